@@ -15,6 +15,7 @@
  *
  */
 
+#include <cmath>
 #include <string>
 
 #include <QLabel>
@@ -38,10 +39,37 @@
 
 namespace free_fleet {
 
+namespace {
+
+/// Fleet markers are sent at most this many times per second, which is
+/// about as often as operators can follow robots moving in rviz
+const int fleet_markers_rate = 10;
+
+/// Robot locations are drawn in the fleet's own coordinates
+const char* const fleet_markers_frame = "map";
+
+/// Robots are drawn again once they moved this many meters or turned this
+/// many radians from where they were last drawn
+const double fleet_markers_distance_threshold = 0.05;
+const double fleet_markers_yaw_threshold = 0.05;
+
+geometry_msgs::Point to_point(const messages::Location& _location)
+{
+  geometry_msgs::Point point;
+  point.x = _location.x;
+  point.y = _location.y;
+  point.z = 0.0;
+  return point;
+}
+
+} // namespace anonymous
+
 //==============================================================================
 
 FFNavToolPanel::FFNavToolPanel(QWidget* parent)
-: rviz::Panel(parent)
+: rviz::Panel(parent),
+  _fleet_markers_timer(nullptr),
+  _redraw_fleet(true)
 {
   create_robot_group_box();
   create_nav_group_box();
@@ -66,6 +94,26 @@ FFNavToolPanel::FFNavToolPanel(QWidget* parent)
 
   _nav_goal_sub = _nh.subscribe(
       "/move_base_simple/goal", 2, &FFNavToolPanel::update_goal, this);
+
+  // The server only takes in robot states to keep its fleet snapshot up to
+  // date, which the markers are drawn from
+  if (!_free_fleet_server->start_robot_state_ingest())
+  {
+    _debug_label->setText("Free Fleet server unable to read robot states...");
+    return;
+  }
+
+  _fleet_markers_pub = _nh.advertise<visualization_msgs::MarkerArray>(
+      "fleet_markers", 1,
+      [this](const ros::SingleSubscriberPublisher&)
+      {
+        _redraw_fleet = true;
+      });
+
+  _fleet_markers_timer = new QTimer(this);
+  connect(_fleet_markers_timer, &QTimer::timeout, this,
+      &FFNavToolPanel::update_fleet_markers);
+  _fleet_markers_timer->start(1000 / fleet_markers_rate);
 }
 
 //==============================================================================
@@ -106,6 +154,159 @@ void FFNavToolPanel::send_nav_goal()
 
 //==============================================================================
 
+void FFNavToolPanel::update_fleet_markers()
+{
+  if (_fleet_markers_pub.getNumSubscribers() == 0)
+    return;
+
+  if (_redraw_fleet.exchange(false))
+    _drawn_robots.clear();
+
+  const ros::Time stamp = ros::Time::now();
+  _fleet_markers.markers.clear();
+
+  auto fleet_snapshot = _free_fleet_server->get_fleet_snapshot();
+  for (const auto& robot : *fleet_snapshot)
+  {
+    const messages::RobotState& state = robot.second->state;
+    auto drawn_it = _drawn_robots.find(robot.first);
+    if (drawn_it != _drawn_robots.end() &&
+        !needs_redraw(drawn_it->second, state))
+      continue;
+
+    auto id_it = _robot_marker_ids.emplace(
+        robot.first, static_cast<int>(_robot_marker_ids.size())).first;
+    add_robot_markers(state, id_it->second, stamp);
+
+    // Assigning into the drawn robot reuses its path from the last drawing
+    DrawnRobot& drawn = _drawn_robots[robot.first];
+    drawn.location = state.location;
+    drawn.path = state.path;
+  }
+
+  for (auto it = _drawn_robots.begin(); it != _drawn_robots.end();)
+  {
+    if (fleet_snapshot->count(it->first))
+    {
+      ++it;
+      continue;
+    }
+    add_robot_deletion(_robot_marker_ids[it->first], stamp);
+    it = _drawn_robots.erase(it);
+  }
+
+  if (!_fleet_markers.markers.empty())
+    _fleet_markers_pub.publish(_fleet_markers);
+}
+
+//==============================================================================
+
+bool FFNavToolPanel::needs_redraw(
+    const DrawnRobot& _drawn, const messages::RobotState& _state)
+{
+  const double distance = std::hypot(
+      _state.location.x - _drawn.location.x,
+      _state.location.y - _drawn.location.y);
+  const double yaw = std::abs(std::remainder(
+      _state.location.yaw - _drawn.location.yaw, 2.0 * M_PI));
+  if (distance > fleet_markers_distance_threshold ||
+      yaw > fleet_markers_yaw_threshold)
+    return true;
+
+  if (_state.path.size() != _drawn.path.size())
+    return true;
+  for (size_t i = 0; i < _state.path.size(); ++i)
+  {
+    if (_state.path[i].x != _drawn.path[i].x ||
+        _state.path[i].y != _drawn.path[i].y)
+      return true;
+  }
+  return false;
+}
+
+//==============================================================================
+
+void FFNavToolPanel::add_robot_markers(
+    const messages::RobotState& _state, int _id, const ros::Time& _stamp)
+{
+  visualization_msgs::Marker marker;
+  marker.header.frame_id = fleet_markers_frame;
+  marker.header.stamp = _stamp;
+  marker.id = _id;
+  marker.action = visualization_msgs::Marker::ADD;
+  marker.pose.orientation.w = 1.0;
+
+  // Arrow pointing the way the robot is facing
+  marker.ns = "robots";
+  marker.type = visualization_msgs::Marker::ARROW;
+  marker.pose.position = to_point(_state.location);
+  marker.pose.orientation.z = std::sin(_state.location.yaw / 2.0);
+  marker.pose.orientation.w = std::cos(_state.location.yaw / 2.0);
+  marker.scale.x = 0.6;
+  marker.scale.y = 0.15;
+  marker.scale.z = 0.15;
+  marker.color.r = 0.1f;
+  marker.color.g = 0.4f;
+  marker.color.b = 1.0f;
+  marker.color.a = 1.0f;
+  _fleet_markers.markers.push_back(marker);
+
+  marker.ns = "names";
+  marker.type = visualization_msgs::Marker::TEXT_VIEW_FACING;
+  marker.text = _state.name;
+  marker.pose.position.z = 0.5;
+  marker.pose.orientation.z = 0.0;
+  marker.pose.orientation.w = 1.0;
+  marker.scale.x = 0.0;
+  marker.scale.y = 0.0;
+  marker.scale.z = 0.3;
+  marker.color.r = 1.0f;
+  marker.color.g = 1.0f;
+  marker.color.b = 1.0f;
+  _fleet_markers.markers.push_back(marker);
+
+  // Line from the robot through the rest of its path, a robot without a
+  // path has its earlier path taken down
+  marker.ns = "paths";
+  marker.text.clear();
+  if (_state.path.empty())
+  {
+    marker.action = visualization_msgs::Marker::DELETE;
+    _fleet_markers.markers.push_back(marker);
+    return;
+  }
+  marker.type = visualization_msgs::Marker::LINE_STRIP;
+  marker.pose.position = geometry_msgs::Point();
+  marker.scale.x = 0.05;
+  marker.scale.z = 0.0;
+  marker.color.r = 0.1f;
+  marker.color.g = 0.9f;
+  marker.color.b = 0.3f;
+  marker.points.reserve(_state.path.size() + 1);
+  marker.points.push_back(to_point(_state.location));
+  for (const auto& location : _state.path)
+    marker.points.push_back(to_point(location));
+  _fleet_markers.markers.push_back(std::move(marker));
+}
+
+//==============================================================================
+
+void FFNavToolPanel::add_robot_deletion(int _id, const ros::Time& _stamp)
+{
+  visualization_msgs::Marker marker;
+  marker.header.frame_id = fleet_markers_frame;
+  marker.header.stamp = _stamp;
+  marker.id = _id;
+  marker.action = visualization_msgs::Marker::DELETE;
+  for (const char* ns : {"robots", "names", "paths"})
+  {
+    marker.ns = ns;
+    _fleet_markers.markers.push_back(marker);
+  }
+}
+
+//==============================================================================
+
 void FFNavToolPanel::create_robot_group_box()
 {
   _robot_group_box = new QGroupBox("Robot Selection");
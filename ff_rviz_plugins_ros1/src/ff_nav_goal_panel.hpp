@@ -19,18 +19,25 @@
 #define FF_RVIZ_PLUGINS_ROS1__SRC__FF_NAV_GOAL_PANEL__HPP
 
 #include <mutex>
+#include <atomic>
+#include <string>
+#include <vector>
+#include <unordered_map>
 
 #include <QString>
 #include <QLineEdit>
 #include <QTextEdit>
 #include <QGroupBox>
+#include <QTimer>
 
 #include <rviz/panel.h>
 
 #include <ros/ros.h>
 #include <geometry_msgs/PoseStamped.h>
+#include <visualization_msgs/MarkerArray.h>
 
 #include <free_fleet/Server.hpp>
+#include <free_fleet/FleetSnapshot.hpp>
 
 namespace free_fleet {
 
@@ -45,6 +52,8 @@ private Q_SLOTS:
 
   void send_nav_goal();
 
+  void update_fleet_markers();
+
 protected:
 
 private:
@@ -75,6 +84,41 @@ private:
   void update_goal(const geometry_msgs::PoseStamped::ConstPtr& msg);
 
   QString nav_goal_to_qstring(const geometry_msgs::PoseStamped& msg) const;
+
+  /// Robots of the server's fleet snapshot are drawn as one MarkerArray,
+  /// sent at most once per tick of the marker timer, holding the markers of
+  /// the robots that changed since they were last drawn and the deletions of
+  /// the robots that were lost, nothing is sent if neither happened
+  QTimer* _fleet_markers_timer;
+  ros::Publisher _fleet_markers_pub;
+  visualization_msgs::MarkerArray _fleet_markers;
+
+  /// What was last drawn of each robot. The server makes a new record for
+  /// every state it takes in, robots are only drawn again once they moved or
+  /// turned past a threshold, or their path changed.
+  struct DrawnRobot
+  {
+    messages::Location location;
+    std::vector<messages::Location> path;
+  };
+
+  std::unordered_map<std::string, DrawnRobot> _drawn_robots;
+
+  static bool needs_redraw(
+      const DrawnRobot& drawn, const messages::RobotState& state);
+
+  /// Marker id of each robot that has been drawn, kept once lost so that a
+  /// robot gets the same markers back when it rejoins
+  std::unordered_map<std::string, int> _robot_marker_ids;
+
+  /// Set when a new subscriber connects, so that the whole fleet gets drawn
+  /// again for it on the next tick
+  std::atomic<bool> _redraw_fleet;
+
+  void add_robot_markers(
+      const messages::RobotState& state, int id, const ros::Time& stamp);
+
+  void add_robot_deletion(int id, const ros::Time& stamp);
 };
 
 } // namespace free_fleet
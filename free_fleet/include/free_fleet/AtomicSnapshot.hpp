@@ -0,0 +1,66 @@
+/*
+ * Copyright (C) 2019 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#ifndef FREE_FLEET__INCLUDE__FREE_FLEET__ATOMICSNAPSHOT_HPP
+#define FREE_FLEET__INCLUDE__FREE_FLEET__ATOMICSNAPSHOT_HPP
+
+#include <memory>
+#include <atomic>
+
+namespace free_fleet {
+
+/// Holds an immutable value that gets replaced as a whole by a single writer,
+/// while any number of readers grab the current value. Readers keep their
+/// snapshot alive for as long as they hold on to the returned pointer,
+/// regardless of newer values being stored. Loads and stores only hold a
+/// short internal lock while swapping the pointer, libstdc++ guards atomic
+/// shared_ptr accesses with a pool of mutexes, and every store allocates,
+/// so this suits values that change less often than they are read. See
+/// SeqLock for small values that change all the time.
+template <typename T>
+class AtomicSnapshot
+{
+public:
+
+  using ConstPtr = std::shared_ptr<const T>;
+
+  AtomicSnapshot() :
+    snapshot(std::make_shared<const T>())
+  {}
+
+  /// Gets the latest stored value.
+  ConstPtr load() const
+  {
+    return std::atomic_load(&snapshot);
+  }
+
+  /// Replaces the stored value, readers that already loaded the previous
+  /// value are not affected.
+  void store(ConstPtr _snapshot)
+  {
+    std::atomic_store(&snapshot, std::move(_snapshot));
+  }
+
+private:
+
+  ConstPtr snapshot;
+
+};
+
+} // namespace free_fleet
+
+#endif // FREE_FLEET__INCLUDE__FREE_FLEET__ATOMICSNAPSHOT_HPP
@@ -19,7 +19,9 @@
 #define FREE_FLEET__INCLUDE__FREE_FLEET__CLIENT_HPP
 
 #include <memory>
+#include <functional>
 
+#include <free_fleet/Stats.hpp>
 #include <free_fleet/ClientConfig.hpp>
 
 #include <free_fleet/messages/RobotState.hpp>
@@ -35,6 +37,15 @@ public:
 
   using SharedPtr = std::shared_ptr<Client>;
 
+  using ModeRequestCallback =
+      std::function<void(const messages::ModeRequest&)>;
+
+  using PathRequestCallback =
+      std::function<void(const messages::PathRequest&)>;
+
+  using DestinationRequestCallback =
+      std::function<void(const messages::DestinationRequest&)>;
+
   /// Factory function that creates an instance of the Free Fleet DDS Client.
   ///
   /// \param[in] config
@@ -54,7 +65,8 @@ public:
   bool send_robot_state(const messages::RobotState& new_robot_state);
 
   /// Attempts to read and receive a new mode request from the free fleet
-  /// server, for commanding the robot client.
+  /// server, for commanding the robot client. All pending mode requests are
+  /// taken, only the newest one addressed to this robot is returned.
   ///
   /// \param[out] mode_request
   ///   Newly received robot mode request from the free fleet server, to be
@@ -64,7 +76,9 @@ public:
   bool read_mode_request(messages::ModeRequest& mode_request);
 
   /// Attempts to read and receive a new path request from the free fleet
-  /// server, for commanding the robot client.
+  /// server, for commanding the robot client, see read_mode_request. Requests
+  /// queued behind a task, see PathRequest::after_task_id, are returned one
+  /// at a time in the order they were sent, after the request they follow.
   ///
   /// \param[out] path_request
   ///   Newly received robot path request from the free fleet server, to be
@@ -74,7 +88,7 @@ public:
   bool read_path_request(messages::PathRequest& path_request);
 
   /// Attempts to read and receive a new destination request from the free
-  /// fleet server, for commanding the robot client.
+  /// fleet server, for commanding the robot client, see read_path_request.
   /// 
   /// \param[out] destination_request
   ///   Newly received robot destination request from the free fleet server,
@@ -84,6 +98,57 @@ public:
   bool read_destination_request(
       messages::DestinationRequest& destination_request);
 
+  /// Registers a callback that gets triggered from a dedicated reader thread
+  /// with the newest mode request addressed to this robot, whenever mode
+  /// requests arrive from the free fleet server. Mode requests have a reader
+  /// thread of their own, separate from the one of path and destination
+  /// requests, so the callback may run concurrently with theirs. Once a
+  /// callback is registered, it takes all incoming mode requests, and
+  /// read_mode_request will no longer return any. Registering a new callback
+  /// replaces the previous one.
+  ///
+  /// \param[in] callback
+  ///   Function to be called with each newly received mode request.
+  /// \return
+  ///   True if the callback was successfully registered, false otherwise.
+  bool on_mode_request(ModeRequestCallback callback);
+
+  /// Registers a callback that gets triggered from a dedicated reader thread
+  /// with the newest path request addressed to this robot, and the requests
+  /// queued behind it, whenever path requests arrive from the free fleet
+  /// server. Once a callback is registered, it takes all incoming path
+  /// requests, and read_path_request will no longer return any. Registering
+  /// a new callback replaces the previous one.
+  ///
+  /// \param[in] callback
+  ///   Function to be called with each newly received path request.
+  /// \return
+  ///   True if the callback was successfully registered, false otherwise.
+  bool on_path_request(PathRequestCallback callback);
+
+  /// Registers a callback that gets triggered from a dedicated reader thread
+  /// with the newest destination request addressed to this robot, and the
+  /// requests queued behind it, whenever destination requests arrive from
+  /// the free fleet server.
+  /// Once a callback is registered, it takes all incoming destination
+  /// requests, and read_destination_request will no longer return any.
+  /// Registering a new callback replaces the previous one.
+  ///
+  /// \param[in] callback
+  ///   Function to be called with each newly received destination request.
+  /// \return
+  ///   True if the callback was successfully registered, false otherwise.
+  bool on_destination_request(DestinationRequestCallback callback);
+
+  /// Gets the statistics collected since the client was made, on the
+  /// traffic through each topic and on the time spent converting messages.
+  /// Statistics are collected without locking, and can be called for from
+  /// any thread.
+  ///
+  /// \return
+  ///   Snapshot of the statistics.
+  Stats get_stats() const;
+
   /// Destructor
   ~Client();
 
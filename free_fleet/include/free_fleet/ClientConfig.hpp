@@ -20,15 +20,118 @@
 
 #include <string>
 
+#include <free_fleet/TopicQoS.hpp>
+#include <free_fleet/DiscoveryConfig.hpp>
+#include <free_fleet/ThreadConfig.hpp>
+
 namespace free_fleet {
 
 struct ClientConfig
 {
+  std::string fleet_name = "fleet_name";
+  std::string robot_name = "robot_name";
   int dds_domain = 42;
   std::string dds_state_topic = "robot_state";
   std::string dds_mode_request_topic = "mode_request";
   std::string dds_path_request_topic = "path_request";
   std::string dds_destination_request_topic = "destination_request";
+  std::string dds_registration_topic = "robot_registration";
+  std::string dds_registration_ack_topic = "robot_registration_ack";
+  std::string dds_time_sync_ping_topic = "time_sync_ping";
+  std::string dds_time_sync_pong_topic = "time_sync_pong";
+  std::string dds_pose_topic = "robot_pose";
+  std::string dds_metadata_topic = "robot_metadata";
+  std::string dds_request_ack_topic = "request_ack";
+
+  /// QoS of each topic, these need to be compatible between the server and
+  /// all of its clients
+  TopicQoS dds_state_qos = TopicQoS::best_effort();
+  TopicQoS dds_mode_request_qos = TopicQoS::urgent_requests();
+  TopicQoS dds_path_request_qos = TopicQoS::reliable_requests();
+  TopicQoS dds_destination_request_qos = TopicQoS::reliable_requests();
+  TopicQoS dds_registration_qos = TopicQoS::latest_state();
+  TopicQoS dds_time_sync_qos = TopicQoS::best_effort();
+  TopicQoS dds_pose_qos = TopicQoS::best_effort();
+  TopicQoS dds_metadata_qos = TopicQoS::latest_state();
+  TopicQoS dds_request_ack_qos = TopicQoS::reliable_requests();
+
+  /// Only subscribes to requests published into this robot's own DDS
+  /// partition, named fleet_name/robot_name, so that requests addressed to
+  /// other robots never reach this client. The server needs to enable this
+  /// as well.
+  bool dds_request_partitions = false;
+
+  /// DDS partition that every topic of the client is published and
+  /// subscribed in, which needs to match the partition of the server, or of
+  /// the server shard that the robot is a part of, see ServerConfig::shards.
+  /// The robot's own request partition is used instead for requests when
+  /// they are enabled. The default partition if empty.
+  std::string dds_partition = "";
+
+  /// Uses the CycloneDDS shared memory transport with a server on the same
+  /// host, see ServerConfig::dds_shared_memory.
+  bool dds_shared_memory = false;
+
+  /// Discovery of the other participants, applied to the DDS domain along
+  /// with the shared memory setting when the participant is created. Like
+  /// it, this applies to the whole DDS domain within the process.
+  DiscoveryConfig dds_discovery;
+
+  /// CPUs and scheduling of the threads that CycloneDDS starts for the
+  /// domain, see ServerConfig::dds_threads
+  ThreadConfig dds_threads;
+
+  /// CPUs and scheduling of the waitset threads that the client starts for
+  /// its request and ping callbacks
+  ThreadConfig threads;
+
+  /// Registers the robot with the server, which assigns it a numeric id.
+  /// Once registered, robot states carry the id instead of the model and
+  /// task id, which are only sent again through the registration when they
+  /// change, and requests are addressed to the robot by its id instead of
+  /// its fleet and robot names.
+  bool robot_registration = false;
+
+  /// Answers the time sync pings of the server, on a thread of their own so
+  /// that pings are stamped as soon as they arrive, which lets the server
+  /// estimate how far this client's clock is off from its own, see
+  /// ServerConfig::time_sync_period.
+  bool time_sync = false;
+
+  /// Acknowledges every request addressed to this robot as soon as it has
+  /// been taken, with its task id and, for path requests, its version, so
+  /// that the server stops sending it again, see
+  /// ServerConfig::request_retry_timeout.
+  bool request_acks = false;
+
+  /// Splits every robot state into its pose, the mode and location of the
+  /// robot, which is sent on the pose topic every time, and the rest of the
+  /// state, which is only sent on the metadata topic when it changes. Robots
+  /// can then report their location at a high rate without sending their
+  /// path and the rest of their state along every time. Replaces the robot
+  /// state topic, the server needs to enable this as well, see
+  /// ServerConfig::split_robot_states.
+  bool split_robot_state = false;
+
+  /// Change in battery percentage that sends the metadata again when the
+  /// robot state is split, smaller changes go out along with the next change
+  /// to the rest of the metadata
+  double metadata_battery_tolerance = 1.0;
+
+  /// Simplifies the path of every robot state before it is sent, dropping
+  /// waypoints that are no further than this many meters from where the
+  /// robot would be at their time along the simplified path, so that dense
+  /// paths cost less to send and to handle on the server. Waypoints the robot
+  /// waits or turns at, and level changes, are kept. Disabled if 0.
+  double path_simplification_tolerance = 0.0;
+
+  /// Largest yaw difference in radians between a dropped waypoint and the
+  /// simplified path
+  double path_simplification_yaw_tolerance = 0.1;
+
+  /// Robot states whose path has at least this many waypoints send it
+  /// packed, see ServerConfig::path_packing_threshold. Disabled if 0.
+  size_t path_packing_threshold = 0;
 
   void print_config() const;
 };
@@ -0,0 +1,46 @@
+/*
+ * Copyright (C) 2019 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#ifndef FREE_FLEET__INCLUDE__FREE_FLEET__CLOCKOFFSET_HPP
+#define FREE_FLEET__INCLUDE__FREE_FLEET__CLOCKOFFSET_HPP
+
+#include <string>
+#include <cstdint>
+
+namespace free_fleet {
+
+/// Estimate of how far the clock of a robot's client is off from the clock
+/// of the server, from the time sync exchanges between the two, see
+/// ServerConfig::time_sync_period.
+struct ClockOffset
+{
+  std::string robot_name;
+
+  /// Nanoseconds that the client's clock is ahead of the server's
+  int64_t offset = 0;
+
+  /// Round trip in nanoseconds of the exchange that the offset was estimated
+  /// from, the offset is accurate to within half of it
+  int64_t round_trip = 0;
+
+  /// Number of exchanges that the client has answered
+  uint64_t exchanges = 0;
+};
+
+} // namespace free_fleet
+
+#endif // FREE_FLEET__INCLUDE__FREE_FLEET__CLOCKOFFSET_HPP
@@ -0,0 +1,88 @@
+/*
+ * Copyright (C) 2019 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#ifndef FREE_FLEET__INCLUDE__FREE_FLEET__DISCOVERYCONFIG_HPP
+#define FREE_FLEET__INCLUDE__FREE_FLEET__DISCOVERYCONFIG_HPP
+
+#include <string>
+#include <vector>
+
+namespace free_fleet {
+
+/// How the DDS participant finds the other participants of its domain, and
+/// over which network. These settings are applied to the DDS domain when
+/// its participant is created, on top of the configuration found in
+/// CYCLONEDDS_URI, and are left to that configuration when at their
+/// defaults.
+struct DiscoveryConfig
+{
+  enum class Mode : int
+  {
+    /// Left to the CycloneDDS configuration
+    Default = 0,
+
+    /// Discovery and data both use multicast
+    Multicast = 1,
+
+    /// Participants are discovered over multicast, but data is only ever
+    /// sent over unicast, which is a lot less noisy on wireless networks
+    SpdpMulticast = 2,
+
+    /// Multicast is not used at all, participants are only discovered
+    /// through the static peers
+    Unicast = 3
+  };
+
+  Mode mode = Mode::Default;
+
+  /// Addresses or host names of peers that are contacted directly for
+  /// discovery, as soon as the participant starts, instead of waiting to
+  /// hear from them. Required for the unicast mode, and best set to the
+  /// server on the clients and to the robots on the server.
+  std::vector<std::string> peers;
+
+  /// Name or address of the network interface used, picked by CycloneDDS if
+  /// empty
+  std::string network_interface = "";
+
+  /// Time in seconds between the announcements of the participant to its
+  /// peers, shorter intervals let restarted participants be found again
+  /// sooner at the cost of more discovery traffic. Left to the CycloneDDS
+  /// default if 0.
+  double spdp_interval = 0.0;
+
+  /// Whether every setting is left to the CycloneDDS configuration
+  bool is_default() const;
+
+  /// Human readable summary of the settings, used when printing configs
+  std::string to_string() const;
+
+  /// Parses the name of a mode, one of "default", "multicast",
+  /// "spdp_multicast" or "unicast".
+  ///
+  /// \param[in] name
+  ///   Name of the mode.
+  /// \param[out] mode
+  ///   Parsed mode, left untouched if the name is unknown.
+  /// \return
+  ///   False if the name is unknown.
+  static bool parse_mode(const std::string& name, Mode& mode);
+};
+
+} // namespace free_fleet
+
+#endif // FREE_FLEET__INCLUDE__FREE_FLEET__DISCOVERYCONFIG_HPP
@@ -0,0 +1,89 @@
+/*
+ * Copyright (C) 2019 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#ifndef FREE_FLEET__INCLUDE__FREE_FLEET__FLEETOBSERVER_HPP
+#define FREE_FLEET__INCLUDE__FREE_FLEET__FLEETOBSERVER_HPP
+
+#include <memory>
+#include <functional>
+
+#include <free_fleet/ServerConfig.hpp>
+
+#include <free_fleet/messages/FleetState.hpp>
+
+namespace free_fleet {
+
+/// Receives the aggregated fleet state that a free fleet server publishes
+/// when its fleet_state_period is set, for dashboards and other observers
+/// that need the whole fleet, without having to subscribe to the state of
+/// every robot themselves.
+class FleetObserver
+{
+public:
+
+  using SharedPtr = std::shared_ptr<FleetObserver>;
+
+  using FleetStateCallback =
+      std::function<void(const messages::FleetState&)>;
+
+  /// Factory function that creates an instance of the Free Fleet Observer.
+  ///
+  /// \param[in] config
+  ///   Configuration of the server being observed, only the fleet name, the
+  ///   DDS domain and the fleet state topic and QoS are used.
+  /// \return
+  ///   Shared pointer to a free fleet observer.
+  static SharedPtr make(const ServerConfig& config);
+
+  /// Attempts to read the latest fleet state published by the server. All
+  /// pending fleet states are taken, only the newest one of the configured
+  /// fleet is returned.
+  ///
+  /// \param[out] fleet_state
+  ///   Newly received state of the fleet.
+  /// \return
+  ///   True if a new fleet state was received, false otherwise.
+  bool read_fleet_state(messages::FleetState& fleet_state);
+
+  /// Registers a callback that gets triggered from a dedicated reader thread
+  /// with the newest fleet state, whenever one arrives from the server. Once
+  /// a callback is registered, read_fleet_state will no longer return any.
+  /// Registering a new callback replaces the previous one.
+  ///
+  /// \param[in] callback
+  ///   Function to be called with each newly received fleet state.
+  /// \return
+  ///   True if the callback was successfully registered, false otherwise.
+  bool on_fleet_state(FleetStateCallback callback);
+
+  /// Destructor
+  ~FleetObserver();
+
+private:
+
+  /// Forward declaration and unique implementation
+  class FleetObserverImpl;
+
+  std::unique_ptr<FleetObserverImpl> impl;
+
+  FleetObserver(const ServerConfig& config);
+
+};
+
+} // namespace free_fleet
+
+#endif // FREE_FLEET__INCLUDE__FREE_FLEET__FLEETOBSERVER_HPP
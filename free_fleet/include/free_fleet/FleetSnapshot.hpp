@@ -0,0 +1,50 @@
+/*
+ * Copyright (C) 2019 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#ifndef FREE_FLEET__INCLUDE__FREE_FLEET__FLEETSNAPSHOT_HPP
+#define FREE_FLEET__INCLUDE__FREE_FLEET__FLEETSNAPSHOT_HPP
+
+#include <chrono>
+#include <memory>
+#include <string>
+#include <unordered_map>
+
+#include <free_fleet/messages/RobotState.hpp>
+
+namespace free_fleet {
+
+/// Latest state received from a robot.
+struct RobotStateRecord
+{
+  using ConstPtr = std::shared_ptr<const RobotStateRecord>;
+
+  messages::RobotState state;
+
+  /// Time at which the state was taken in by the server, useful for telling
+  /// apart robots that have gone quiet
+  std::chrono::steady_clock::time_point last_seen;
+};
+
+/// Immutable view over the latest state of every robot that has been heard
+/// from and has not been lost since, keyed by robot name. Records are shared between snapshots, so only
+/// robots that were updated in between two snapshots get copied.
+using FleetSnapshot =
+    std::unordered_map<std::string, RobotStateRecord::ConstPtr>;
+
+} // namespace free_fleet
+
+#endif // FREE_FLEET__INCLUDE__FREE_FLEET__FLEETSNAPSHOT_HPP
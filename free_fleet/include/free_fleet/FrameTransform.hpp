@@ -0,0 +1,120 @@
+/*
+ * Copyright (C) 2019 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#ifndef FREE_FLEET__INCLUDE__FREE_FLEET__FRAMETRANSFORM_HPP
+#define FREE_FLEET__INCLUDE__FREE_FLEET__FRAMETRANSFORM_HPP
+
+#include <cstddef>
+
+namespace free_fleet {
+
+/// 2D similarity transform between two map frames, typically between the
+/// frame of RMF and the frame of a fleet's own map. The linear part is
+/// precomputed once, transforming a location only takes a few multiply-adds
+/// and no trigonometry, and the batch functions are written as plain loops
+/// that the compiler is able to vectorize.
+class FrameTransform
+{
+public:
+
+  /// Identity transform.
+  FrameTransform();
+
+  /// Transform that scales, then rotates, then translates locations.
+  ///
+  /// \param[in] translation_x
+  ///   Translation along x, applied last.
+  /// \param[in] translation_y
+  ///   Translation along y, applied last.
+  /// \param[in] rotation
+  ///   Rotation in radians, which is also added to the yaw of locations.
+  /// \param[in] scale
+  ///   Uniform scale, applied first, which has to be non-zero.
+  FrameTransform(
+      double translation_x,
+      double translation_y,
+      double rotation,
+      double scale);
+
+  /// Transform that undoes this one.
+  FrameTransform inverse() const;
+
+  /// Transforms a single point and its yaw.
+  void apply(double& x, double& y, double& yaw) const
+  {
+    const double new_x = xx * x + xy * y + tx;
+    const double new_y = yx * x + yy * y + ty;
+    x = new_x;
+    y = new_y;
+    yaw += yaw_offset;
+  }
+
+  /// Transforms arrays of coordinates in place, in a single pass.
+  ///
+  /// \param[in] count
+  ///   Number of points, each array needs to hold at least this many.
+  void apply(double* xs, double* ys, double* yaws, std::size_t count) const;
+
+  /// Transforms a single location in place, which can be any type with x, y
+  /// and yaw members, like messages::Location or rmf_fleet_msgs Location.
+  template <typename LocationT>
+  void apply(LocationT& location) const
+  {
+    double x = location.x;
+    double y = location.y;
+    double yaw = location.yaw;
+    apply(x, y, yaw);
+    location.x = static_cast<decltype(location.x)>(x);
+    location.y = static_cast<decltype(location.y)>(y);
+    location.yaw = static_cast<decltype(location.yaw)>(yaw);
+  }
+
+  /// Transforms a whole range of locations in place, such as a path.
+  template <typename Iterator>
+  void apply(Iterator begin, Iterator end) const
+  {
+    for (Iterator it = begin; it != end; ++it)
+      apply(*it);
+  }
+
+  double rotation() const
+  {
+    return yaw_offset;
+  }
+
+  /// Factor by which the transform scales distances.
+  double scale() const;
+
+private:
+
+  // Linear part, row major
+  double xx;
+  double xy;
+  double yx;
+  double yy;
+
+  // Translation
+  double tx;
+  double ty;
+
+  double yaw_offset;
+
+};
+
+} // namespace free_fleet
+
+#endif // FREE_FLEET__INCLUDE__FREE_FLEET__FRAMETRANSFORM_HPP
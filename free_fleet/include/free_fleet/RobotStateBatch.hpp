@@ -0,0 +1,83 @@
+/*
+ * Copyright (C) 2019 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#ifndef FREE_FLEET__INCLUDE__FREE_FLEET__ROBOTSTATEBATCH_HPP
+#define FREE_FLEET__INCLUDE__FREE_FLEET__ROBOTSTATEBATCH_HPP
+
+#include <vector>
+#include <utility>
+
+#include <free_fleet/messages/RobotState.hpp>
+
+namespace free_fleet {
+
+class Server;
+
+/// Reusable storage for the robot states read by Server::read_robot_states.
+/// States that are not part of the latest read are set aside instead of
+/// being destroyed, along with the capacities of their strings and paths, and
+/// picked back up by the next reads. Reading into the same batch on every
+/// tick stops allocating once it has held the largest fleet and the longest
+/// paths that it is going to see. A batch is only used from one thread at a
+/// time.
+class RobotStateBatch
+{
+public:
+
+  /// States of the latest read, in the order they were taken in.
+  const std::vector<messages::RobotState>& states() const
+  {
+    return current;
+  }
+
+  size_t size() const
+  {
+    return current.size();
+  }
+
+  bool empty() const
+  {
+    return current.empty();
+  }
+
+  const messages::RobotState& operator[](size_t _index) const
+  {
+    return current[_index];
+  }
+
+  /// Sets all of the current states aside.
+  void clear()
+  {
+    while (!current.empty())
+    {
+      spare.push_back(std::move(current.back()));
+      current.pop_back();
+    }
+  }
+
+private:
+
+  friend class Server;
+
+  std::vector<messages::RobotState> current;
+
+  std::vector<messages::RobotState> spare;
+};
+
+} // namespace free_fleet
+
+#endif // FREE_FLEET__INCLUDE__FREE_FLEET__ROBOTSTATEBATCH_HPP
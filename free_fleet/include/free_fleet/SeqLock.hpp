@@ -0,0 +1,99 @@
+/*
+ * Copyright (C) 2019 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+
+#ifndef FREE_FLEET__INCLUDE__FREE_FLEET__SEQLOCK_HPP
+#define FREE_FLEET__INCLUDE__FREE_FLEET__SEQLOCK_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+namespace free_fleet {
+
+/// Holds a small trivially copyable value that a single writer at a time
+/// overwrites in place, for values that change too often to be replaced
+/// through an AtomicSnapshot. Neither side ever locks or allocates. Readers
+/// retry when they overlapped with a write, so they only ever spin for as
+/// long as a copy of the value takes.
+template <typename T>
+class SeqLock
+{
+public:
+
+  static_assert(std::is_trivially_copyable<T>::value,
+      "SeqLock values need to be trivially copyable");
+
+  SeqLock()
+  {
+    store(T());
+  }
+
+  /// Gets a consistent copy of the latest stored value.
+  T load() const
+  {
+    uint64_t copy[WordCount];
+    uint32_t before = 0;
+    uint32_t after = 0;
+    do
+    {
+      before = sequence.load(std::memory_order_acquire);
+      for (size_t i = 0; i < WordCount; ++i)
+        copy[i] = words[i].load(std::memory_order_relaxed);
+      std::atomic_thread_fence(std::memory_order_acquire);
+      after = sequence.load(std::memory_order_relaxed);
+    } while ((before & 1) || before != after);
+
+    T value;
+    std::memcpy(&value, copy, sizeof(T));
+    return value;
+  }
+
+  /// Overwrites the stored value, stores need to be serialized by the
+  /// caller.
+  void store(const T& _value)
+  {
+    uint64_t copy[WordCount] = {};
+    std::memcpy(copy, &_value, sizeof(T));
+
+    const uint32_t current = sequence.load(std::memory_order_relaxed);
+    sequence.store(current + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    for (size_t i = 0; i < WordCount; ++i)
+      words[i].store(copy[i], std::memory_order_relaxed);
+    sequence.store(current + 2, std::memory_order_release);
+  }
+
+private:
+
+  static constexpr size_t WordCount =
+      (sizeof(T) + sizeof(uint64_t) - 1) / sizeof(uint64_t);
+
+  /// Odd while a store is in progress
+  std::atomic<uint32_t> sequence{0};
+
+  /// The value is copied word by word through atomics, so that readers that
+  /// overlap with a write read stale words instead of racing with it
+  std::atomic<uint64_t> words[WordCount];
+
+};
+
+} // namespace free_fleet
+
+#endif // FREE_FLEET__INCLUDE__FREE_FLEET__SEQLOCK_HPP
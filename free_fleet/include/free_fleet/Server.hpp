@@ -20,10 +20,17 @@
 
 #include <memory>
 #include <vector>
+#include <functional>
 
+#include <free_fleet/Stats.hpp>
+#include <free_fleet/ClockOffset.hpp>
+#include <free_fleet/StateHistory.hpp>
 #include <free_fleet/ServerConfig.hpp>
+#include <free_fleet/FleetSnapshot.hpp>
+#include <free_fleet/RobotStateBatch.hpp>
 
 #include <free_fleet/messages/RobotState.hpp>
+#include <free_fleet/messages/RobotStateView.hpp>
 #include <free_fleet/messages/ModeRequest.hpp>
 #include <free_fleet/messages/PathRequest.hpp>
 #include <free_fleet/messages/DestinationRequest.hpp>
@@ -36,6 +43,14 @@ public:
 
   using SharedPtr = std::shared_ptr<Server>;
 
+  using RobotStatesCallback =
+      std::function<void(const std::vector<messages::RobotState>&)>;
+
+  using RobotStateViewCallback =
+      std::function<void(const messages::RobotStateView&)>;
+
+  using RobotEventCallback = std::function<void(const std::string&)>;
+
   /// Factory function that creates an instance of the Free Fleet Server.
   ///
   /// \param[in] config
@@ -54,6 +69,175 @@ public:
   ///   True if new robot states were received, false otherwise.
   bool read_robot_states(std::vector<messages::RobotState>& new_robot_states);
 
+  /// Reads new incoming robot states the same way, into a batch that keeps
+  /// the states of earlier reads around to be reused, which is meant for
+  /// callers that read on every tick and are done with the states by the
+  /// next read.
+  ///
+  /// \param[out] new_robot_states
+  ///   Batch holding the new incoming robot states once this returns.
+  /// \return
+  ///   True if new robot states were received, false otherwise.
+  bool read_robot_states(RobotStateBatch& new_robot_states);
+
+  /// Attempts to read new incoming robot states in place, handing each of
+  /// them to the callback as a view over the received sample, without
+  /// copying anything out of it. This suits callers that only look at a few
+  /// fields or filter the states, and only convert the ones they keep. Views
+  /// must not be held on to once the callback returns, and the callback must
+  /// not read from this server itself. States read this way do not update
+  /// the fleet snapshot, and progress-only paths are not rebuilt, see
+  /// RobotStateView::path_size.
+  ///
+  /// \param[in] callback
+  ///   Function to be called with a view of each new robot state.
+  /// \return
+  ///   True if new robot states were received, false otherwise.
+  bool read_robot_state_views(const RobotStateViewCallback& callback);
+
+  /// Registers a callback that gets triggered from a dedicated reader thread
+  /// as soon as new robot states arrive over DDS, instead of having to poll
+  /// read_robot_states. Once a callback is registered, it takes all incoming
+  /// robot states, and read_robot_states will no longer return any.
+  /// Registering a new callback replaces the previous one.
+  ///
+  /// \param[in] callback
+  ///   Function to be called with each batch of newly received robot states.
+  /// \return
+  ///   True if the callback was successfully registered, false otherwise.
+  bool on_robot_states(RobotStatesCallback callback);
+
+  /// Starts taking in robot states on the dedicated reader thread, only to
+  /// keep the fleet snapshot up to date, for integrators that have no use for
+  /// read_robot_states or on_robot_states. Registering a callback with
+  /// on_robot_states later on replaces this.
+  ///
+  /// \return
+  ///   True if the reader thread was successfully started, false otherwise.
+  bool start_robot_state_ingest();
+
+  /// Registers a callback that gets triggered with the name of every robot
+  /// that is lost, either because its state writer is gone or no longer
+  /// alive, or because it has not sent a state within the configured
+  /// robot_expiry_timeout. Lost robots are removed from the fleet snapshot.
+  /// The callback is triggered from whichever thread takes in robot states.
+  ///
+  /// \param[in] callback
+  ///   Function to be called with the name of each lost robot.
+  /// \return
+  ///   True if the callback was successfully registered, false otherwise.
+  bool on_robot_lost(RobotEventCallback callback);
+
+  /// Registers a callback that gets triggered with the name of every robot
+  /// that sends a state again after having been lost, see on_robot_lost.
+  ///
+  /// \param[in] callback
+  ///   Function to be called with the name of each robot that rejoined.
+  /// \return
+  ///   True if the callback was successfully registered, false otherwise.
+  bool on_robot_rejoined(RobotEventCallback callback);
+
+  /// Gets the latest state of every robot that the server has heard from.
+  /// The snapshot is updated whenever robot states are taken in, through
+  /// read_robot_states, on_robot_states or start_robot_state_ingest, and can
+  /// be called from any number of threads without blocking the ingestion.
+  ///
+  /// \return
+  ///   Immutable snapshot of the fleet, which stays valid for as long as it
+  ///   is held on to.
+  std::shared_ptr<const FleetSnapshot> get_fleet_snapshot() const;
+
+  /// Gets the latest state of a single robot, see get_fleet_snapshot.
+  ///
+  /// \param[in] robot_name
+  ///   Name of the robot.
+  /// \return
+  ///   Latest state record of the robot, nullptr if it has never been heard
+  ///   from.
+  RobotStateRecord::ConstPtr get_robot_state(
+      const std::string& robot_name) const;
+
+  /// Gets the statistics collected since the server was made, on the
+  /// traffic through each topic and on the time spent converting messages.
+  /// Statistics are collected without locking, and can be called for from
+  /// any thread.
+  ///
+  /// \return
+  ///   Snapshot of the statistics.
+  Stats get_stats() const;
+
+  /// Gets the latest estimate of how far the clock of each robot is off from
+  /// the server's, for the robots that have answered a time sync ping, see
+  /// ServerConfig::time_sync_period. Estimates are updated once every
+  /// period, and can be called for from any thread.
+  ///
+  /// \return
+  ///   Clock offset of each robot, sorted by the robot names.
+  std::vector<ClockOffset> get_clock_offsets() const;
+
+  /// Gets the states of a robot within a time range out of its state
+  /// history, see ServerConfig::robot_state_history_capacity. The history is
+  /// filled as robot states are taken in, by the time of each location, and
+  /// can be called for from any thread.
+  ///
+  /// \param[in] robot_name
+  ///   Name of the robot.
+  /// \param[in] start_time
+  ///   Start of the time range in nanoseconds, inclusive.
+  /// \param[in] end_time
+  ///   End of the time range in nanoseconds, inclusive.
+  /// \param[out] history
+  ///   Cleared and filled with the states of the robot within the time
+  ///   range, oldest first. Reusing it between calls reuses its arrays.
+  /// \return
+  ///   False if the history is disabled or the robot has never been heard
+  ///   from.
+  bool get_state_history(
+      const std::string& robot_name,
+      int64_t start_time,
+      int64_t end_time,
+      StateHistory& history) const;
+
+  /// Finds the robots of the fleet snapshot on a level within a radius of a
+  /// point, see ServerConfig::spatial_index_cell_size. Can be called for from
+  /// any thread.
+  ///
+  /// \param[in] level_name
+  ///   Level that the robots are on.
+  /// \param[in] x
+  ///   X coordinate of the point in the fleet's own coordinates.
+  /// \param[in] y
+  ///   Y coordinate of the point in the fleet's own coordinates.
+  /// \param[in] radius
+  ///   Radius in meters, inclusive.
+  /// \return
+  ///   Names of the robots within the radius, in no particular order.
+  std::vector<std::string> query_radius(
+      const std::string& level_name, double x, double y, double radius) const;
+
+  /// Finds the robots of the fleet snapshot on a level within an axis
+  /// aligned box, see ServerConfig::spatial_index_cell_size. Can be called
+  /// for from any thread.
+  ///
+  /// \param[in] level_name
+  ///   Level that the robots are on.
+  /// \param[in] min_x
+  ///   Lower x bound of the box in the fleet's own coordinates, inclusive.
+  /// \param[in] min_y
+  ///   Lower y bound of the box in the fleet's own coordinates, inclusive.
+  /// \param[in] max_x
+  ///   Upper x bound of the box in the fleet's own coordinates, inclusive.
+  /// \param[in] max_y
+  ///   Upper y bound of the box in the fleet's own coordinates, inclusive.
+  /// \return
+  ///   Names of the robots within the box, in no particular order.
+  std::vector<std::string> query_box(
+      const std::string& level_name,
+      double min_x,
+      double min_y,
+      double max_x,
+      double max_y) const;
+
   /// Attempts to send a new mode request to all the clients. Clients are in
   /// charge to identify if requests are targetted towards them.
   /// 
@@ -63,8 +247,22 @@ public:
   ///   True if the mode request was successfully sent, false otherwise.
   bool send_mode_request(const messages::ModeRequest& mode_request);
 
+  /// Attempts to send a batch of mode requests at once, typically addressed
+  /// to different robots. With writer batching enabled in the config, all
+  /// the requests are flushed out together in as few packets as possible.
+  ///
+  /// \param[in] mode_requests
+  ///   New mode requests to be sent out to the clients.
+  /// \return
+  ///   True if all the mode requests were successfully sent, false otherwise.
+  bool send_mode_requests(
+      const std::vector<messages::ModeRequest>& mode_requests);
+
   /// Attempts to send a new path request to all the clients. Clients are in
-  /// charge to identify if requests are targetted towards them.
+  /// charge to identify if requests are targetted towards them. Requests
+  /// that update the path last sent to the robot, see PathRequest::operation,
+  /// are applied on top of it, and fail when no path has been sent to the
+  /// robot yet.
   ///
   /// \param[in] path_request
   ///   New path request to be sent out to the clients.
@@ -72,6 +270,39 @@ public:
   ///   True if the path request was successfully sent, false otherwise.
   bool send_path_request(const messages::PathRequest& path_request);
 
+  /// Attempts to send a new path request that is handed over to the server,
+  /// see send_path_request. The server keeps its own copy of every path it
+  /// sends out, for rebuilding the remaining path of robots that only report
+  /// their progress, handing the request over lets it take the waypoints
+  /// instead of copying them.
+  ///
+  /// \param[in] path_request
+  ///   New path request to be sent out to the clients.
+  /// \return
+  ///   True if the path request was successfully sent, false otherwise.
+  bool send_path_request(messages::PathRequest&& path_request);
+
+  /// Attempts to send a batch of path requests at once, typically when many
+  /// robots get re-planned together. With writer batching enabled in the
+  /// config, all the requests are flushed out together in as few packets as
+  /// possible.
+  ///
+  /// \param[in] path_requests
+  ///   New path requests to be sent out to the clients.
+  /// \return
+  ///   True if all the path requests were successfully sent, false otherwise.
+  bool send_path_requests(
+      const std::vector<messages::PathRequest>& path_requests);
+
+  /// Attempts to send a batch of path requests that are handed over to the
+  /// server, see send_path_requests and send_path_request.
+  ///
+  /// \param[in] path_requests
+  ///   New path requests to be sent out to the clients.
+  /// \return
+  ///   True if all the path requests were successfully sent, false otherwise.
+  bool send_path_requests(std::vector<messages::PathRequest>&& path_requests);
+
   /// Attempts to send a new destination request to all the clients. Clients 
   /// are in charge to identify if requests are targetted towards them.
   ///
@@ -82,17 +313,109 @@ public:
   bool send_destination_request(
       const messages::DestinationRequest& destination_request);
 
+  /// Attempts to send a batch of destination requests at once. With writer
+  /// batching enabled in the config, all the requests are flushed out
+  /// together in as few packets as possible.
+  ///
+  /// \param[in] destination_requests
+  ///   New destination requests to be sent out to the clients.
+  /// \return
+  ///   True if all the destination requests were successfully sent, false
+  ///   otherwise.
+  bool send_destination_requests(
+      const std::vector<messages::DestinationRequest>& destination_requests);
+
+  /// Queues up a mode request to be sent from the dedicated send thread, and
+  /// returns without waiting for it to be converted and written. Mode
+  /// requests are written ahead of any queued path or destination requests,
+  /// and are the last to be dropped when the queue is full. Otherwise the
+  /// configured send_queue_policy decides which request gets dropped.
+  ///
+  /// \param[in] mode_request
+  ///   New mode request to be sent out to the clients.
+  /// \return
+  ///   True if the mode request was queued, false otherwise.
+  bool send_mode_request_async(const messages::ModeRequest& mode_request);
+
+  /// Queues up a mode request that is handed over to the server, without
+  /// copying it into the queue, see send_mode_request_async.
+  ///
+  /// \param[in] mode_request
+  ///   New mode request to be sent out to the clients.
+  /// \return
+  ///   True if the mode request was queued, false otherwise.
+  bool send_mode_request_async(messages::ModeRequest&& mode_request);
+
+  /// Queues up a path request to be sent from the dedicated send thread, see
+  /// send_mode_request_async.
+  ///
+  /// \param[in] path_request
+  ///   New path request to be sent out to the clients.
+  /// \return
+  ///   True if the path request was queued, false otherwise.
+  bool send_path_request_async(const messages::PathRequest& path_request);
+
+  /// Queues up a path request that is handed over to the server, without
+  /// copying it into the queue, see send_mode_request_async.
+  ///
+  /// \param[in] path_request
+  ///   New path request to be sent out to the clients.
+  /// \return
+  ///   True if the path request was queued, false otherwise.
+  bool send_path_request_async(messages::PathRequest&& path_request);
+
+  /// Queues up a destination request to be sent from the dedicated send
+  /// thread, see send_mode_request_async.
+  ///
+  /// \param[in] destination_request
+  ///   New destination request to be sent out to the clients.
+  /// \return
+  ///   True if the destination request was queued, false otherwise.
+  bool send_destination_request_async(
+      const messages::DestinationRequest& destination_request);
+
+  /// Queues up a destination request that is handed over to the server,
+  /// without copying it into the queue, see send_mode_request_async.
+  ///
+  /// \param[in] destination_request
+  ///   New destination request to be sent out to the clients.
+  /// \return
+  ///   True if the destination request was queued, false otherwise.
+  bool send_destination_request_async(
+      messages::DestinationRequest&& destination_request);
+
   /// Destructor
   ~Server();
 
 private:
 
-  /// Forward declaration and unique implementation
+  /// Forward declaration and implementation of each shard, see
+  /// ServerConfig::shards, which is a single one unless the fleet is sharded
   class ServerImpl;
 
-  std::unique_ptr<ServerImpl> impl;
+  std::vector<std::unique_ptr<ServerImpl>> shards;
+
+  Server();
+
+  static std::unique_ptr<ServerImpl> make_shard(const ServerConfig& config);
+
+  /// Index of the shard that the robot was last heard from on, the number of
+  /// shards if it has not been heard from on any
+  size_t find_shard(const std::string& robot_name) const;
+
+  /// Sends a request through the shard of its robot, or through every shard
+  /// for robots that have not been heard from. The last shard that the
+  /// request is sent through is flagged, so that it can take the request.
+  template <typename Send>
+  bool route_request(const std::string& robot_name, const Send& send);
+
+  /// Splits a batch of requests between the shards of their robots, sending
+  /// requests for robots that have not been heard from through every shard.
+  template <typename Request, typename Send>
+  bool route_requests(std::vector<Request>&& requests, const Send& send);
 
-  Server(const ServerConfig& config);
+  static std::vector<std::string> unique_robot_names(
+      std::vector<std::string> robot_names);
 
 };
 
@@ -19,16 +19,214 @@
 #define FREE_FLEET__INCLUDE__FREE_FLEET__SERVERCONFIG_HPP
 
 #include <string>
+#include <vector>
+#include <cstddef>
+
+#include <free_fleet/TopicQoS.hpp>
+#include <free_fleet/DiscoveryConfig.hpp>
+#include <free_fleet/ThreadConfig.hpp>
 
 namespace free_fleet {
 
 struct ServerConfig
 {
+  std::string fleet_name = "fleet_name";
   int dds_domain = 42;
   std::string dds_robot_state_topic = "robot_state";
   std::string dds_mode_request_topic = "mode_request";
   std::string dds_path_request_topic = "path_request";
   std::string dds_destination_request_topic = "destination_request";
+  std::string dds_fleet_state_topic = "fleet_state";
+  std::string dds_registration_topic = "robot_registration";
+  std::string dds_registration_ack_topic = "robot_registration_ack";
+  std::string dds_time_sync_ping_topic = "time_sync_ping";
+  std::string dds_time_sync_pong_topic = "time_sync_pong";
+  std::string dds_robot_pose_topic = "robot_pose";
+  std::string dds_robot_metadata_topic = "robot_metadata";
+  std::string dds_request_ack_topic = "request_ack";
+
+  /// QoS of each topic, these need to be compatible between the server and
+  /// all of its clients
+  TopicQoS dds_robot_state_qos = TopicQoS::best_effort();
+  TopicQoS dds_mode_request_qos = TopicQoS::urgent_requests();
+  TopicQoS dds_path_request_qos = TopicQoS::reliable_requests();
+  TopicQoS dds_destination_request_qos = TopicQoS::reliable_requests();
+  TopicQoS dds_fleet_state_qos = TopicQoS::latest_state();
+  TopicQoS dds_registration_qos = TopicQoS::latest_state();
+  TopicQoS dds_time_sync_qos = TopicQoS::best_effort();
+  TopicQoS dds_robot_pose_qos = TopicQoS::best_effort();
+  TopicQoS dds_robot_metadata_qos = TopicQoS::latest_state();
+  TopicQoS dds_request_ack_qos = TopicQoS::reliable_requests();
+
+  /// Publishes each request only into the DDS partition of the robot it is
+  /// addressed to, named fleet_name/robot_name, instead of broadcasting it to
+  /// every client. Clients need to enable this as well to receive requests.
+  bool dds_request_partitions = false;
+
+  /// DDS partition that every topic of the server is published and
+  /// subscribed in, which its clients and observers need to use as well. The
+  /// per-robot request partitions are used instead for requests when they
+  /// are enabled. The default partition if empty.
+  std::string dds_partition = "";
+
+  /// Uses the CycloneDDS shared memory transport, through iceoryx, between
+  /// the server and the clients and adapters running on the same host,
+  /// while participants on other hosts are still reached over the network.
+  /// It needs the library to be built with FREE_FLEET_SHARED_MEMORY against
+  /// a CycloneDDS built with iceoryx, and a RouDi daemon to be running,
+  /// otherwise a warning is logged and the network is used. Note that this
+  /// applies to the whole DDS domain within the process.
+  bool dds_shared_memory = false;
+
+  /// Discovery of the other participants, applied to the DDS domain along
+  /// with the shared memory setting when the participant is created. Like
+  /// it, this applies to the whole DDS domain within the process.
+  DiscoveryConfig dds_discovery;
+
+  /// CPUs and scheduling of the threads that CycloneDDS starts for the
+  /// domain, its receive threads among them, applied along with the
+  /// discovery settings when the participant is created. Like them, this
+  /// applies to the whole DDS domain within the process.
+  ThreadConfig dds_threads;
+
+  /// CPUs and scheduling of every thread that the server starts itself, the
+  /// waitset threads that take robot states in, the ingest threads, and the
+  /// send, fleet state, time sync and retry threads
+  ThreadConfig threads;
+
+  /// Part of the fleet that is served by its own participant or partition
+  struct Shard
+  {
+    int dds_domain = 42;
+
+    std::string dds_partition = "";
+  };
+
+  /// Splits the fleet into shards, each with its own robot state reader,
+  /// ingest thread, writers and fleet snapshot, on the DDS domain and within
+  /// the DDS partition of the shard, replacing dds_domain and dds_partition.
+  /// Every client joins a single shard through the same domain and
+  /// partition. The server takes states in from every shard, and routes each
+  /// request to the shard that the robot was last heard from on, or to
+  /// every shard for robots that have not been heard from. Fleet states are
+  /// published by each shard for its own robots. A single shard on
+  /// dds_domain and dds_partition if empty.
+  std::vector<Shard> shards;
+
+  /// Enables DDS writer batching, samples are then queued up and only sent
+  /// out once the writer gets flushed, which every send call does once it is
+  /// done writing. Note that this is a process wide DDS setting.
+  bool dds_write_batching = false;
+
+  /// What happens to requests sent through the send_*_async calls when the
+  /// send queue is already full
+  enum class SendQueuePolicy
+  {
+    /// Drops the oldest queued request to make space for the new one
+    DropOldest,
+
+    /// A new request replaces the request last queued for the same robot,
+    /// which it supersedes, if that one is of the same kind and queued after
+    /// the same task. The oldest request only gets dropped when there is
+    /// none to replace.
+    CoalescePerRobot
+  };
+
+  /// Maximum number of requests waiting to be written by the send thread
+  size_t send_queue_capacity = 128;
+
+  SendQueuePolicy send_queue_policy = SendQueuePolicy::DropOldest;
+
+  /// Number of threads that incoming robot states are converted on, batches
+  /// of states get split between them when there are enough to go around.
+  /// 1 converts everything on the thread reading the states.
+  size_t ingest_threads = 1;
+
+  /// Number of robot states taken from the reader at a time to begin with,
+  /// registrations and time sync pongs are taken in windows of the same size.
+  /// A window doubles every time a take fills it up, up to
+  /// max_take_window, so that the states of a fleet larger than the window
+  /// are soon taken in a single take instead of several.
+  size_t robot_state_take_window = 16;
+
+  size_t max_take_window = 1024;
+
+  /// Robots that have not sent a state for this many seconds are considered
+  /// lost, and are removed from the fleet snapshot, disabled if 0. Robots
+  /// whose state writers go away, or lose their liveliness, are lost right
+  /// away regardless.
+  double robot_expiry_timeout = 0.0;
+
+  /// Publishes the fleet snapshot as a single FleetState on the fleet state
+  /// topic every this many seconds, whenever it has changed, for observers
+  /// that need the whole fleet without subscribing to every robot state, see
+  /// FleetObserver. The snapshot only changes while robot states are being
+  /// taken in. Disabled if 0.
+  double fleet_state_period = 0.0;
+
+  /// Sends only the changed tail of a path request, as an update of the
+  /// path that was last sent to the same robot, whenever the robot reports
+  /// that it is following that path and the start of the new path matches
+  /// its remaining waypoints, see PathRequest::operation. Requests that carry
+  /// their own operation are always sent as they are. Every client needs to
+  /// understand path updates before this is enabled, and robot states need
+  /// to be taken in for the server to know which path each robot follows.
+  bool incremental_path_requests = false;
+
+  /// Path requests with at least this many waypoints send them packed into
+  /// a delta encoded block of bytes, which usually takes a fraction of the
+  /// plain waypoints for constrained links, paths are only sent packed when
+  /// that makes them smaller. Packed paths are always understood by clients
+  /// and servers alike, whatever their own threshold. Disabled if 0.
+  size_t path_packing_threshold = 0;
+
+  /// Also takes in the robot states that clients split into poses and
+  /// metadata, see ClientConfig::split_robot_state, merging every pose with
+  /// the latest metadata of its robot so that it comes out as a whole robot
+  /// state, and the fleet state is left unchanged. Poses are held back until
+  /// the metadata of their robot has arrived. Robot states that are not
+  /// split are still taken in as they are.
+  bool split_robot_states = false;
+
+  /// Pings every client this many seconds to estimate how far the clock of
+  /// each robot is off from the server's, see Server::get_clock_offsets. The
+  /// location of each robot state, which robots stamp with their own clocks,
+  /// is then moved onto the server's clock as the state is taken in, and so
+  /// is the time it was sent at for the receipt age in the stats. Waypoint
+  /// times already come from the server's requests and are left as they
+  /// are. Clients need to enable time sync as well to answer the pings.
+  /// Disabled if 0.
+  double time_sync_period = 0.0;
+
+  /// Sends every request again if its robot has not acknowledged it within
+  /// this many seconds, doubling the wait after every retry up to
+  /// request_retry_max_timeout, until it is acknowledged, superseded by a
+  /// newer request of the same kind for the same robot, or has been sent
+  /// request_max_retries more times. Clients need to enable request acks,
+  /// see ClientConfig::request_acks, otherwise every request is retried
+  /// until it runs out of retries. Each shard only hears the acks of its own
+  /// robots, so requests routed to every shard, for robots that have not
+  /// been heard from, run out of retries on the other shards. Disabled if 0.
+  double request_retry_timeout = 0.0;
+
+  double request_retry_max_timeout = 8.0;
+
+  size_t request_max_retries = 5;
+
+  /// Keeps the poses and modes of the last this many states of every robot,
+  /// for looking up where robots have been over a time range, see
+  /// Server::get_state_history. The history of each robot is allocated in
+  /// full when its first state is taken in, and is kept after the robot is
+  /// lost. Disabled if 0.
+  size_t robot_state_history_capacity = 0;
+
+  /// Keeps the robots of the fleet snapshot in a grid of cells this many
+  /// meters wide on every level, so that Server::query_radius and
+  /// Server::query_box only look at the robots in the cells that overlap the
+  /// queried area. Positions are in the fleet's own coordinates, and cells
+  /// should be around the size of the typical query. Queries go through the
+  /// whole snapshot instead if 0.
+  double spatial_index_cell_size = 0.0;
 
   void print_config() const;
 };
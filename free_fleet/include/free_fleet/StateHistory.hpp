@@ -0,0 +1,62 @@
+/*
+ * Copyright (C) 2019 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#ifndef FREE_FLEET__INCLUDE__FREE_FLEET__STATEHISTORY_HPP
+#define FREE_FLEET__INCLUDE__FREE_FLEET__STATEHISTORY_HPP
+
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+
+namespace free_fleet {
+
+/// States of a single robot over time, as structure of arrays, where the
+/// same index of every array belongs to the same state, oldest first. See
+/// Server::get_state_history.
+struct StateHistory
+{
+  /// Time of the robot's location in nanoseconds, by the server's clock
+  /// when the robot's clock offset is known, see ServerConfig::time_sync_period
+  std::vector<int64_t> time;
+
+  std::vector<float> x;
+
+  std::vector<float> y;
+
+  std::vector<float> yaw;
+
+  /// See messages::RobotMode
+  std::vector<uint32_t> mode;
+
+  size_t size() const
+  {
+    return time.size();
+  }
+
+  void clear()
+  {
+    time.clear();
+    x.clear();
+    y.clear();
+    yaw.clear();
+    mode.clear();
+  }
+};
+
+} // namespace free_fleet
+
+#endif // FREE_FLEET__INCLUDE__FREE_FLEET__STATEHISTORY_HPP
@@ -0,0 +1,141 @@
+/*
+ * Copyright (C) 2019 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#ifndef FREE_FLEET__INCLUDE__FREE_FLEET__STATS_HPP
+#define FREE_FLEET__INCLUDE__FREE_FLEET__STATS_HPP
+
+#include <array>
+#include <string>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+
+namespace free_fleet {
+
+/// Distribution of durations in nanoseconds. Durations are counted in
+/// log-linear buckets, the way HDR histograms do, every power of two is split
+/// into SubBuckets buckets of equal width. This keeps the relative error of
+/// every percentile under 1 / SubBuckets across the whole range, with a fixed
+/// number of buckets.
+struct LatencyHistogram
+{
+  static constexpr size_t SubBucketBits = 4;
+
+  static constexpr size_t SubBuckets = size_t(1) << SubBucketBits;
+
+  /// Durations are clamped to below 2^MaxValueBits nanoseconds, a little
+  /// over 18 minutes
+  static constexpr size_t MaxValueBits = 40;
+
+  static constexpr size_t BucketCount =
+      (MaxValueBits - SubBucketBits + 1) * SubBuckets;
+
+  /// \param[in] value
+  ///   Duration in nanoseconds.
+  /// \return
+  ///   Index of the bucket that the duration is counted in.
+  static size_t bucket_of(uint64_t value);
+
+  /// \param[in] bucket
+  ///   Index of the bucket.
+  /// \return
+  ///   Largest duration that is counted in the bucket.
+  static uint64_t bucket_upper_bound(size_t bucket);
+
+  /// Number of durations counted in each bucket
+  std::array<uint64_t, BucketCount> counts = {};
+
+  /// Number of durations counted
+  uint64_t count = 0;
+
+  /// Sum of the durations counted
+  uint64_t sum = 0;
+
+  /// Longest duration counted
+  uint64_t max = 0;
+
+  /// \return
+  ///   Average duration, 0 if nothing was counted.
+  double mean() const;
+
+  /// \param[in] percentile
+  ///   Percentile between 0 and 100.
+  /// \return
+  ///   Upper bound of the bucket that the percentile falls in, which is
+  ///   never below the actual duration, 0 if nothing was counted.
+  uint64_t percentile(double percentile) const;
+
+  /// Adds the durations counted by another histogram to this one.
+  void merge(const LatencyHistogram& other);
+};
+
+/// Traffic through a single DDS topic since the server or client was made.
+struct TopicStats
+{
+  std::string topic;
+
+  uint64_t messages_sent = 0;
+
+  uint64_t messages_received = 0;
+
+  /// Payload of the messages, counting every string and sequence element
+  /// the way they are serialized, without the protocol overhead
+  uint64_t bytes_sent = 0;
+
+  uint64_t bytes_received = 0;
+
+  /// Messages that dds_write failed to write
+  uint64_t write_failures = 0;
+
+  /// Samples that never made it to the reader, as reported by DDS
+  uint64_t samples_lost = 0;
+
+  /// Samples that the reader had no room for, as reported by DDS
+  uint64_t samples_rejected = 0;
+};
+
+/// Snapshot of the statistics collected by a server or client.
+struct Stats
+{
+  /// Every topic that is written to or read from, including the ones that
+  /// are not enabled in the config, which stay at 0
+  std::vector<TopicStats> topics;
+
+  /// Time taken converting each message to or from its DDS sample
+  LatencyHistogram conversion_time;
+
+  /// Time between each robot state being written and the server taking it
+  /// in, or each request being written and the client taking it in. This
+  /// compares the clocks of different machines, which need to be kept in
+  /// sync for it to mean anything, samples from ahead of the local clock
+  /// count as 0.
+  LatencyHistogram receipt_age;
+
+  /// Time between each request first being written by the server and its
+  /// robot acknowledging it, only counted on servers that retry requests
+  LatencyHistogram request_ack_time;
+
+  /// Requests that the server sent again for not being acknowledged in time
+  uint64_t request_retries = 0;
+
+  /// Requests that ran out of retries without being acknowledged
+  uint64_t unacknowledged_requests = 0;
+};
+
+} // namespace free_fleet
+
+#endif // FREE_FLEET__INCLUDE__FREE_FLEET__STATS_HPP
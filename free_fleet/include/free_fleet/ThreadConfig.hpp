@@ -0,0 +1,58 @@
+/*
+ * Copyright (C) 2019 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#ifndef FREE_FLEET__INCLUDE__FREE_FLEET__THREADCONFIG_HPP
+#define FREE_FLEET__INCLUDE__FREE_FLEET__THREADCONFIG_HPP
+
+#include <string>
+#include <vector>
+
+namespace free_fleet {
+
+/// Which CPUs a thread runs on and how it gets scheduled, so that the
+/// threads of free fleet can be kept away from the cores of other processes
+/// on shared computers, or ahead of them. Threads are left as they are when
+/// every setting is at its default.
+struct ThreadConfig
+{
+  /// CPUs that the thread is pinned to, any CPU if empty
+  std::vector<int> cpus;
+
+  /// Runs the thread under SCHED_FIFO with this priority, between 1 and 99,
+  /// which needs CAP_SYS_NICE or a large enough rtprio limit. The default
+  /// scheduling if 0.
+  int fifo_priority = 0;
+
+  /// Whether the thread is left as it is
+  bool is_default() const;
+
+  /// Pins the calling thread to the CPUs and sets its scheduling. Settings
+  /// that could not be applied are logged and left as they were.
+  ///
+  /// \param[in] name
+  ///   Name of the thread, only used in the warnings.
+  /// \return
+  ///   True if every setting was applied.
+  bool apply(const char* name) const;
+
+  /// Human readable summary of the settings, used when printing configs
+  std::string to_string() const;
+};
+
+} // namespace free_fleet
+
+#endif // FREE_FLEET__INCLUDE__FREE_FLEET__THREADCONFIG_HPP
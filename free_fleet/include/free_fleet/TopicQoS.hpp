@@ -0,0 +1,78 @@
+/*
+ * Copyright (C) 2019 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#ifndef FREE_FLEET__INCLUDE__FREE_FLEET__TOPICQOS_HPP
+#define FREE_FLEET__INCLUDE__FREE_FLEET__TOPICQOS_HPP
+
+#include <string>
+
+namespace free_fleet {
+
+/// Quality of service settings used for the readers and writers of a single
+/// DDS topic. Both ends of a topic need compatible settings to be matched,
+/// a reliable reader will not receive anything from a best effort writer.
+struct TopicQoS
+{
+  /// Reliable delivery with retransmissions, otherwise best effort
+  bool reliable = false;
+
+  /// Number of samples to keep per instance, keeps all samples if set to 0
+  int history_depth = 1;
+
+  /// Keeps the last samples around for late joining readers
+  bool transient_local = false;
+
+  /// Maximum expected time between samples in seconds, disabled if 0
+  double deadline = 0.0;
+
+  /// Acceptable additional delay in seconds before samples go out, allowing
+  /// DDS to group samples together, disabled if 0
+  double latency_budget = 0.0;
+
+  /// Time in seconds that a writer stays alive for without being heard from,
+  /// readers see the instances of the writer as no longer alive after that.
+  /// Left to the participant's own lease if 0
+  double liveliness_lease = 0.0;
+
+  /// Transport priority of the samples, higher values are more urgent. DDS
+  /// implementations use it to prioritise the sending of samples over those
+  /// of other writers, and can map it onto the DSCP marking of the packets
+  /// through their network configuration. Left to the default if 0
+  int transport_priority = 0;
+
+  /// Default settings for high rate robot states, that are cheap to lose
+  static TopicQoS best_effort();
+
+  /// Default settings for one-shot requests, which must not be lost
+  static TopicQoS reliable_requests();
+
+  /// Default settings for safety critical requests such as pausing or
+  /// stopping robots, which must not be lost and must not be held back
+  /// behind other traffic
+  static TopicQoS urgent_requests();
+
+  /// Default settings for states that are published as a whole, only the
+  /// latest one matters and is kept around for observers that join late
+  static TopicQoS latest_state();
+
+  /// Human readable summary of the settings, used when printing configs
+  std::string to_string() const;
+};
+
+} // namespace free_fleet
+
+#endif // FREE_FLEET__INCLUDE__FREE_FLEET__TOPICQOS_HPP
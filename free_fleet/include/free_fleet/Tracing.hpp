@@ -0,0 +1,85 @@
+/*
+ * Copyright (C) 2019 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#ifndef FREE_FLEET__INCLUDE__FREE_FLEET__TRACING_HPP
+#define FREE_FLEET__INCLUDE__FREE_FLEET__TRACING_HPP
+
+namespace free_fleet {
+namespace tracing {
+
+/// Kind of request recorded along with every request tracepoint.
+enum class RequestKind : int
+{
+  Mode = 0,
+  Path = 1,
+  Destination = 2
+};
+
+#ifdef FREE_FLEET_TRACING
+
+/// Every stage a request goes through on its way from RMF to the robot has
+/// its own LTTng-UST tracepoint in the free_fleet provider, which is emitted
+/// by the free_fleet library the same way tracetools does for ros2_tracing,
+/// so that the nodes do not need to define any tracepoints of their own.
+/// Events of the same request share their robot name and task id, which the
+/// clients already require to be unique per robot, so a per-request latency
+/// breakdown is rebuilt by joining events on those two fields.
+///
+/// Use FREE_FLEET_TRACEPOINT instead of calling these directly, so that the
+/// call sites compile out when the library is built without tracing.
+
+/// A request was received from RMF by the server node.
+void trace_rmf_request_received(
+    RequestKind kind, const char* robot_name, const char* task_id);
+
+/// The server node handed the request over to the server to be sent.
+void trace_server_request_queued(
+    RequestKind kind, const char* robot_name, const char* task_id);
+
+/// The server converted and wrote the request to DDS.
+void trace_server_request_written(
+    RequestKind kind, const char* robot_name, const char* task_id);
+
+/// The client took the request from DDS and converted it.
+void trace_client_request_taken(
+    RequestKind kind, const char* robot_name, const char* task_id);
+
+/// The client node accepted the request as addressed to its robot and new.
+void trace_client_request_accepted(
+    RequestKind kind, const char* robot_name, const char* task_id);
+
+/// The client node sent the goal of the request to the navigation stack.
+void trace_client_goal_sent(
+    RequestKind kind, const char* robot_name, const char* task_id);
+
+#endif
+
+} // namespace tracing
+} // namespace free_fleet
+
+/// Records a request going through one of the stages above, for example
+/// FREE_FLEET_TRACEPOINT(client_request_taken, tracing::RequestKind::Path,
+/// name, task_id). Neither the call nor its arguments are compiled in without
+/// tracing.
+#ifdef FREE_FLEET_TRACING
+#define FREE_FLEET_TRACEPOINT(stage, kind, robot_name, task_id) \
+    ::free_fleet::tracing::trace_##stage((kind), (robot_name), (task_id))
+#else
+#define FREE_FLEET_TRACEPOINT(stage, kind, robot_name, task_id) ((void)0)
+#endif
+
+#endif // FREE_FLEET__INCLUDE__FREE_FLEET__TRACING_HPP
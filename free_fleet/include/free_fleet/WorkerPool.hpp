@@ -0,0 +1,116 @@
+/*
+ * Copyright (C) 2019 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#ifndef FREE_FLEET__INCLUDE__FREE_FLEET__WORKERPOOL_HPP
+#define FREE_FLEET__INCLUDE__FREE_FLEET__WORKERPOOL_HPP
+
+#include <mutex>
+#include <memory>
+#include <thread>
+#include <vector>
+#include <cstddef>
+#include <functional>
+#include <condition_variable>
+
+#include <free_fleet/ThreadConfig.hpp>
+
+namespace free_fleet {
+
+/// Fixed set of threads that splits loops over independent elements between
+/// them. Every element only ever gets written by the thread that was handed
+/// its index, so results land in the same order as the input, regardless of
+/// how the work was scheduled.
+class WorkerPool
+{
+public:
+
+  using SharedPtr = std::shared_ptr<WorkerPool>;
+
+  /// Function handling the elements within [begin, end)
+  using RangeFunction = std::function<void(size_t begin, size_t end)>;
+
+  /// Constructor
+  ///
+  /// \param[in] threads
+  ///   Total number of threads working on each loop, including the calling
+  ///   thread, 0 or 1 run everything on the calling thread.
+  /// \param[in] thread_config
+  ///   CPUs and scheduling of the threads started by the pool, the calling
+  ///   thread is left as it is.
+  WorkerPool(
+      size_t threads, const ThreadConfig& thread_config = ThreadConfig());
+
+  ~WorkerPool();
+
+  WorkerPool(const WorkerPool&) = delete;
+
+  WorkerPool& operator=(const WorkerPool&) = delete;
+
+  /// Number of threads working on each loop, including the calling thread
+  size_t size() const;
+
+  /// Splits [0, count) into contiguous ranges handled by the workers and the
+  /// calling thread, and returns once all of them are done. Loops are run
+  /// one at a time, concurrent callers wait for their turn.
+  ///
+  /// \param[in] count
+  ///   Number of elements.
+  /// \param[in] min_range
+  ///   Ranges are never made smaller than this, small loops are not worth
+  ///   waking up the workers for.
+  /// \param[in] function
+  ///   Function to be called with each range.
+  void parallel_for(
+      size_t count, size_t min_range, const RangeFunction& function);
+
+private:
+
+  void thread_fn(size_t worker_index);
+
+  ThreadConfig thread_config;
+
+  std::vector<std::thread> workers;
+
+  /// Only one loop is handed out at a time
+  std::mutex loop_mutex;
+
+  std::mutex mutex;
+
+  std::condition_variable work_cv;
+
+  std::condition_variable done_cv;
+
+  /// Incremented for every loop handed to the workers
+  size_t generation;
+
+  size_t pending;
+
+  size_t range_size;
+
+  size_t range_count;
+
+  size_t element_count;
+
+  const RangeFunction* range_function;
+
+  bool running;
+
+};
+
+} // namespace free_fleet
+
+#endif // FREE_FLEET__INCLUDE__FREE_FLEET__WORKERPOOL_HPP
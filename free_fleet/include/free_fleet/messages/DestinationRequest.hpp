@@ -18,6 +18,9 @@
 #ifndef FREE_FLEET__INCLUDE__FREE_FLEET__MESSAGES__DESTINATIONREQUEST_HPP
 #define FREE_FLEET__INCLUDE__FREE_FLEET__MESSAGES__DESTINATIONREQUEST_HPP
 
+#include <string>
+#include <cstdint>
+
 #include "Location.hpp"
 
 namespace free_fleet {
@@ -29,6 +32,16 @@ struct DestinationRequest
   std::string robot_name;
   Location destination;
   std::string task_id;
+
+  /// Numeric id of the robot the request is addressed to, filled in by the
+  /// server for robots that have registered, and used instead of the fleet
+  /// and robot names to address the request. Left to 0 when sending.
+  uint32_t robot_id = 0;
+
+  /// Queues the request on the robot to start once it completes the task
+  /// with this id, see PathRequest::after_task_id. Left empty to replace the
+  /// current path right away.
+  std::string after_task_id;
 };
 
 } // namespace messages
@@ -20,6 +20,7 @@
 
 #include <string>
 #include <vector>
+#include <cstdint>
 
 #include "RobotMode.hpp"
 #include "ModeParameter.hpp"
@@ -34,6 +35,11 @@ struct ModeRequest
   RobotMode mode;
   std::string task_id;
   std::vector<ModeParameter> parameters;
+
+  /// Numeric id of the robot the request is addressed to, filled in by the
+  /// server for robots that have registered, and used instead of the fleet
+  /// and robot names to address the request. Left to 0 when sending.
+  uint32_t robot_id = 0;
 };
 
 } // namespace messages
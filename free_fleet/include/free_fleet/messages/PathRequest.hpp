@@ -18,7 +18,10 @@
 #ifndef FREE_FLEET__INCLUDE__FREE_FLEET__MESSAGES__PATHREQUEST_HPP
 #define FREE_FLEET__INCLUDE__FREE_FLEET__MESSAGES__PATHREQUEST_HPP
 
+#include <string>
 #include <vector>
+#include <cstddef>
+#include <cstdint>
 
 #include "Location.hpp"
 
@@ -31,6 +34,53 @@ struct PathRequest
   std::string robot_name;
   std::vector<Location> path;
   std::string task_id;
+
+  /// Stamped by the server when the request is sent out, so that robots can
+  /// report their progress along this path by version and waypoint index.
+  uint32_t version = 0;
+
+  /// Requests either carry the whole path, or only change the tail of the
+  /// path of an earlier request, so that robots can keep going towards their
+  /// current waypoint when only the end of their path changes. Updates are
+  /// applied on top of the path of base_version, which is stamped by the
+  /// server, and robots that are not following that path ignore them. Waypoint
+  /// indices count from the start of the base path, including waypoints that
+  /// have already been passed.
+  uint32_t operation = PATH_REPLACE;
+  static const uint32_t PATH_REPLACE = 0;
+  /// The waypoints are appended to the end of the base path
+  static const uint32_t PATH_APPEND = 1;
+  /// The base path is kept up to start_index, followed by the waypoints
+  static const uint32_t PATH_REPLACE_FROM = 2;
+  /// The base path is cut down to start_index, without any waypoints
+  static const uint32_t PATH_TRUNCATE = 3;
+
+  uint32_t base_version = 0;
+
+  uint32_t start_index = 0;
+
+  /// Number of waypoints at the start of the base path that are kept by this
+  /// request, the waypoints of this request follow after them.
+  size_t kept_waypoints(size_t base_length) const
+  {
+    if (operation == PATH_APPEND)
+      return base_length;
+    if (operation == PATH_REPLACE)
+      return 0;
+    return start_index < base_length ? start_index : base_length;
+  }
+
+  /// Numeric id of the robot the request is addressed to, filled in by the
+  /// server for robots that have registered, and used instead of the fleet
+  /// and robot names to address the request. Left to 0 when sending.
+  uint32_t robot_id = 0;
+
+  /// Queues the request on the robot to start once it completes the task
+  /// with this id, instead of replacing its current path, so that the robot
+  /// moves on to its next task without waiting for the server. Queued
+  /// requests always carry their whole path. Left empty to replace the
+  /// current path right away.
+  std::string after_task_id;
 };
 
 } // namespace messages
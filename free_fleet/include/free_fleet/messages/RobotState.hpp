@@ -20,6 +20,7 @@
 
 #include <string>
 #include <vector>
+#include <cstdint>
 
 #include "Location.hpp"
 #include "RobotMode.hpp"
@@ -36,6 +37,22 @@ struct RobotState
   float battery_percent;
   Location location;
   std::vector<Location> path;
+
+  /// Version of the path request that the robot is currently following, 0
+  /// when it is not following any path request.
+  uint32_t path_version = 0;
+
+  /// Index of the waypoint the robot is heading to, within the path of the
+  /// path request it is following. Clients using compact path progress leave
+  /// the path empty, which is then rebuilt by the server from its own copy
+  /// of the path request.
+  uint32_t path_index = 0;
+
+  /// Numeric id the server assigned to the robot when it registered, 0 for
+  /// robots that have not registered. Registered robots leave the model and
+  /// task id out of the states they send, which are filled back in by the
+  /// server from their registration.
+  uint32_t robot_id = 0;
 };
 
 } // namespace messages
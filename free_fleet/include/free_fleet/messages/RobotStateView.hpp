@@ -0,0 +1,144 @@
+/*
+ * Copyright (C) 2019 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#ifndef FREE_FLEET__INCLUDE__FREE_FLEET__MESSAGES__ROBOTSTATEVIEW_HPP
+#define FREE_FLEET__INCLUDE__FREE_FLEET__MESSAGES__ROBOTSTATEVIEW_HPP
+
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+
+#include "RobotMode.hpp"
+#include "RobotState.hpp"
+
+struct FreeFleetData_RobotState;
+struct FreeFleetData_RobotPose;
+
+namespace free_fleet {
+namespace messages {
+
+/// Location read in place from a received message, the level name points
+/// into the message and is never null.
+struct LocationView
+{
+  int32_t sec;
+  uint32_t nanosec;
+  float x;
+  float y;
+  float yaw;
+  const char* level_name;
+};
+
+/// Read-only view over a robot state as it was received, without copying any
+/// of its strings or its path. A view is only valid for as long as the
+/// sample it was handed out with, see Server::read_robot_state_views, and
+/// must be converted for the state to be kept around any longer.
+///
+/// Views of robots whose clock offset from the server is known, see
+/// ServerConfig::time_sync_period, report the time of their location by the
+/// server's clock. Waypoints keep the times of the requests they came from.
+class RobotStateView
+{
+public:
+
+  RobotStateView(
+      const FreeFleetData_RobotState& sample,
+      int64_t clock_offset = 0);
+
+  /// View of the state of a registered robot, which reports the model and
+  /// task id it registered with instead of its empty ones. The strings need
+  /// to stay valid for as long as the view.
+  RobotStateView(
+      const FreeFleetData_RobotState& sample,
+      const char* model,
+      const char* task_id,
+      int64_t clock_offset = 0);
+
+  /// View of a robot state that was split into its pose and its metadata,
+  /// see ClientConfig::split_robot_state, which reports the mode and
+  /// location of the pose along with the rest of the metadata. The model and
+  /// task id are the ones the robot registered with unless null, and both
+  /// samples need to stay valid for as long as the view.
+  RobotStateView(
+      const FreeFleetData_RobotState& metadata,
+      const FreeFleetData_RobotPose& pose,
+      const char* model,
+      const char* task_id,
+      int64_t clock_offset = 0);
+
+  /// The strings are never null
+  const char* name() const;
+
+  const char* model() const;
+
+  const char* task_id() const;
+
+  RobotMode mode() const;
+
+  float battery_percent() const;
+
+  LocationView location() const;
+
+  /// Number of waypoints in the path, robots that only report their path
+  /// progress send an empty path, see RobotState::path_index. Paths that
+  /// were sent packed, see ClientConfig::path_packing_threshold, are
+  /// unpacked the first time the path is looked at.
+  size_t path_size() const;
+
+  /// Waypoint of the path at the index, which needs to be below path_size.
+  LocationView path(size_t index) const;
+
+  uint32_t path_version() const;
+
+  uint32_t path_index() const;
+
+  uint32_t robot_id() const;
+
+private:
+
+  friend void convert(const RobotStateView& input, RobotState& output);
+
+  const std::vector<LocationView>& unpacked_path() const;
+
+  const FreeFleetData_RobotState* sample;
+
+  /// Pose of a split robot state, which takes over the mode and location of
+  /// the sample
+  const FreeFleetData_RobotPose* pose = nullptr;
+
+  const char* registered_model = nullptr;
+
+  const char* registered_task_id = nullptr;
+
+  /// Nanoseconds that the robot's clock is ahead of the server's
+  int64_t clock_offset = 0;
+
+  /// Waypoints of a packed path, once unpacked
+  mutable std::vector<LocationView> unpacked_waypoints;
+
+  mutable bool path_unpacked = false;
+
+};
+
+/// Copies the viewed robot state into one that can be kept around. Existing
+/// string and path capacities of the output are reused.
+void convert(const RobotStateView& input, RobotState& output);
+
+} // namespace messages
+} // namespace free_fleet
+
+#endif // FREE_FLEET__INCLUDE__FREE_FLEET__MESSAGES__ROBOTSTATEVIEW_HPP
@@ -22,58 +22,213 @@
 #include "ClientImpl.hpp"
 
 #include "messages/FleetMessages.h"
+#include "dds_utils/DDSParticipant.hpp"
 #include "dds_utils/DDSPublishHandler.hpp"
 #include "dds_utils/DDSSubscribeHandler.hpp"
+#include "dds_utils/DDSWaitSetHandler.hpp"
+#include "dds_utils/common.hpp"
 
 namespace free_fleet {
 
 Client::SharedPtr Client::make(const ClientConfig& _config)
 {
+  using ModeRequestSub =
+      ClientImpl::RequestSubscribeHandler<FreeFleetData_ModeRequest>;
+  using PathRequestSub =
+      ClientImpl::RequestSubscribeHandler<FreeFleetData_PathRequest>;
+  using DestinationRequestSub =
+      ClientImpl::RequestSubscribeHandler<FreeFleetData_DestinationRequest>;
+  using RegistrationAckSub =
+      ClientImpl::RequestSubscribeHandler<FreeFleetData_RobotRegistrationAck>;
+  using TimeSyncPingSub =
+      ClientImpl::RequestSubscribeHandler<FreeFleetData_TimeSyncPing>;
+
   SharedPtr client = SharedPtr(new Client(_config));
 
-  dds_entity_t participant = dds_create_participant(
-      static_cast<dds_domainid_t>(_config.dds_domain), NULL, NULL);
-  if (participant < 0)
-  {
-    DDS_FATAL("dds_create_participant: %s\n", dds_strretcode(-participant));
+  dds::DDSParticipant::SharedPtr shared_participant =
+      dds::DDSParticipant::get(
+          static_cast<dds_domainid_t>(_config.dds_domain),
+          common::domain_config(
+              _config.dds_shared_memory, _config.dds_discovery,
+              _config.dds_threads),
+          _config.dds_threads.cpus);
+  if (!shared_participant)
     return nullptr;
+  dds_entity_t participant = shared_participant->get_entity();
+
+  // Split robot states go out as poses and metadata on topics of their own,
+  // in place of the robot state topic
+  dds::DDSPublishHandler<FreeFleetData_RobotState>::SharedPtr state_pub;
+  dds::DDSPublishHandler<FreeFleetData_RobotPose>::SharedPtr pose_pub;
+  dds::DDSPublishHandler<FreeFleetData_RobotState>::SharedPtr metadata_pub;
+  if (_config.split_robot_state)
+  {
+    dds_qos_t* pose_qos = common::create_qos(_config.dds_pose_qos);
+    pose_pub.reset(
+        new dds::DDSPublishHandler<FreeFleetData_RobotPose>(
+            participant, &FreeFleetData_RobotPose_desc,
+            _config.dds_pose_topic, pose_qos, _config.dds_partition));
+    dds_delete_qos(pose_qos);
+
+    dds_qos_t* metadata_qos = common::create_qos(_config.dds_metadata_qos);
+    metadata_pub.reset(
+        new dds::DDSPublishHandler<FreeFleetData_RobotState>(
+            participant, &FreeFleetData_RobotState_desc,
+            _config.dds_metadata_topic, metadata_qos,
+            _config.dds_partition));
+    dds_delete_qos(metadata_qos);
+    if (!pose_pub->is_ready() || !metadata_pub->is_ready())
+      return nullptr;
+  }
+  else
+  {
+    dds_qos_t* state_qos = common::create_qos(_config.dds_state_qos);
+    state_pub.reset(
+        new dds::DDSPublishHandler<FreeFleetData_RobotState>(
+            participant, &FreeFleetData_RobotState_desc,
+            _config.dds_state_topic, state_qos, _config.dds_partition));
+    dds_delete_qos(state_qos);
+    if (!state_pub->is_ready())
+      return nullptr;
   }
 
-  dds::DDSPublishHandler<FreeFleetData_RobotState>::SharedPtr state_pub(
-      new dds::DDSPublishHandler<FreeFleetData_RobotState>(
-          participant, &FreeFleetData_RobotState_desc,
-          _config.dds_state_topic));
+  // Requests addressed to other robots are not even received when per-robot
+  // partitions are used
+  const std::string request_partition =
+      _config.dds_request_partitions ?
+          common::robot_partition(_config.fleet_name, _config.robot_name) :
+          _config.dds_partition;
 
-  dds::DDSSubscribeHandler<FreeFleetData_ModeRequest>::SharedPtr 
+  dds_qos_t* mode_request_qos =
+      common::create_qos(_config.dds_mode_request_qos);
+  ModeRequestSub::SharedPtr
       mode_request_sub(
-          new dds::DDSSubscribeHandler<FreeFleetData_ModeRequest>(
+          new ModeRequestSub(
               participant, &FreeFleetData_ModeRequest_desc,
-              _config.dds_mode_request_topic));
+              _config.dds_mode_request_topic, mode_request_qos,
+              request_partition,
+              ClientImpl::RequestTakeWindow));
+  dds_delete_qos(mode_request_qos);
 
-  dds::DDSSubscribeHandler<FreeFleetData_PathRequest>::SharedPtr 
+  dds_qos_t* path_request_qos =
+      common::create_qos(_config.dds_path_request_qos);
+  PathRequestSub::SharedPtr
       path_request_sub(
-          new dds::DDSSubscribeHandler<FreeFleetData_PathRequest>(
+          new PathRequestSub(
               participant, &FreeFleetData_PathRequest_desc,
-              _config.dds_path_request_topic));
+              _config.dds_path_request_topic, path_request_qos,
+              request_partition,
+              ClientImpl::RequestTakeWindow));
+  dds_delete_qos(path_request_qos);
 
-  dds::DDSSubscribeHandler<FreeFleetData_DestinationRequest>::SharedPtr
+  dds_qos_t* destination_request_qos =
+      common::create_qos(_config.dds_destination_request_qos);
+  DestinationRequestSub::SharedPtr
       destination_request_sub(
-          new dds::DDSSubscribeHandler<FreeFleetData_DestinationRequest>(
+          new DestinationRequestSub(
               participant, &FreeFleetData_DestinationRequest_desc,
-              _config.dds_destination_request_topic));
+              _config.dds_destination_request_topic, destination_request_qos,
+              request_partition,
+              ClientImpl::RequestTakeWindow));
+  dds_delete_qos(destination_request_qos);
+
+  dds::DDSWaitSetHandler::SharedPtr waitset(
+      new dds::DDSWaitSetHandler(participant, _config.threads));
+  dds::DDSWaitSetHandler::SharedPtr mode_request_waitset(
+      new dds::DDSWaitSetHandler(participant, _config.threads));
 
-  if (!state_pub->is_ready() ||
-      !mode_request_sub->is_ready() ||
+  if (!mode_request_sub->is_ready() ||
       !path_request_sub->is_ready() ||
-      !destination_request_sub->is_ready())
+      !destination_request_sub->is_ready() ||
+      !waitset->is_ready() ||
+      !mode_request_waitset->is_ready())
     return nullptr;
 
+  dds::DDSPublishHandler<FreeFleetData_RobotRegistration>::SharedPtr
+      registration_pub;
+  RegistrationAckSub::SharedPtr registration_ack_sub;
+  if (_config.robot_registration)
+  {
+    dds_qos_t* registration_qos =
+        common::create_qos(_config.dds_registration_qos);
+    registration_pub.reset(
+        new dds::DDSPublishHandler<FreeFleetData_RobotRegistration>(
+            participant, &FreeFleetData_RobotRegistration_desc,
+            _config.dds_registration_topic, registration_qos,
+            _config.dds_partition));
+    registration_ack_sub.reset(
+        new RegistrationAckSub(
+            participant, &FreeFleetData_RobotRegistrationAck_desc,
+            _config.dds_registration_ack_topic, registration_qos,
+            _config.dds_partition,
+            ClientImpl::RequestTakeWindow));
+    dds_delete_qos(registration_qos);
+    if (!registration_pub->is_ready() || !registration_ack_sub->is_ready())
+      return nullptr;
+  }
+
+  // Pings are broadcast to every client of the fleet, outside of the request
+  // partitions
+  TimeSyncPingSub::SharedPtr time_sync_ping_sub;
+  dds::DDSPublishHandler<FreeFleetData_TimeSyncPong>::SharedPtr
+      time_sync_pong_pub;
+  dds::DDSWaitSetHandler::SharedPtr time_sync_waitset;
+  if (_config.time_sync)
+  {
+    dds_qos_t* time_sync_qos = common::create_qos(_config.dds_time_sync_qos);
+    time_sync_ping_sub.reset(
+        new TimeSyncPingSub(
+            participant, &FreeFleetData_TimeSyncPing_desc,
+            _config.dds_time_sync_ping_topic, time_sync_qos,
+            _config.dds_partition,
+            ClientImpl::RequestTakeWindow));
+    time_sync_pong_pub.reset(
+        new dds::DDSPublishHandler<FreeFleetData_TimeSyncPong>(
+            participant, &FreeFleetData_TimeSyncPong_desc,
+            _config.dds_time_sync_pong_topic, time_sync_qos,
+            _config.dds_partition));
+    dds_delete_qos(time_sync_qos);
+    time_sync_waitset.reset(
+        new dds::DDSWaitSetHandler(participant, _config.threads));
+    if (!time_sync_ping_sub->is_ready() ||
+        !time_sync_pong_pub->is_ready() ||
+        !time_sync_waitset->is_ready())
+      return nullptr;
+  }
+
+  // Acks go back to the server in the partition of the client, whether or
+  // not requests come in through the per-robot request partitions
+  dds::DDSPublishHandler<FreeFleetData_RequestAck>::SharedPtr request_ack_pub;
+  if (_config.request_acks)
+  {
+    dds_qos_t* request_ack_qos =
+        common::create_qos(_config.dds_request_ack_qos);
+    request_ack_pub.reset(
+        new dds::DDSPublishHandler<FreeFleetData_RequestAck>(
+            participant, &FreeFleetData_RequestAck_desc,
+            _config.dds_request_ack_topic, request_ack_qos,
+            _config.dds_partition));
+    dds_delete_qos(request_ack_qos);
+    if (!request_ack_pub->is_ready())
+      return nullptr;
+  }
+
   client->impl->start(ClientImpl::Fields{
-      std::move(participant),
+      std::move(shared_participant),
       std::move(state_pub),
       std::move(mode_request_sub),
       std::move(path_request_sub),
-      std::move(destination_request_sub)});
+      std::move(destination_request_sub),
+      std::move(waitset),
+      std::move(mode_request_waitset),
+      std::move(registration_pub),
+      std::move(registration_ack_sub),
+      std::move(time_sync_ping_sub),
+      std::move(time_sync_pong_pub),
+      std::move(time_sync_waitset),
+      std::move(pose_pub),
+      std::move(metadata_pub),
+      std::move(request_ack_pub)});
   return client;
 }
 
@@ -106,4 +261,24 @@ bool Client::read_destination_request(
   return impl->read_destination_request(_destination_request);
 }
 
+bool Client::on_mode_request(ModeRequestCallback _callback)
+{
+  return impl->on_mode_request(std::move(_callback));
+}
+
+bool Client::on_path_request(PathRequestCallback _callback)
+{
+  return impl->on_path_request(std::move(_callback));
+}
+
+bool Client::on_destination_request(DestinationRequestCallback _callback)
+{
+  return impl->on_destination_request(std::move(_callback));
+}
+
+Stats Client::get_stats() const
+{
+  return impl->get_stats();
+}
+
 } // namespace free_fleet
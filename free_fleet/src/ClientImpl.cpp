@@ -15,73 +15,536 @@
  *
  */
 
+#include <cmath>
+#include <vector>
+
+#include <free_fleet/Tracing.hpp>
+
 #include "ClientImpl.hpp"
 #include "messages/message_utils.hpp"
+#include "dds_utils/common.hpp"
 
 namespace free_fleet {
 
+constexpr size_t Client::ClientImpl::RequestTakeWindow;
+
 Client::ClientImpl::ClientImpl(const ClientConfig& _config) :
   client_config(_config)
-{}
+{
+  if (client_config.path_simplification_tolerance > 0.0)
+    path_simplifier.reset(new messages::PathSimplifier(
+        client_config.path_simplification_tolerance,
+        client_config.path_simplification_yaw_tolerance));
+
+  topic_stats[RobotStateStats].topic = client_config.dds_state_topic;
+  topic_stats[ModeRequestStats].topic = client_config.dds_mode_request_topic;
+  topic_stats[PathRequestStats].topic = client_config.dds_path_request_topic;
+  topic_stats[DestinationRequestStats].topic =
+      client_config.dds_destination_request_topic;
+  topic_stats[RegistrationStats].topic =
+      client_config.dds_registration_topic;
+  topic_stats[RegistrationAckStats].topic =
+      client_config.dds_registration_ack_topic;
+  topic_stats[TimeSyncPingStats].topic =
+      client_config.dds_time_sync_ping_topic;
+  topic_stats[TimeSyncPongStats].topic =
+      client_config.dds_time_sync_pong_topic;
+  topic_stats[PoseStats].topic = client_config.dds_pose_topic;
+  topic_stats[MetadataStats].topic = client_config.dds_metadata_topic;
+  topic_stats[RequestAckStats].topic = client_config.dds_request_ack_topic;
+}
 
 Client::ClientImpl::~ClientImpl()
 {
-  dds_return_t return_code = dds_delete(fields.participant);
-  if (return_code != DDS_RETCODE_OK)
-  {
-    DDS_FATAL("dds_delete: %s", dds_strretcode(-return_code));
-  }
+  // The handlers delete their own entities as the fields go out of scope,
+  // the participant is only deleted along with its last user
+  if (fields.mode_request_waitset)
+    fields.mode_request_waitset->stop();
+  if (fields.waitset)
+    fields.waitset->stop();
+  if (fields.time_sync_waitset)
+    fields.time_sync_waitset->stop();
 }
 
 void Client::ClientImpl::start(Fields _fields)
 {
   fields = std::move(_fields);
+
+  topic_stats[ModeRequestStats].reader =
+      fields.mode_request_sub->get_reader();
+  topic_stats[PathRequestStats].reader =
+      fields.path_request_sub->get_reader();
+  topic_stats[DestinationRequestStats].reader =
+      fields.destination_request_sub->get_reader();
+  if (fields.registration_ack_sub)
+    topic_stats[RegistrationAckStats].reader =
+        fields.registration_ack_sub->get_reader();
+
+  if (fields.time_sync_ping_sub)
+  {
+    topic_stats[TimeSyncPingStats].reader =
+        fields.time_sync_ping_sub->get_reader();
+    fields.time_sync_waitset->attach(
+        fields.time_sync_ping_sub->get_reader(),
+        std::bind(&ClientImpl::handle_time_sync_pings, this));
+  }
+}
+
+Stats Client::ClientImpl::get_stats() const
+{
+  Stats stats;
+  for (const TopicCounters& counters : topic_stats)
+    stats.topics.push_back(counters.snapshot());
+  conversion_time.snapshot(stats.conversion_time);
+  receipt_age.snapshot(stats.receipt_age);
+  return stats;
 }
 
 bool Client::ClientImpl::send_robot_state(
     const messages::RobotState& _new_robot_state)
 {
-  FreeFleetData_RobotState* new_rs = FreeFleetData_RobotState__alloc();
-  convert(_new_robot_state, *new_rs);
-  bool sent = fields.state_pub->write(new_rs);
-  FreeFleetData_RobotState_free(new_rs, DDS_FREE_ALL);
-  return sent;
+  if (fields.pose_pub)
+    return send_split_robot_state(_new_robot_state);
+
+  auto sample = fields.state_pub->lock_sample();
+  if (fields.registration_pub)
+    update_registration(_new_robot_state);
+  convert_robot_state(_new_robot_state, *sample);
+  return topic_stats[RobotStateStats].record_write(
+      fields.state_pub->write(sample.get()),
+      messages::payload_size(*sample));
 }
 
-bool Client::ClientImpl::read_mode_request
-    (messages::ModeRequest& _mode_request)
+void Client::ClientImpl::convert_robot_state(
+    const messages::RobotState& _robot_state,
+    FreeFleetData_RobotState& _sample)
 {
-  auto mode_requests = fields.mode_request_sub->read();
-  if (!mode_requests.empty())
+  const auto convert_start = std::chrono::steady_clock::now();
+  if (path_simplifier && _robot_state.path.size() > 2)
+    convert(
+        _robot_state, path_simplifier->simplify(_robot_state.path), _sample);
+  else
+    convert(_robot_state, _sample);
+  messages::pack_path(_sample, client_config.path_packing_threshold);
+  conversion_time.record(nanoseconds_since(convert_start));
+
+  // Registered robots leave their metadata to the registration, the name
+  // stays as it is the key of the robot's instance
+  if (fields.registration_pub)
   {
-    convert(*(mode_requests[0]), _mode_request);
-    return true;
+    _sample.robot_id = robot_id.load();
+    if (_sample.robot_id != 0)
+    {
+      common::dds_string_assign(_sample.model, "");
+      common::dds_string_assign(_sample.task_id, "");
+    }
   }
-  return false;
 }
 
-bool Client::ClientImpl::read_path_request(
-    messages::PathRequest& _path_request)
+namespace {
+
+bool same_path(
+    const std::vector<messages::Location>& _a,
+    const std::vector<messages::Location>& _b)
 {
-  auto path_requests = fields.path_request_sub->read();
-  if (!path_requests.empty())
+  if (_a.size() != _b.size())
+    return false;
+
+  for (size_t i = 0; i < _a.size(); ++i)
   {
-    convert(*(path_requests[0]), _path_request);
+    if (_a[i].sec != _b[i].sec || _a[i].nanosec != _b[i].nanosec ||
+        _a[i].x != _b[i].x || _a[i].y != _b[i].y || _a[i].yaw != _b[i].yaw ||
+        _a[i].level_name != _b[i].level_name)
+      return false;
+  }
+  return true;
+}
+
+} // namespace anonymous
+
+bool Client::ClientImpl::metadata_changed(
+    const messages::RobotState& _robot_state) const
+{
+  if (fields.registration_pub && sent_metadata_robot_id != robot_id.load())
     return true;
+
+  return _robot_state.name != sent_metadata.name ||
+      _robot_state.model != sent_metadata.model ||
+      _robot_state.task_id != sent_metadata.task_id ||
+      std::abs(
+          _robot_state.battery_percent - sent_metadata.battery_percent) >
+          client_config.metadata_battery_tolerance ||
+      _robot_state.path_version != sent_metadata.path_version ||
+      _robot_state.path_index != sent_metadata.path_index ||
+      _robot_state.robot_id != sent_metadata.robot_id ||
+      !same_path(_robot_state.path, sent_metadata.path);
+}
+
+bool Client::ClientImpl::send_split_robot_state(
+    const messages::RobotState& _new_robot_state)
+{
+  // The metadata goes out ahead of the pose, as the server holds back poses
+  // until it has the metadata of their robot. Its writer keeps the latest
+  // metadata around for servers that join late.
+  bool metadata_written = true;
+  {
+    auto metadata = fields.metadata_pub->lock_sample();
+    if (fields.registration_pub)
+      update_registration(_new_robot_state);
+    if (!metadata_sent || metadata_changed(_new_robot_state))
+    {
+      convert_robot_state(_new_robot_state, *metadata);
+      metadata_written = topic_stats[MetadataStats].record_write(
+          fields.metadata_pub->write(metadata.get()),
+          messages::payload_size(*metadata));
+      if (metadata_written)
+      {
+        metadata_sent = true;
+        sent_metadata = _new_robot_state;
+        sent_metadata_robot_id = metadata->robot_id;
+      }
+    }
   }
+
+  auto pose = fields.pose_pub->lock_sample();
+  common::dds_string_assign(pose->name, _new_robot_state.name);
+  messages::convert(_new_robot_state.mode, pose->mode);
+  messages::convert(_new_robot_state.location, pose->location);
+  const bool pose_written = topic_stats[PoseStats].record_write(
+      fields.pose_pub->write(pose.get()),
+      messages::payload_size(*pose));
+  return pose_written && metadata_written;
+}
+
+void Client::ClientImpl::update_registration(
+    const messages::RobotState& _robot_state)
+{
+  if (!registered ||
+      registered_model != _robot_state.model ||
+      registered_task_id != _robot_state.task_id)
+  {
+    auto registration = fields.registration_pub->lock_sample();
+    common::dds_string_assign(
+        registration->fleet_name, client_config.fleet_name);
+    common::dds_string_assign(
+        registration->robot_name, client_config.robot_name);
+    common::dds_string_assign(registration->model, _robot_state.model);
+    common::dds_string_assign(registration->task_id, _robot_state.task_id);
+    if (topic_stats[RegistrationStats].record_write(
+        fields.registration_pub->write(registration.get()),
+        messages::payload_size(*registration)))
+    {
+      registered = true;
+      registered_model = _robot_state.model;
+      registered_task_id = _robot_state.task_id;
+    }
+  }
+
+  // Acks only arrive when the robot first registers, or when the server
+  // restarts and assigns it a new id
+  auto acks = fields.registration_ack_sub->take_loaned();
+  for (size_t i = 0; i < acks.size(); ++i)
+  {
+    const FreeFleetData_RobotRegistrationAck& ack = acks[i];
+    if (!acks.valid(i))
+      continue;
+
+    topic_stats[RegistrationAckStats].record_received(
+        messages::payload_size(ack));
+    if (ack.fleet_name && client_config.fleet_name == ack.fleet_name &&
+        ack.robot_name && client_config.robot_name == ack.robot_name)
+      robot_id = ack.robot_id;
+  }
+}
+
+bool Client::ClientImpl::is_addressed_to(
+    const char* _fleet_name,
+    const char* _robot_name,
+    uint32_t _request_robot_id) const
+{
+  // Ids are only compared when both were assigned by the same run of the
+  // server, which is told by their upper bits
+  const uint32_t id = robot_id.load();
+  if (id != 0 && _request_robot_id != 0 &&
+      (id >> 16) == (_request_robot_id >> 16))
+    return id == _request_robot_id;
+
+  return _fleet_name && _robot_name &&
+      client_config.fleet_name == _fleet_name &&
+      client_config.robot_name == _robot_name;
+}
+
+namespace {
+
+bool is_queued(const FreeFleetData_ModeRequest&)
+{
   return false;
 }
 
+bool is_queued(const FreeFleetData_PathRequest& _request)
+{
+  return _request.after_task_id && _request.after_task_id[0] != '\0';
+}
+
+bool is_queued(const FreeFleetData_DestinationRequest& _request)
+{
+  return _request.after_task_id && _request.after_task_id[0] != '\0';
+}
+
+constexpr tracing::RequestKind request_kind(const FreeFleetData_ModeRequest&)
+{
+  return tracing::RequestKind::Mode;
+}
+
+constexpr tracing::RequestKind request_kind(const FreeFleetData_PathRequest&)
+{
+  return tracing::RequestKind::Path;
+}
+
+constexpr tracing::RequestKind request_kind(
+    const FreeFleetData_DestinationRequest&)
+{
+  return tracing::RequestKind::Destination;
+}
+
+/// Path requests that belong to the same task are told apart by their
+/// versions, the other requests are only told apart by their task ids
+uint32_t request_version(const FreeFleetData_ModeRequest&)
+{
+  return 0;
+}
+
+uint32_t request_version(const FreeFleetData_PathRequest& _request)
+{
+  return _request.version;
+}
+
+uint32_t request_version(const FreeFleetData_DestinationRequest&)
+{
+  return 0;
+}
+
+} // namespace anonymous
+
+template <typename DDSMessage>
+void Client::ClientImpl::acknowledge_request(const DDSMessage& _request)
+{
+  if (!fields.request_ack_pub)
+    return;
+
+  auto ack = fields.request_ack_pub->lock_sample();
+  common::dds_string_assign(ack->fleet_name, client_config.fleet_name);
+  common::dds_string_assign(ack->robot_name, client_config.robot_name);
+  common::dds_string_assign(
+      ack->task_id, _request.task_id ? _request.task_id : "");
+  ack->kind = static_cast<uint32_t>(request_kind(_request));
+  ack->version = request_version(_request);
+  topic_stats[RequestAckStats].record_write(
+      fields.request_ack_pub->write(ack.get()),
+      messages::payload_size(*ack));
+}
+
+template <typename DDSMessage, typename Message>
+bool Client::ClientImpl::take_newest_request(
+    RequestSubscribeHandler<DDSMessage>& _request_sub,
+    TopicCounters& _request_stats,
+    std::deque<Message>& _pending,
+    Message& _request)
+{
+  // Requests broadcast to the fleet pile up behind each other, everything
+  // pending is taken at once, and only the newest request for this robot is
+  // worth converting, as it supersedes the ones before it. Requests queued
+  // behind a task do not supersede anything, they are kept in order after
+  // the newest request that does.
+  std::vector<size_t> taken;
+  while (true)
+  {
+    auto requests = _request_sub.take_loaned();
+    const dds_time_t received_time = dds_time();
+    for (size_t i = 0; i < requests.size(); ++i)
+    {
+      if (!requests.valid(i))
+        continue;
+      _request_stats.record_received(messages::payload_size(requests[i]));
+      receipt_age.record(sample_age(requests.info(i), received_time));
+    }
+
+    taken.clear();
+    bool superseded = false;
+    for (size_t i = requests.size(); i > 0; --i)
+    {
+      const DDSMessage& request = requests[i - 1];
+      if (requests.valid(i - 1) &&
+          is_addressed_to(
+              request.fleet_name, request.robot_name, request.robot_id))
+      {
+        taken.push_back(i - 1);
+        if (!is_queued(request))
+        {
+          superseded = true;
+          break;
+        }
+      }
+    }
+
+    if (superseded)
+      _pending.clear();
+    const auto convert_start = std::chrono::steady_clock::now();
+    for (size_t i = taken.size(); i > 0; --i)
+    {
+      _pending.emplace_back();
+      convert(requests[taken[i - 1]], _pending.back());
+    }
+    if (!taken.empty())
+      conversion_time.record(nanoseconds_since(convert_start));
+    for (size_t i = taken.size(); i > 0; --i)
+      acknowledge_request(requests[taken[i - 1]]);
+
+    if (!requests.full())
+      break;
+  }
+
+  if (_pending.empty())
+    return false;
+  _request = std::move(_pending.front());
+  _pending.pop_front();
+  return true;
+}
+
+bool Client::ClientImpl::read_mode_request
+    (messages::ModeRequest& _mode_request)
+{
+  std::lock_guard<std::mutex> lock(mode_request_mutex);
+  if (!take_newest_request(
+      *fields.mode_request_sub, topic_stats[ModeRequestStats],
+      pending_mode_requests, _mode_request))
+    return false;
+
+  FREE_FLEET_TRACEPOINT(client_request_taken, tracing::RequestKind::Mode,
+      _mode_request.robot_name.c_str(), _mode_request.task_id.c_str());
+  return true;
+}
+
+bool Client::ClientImpl::read_path_request(
+    messages::PathRequest& _path_request)
+{
+  std::lock_guard<std::mutex> lock(path_request_mutex);
+  if (!take_newest_request(
+      *fields.path_request_sub, topic_stats[PathRequestStats],
+      pending_path_requests, _path_request))
+    return false;
+
+  FREE_FLEET_TRACEPOINT(client_request_taken, tracing::RequestKind::Path,
+      _path_request.robot_name.c_str(), _path_request.task_id.c_str());
+  return true;
+}
+
 bool Client::ClientImpl::read_destination_request(
     messages::DestinationRequest& _destination_request)
 {
-  auto destination_requests = fields.destination_request_sub->read();
-  if (!destination_requests.empty())
+  std::lock_guard<std::mutex> lock(destination_request_mutex);
+  if (!take_newest_request(
+      *fields.destination_request_sub, topic_stats[DestinationRequestStats],
+      pending_destination_requests, _destination_request))
+    return false;
+
+  FREE_FLEET_TRACEPOINT(
+      client_request_taken, tracing::RequestKind::Destination,
+      _destination_request.robot_name.c_str(),
+      _destination_request.task_id.c_str());
+  return true;
+}
+
+bool Client::ClientImpl::on_mode_request(ModeRequestCallback _callback)
+{
+  if (!_callback)
+    return false;
+
+  return fields.mode_request_waitset->attach(
+      fields.mode_request_sub->get_reader(),
+      std::bind(
+          &ClientImpl::handle_mode_requests, this, std::move(_callback)));
+}
+
+bool Client::ClientImpl::on_path_request(PathRequestCallback _callback)
+{
+  if (!_callback)
+    return false;
+
+  return fields.waitset->attach(
+      fields.path_request_sub->get_reader(),
+      std::bind(
+          &ClientImpl::handle_path_requests, this, std::move(_callback)));
+}
+
+bool Client::ClientImpl::on_destination_request(
+    DestinationRequestCallback _callback)
+{
+  if (!_callback)
+    return false;
+
+  return fields.waitset->attach(
+      fields.destination_request_sub->get_reader(),
+      std::bind(
+          &ClientImpl::handle_destination_requests, this,
+          std::move(_callback)));
+}
+
+void Client::ClientImpl::handle_mode_requests(ModeRequestCallback _callback)
+{
+  messages::ModeRequest mode_request;
+  if (read_mode_request(mode_request))
+    _callback(mode_request);
+}
+
+void Client::ClientImpl::handle_path_requests(PathRequestCallback _callback)
+{
+  messages::PathRequest path_request;
+  while (read_path_request(path_request))
+    _callback(path_request);
+}
+
+void Client::ClientImpl::handle_destination_requests(
+    DestinationRequestCallback _callback)
+{
+  messages::DestinationRequest destination_request;
+  while (read_destination_request(destination_request))
+    _callback(destination_request);
+}
+
+void Client::ClientImpl::handle_time_sync_pings()
+{
+  while (true)
   {
-    convert(*(destination_requests[0]), _destination_request);
-    return true;
+    auto pings = fields.time_sync_ping_sub->take_loaned();
+    const dds_time_t received_time = dds_time();
+    for (size_t i = 0; i < pings.size(); ++i)
+    {
+      if (!pings.valid(i))
+        continue;
+
+      const FreeFleetData_TimeSyncPing& ping = pings[i];
+      topic_stats[TimeSyncPingStats].record_received(
+          messages::payload_size(ping));
+      if (!ping.fleet_name || client_config.fleet_name != ping.fleet_name)
+        continue;
+
+      // Only the time between receiving the ping and sending the pong is
+      // taken out of the round trip, both are stamped as late as possible
+      auto pong = fields.time_sync_pong_pub->lock_sample();
+      common::dds_string_assign(pong->fleet_name, client_config.fleet_name);
+      common::dds_string_assign(pong->robot_name, client_config.robot_name);
+      pong->server_send_time = ping.server_send_time;
+      pong->client_receive_time = received_time;
+      pong->client_send_time = dds_time();
+      topic_stats[TimeSyncPongStats].record_write(
+          fields.time_sync_pong_pub->write(pong.get()),
+          messages::payload_size(*pong));
+    }
+
+    if (!pings.full())
+      break;
   }
-  return false;
 }
 
 } // namespace free_fleet
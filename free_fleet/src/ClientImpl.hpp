@@ -18,18 +18,30 @@
 #ifndef FREE_FLEET__SRC__CLIENTIMPL_HPP
 #define FREE_FLEET__SRC__CLIENTIMPL_HPP
 
+#include <array>
+#include <deque>
+#include <mutex>
+#include <atomic>
+#include <memory>
+#include <string>
+
 #include <free_fleet/messages/RobotState.hpp>
 #include <free_fleet/messages/ModeRequest.hpp>
 #include <free_fleet/messages/PathRequest.hpp>
 #include <free_fleet/messages/DestinationRequest.hpp>
 #include <free_fleet/Client.hpp>
 #include <free_fleet/ClientConfig.hpp>
+#include <free_fleet/Stats.hpp>
 
 #include <dds/dds.h>
 
+#include "StatsRecorder.hpp"
 #include "messages/FleetMessages.h"
+#include "messages/PathSimplifier.hpp"
+#include "dds_utils/DDSParticipant.hpp"
 #include "dds_utils/DDSPublishHandler.hpp"
 #include "dds_utils/DDSSubscribeHandler.hpp"
+#include "dds_utils/DDSWaitSetHandler.hpp"
 
 namespace free_fleet {
 
@@ -37,11 +49,18 @@ class Client::ClientImpl
 {
 public:
 
+  /// Number of requests taken from a reader at a time
+  static constexpr size_t RequestTakeWindow = 16;
+
+  template <typename Message>
+  using RequestSubscribeHandler = dds::DDSSubscribeHandler<Message>;
+
   /// DDS related fields required for the client to operate
   struct Fields
   {
-    /// DDS participant that is tied to the configured dds_domain_id
-    dds_entity_t participant;
+    /// DDS participant that is tied to the configured dds_domain_id, shared
+    /// with the other clients and servers of this process on the same domain
+    dds::DDSParticipant::SharedPtr participant;
 
     /// DDS publisher that handles sending out current robot states to the 
     /// server
@@ -49,16 +68,59 @@ public:
         state_pub;
 
     /// DDS subscriber for mode requests coming from the server
-    dds::DDSSubscribeHandler<FreeFleetData_ModeRequest>::SharedPtr 
+    RequestSubscribeHandler<FreeFleetData_ModeRequest>::SharedPtr 
         mode_request_sub;
 
     /// DDS subscriber for path requests coming from the server
-    dds::DDSSubscribeHandler<FreeFleetData_PathRequest>::SharedPtr 
+    RequestSubscribeHandler<FreeFleetData_PathRequest>::SharedPtr 
         path_request_sub;
 
     /// DDS subscriber for destination requests coming from the server
-    dds::DDSSubscribeHandler<FreeFleetData_DestinationRequest>::SharedPtr
+    RequestSubscribeHandler<FreeFleetData_DestinationRequest>::SharedPtr
         destination_request_sub;
+
+    /// DDS waitset that wakes up the reader thread when callbacks are used
+    dds::DDSWaitSetHandler::SharedPtr waitset;
+
+    /// DDS waitset with a thread of its own for mode request callbacks, so
+    /// that pausing or stopping the robot is never held up behind the
+    /// handling of a path or destination request
+    dds::DDSWaitSetHandler::SharedPtr mode_request_waitset;
+
+    /// DDS publisher for registering the robot with the server, only when
+    /// robot registration is enabled
+    dds::DDSPublishHandler<FreeFleetData_RobotRegistration>::SharedPtr
+        registration_pub;
+
+    /// DDS subscriber for the id the server assigns to the robot, only when
+    /// robot registration is enabled
+    RequestSubscribeHandler<FreeFleetData_RobotRegistrationAck>::SharedPtr
+        registration_ack_sub;
+
+    /// DDS subscriber for the time sync pings of the server, only when time
+    /// sync is enabled
+    RequestSubscribeHandler<FreeFleetData_TimeSyncPing>::SharedPtr
+        time_sync_ping_sub;
+
+    /// DDS publisher for the answers to the pings, only when time sync is
+    /// enabled
+    dds::DDSPublishHandler<FreeFleetData_TimeSyncPong>::SharedPtr
+        time_sync_pong_pub;
+
+    /// DDS waitset with a thread of its own for the pings, which need to be
+    /// stamped as soon as they arrive, only when time sync is enabled
+    dds::DDSWaitSetHandler::SharedPtr time_sync_waitset;
+
+    /// DDS publishers for the poses and the metadata of the robot, which
+    /// replace the state publisher when the robot state is split
+    dds::DDSPublishHandler<FreeFleetData_RobotPose>::SharedPtr pose_pub;
+
+    dds::DDSPublishHandler<FreeFleetData_RobotState>::SharedPtr metadata_pub;
+
+    /// DDS publisher for acknowledging the requests taken, only when request
+    /// acks are enabled
+    dds::DDSPublishHandler<FreeFleetData_RequestAck>::SharedPtr
+        request_ack_pub;
   };
 
   ClientImpl(const ClientConfig& config);
@@ -76,12 +138,137 @@ public:
   bool read_destination_request(
       messages::DestinationRequest& destination_request);
 
+  bool on_mode_request(ModeRequestCallback callback);
+
+  bool on_path_request(PathRequestCallback callback);
+
+  bool on_destination_request(DestinationRequestCallback callback);
+
+  Stats get_stats() const;
+
 private:
 
   Fields fields;
 
   ClientConfig client_config;
 
+  /// Topics that traffic is counted for, indexing topic_stats
+  enum StatsTopic : size_t
+  {
+    RobotStateStats = 0,
+    ModeRequestStats,
+    PathRequestStats,
+    DestinationRequestStats,
+    RegistrationStats,
+    RegistrationAckStats,
+    TimeSyncPingStats,
+    TimeSyncPongStats,
+    PoseStats,
+    MetadataStats,
+    RequestAckStats,
+    StatsTopicCount
+  };
+
+  std::array<TopicCounters, StatsTopicCount> topic_stats;
+
+  AtomicHistogram conversion_time;
+
+  /// Age of the requests as they are taken in
+  AtomicHistogram receipt_age;
+
+  /// Only created when path simplification is enabled, and only used while
+  /// holding the state sample
+  std::unique_ptr<messages::PathSimplifier> path_simplifier;
+
+  /// Id assigned by the server, 0 until the robot has been registered
+  std::atomic<uint32_t> robot_id{0};
+
+  /// Metadata the robot last registered with, only used while holding the
+  /// state sample
+  bool registered = false;
+
+  std::string registered_model;
+
+  std::string registered_task_id;
+
+  /// Registers the robot again whenever its metadata changes, and takes in
+  /// the id assigned by the server
+  void update_registration(const messages::RobotState& robot_state);
+
+  /// Converts the robot state into the sample, simplifying and packing its
+  /// path, and leaving out the metadata of registered robots
+  void convert_robot_state(
+      const messages::RobotState& robot_state,
+      FreeFleetData_RobotState& sample);
+
+  /// Metadata last sent when the robot state is split, along with the robot
+  /// id it was sent with, only used while holding the metadata sample
+  bool metadata_sent = false;
+
+  messages::RobotState sent_metadata;
+
+  uint32_t sent_metadata_robot_id = 0;
+
+  /// Whether anything but the pose of the robot state differs from the
+  /// metadata that was last sent
+  bool metadata_changed(const messages::RobotState& robot_state) const;
+
+  /// Sends the pose of the robot state, along with its metadata when it has
+  /// changed
+  bool send_split_robot_state(const messages::RobotState& new_robot_state);
+
+  /// Requests carry the id of the robot they are addressed to once it has
+  /// registered, which is compared instead of its names
+  bool is_addressed_to(
+      const char* fleet_name, const char* robot_name,
+      uint32_t request_robot_id) const;
+
+  /// Guards each of the request readers, which may be taken from by both the
+  /// polling calls and the waitset thread
+  std::mutex mode_request_mutex;
+
+  std::mutex path_request_mutex;
+
+  std::mutex destination_request_mutex;
+
+  /// Requests that were taken and converted but not handed out yet, guarded
+  /// by the mutex of their reader. There is more than one only when requests
+  /// that are queued behind the current task arrive together.
+  std::deque<messages::ModeRequest> pending_mode_requests;
+
+  std::deque<messages::PathRequest> pending_path_requests;
+
+  std::deque<messages::DestinationRequest> pending_destination_requests;
+
+  /// Lets the server know that the request has been received, when request
+  /// acks are enabled
+  template <typename DDSMessage>
+  void acknowledge_request(const DDSMessage& request);
+
+  /// Drains the reader, converting only the newest request that is addressed
+  /// to this robot, along with the requests after it that are queued behind
+  /// a task, which do not supersede it. Older requests and requests for
+  /// other robots are dropped without being converted. Every request taken
+  /// is counted in the stats of the topic, and every request converted is
+  /// acknowledged. Returns the oldest pending request, false if there is
+  /// none.
+  template <typename DDSMessage, typename Message>
+  bool take_newest_request(
+      RequestSubscribeHandler<DDSMessage>& request_sub,
+      TopicCounters& request_stats,
+      std::deque<Message>& pending,
+      Message& request);
+
+  void handle_mode_requests(ModeRequestCallback callback);
+
+  void handle_path_requests(PathRequestCallback callback);
+
+  void handle_destination_requests(DestinationRequestCallback callback);
+
+  /// Answers every pending ping of the server, called from the time sync
+  /// waitset thread
+  void handle_time_sync_pings();
+
 };
 
 } // namespace free_fleet
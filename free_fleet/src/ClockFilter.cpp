@@ -0,0 +1,83 @@
+/*
+ * Copyright (C) 2019 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#include <algorithm>
+
+#include "ClockFilter.hpp"
+
+namespace free_fleet {
+
+constexpr size_t ClockFilter::Window;
+
+bool ClockFilter::add(
+    int64_t _server_send_time,
+    int64_t _client_receive_time,
+    int64_t _client_send_time,
+    int64_t _server_receive_time)
+{
+  // The time the client held on to the ping does not count towards the
+  // round trip, the offset assumes that both ways took equally long
+  const int64_t held = _client_send_time - _client_receive_time;
+  const int64_t round_trip = (_server_receive_time - _server_send_time) - held;
+  if (held < 0 || round_trip < 0)
+    return false;
+
+  const int64_t offset =
+      ((_client_receive_time - _server_send_time) +
+      (_client_send_time - _server_receive_time)) / 2;
+
+  const size_t index = static_cast<size_t>(count % Window);
+  window[index] = Exchange{offset, round_trip};
+  ++count;
+
+  // The best exchange only needs to be looked for again once it has been
+  // pushed out of the window
+  const size_t filled = static_cast<size_t>(std::min<uint64_t>(count, Window));
+  if (count == 1 || round_trip <= window[best].round_trip)
+    best = index;
+  else if (best == index)
+  {
+    for (size_t i = 0; i < filled; ++i)
+    {
+      if (window[i].round_trip < window[best].round_trip)
+        best = i;
+    }
+  }
+  return true;
+}
+
+bool ClockFilter::has_estimate() const
+{
+  return count > 0;
+}
+
+int64_t ClockFilter::offset() const
+{
+  return count > 0 ? window[best].offset : 0;
+}
+
+int64_t ClockFilter::round_trip() const
+{
+  return count > 0 ? window[best].round_trip : 0;
+}
+
+uint64_t ClockFilter::exchanges() const
+{
+  return count;
+}
+
+} // namespace free_fleet
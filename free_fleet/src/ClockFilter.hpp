@@ -0,0 +1,90 @@
+/*
+ * Copyright (C) 2019 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#ifndef FREE_FLEET__SRC__CLOCKFILTER_HPP
+#define FREE_FLEET__SRC__CLOCKFILTER_HPP
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+namespace free_fleet {
+
+/// Estimates the offset of a client's clock from the server's the way the
+/// clock filter of NTP does. Every exchange of a ping and its pong gives an
+/// offset that is off by no more than half of the exchange's round trip, so
+/// out of the most recent exchanges, the one with the shortest round trip
+/// gives the most accurate offset. Filters are not thread safe.
+class ClockFilter
+{
+public:
+
+  /// Number of the most recent exchanges that the offset is picked from
+  static constexpr size_t Window = 8;
+
+  /// Takes in an exchange, all times are in nanoseconds.
+  ///
+  /// \param[in] server_send_time
+  ///   When the server sent the ping, by the server's clock.
+  /// \param[in] client_receive_time
+  ///   When the client received the ping, by the client's clock.
+  /// \param[in] client_send_time
+  ///   When the client sent its pong, by the client's clock.
+  /// \param[in] server_receive_time
+  ///   When the server received the pong, by the server's clock.
+  /// \return
+  ///   False if the exchange was inconsistent and left out.
+  bool add(
+      int64_t server_send_time,
+      int64_t client_receive_time,
+      int64_t client_send_time,
+      int64_t server_receive_time);
+
+  /// Whether any exchange has been taken in yet
+  bool has_estimate() const;
+
+  /// Nanoseconds that the client's clock is ahead of the server's
+  int64_t offset() const;
+
+  /// Round trip of the exchange that the offset comes from
+  int64_t round_trip() const;
+
+  /// Number of exchanges taken in so far
+  uint64_t exchanges() const;
+
+private:
+
+  struct Exchange
+  {
+    int64_t offset;
+
+    int64_t round_trip;
+  };
+
+  std::array<Exchange, Window> window;
+
+  /// Total number of exchanges, the next one goes into window at this count
+  /// modulo the window size
+  uint64_t count = 0;
+
+  /// Index of the exchange in window with the shortest round trip
+  size_t best = 0;
+};
+
+} // namespace free_fleet
+
+#endif // FREE_FLEET__SRC__CLOCKFILTER_HPP
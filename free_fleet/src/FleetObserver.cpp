@@ -0,0 +1,88 @@
+/*
+ * Copyright (C) 2019 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#include <dds/dds.h>
+
+#include <free_fleet/FleetObserver.hpp>
+
+#include "FleetObserverImpl.hpp"
+
+#include "messages/FleetMessages.h"
+#include "dds_utils/DDSParticipant.hpp"
+#include "dds_utils/DDSSubscribeHandler.hpp"
+#include "dds_utils/DDSWaitSetHandler.hpp"
+#include "dds_utils/common.hpp"
+
+namespace free_fleet {
+
+FleetObserver::SharedPtr FleetObserver::make(const ServerConfig& _config)
+{
+  using FleetStateSub = FleetObserverImpl::FleetStateSubscribeHandler;
+
+  SharedPtr observer = SharedPtr(new FleetObserver(_config));
+
+  dds::DDSParticipant::SharedPtr shared_participant =
+      dds::DDSParticipant::get(
+          static_cast<dds_domainid_t>(_config.dds_domain),
+          common::domain_config(
+              _config.dds_shared_memory, _config.dds_discovery));
+  if (!shared_participant)
+    return nullptr;
+  dds_entity_t participant = shared_participant->get_entity();
+
+  dds_qos_t* fleet_state_qos =
+      common::create_qos(_config.dds_fleet_state_qos);
+  FleetStateSub::SharedPtr fleet_state_sub(
+      new FleetStateSub(
+          participant, &FreeFleetData_FleetState_desc,
+          _config.dds_fleet_state_topic, fleet_state_qos,
+          _config.dds_partition,
+          FleetObserverImpl::FleetStateTakeWindow));
+  dds_delete_qos(fleet_state_qos);
+
+  dds::DDSWaitSetHandler::SharedPtr waitset(
+      new dds::DDSWaitSetHandler(participant));
+
+  if (!fleet_state_sub->is_ready() || !waitset->is_ready())
+    return nullptr;
+
+  observer->impl->start(FleetObserverImpl::Fields{
+      std::move(shared_participant),
+      std::move(fleet_state_sub),
+      std::move(waitset)});
+  return observer;
+}
+
+FleetObserver::FleetObserver(const ServerConfig& _config)
+{
+  impl.reset(new FleetObserverImpl(_config));
+}
+
+FleetObserver::~FleetObserver()
+{}
+
+bool FleetObserver::read_fleet_state(messages::FleetState& _fleet_state)
+{
+  return impl->read_fleet_state(_fleet_state);
+}
+
+bool FleetObserver::on_fleet_state(FleetStateCallback _callback)
+{
+  return impl->on_fleet_state(std::move(_callback));
+}
+
+} // namespace free_fleet
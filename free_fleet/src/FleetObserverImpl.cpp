@@ -0,0 +1,92 @@
+/*
+ * Copyright (C) 2019 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#include "FleetObserverImpl.hpp"
+#include "messages/message_utils.hpp"
+
+namespace free_fleet {
+
+constexpr size_t FleetObserver::FleetObserverImpl::FleetStateTakeWindow;
+
+FleetObserver::FleetObserverImpl::FleetObserverImpl(
+    const ServerConfig& _config) :
+  server_config(_config)
+{}
+
+FleetObserver::FleetObserverImpl::~FleetObserverImpl()
+{
+  // The participant is only deleted along with its last user
+  if (fields.waitset)
+    fields.waitset->stop();
+}
+
+void FleetObserver::FleetObserverImpl::start(Fields _fields)
+{
+  fields = std::move(_fields);
+}
+
+bool FleetObserver::FleetObserverImpl::read_fleet_state(
+    messages::FleetState& _fleet_state)
+{
+  std::lock_guard<std::mutex> lock(fleet_state_mutex);
+
+  // Other fleets may share the topic, only the newest state of the observed
+  // fleet is converted
+  bool found = false;
+  while (true)
+  {
+    auto fleet_states = fields.fleet_state_sub->take_loaned();
+    for (size_t i = fleet_states.size(); i > 0 && !found; --i)
+    {
+      const FreeFleetData_FleetState& fleet_state = fleet_states[i - 1];
+      if (fleet_states.valid(i - 1) &&
+          fleet_state.name &&
+          server_config.fleet_name == fleet_state.name)
+      {
+        convert(fleet_state, _fleet_state);
+        found = true;
+      }
+    }
+
+    if (!fleet_states.full())
+      break;
+  }
+  return found;
+}
+
+bool FleetObserver::FleetObserverImpl::on_fleet_state(
+    FleetStateCallback _callback)
+{
+  if (!_callback)
+    return false;
+
+  return fields.waitset->attach(
+      fields.fleet_state_sub->get_reader(),
+      std::bind(
+          &FleetObserverImpl::handle_fleet_states, this,
+          std::move(_callback)));
+}
+
+void FleetObserver::FleetObserverImpl::handle_fleet_states(
+    FleetStateCallback _callback)
+{
+  messages::FleetState fleet_state;
+  if (read_fleet_state(fleet_state))
+    _callback(fleet_state);
+}
+
+} // namespace free_fleet
@@ -0,0 +1,87 @@
+/*
+ * Copyright (C) 2019 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#ifndef FREE_FLEET__SRC__FLEETOBSERVERIMPL_HPP
+#define FREE_FLEET__SRC__FLEETOBSERVERIMPL_HPP
+
+#include <mutex>
+
+#include <free_fleet/messages/FleetState.hpp>
+#include <free_fleet/FleetObserver.hpp>
+#include <free_fleet/ServerConfig.hpp>
+
+#include <dds/dds.h>
+
+#include "messages/FleetMessages.h"
+#include "dds_utils/DDSParticipant.hpp"
+#include "dds_utils/DDSSubscribeHandler.hpp"
+#include "dds_utils/DDSWaitSetHandler.hpp"
+
+namespace free_fleet {
+
+class FleetObserver::FleetObserverImpl
+{
+public:
+
+  /// Number of fleet states taken from the reader at a time, each
+  /// fleet is a single instance that only keeps its latest state
+  static constexpr size_t FleetStateTakeWindow = 4;
+
+  using FleetStateSubscribeHandler =
+      dds::DDSSubscribeHandler<FreeFleetData_FleetState>;
+
+  /// DDS related fields required for the observer to operate
+  struct Fields
+  {
+    /// DDS participant that is tied to the configured dds_domain_id, shared
+    /// with the servers and observers of this process on the same domain
+    dds::DDSParticipant::SharedPtr participant;
+
+    /// DDS subscriber for the fleet states published by the server
+    FleetStateSubscribeHandler::SharedPtr fleet_state_sub;
+
+    /// DDS waitset that wakes up the reader thread when callbacks are used
+    dds::DDSWaitSetHandler::SharedPtr waitset;
+  };
+
+  FleetObserverImpl(const ServerConfig& config);
+
+  ~FleetObserverImpl();
+
+  void start(Fields fields);
+
+  bool read_fleet_state(messages::FleetState& fleet_state);
+
+  bool on_fleet_state(FleetStateCallback callback);
+
+private:
+
+  Fields fields;
+
+  ServerConfig server_config;
+
+  /// Guards the fleet state reader, which may be taken from by both the
+  /// polling calls and the waitset thread
+  std::mutex fleet_state_mutex;
+
+  void handle_fleet_states(FleetStateCallback callback);
+
+};
+
+} // namespace free_fleet
+
+#endif // FREE_FLEET__SRC__FLEETOBSERVERIMPL_HPP
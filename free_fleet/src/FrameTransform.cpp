@@ -0,0 +1,89 @@
+/*
+ * Copyright (C) 2019 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#include <cmath>
+
+#include <free_fleet/FrameTransform.hpp>
+
+namespace free_fleet {
+
+FrameTransform::FrameTransform() :
+  xx(1.0), xy(0.0), yx(0.0), yy(1.0),
+  tx(0.0), ty(0.0),
+  yaw_offset(0.0)
+{}
+
+FrameTransform::FrameTransform(
+    double _translation_x,
+    double _translation_y,
+    double _rotation,
+    double _scale) :
+  xx(_scale * std::cos(_rotation)),
+  xy(-_scale * std::sin(_rotation)),
+  yx(_scale * std::sin(_rotation)),
+  yy(_scale * std::cos(_rotation)),
+  tx(_translation_x),
+  ty(_translation_y),
+  yaw_offset(_rotation)
+{}
+
+FrameTransform FrameTransform::inverse() const
+{
+  // The linear part is a scaled rotation, its inverse is its transpose
+  // divided by the squared scale
+  const double determinant = xx * yy - xy * yx;
+
+  FrameTransform inverse;
+  inverse.xx = yy / determinant;
+  inverse.xy = -xy / determinant;
+  inverse.yx = -yx / determinant;
+  inverse.yy = xx / determinant;
+  inverse.tx = -(inverse.xx * tx + inverse.xy * ty);
+  inverse.ty = -(inverse.yx * tx + inverse.yy * ty);
+  inverse.yaw_offset = -yaw_offset;
+  return inverse;
+}
+
+double FrameTransform::scale() const
+{
+  return std::hypot(xx, yx);
+}
+
+void FrameTransform::apply(
+    double* _xs, double* _ys, double* _yaws, std::size_t _count) const
+{
+  // Copies of the coefficients let the compiler know that they do not alias
+  // with the arrays being written to
+  const double a = xx;
+  const double b = xy;
+  const double c = yx;
+  const double d = yy;
+  const double e = tx;
+  const double f = ty;
+  const double g = yaw_offset;
+
+  for (std::size_t i = 0; i < _count; ++i)
+  {
+    const double x = _xs[i];
+    const double y = _ys[i];
+    _xs[i] = a * x + b * y + e;
+    _ys[i] = c * x + d * y + f;
+    _yaws[i] += g;
+  }
+}
+
+} // namespace free_fleet
@@ -0,0 +1,129 @@
+/*
+ * Copyright (C) 2019 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#include <algorithm>
+
+#include "RobotStateHistory.hpp"
+
+namespace free_fleet {
+
+RobotStateHistory::RobotStateHistory(size_t _capacity) :
+  times(_capacity),
+  xs(_capacity),
+  ys(_capacity),
+  yaws(_capacity),
+  modes(_capacity)
+{}
+
+bool RobotStateHistory::append(const messages::RobotState& _state)
+{
+  if (times.empty())
+    return false;
+
+  const int64_t time =
+      static_cast<int64_t>(_state.location.sec) * 1000000000 +
+      static_cast<int64_t>(_state.location.nanosec);
+  if (count > 0 && time < times[index(count - 1)])
+    return false;
+
+  size_t i;
+  if (count < times.size())
+    i = index(count++);
+  else
+  {
+    i = first;
+    first = index(1);
+  }
+
+  times[i] = time;
+  xs[i] = _state.location.x;
+  ys[i] = _state.location.y;
+  yaws[i] = _state.location.yaw;
+  modes[i] = _state.mode.mode;
+  return true;
+}
+
+void RobotStateHistory::query(
+    int64_t _start_time, int64_t _end_time, StateHistory& _history) const
+{
+  _history.clear();
+  if (count == 0 || _end_time < _start_time)
+    return;
+
+  const size_t begin = bound(_start_time, false);
+  const size_t end = bound(_end_time, true);
+  if (begin >= end)
+    return;
+
+  const size_t size = end - begin;
+  _history.time.reserve(size);
+  _history.x.reserve(size);
+  _history.y.reserve(size);
+  _history.yaw.reserve(size);
+  _history.mode.reserve(size);
+
+  // The range wraps around the end of the arrays at most once, so it is
+  // copied as up to two contiguous runs per array
+  const size_t start = index(begin);
+  const size_t head = std::min(size, times.size() - start);
+  const auto copy_runs = [&](const auto& _source, auto& _target)
+  {
+    _target.insert(_target.end(),
+        _source.begin() + start, _source.begin() + start + head);
+    _target.insert(_target.end(),
+        _source.begin(), _source.begin() + (size - head));
+  };
+  copy_runs(times, _history.time);
+  copy_runs(xs, _history.x);
+  copy_runs(ys, _history.y);
+  copy_runs(yaws, _history.yaw);
+  copy_runs(modes, _history.mode);
+}
+
+size_t RobotStateHistory::size() const
+{
+  return count;
+}
+
+size_t RobotStateHistory::capacity() const
+{
+  return times.size();
+}
+
+size_t RobotStateHistory::index(size_t _position) const
+{
+  const size_t i = first + _position;
+  return i < times.size() ? i : i - times.size();
+}
+
+size_t RobotStateHistory::bound(int64_t _time, bool _upper) const
+{
+  size_t low = 0;
+  size_t high = count;
+  while (low < high)
+  {
+    const size_t middle = low + (high - low) / 2;
+    const int64_t time = times[index(middle)];
+    if (_upper ? time <= _time : time < _time)
+      low = middle + 1;
+    else
+      high = middle;
+  }
+  return low;
+}
+
+} // namespace free_fleet
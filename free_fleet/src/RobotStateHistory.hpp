@@ -0,0 +1,92 @@
+/*
+ * Copyright (C) 2019 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#ifndef FREE_FLEET__SRC__ROBOTSTATEHISTORY_HPP
+#define FREE_FLEET__SRC__ROBOTSTATEHISTORY_HPP
+
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+
+#include <free_fleet/StateHistory.hpp>
+#include <free_fleet/messages/RobotState.hpp>
+
+namespace free_fleet {
+
+/// Fixed capacity ring buffer of the most recent states of a single robot,
+/// kept as structure of arrays so that a time range query only walks the
+/// time array to find its bounds before copying the other arrays out. All of
+/// the arrays are allocated up front, appending never allocates. States are
+/// kept in the order of their time, a state older than the newest one kept
+/// is dropped. Not thread safe.
+class RobotStateHistory
+{
+public:
+
+  /// \param[in] capacity
+  ///   Number of states kept, the oldest state is overwritten once full.
+  explicit RobotStateHistory(size_t capacity);
+
+  /// \param[in] state
+  ///   State to append, using the time and pose of its location.
+  /// \return
+  ///   False if the state was dropped for being older than the newest state.
+  bool append(const messages::RobotState& state);
+
+  /// \param[in] start_time
+  ///   Start of the time range in nanoseconds, inclusive.
+  /// \param[in] end_time
+  ///   End of the time range in nanoseconds, inclusive.
+  /// \param[out] history
+  ///   Cleared and filled with the states within the time range, oldest
+  ///   first.
+  void query(
+      int64_t start_time, int64_t end_time, StateHistory& history) const;
+
+  size_t size() const;
+
+  size_t capacity() const;
+
+private:
+
+  /// Index into the arrays of the state at the given position from the
+  /// oldest state kept.
+  size_t index(size_t position) const;
+
+  /// Position from the oldest state of the first state that is not before
+  /// the given time, or after it if upper is set.
+  size_t bound(int64_t time, bool upper) const;
+
+  std::vector<int64_t> times;
+
+  std::vector<float> xs;
+
+  std::vector<float> ys;
+
+  std::vector<float> yaws;
+
+  std::vector<uint32_t> modes;
+
+  /// Index of the oldest state kept
+  size_t first = 0;
+
+  size_t count = 0;
+};
+
+} // namespace free_fleet
+
+#endif // FREE_FLEET__SRC__ROBOTSTATEHISTORY_HPP
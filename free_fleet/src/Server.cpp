@@ -15,6 +15,9 @@
  *
  */
 
+#include <iterator>
+#include <algorithm>
+
 #include <dds/dds.h>
 
 #include <free_fleet/Server.hpp>
@@ -22,65 +25,255 @@
 #include "ServerImpl.hpp"
 
 #include "messages/FleetMessages.h"
+#include "dds_utils/DDSParticipant.hpp"
 #include "dds_utils/DDSPublishHandler.hpp"
 #include "dds_utils/DDSSubscribeHandler.hpp"
+#include "dds_utils/DDSWaitSetHandler.hpp"
+#include "dds_utils/common.hpp"
 
 namespace free_fleet {
 
 Server::SharedPtr Server::make(const ServerConfig& _config)
 {
-  SharedPtr server = SharedPtr(new Server(_config));
+  SharedPtr server = SharedPtr(new Server());
+
+  if (_config.dds_write_batching)
+    dds_write_set_batch(true);
 
-  dds_entity_t participant = dds_create_participant(
-      static_cast<dds_domainid_t>(_config.dds_domain), NULL, NULL);
-  if (participant < 0)
+  if (_config.shards.empty())
   {
-    DDS_FATAL("dds_create_participant: %s\n", dds_strretcode(-participant));
-    return nullptr;
+    std::unique_ptr<ServerImpl> shard = make_shard(_config);
+    if (!shard)
+      return nullptr;
+    server->shards.push_back(std::move(shard));
+    return server;
+  }
+
+  // Each shard is a server of its own on its domain and partition, which
+  // only shares the participant with the shards on the same domain
+  for (const auto& shard_config : _config.shards)
+  {
+    ServerConfig config = _config;
+    config.dds_domain = shard_config.dds_domain;
+    config.dds_partition = shard_config.dds_partition;
+    config.shards.clear();
+
+    std::unique_ptr<ServerImpl> shard = make_shard(config);
+    if (!shard)
+      return nullptr;
+    server->shards.push_back(std::move(shard));
   }
+  return server;
+}
+
+std::unique_ptr<Server::ServerImpl> Server::make_shard(
+    const ServerConfig& _config)
+{
+  std::unique_ptr<ServerImpl> shard(new ServerImpl(_config));
+
+  // Servers on the same domain within this process share a single
+  // participant, each of them only creates its own topics, readers and
+  // writers under it.
+  dds::DDSParticipant::SharedPtr shared_participant =
+      dds::DDSParticipant::get(
+          static_cast<dds_domainid_t>(_config.dds_domain),
+          common::domain_config(
+              _config.dds_shared_memory, _config.dds_discovery,
+              _config.dds_threads),
+          _config.dds_threads.cpus);
+  if (!shared_participant)
+    return nullptr;
+  dds_entity_t participant = shared_participant->get_entity();
 
-  dds::DDSSubscribeHandler<FreeFleetData_RobotState, 10>::SharedPtr state_sub(
-      new dds::DDSSubscribeHandler<FreeFleetData_RobotState, 10>(
+  // Robot states are keyed by the robot name, with the default history depth
+  // of 1 only the newest state of each robot is kept around until it is read.
+  dds_qos_t* state_qos = common::create_qos(_config.dds_robot_state_qos);
+  ServerImpl::RobotStateSubscribeHandler::SharedPtr state_sub(
+      new ServerImpl::RobotStateSubscribeHandler(
           participant, &FreeFleetData_RobotState_desc,
-          _config.dds_robot_state_topic));
+          _config.dds_robot_state_topic, state_qos,
+          _config.dds_partition,
+          _config.robot_state_take_window, _config.max_take_window));
+  dds_delete_qos(state_qos);
+
+  // Poses are keyed by the robot name like whole states, and the latest
+  // metadata of each robot is kept around by its writer for servers that
+  // join late
+  ServerImpl::RobotPoseSubscribeHandler::SharedPtr pose_sub;
+  ServerImpl::RobotStateSubscribeHandler::SharedPtr metadata_sub;
+  if (_config.split_robot_states)
+  {
+    dds_qos_t* pose_qos = common::create_qos(_config.dds_robot_pose_qos);
+    pose_sub.reset(
+        new ServerImpl::RobotPoseSubscribeHandler(
+            participant, &FreeFleetData_RobotPose_desc,
+            _config.dds_robot_pose_topic, pose_qos,
+            _config.dds_partition,
+            _config.robot_state_take_window, _config.max_take_window));
+    dds_delete_qos(pose_qos);
 
+    dds_qos_t* metadata_qos =
+        common::create_qos(_config.dds_robot_metadata_qos);
+    metadata_sub.reset(
+        new ServerImpl::RobotStateSubscribeHandler(
+            participant, &FreeFleetData_RobotState_desc,
+            _config.dds_robot_metadata_topic, metadata_qos,
+            _config.dds_partition,
+            _config.robot_state_take_window, _config.max_take_window));
+    dds_delete_qos(metadata_qos);
+    if (!pose_sub->is_ready() || !metadata_sub->is_ready())
+      return nullptr;
+  }
+
+  dds_qos_t* mode_request_qos =
+      common::create_qos(_config.dds_mode_request_qos);
   dds::DDSPublishHandler<FreeFleetData_ModeRequest>::SharedPtr 
       mode_request_pub(
           new dds::DDSPublishHandler<FreeFleetData_ModeRequest>(
               participant, &FreeFleetData_ModeRequest_desc,
-              _config.dds_mode_request_topic));
+              _config.dds_mode_request_topic, mode_request_qos,
+              _config.dds_partition));
+  dds_delete_qos(mode_request_qos);
 
+  dds_qos_t* path_request_qos =
+      common::create_qos(_config.dds_path_request_qos);
   dds::DDSPublishHandler<FreeFleetData_PathRequest>::SharedPtr 
       path_request_pub(
           new dds::DDSPublishHandler<FreeFleetData_PathRequest>(
               participant, &FreeFleetData_PathRequest_desc,
-              _config.dds_path_request_topic));
+              _config.dds_path_request_topic, path_request_qos,
+              _config.dds_partition));
+  dds_delete_qos(path_request_qos);
 
+  dds_qos_t* destination_request_qos =
+      common::create_qos(_config.dds_destination_request_qos);
   dds::DDSPublishHandler<FreeFleetData_DestinationRequest>::SharedPtr 
       destination_request_pub(
           new dds::DDSPublishHandler<FreeFleetData_DestinationRequest>(
               participant, &FreeFleetData_DestinationRequest_desc,
-              _config.dds_destination_request_topic));
+              _config.dds_destination_request_topic, destination_request_qos,
+              _config.dds_partition));
+  dds_delete_qos(destination_request_qos);
+
+  dds::DDSWaitSetHandler::SharedPtr waitset(
+      new dds::DDSWaitSetHandler(participant, _config.threads));
+
+  // Only servers that publish the fleet state create its writer, so that
+  // observers do not match with the servers that never publish it
+  dds::DDSPublishHandler<FreeFleetData_FleetState>::SharedPtr fleet_state_pub;
+  if (_config.fleet_state_period > 0.0)
+  {
+    dds_qos_t* fleet_state_qos =
+        common::create_qos(_config.dds_fleet_state_qos);
+    fleet_state_pub.reset(
+        new dds::DDSPublishHandler<FreeFleetData_FleetState>(
+            participant, &FreeFleetData_FleetState_desc,
+            _config.dds_fleet_state_topic, fleet_state_qos,
+            _config.dds_partition));
+    dds_delete_qos(fleet_state_qos);
+    if (!fleet_state_pub->is_ready())
+      return nullptr;
+  }
+
+  // Registrations and their acks are kept around by their writers, so that
+  // either end can restart without the robots having to register again
+  dds_qos_t* registration_qos =
+      common::create_qos(_config.dds_registration_qos);
+  ServerImpl::RegistrationSubscribeHandler::SharedPtr registration_sub(
+      new ServerImpl::RegistrationSubscribeHandler(
+          participant, &FreeFleetData_RobotRegistration_desc,
+          _config.dds_registration_topic, registration_qos,
+          _config.dds_partition,
+          _config.robot_state_take_window, _config.max_take_window));
+  dds::DDSPublishHandler<FreeFleetData_RobotRegistrationAck>::SharedPtr
+      registration_ack_pub(
+          new dds::DDSPublishHandler<FreeFleetData_RobotRegistrationAck>(
+              participant, &FreeFleetData_RobotRegistrationAck_desc,
+              _config.dds_registration_ack_topic, registration_qos,
+              _config.dds_partition));
+  dds_delete_qos(registration_qos);
+
+  // Pings go out to every client of the fleet, and stale pings or pongs are
+  // of no use, so neither is kept around or sent reliably by default
+  dds::DDSPublishHandler<FreeFleetData_TimeSyncPing>::SharedPtr
+      time_sync_ping_pub;
+  ServerImpl::TimeSyncPongSubscribeHandler::SharedPtr time_sync_pong_sub;
+  dds::DDSWaitSetHandler::SharedPtr time_sync_waitset;
+  if (_config.time_sync_period > 0.0)
+  {
+    dds_qos_t* time_sync_qos = common::create_qos(_config.dds_time_sync_qos);
+    time_sync_ping_pub.reset(
+        new dds::DDSPublishHandler<FreeFleetData_TimeSyncPing>(
+            participant, &FreeFleetData_TimeSyncPing_desc,
+            _config.dds_time_sync_ping_topic, time_sync_qos,
+            _config.dds_partition));
+    time_sync_pong_sub.reset(
+        new ServerImpl::TimeSyncPongSubscribeHandler(
+            participant, &FreeFleetData_TimeSyncPong_desc,
+            _config.dds_time_sync_pong_topic, time_sync_qos,
+            _config.dds_partition,
+            _config.robot_state_take_window, _config.max_take_window));
+    dds_delete_qos(time_sync_qos);
+    time_sync_waitset.reset(
+        new dds::DDSWaitSetHandler(participant, _config.threads));
+    if (!time_sync_ping_pub->is_ready() ||
+        !time_sync_pong_sub->is_ready() ||
+        !time_sync_waitset->is_ready())
+      return nullptr;
+  }
+
+  // Acks are taken on a thread of their own, so that they are timed as soon
+  // as they arrive, and kept until taken like the requests they answer
+  ServerImpl::RequestAckSubscribeHandler::SharedPtr request_ack_sub;
+  dds::DDSWaitSetHandler::SharedPtr request_ack_waitset;
+  if (_config.request_retry_timeout > 0.0)
+  {
+    dds_qos_t* request_ack_qos =
+        common::create_qos(_config.dds_request_ack_qos);
+    request_ack_sub.reset(
+        new ServerImpl::RequestAckSubscribeHandler(
+            participant, &FreeFleetData_RequestAck_desc,
+            _config.dds_request_ack_topic, request_ack_qos,
+            _config.dds_partition,
+            _config.robot_state_take_window, _config.max_take_window));
+    dds_delete_qos(request_ack_qos);
+    request_ack_waitset.reset(
+        new dds::DDSWaitSetHandler(participant, _config.threads));
+    if (!request_ack_sub->is_ready() || !request_ack_waitset->is_ready())
+      return nullptr;
+  }
 
   if (!state_sub->is_ready() ||
       !mode_request_pub->is_ready() ||
       !path_request_pub->is_ready() ||
-      !destination_request_pub->is_ready())
+      !destination_request_pub->is_ready() ||
+      !waitset->is_ready() ||
+      !registration_sub->is_ready() ||
+      !registration_ack_pub->is_ready())
     return nullptr;
 
-  server->impl->start(ServerImpl::Fields{
-      std::move(participant),
+  shard->start(ServerImpl::Fields{
+      std::move(shared_participant),
       std::move(state_sub),
       std::move(mode_request_pub),
       std::move(path_request_pub),
-      std::move(destination_request_pub)});
-  return server;
+      std::move(destination_request_pub),
+      std::move(waitset),
+      std::move(fleet_state_pub),
+      std::move(registration_sub),
+      std::move(registration_ack_pub),
+      std::move(time_sync_ping_pub),
+      std::move(time_sync_pong_sub),
+      std::move(time_sync_waitset),
+      std::move(pose_sub),
+      std::move(metadata_sub),
+      std::move(request_ack_sub),
+      std::move(request_ack_waitset)});
+  return shard;
 }
 
-Server::Server(const ServerConfig& _config)
-{
-  impl.reset(new ServerImpl(_config));
-}
+Server::Server()
+{}
 
 Server::~Server()
 {}
@@ -88,23 +281,471 @@ Server::~Server()
 bool Server::read_robot_states(
     std::vector<messages::RobotState>& _new_robot_states)
 {
-  return impl->read_robot_states(_new_robot_states);
+  if (shards.size() == 1)
+    return shards.front()->read_robot_states(_new_robot_states);
+
+  size_t count = 0;
+  for (const auto& shard : shards)
+    count = shard->append_robot_states(_new_robot_states, count);
+  if (count == 0)
+    return false;
+  _new_robot_states.resize(count);
+  return true;
+}
+
+bool Server::read_robot_states(RobotStateBatch& _new_robot_states)
+{
+  std::vector<messages::RobotState>& current = _new_robot_states.current;
+  std::vector<messages::RobotState>* spare = &_new_robot_states.spare;
+  if (shards.size() == 1)
+  {
+    if (shards.front()->read_robot_states(current, spare))
+      return true;
+    _new_robot_states.clear();
+    return false;
+  }
+
+  size_t count = 0;
+  for (const auto& shard : shards)
+    count = shard->append_robot_states(current, count, spare);
+  ServerImpl::resize_robot_states(current, count, spare);
+  return count > 0;
+}
+
+bool Server::read_robot_state_views(const RobotStateViewCallback& _callback)
+{
+  bool read = false;
+  for (const auto& shard : shards)
+    read = shard->read_robot_state_views(_callback) || read;
+  return read;
+}
+
+bool Server::on_robot_states(RobotStatesCallback _callback)
+{
+  bool registered = true;
+  for (const auto& shard : shards)
+    registered = shard->on_robot_states(_callback) && registered;
+  return registered;
+}
+
+bool Server::on_robot_lost(RobotEventCallback _callback)
+{
+  bool registered = true;
+  for (const auto& shard : shards)
+    registered = shard->on_robot_lost(_callback) && registered;
+  return registered;
+}
+
+bool Server::on_robot_rejoined(RobotEventCallback _callback)
+{
+  bool registered = true;
+  for (const auto& shard : shards)
+    registered = shard->on_robot_rejoined(_callback) && registered;
+  return registered;
+}
+
+bool Server::start_robot_state_ingest()
+{
+  bool started = true;
+  for (const auto& shard : shards)
+    started = shard->start_robot_state_ingest() && started;
+  return started;
+}
+
+std::shared_ptr<const FleetSnapshot> Server::get_fleet_snapshot() const
+{
+  if (shards.size() == 1)
+    return shards.front()->get_fleet_snapshot();
+
+  // Robots that were heard from on more than one shard, while moving between
+  // them, are taken from the shard that heard from them last
+  auto fleet_snapshot = std::make_shared<FleetSnapshot>();
+  for (const auto& shard : shards)
+  {
+    for (const auto& it : *shard->get_fleet_snapshot())
+    {
+      auto inserted = fleet_snapshot->insert(it);
+      if (!inserted.second &&
+          inserted.first->second->last_seen < it.second->last_seen)
+        inserted.first->second = it.second;
+    }
+  }
+  return fleet_snapshot;
+}
+
+RobotStateRecord::ConstPtr Server::get_robot_state(
+    const std::string& _robot_name) const
+{
+  RobotStateRecord::ConstPtr latest_record;
+  for (const auto& shard : shards)
+  {
+    RobotStateRecord::ConstPtr record = shard->get_robot_state(_robot_name);
+    if (record &&
+        (!latest_record || latest_record->last_seen < record->last_seen))
+      latest_record = std::move(record);
+  }
+  return latest_record;
+}
+
+Stats Server::get_stats() const
+{
+  // Every shard counts the same topics in the same order
+  Stats stats = shards.front()->get_stats();
+  for (size_t i = 1; i < shards.size(); ++i)
+  {
+    const Stats shard_stats = shards[i]->get_stats();
+    for (size_t j = 0; j < stats.topics.size(); ++j)
+    {
+      TopicStats& topic = stats.topics[j];
+      const TopicStats& shard_topic = shard_stats.topics[j];
+      topic.messages_sent += shard_topic.messages_sent;
+      topic.messages_received += shard_topic.messages_received;
+      topic.bytes_sent += shard_topic.bytes_sent;
+      topic.bytes_received += shard_topic.bytes_received;
+      topic.write_failures += shard_topic.write_failures;
+      topic.samples_lost += shard_topic.samples_lost;
+      topic.samples_rejected += shard_topic.samples_rejected;
+    }
+    stats.conversion_time.merge(shard_stats.conversion_time);
+    stats.receipt_age.merge(shard_stats.receipt_age);
+    stats.request_ack_time.merge(shard_stats.request_ack_time);
+    stats.request_retries += shard_stats.request_retries;
+    stats.unacknowledged_requests += shard_stats.unacknowledged_requests;
+  }
+  return stats;
+}
+
+std::vector<ClockOffset> Server::get_clock_offsets() const
+{
+  if (shards.size() == 1)
+    return shards.front()->get_clock_offsets();
+
+  std::vector<ClockOffset> clock_offsets;
+  for (const auto& shard : shards)
+  {
+    auto shard_offsets = shard->get_clock_offsets();
+    clock_offsets.insert(
+        clock_offsets.end(), shard_offsets.begin(), shard_offsets.end());
+  }
+  std::sort(
+      clock_offsets.begin(), clock_offsets.end(),
+      [](const ClockOffset& _a, const ClockOffset& _b)
+      {
+        return _a.robot_name < _b.robot_name;
+      });
+  return clock_offsets;
+}
+
+bool Server::get_state_history(
+    const std::string& _robot_name,
+    int64_t _start_time,
+    int64_t _end_time,
+    StateHistory& _history) const
+{
+  // Histories are kept after robots are lost, a robot that moved between
+  // shards is looked up on the shard it is currently on first
+  const size_t current_shard = find_shard(_robot_name);
+  if (current_shard < shards.size() &&
+      shards[current_shard]->get_state_history(
+          _robot_name, _start_time, _end_time, _history))
+    return true;
+
+  for (const auto& shard : shards)
+  {
+    if (shard->get_state_history(
+        _robot_name, _start_time, _end_time, _history))
+      return true;
+  }
+  return false;
+}
+
+std::vector<std::string> Server::query_radius(
+    const std::string& _level_name,
+    double _x,
+    double _y,
+    double _radius) const
+{
+  if (shards.size() == 1)
+    return shards.front()->query_radius(_level_name, _x, _y, _radius);
+
+  std::vector<std::string> robot_names;
+  for (const auto& shard : shards)
+  {
+    auto shard_robot_names =
+        shard->query_radius(_level_name, _x, _y, _radius);
+    robot_names.insert(
+        robot_names.end(),
+        std::make_move_iterator(shard_robot_names.begin()),
+        std::make_move_iterator(shard_robot_names.end()));
+  }
+  return unique_robot_names(std::move(robot_names));
+}
+
+std::vector<std::string> Server::query_box(
+    const std::string& _level_name,
+    double _min_x,
+    double _min_y,
+    double _max_x,
+    double _max_y) const
+{
+  if (shards.size() == 1)
+    return shards.front()->query_box(
+        _level_name, _min_x, _min_y, _max_x, _max_y);
+
+  std::vector<std::string> robot_names;
+  for (const auto& shard : shards)
+  {
+    auto shard_robot_names =
+        shard->query_box(_level_name, _min_x, _min_y, _max_x, _max_y);
+    robot_names.insert(
+        robot_names.end(),
+        std::make_move_iterator(shard_robot_names.begin()),
+        std::make_move_iterator(shard_robot_names.end()));
+  }
+  return unique_robot_names(std::move(robot_names));
 }
 
 bool Server::send_mode_request(const messages::ModeRequest& _mode_request)
 {
-  return impl->send_mode_request(_mode_request);
+  return route_request(
+      _mode_request.robot_name,
+      [&](ServerImpl& _shard, bool)
+      {
+        return _shard.send_mode_request(_mode_request);
+      });
+}
+
+bool Server::send_mode_requests(
+    const std::vector<messages::ModeRequest>& _mode_requests)
+{
+  if (shards.size() == 1)
+    return shards.front()->send_mode_requests(_mode_requests);
+
+  return route_requests(
+      std::vector<messages::ModeRequest>(_mode_requests),
+      [](ServerImpl& _shard, std::vector<messages::ModeRequest>&& _batch)
+      {
+        return _shard.send_mode_requests(_batch);
+      });
 }
 
 bool Server::send_path_request(const messages::PathRequest& _path_request)
 {
-  return impl->send_path_request(_path_request);
+  return route_request(
+      _path_request.robot_name,
+      [&](ServerImpl& _shard, bool)
+      {
+        return _shard.send_path_request(_path_request);
+      });
+}
+
+bool Server::send_path_request(messages::PathRequest&& _path_request)
+{
+  // Copies the robot name, as the request is moved into the last shard
+  return route_request(
+      std::string(_path_request.robot_name),
+      [&](ServerImpl& _shard, bool _last)
+      {
+        return _last ?
+            _shard.send_path_request(std::move(_path_request)) :
+            _shard.send_path_request(_path_request);
+      });
+}
+
+bool Server::send_path_requests(
+    const std::vector<messages::PathRequest>& _path_requests)
+{
+  if (shards.size() == 1)
+    return shards.front()->send_path_requests(_path_requests);
+
+  return route_requests(
+      std::vector<messages::PathRequest>(_path_requests),
+      [](ServerImpl& _shard, std::vector<messages::PathRequest>&& _batch)
+      {
+        return _shard.send_path_requests(std::move(_batch));
+      });
+}
+
+bool Server::send_path_requests(
+    std::vector<messages::PathRequest>&& _path_requests)
+{
+  if (shards.size() == 1)
+    return shards.front()->send_path_requests(std::move(_path_requests));
+
+  return route_requests(
+      std::move(_path_requests),
+      [](ServerImpl& _shard, std::vector<messages::PathRequest>&& _batch)
+      {
+        return _shard.send_path_requests(std::move(_batch));
+      });
 }
 
 bool Server::send_destination_request(
     const messages::DestinationRequest& _destination_request)
 {
-  return impl->send_destination_request(_destination_request);
+  return route_request(
+      _destination_request.robot_name,
+      [&](ServerImpl& _shard, bool)
+      {
+        return _shard.send_destination_request(_destination_request);
+      });
+}
+
+bool Server::send_destination_requests(
+    const std::vector<messages::DestinationRequest>& _destination_requests)
+{
+  if (shards.size() == 1)
+    return shards.front()->send_destination_requests(_destination_requests);
+
+  return route_requests(
+      std::vector<messages::DestinationRequest>(_destination_requests),
+      [](ServerImpl& _shard,
+          std::vector<messages::DestinationRequest>&& _batch)
+      {
+        return _shard.send_destination_requests(_batch);
+      });
+}
+
+bool Server::send_mode_request_async(
+    const messages::ModeRequest& _mode_request)
+{
+  return route_request(
+      _mode_request.robot_name,
+      [&](ServerImpl& _shard, bool)
+      {
+        return _shard.send_mode_request_async(_mode_request);
+      });
+}
+
+bool Server::send_mode_request_async(messages::ModeRequest&& _mode_request)
+{
+  return route_request(
+      std::string(_mode_request.robot_name),
+      [&](ServerImpl& _shard, bool _last)
+      {
+        return _last ?
+            _shard.send_mode_request_async(std::move(_mode_request)) :
+            _shard.send_mode_request_async(_mode_request);
+      });
+}
+
+bool Server::send_path_request_async(
+    const messages::PathRequest& _path_request)
+{
+  return route_request(
+      _path_request.robot_name,
+      [&](ServerImpl& _shard, bool)
+      {
+        return _shard.send_path_request_async(_path_request);
+      });
+}
+
+bool Server::send_path_request_async(messages::PathRequest&& _path_request)
+{
+  return route_request(
+      std::string(_path_request.robot_name),
+      [&](ServerImpl& _shard, bool _last)
+      {
+        return _last ?
+            _shard.send_path_request_async(std::move(_path_request)) :
+            _shard.send_path_request_async(_path_request);
+      });
+}
+
+bool Server::send_destination_request_async(
+    const messages::DestinationRequest& _destination_request)
+{
+  return route_request(
+      _destination_request.robot_name,
+      [&](ServerImpl& _shard, bool)
+      {
+        return _shard.send_destination_request_async(_destination_request);
+      });
+}
+
+bool Server::send_destination_request_async(
+    messages::DestinationRequest&& _destination_request)
+{
+  return route_request(
+      std::string(_destination_request.robot_name),
+      [&](ServerImpl& _shard, bool _last)
+      {
+        return _last ?
+            _shard.send_destination_request_async(
+                std::move(_destination_request)) :
+            _shard.send_destination_request_async(_destination_request);
+      });
+}
+
+size_t Server::find_shard(const std::string& _robot_name) const
+{
+  size_t latest_shard = shards.size();
+  RobotStateRecord::ConstPtr latest_record;
+  for (size_t i = 0; i < shards.size(); ++i)
+  {
+    RobotStateRecord::ConstPtr record =
+        shards[i]->get_robot_state(_robot_name);
+    if (record &&
+        (!latest_record || latest_record->last_seen < record->last_seen))
+    {
+      latest_shard = i;
+      latest_record = std::move(record);
+    }
+  }
+  return latest_shard;
+}
+
+template <typename Send>
+bool Server::route_request(const std::string& _robot_name, const Send& _send)
+{
+  if (shards.size() == 1)
+    return _send(*shards.front(), true);
+
+  const size_t shard = find_shard(_robot_name);
+  if (shard < shards.size())
+    return _send(*shards[shard], true);
+
+  bool sent = true;
+  for (size_t i = 0; i < shards.size(); ++i)
+    sent = _send(*shards[i], i + 1 == shards.size()) && sent;
+  return sent;
+}
+
+template <typename Request, typename Send>
+bool Server::route_requests(
+    std::vector<Request>&& _requests, const Send& _send)
+{
+  std::vector<std::vector<Request>> batches(shards.size());
+  for (auto& request : _requests)
+  {
+    const size_t shard = find_shard(request.robot_name);
+    if (shard < shards.size())
+    {
+      batches[shard].push_back(std::move(request));
+      continue;
+    }
+    for (size_t i = 0; i + 1 < shards.size(); ++i)
+      batches[i].push_back(request);
+    batches.back().push_back(std::move(request));
+  }
+
+  bool sent = true;
+  for (size_t i = 0; i < shards.size(); ++i)
+  {
+    if (!batches[i].empty())
+      sent = _send(*shards[i], std::move(batches[i])) && sent;
+  }
+  return sent;
+}
+
+std::vector<std::string> Server::unique_robot_names(
+    std::vector<std::string> _robot_names)
+{
+  std::sort(_robot_names.begin(), _robot_names.end());
+  _robot_names.erase(
+      std::unique(_robot_names.begin(), _robot_names.end()),
+      _robot_names.end());
+  return _robot_names;
 }
 
 } // namespace free_fleet
@@ -1,4 +1,4 @@
-  /*
+/*
  * Copyright (C) 2019 Open Source Robotics Foundation
  *
  * Licensed under the Apache License, Version 2.0 (the "License");
@@ -15,76 +15,1982 @@
  *
  */
 
+#include <chrono>
+#include <random>
+#include <algorithm>
+
+#include <free_fleet/Tracing.hpp>
+
 #include "ServerImpl.hpp"
 #include "messages/message_utils.hpp"
+#include "dds_utils/common.hpp"
+
+namespace free_fleet {
+
+constexpr size_t Server::ServerImpl::IngestRangeSize;
+
+namespace {
+
+/// Number of robots that can register with a single run of the server
+constexpr size_t MaxRegisteredRobots = 0xFFFF;
+
+} // namespace anonymous
+
+Server::ServerImpl::ServerImpl(const ServerConfig& _config) :
+  server_config(_config),
+  ingest_pool(new WorkerPool(_config.ingest_threads, _config.threads)),
+  spatial_index(_config.spatial_index_cell_size)
+{
+  std::random_device random;
+  registration_session =
+      std::uniform_int_distribution<uint32_t>(1, 0xFFFF)(random);
+
+  topic_stats[RobotStateStats].topic = server_config.dds_robot_state_topic;
+  topic_stats[ModeRequestStats].topic = server_config.dds_mode_request_topic;
+  topic_stats[PathRequestStats].topic = server_config.dds_path_request_topic;
+  topic_stats[DestinationRequestStats].topic =
+      server_config.dds_destination_request_topic;
+  topic_stats[FleetStateStats].topic = server_config.dds_fleet_state_topic;
+  topic_stats[RegistrationStats].topic =
+      server_config.dds_registration_topic;
+  topic_stats[RegistrationAckStats].topic =
+      server_config.dds_registration_ack_topic;
+  topic_stats[TimeSyncPingStats].topic =
+      server_config.dds_time_sync_ping_topic;
+  topic_stats[TimeSyncPongStats].topic =
+      server_config.dds_time_sync_pong_topic;
+  topic_stats[RobotPoseStats].topic = server_config.dds_robot_pose_topic;
+  topic_stats[RobotMetadataStats].topic =
+      server_config.dds_robot_metadata_topic;
+  topic_stats[RequestAckStats].topic = server_config.dds_request_ack_topic;
+}
+
+Server::ServerImpl::~ServerImpl()
+{
+  // The handlers delete their own entities as the fields go out of scope,
+  // the participant is only deleted along with its last user
+  stop_send_thread();
+  stop_fleet_state_thread();
+  stop_time_sync_thread();
+  stop_retry_thread();
+
+  if (fields.waitset)
+    fields.waitset->stop();
+  if (fields.time_sync_waitset)
+    fields.time_sync_waitset->stop();
+  if (fields.request_ack_waitset)
+    fields.request_ack_waitset->stop();
+}
+
+void Server::ServerImpl::start(Fields _fields)
+{
+  fields = std::move(_fields);
+
+  topic_stats[RobotStateStats].reader = fields.robot_state_sub->get_reader();
+  topic_stats[RegistrationStats].reader =
+      fields.registration_sub->get_reader();
+  if (fields.robot_pose_sub)
+  {
+    topic_stats[RobotPoseStats].reader = fields.robot_pose_sub->get_reader();
+    topic_stats[RobotMetadataStats].reader =
+        fields.robot_metadata_sub->get_reader();
+  }
+
+  if (fields.fleet_state_pub)
+  {
+    fleet_state_thread_running = true;
+    fleet_state_thread =
+        std::thread(&ServerImpl::fleet_state_thread_fn, this);
+  }
+
+  if (fields.time_sync_ping_pub)
+  {
+    topic_stats[TimeSyncPongStats].reader =
+        fields.time_sync_pong_sub->get_reader();
+    fields.time_sync_waitset->attach(
+        fields.time_sync_pong_sub->get_reader(),
+        std::bind(&ServerImpl::handle_time_sync_pongs, this));
+
+    time_sync_thread_running = true;
+    time_sync_thread = std::thread(&ServerImpl::time_sync_thread_fn, this);
+  }
+
+  if (fields.request_ack_sub)
+  {
+    topic_stats[RequestAckStats].reader =
+        fields.request_ack_sub->get_reader();
+    fields.request_ack_waitset->attach(
+        fields.request_ack_sub->get_reader(),
+        std::bind(&ServerImpl::handle_request_acks, this));
+
+    retry_thread_running = true;
+    retry_thread = std::thread(&ServerImpl::retry_thread_fn, this);
+  }
+}
+
+void Server::ServerImpl::fleet_state_thread_fn()
+{
+  server_config.threads.apply("fleet state");
+
+  const auto period =
+      std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+          std::chrono::duration<double>(server_config.fleet_state_period));
+
+  std::shared_ptr<const FleetSnapshot> published_snapshot;
+  auto next_publish = std::chrono::steady_clock::now();
+  while (true)
+  {
+    {
+      std::unique_lock<std::mutex> lock(fleet_state_mutex);
+      next_publish += period;
+      fleet_state_cv.wait_until(
+          lock, next_publish, [this]() { return !fleet_state_thread_running; });
+      if (!fleet_state_thread_running)
+        return;
+    }
+
+    // Snapshots are only ever replaced, an unchanged pointer means nothing
+    // has changed since the last fleet state went out
+    auto snapshot = fleet_snapshot.load();
+    if (snapshot == published_snapshot)
+      continue;
+
+    auto sample = fields.fleet_state_pub->lock_sample();
+    const auto convert_start = std::chrono::steady_clock::now();
+    common::dds_string_assign(sample->name, server_config.fleet_name);
+    messages::convert(*snapshot, sample->robots);
+    conversion_time.record(nanoseconds_since(convert_start));
+    if (topic_stats[FleetStateStats].record_write(
+        fields.fleet_state_pub->write(sample.get()),
+        messages::payload_size(*sample)))
+      published_snapshot = std::move(snapshot);
+  }
+}
+
+void Server::ServerImpl::stop_fleet_state_thread()
+{
+  {
+    std::lock_guard<std::mutex> lock(fleet_state_mutex);
+    if (!fleet_state_thread_running)
+      return;
+    fleet_state_thread_running = false;
+  }
+  fleet_state_cv.notify_one();
+  if (fleet_state_thread.joinable())
+    fleet_state_thread.join();
+}
+
+void Server::ServerImpl::time_sync_thread_fn()
+{
+  server_config.threads.apply("time sync");
+
+  const auto period =
+      std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+          std::chrono::duration<double>(server_config.time_sync_period));
+
+  auto next_ping = std::chrono::steady_clock::now();
+  while (true)
+  {
+    {
+      std::unique_lock<std::mutex> lock(time_sync_mutex);
+      time_sync_cv.wait_until(
+          lock, next_ping, [this]() { return !time_sync_thread_running; });
+      if (!time_sync_thread_running)
+        return;
+    }
+    next_ping += period;
+
+    // Estimates are only stored once a period, instead of on every pong, so
+    // that readers never wait on the waitset thread
+    std::shared_ptr<ClockOffsets> offsets = std::make_shared<ClockOffsets>();
+    {
+      std::lock_guard<std::mutex> lock(clock_filters_mutex);
+      offsets->reserve(clock_filters.size());
+      for (const auto& it : clock_filters)
+      {
+        ClockOffset& offset = (*offsets)[it.first];
+        offset.robot_name = it.first;
+        offset.offset = it.second.offset();
+        offset.round_trip = it.second.round_trip();
+        offset.exchanges = it.second.exchanges();
+      }
+    }
+    clock_offsets.store(std::move(offsets));
+
+    auto ping = fields.time_sync_ping_pub->lock_sample();
+    common::dds_string_assign(ping->fleet_name, server_config.fleet_name);
+    ping->server_send_time = dds_time();
+    topic_stats[TimeSyncPingStats].record_write(
+        fields.time_sync_ping_pub->write(ping.get()),
+        messages::payload_size(*ping));
+  }
+}
+
+void Server::ServerImpl::stop_time_sync_thread()
+{
+  {
+    std::lock_guard<std::mutex> lock(time_sync_mutex);
+    if (!time_sync_thread_running)
+      return;
+    time_sync_thread_running = false;
+  }
+  time_sync_cv.notify_one();
+  if (time_sync_thread.joinable())
+    time_sync_thread.join();
+}
+
+void Server::ServerImpl::handle_time_sync_pongs()
+{
+  while (true)
+  {
+    auto pongs = fields.time_sync_pong_sub->take_loaned();
+    const dds_time_t received_time = dds_time();
+    {
+      std::lock_guard<std::mutex> lock(clock_filters_mutex);
+      for (size_t i = 0; i < pongs.size(); ++i)
+      {
+        if (!pongs.valid(i))
+          continue;
+
+        const FreeFleetData_TimeSyncPong& pong = pongs[i];
+        topic_stats[TimeSyncPongStats].record_received(
+            messages::payload_size(pong));
+        if (!pong.fleet_name || !pong.robot_name ||
+            server_config.fleet_name != pong.fleet_name)
+          continue;
+
+        clock_filters[pong.robot_name].add(
+            pong.server_send_time, pong.client_receive_time,
+            pong.client_send_time, received_time);
+      }
+    }
+
+    if (!pongs.full())
+      break;
+  }
+}
+
+int64_t Server::ServerImpl::find_clock_offset(
+    const ClockOffsets& _offsets, const char* _robot_name)
+{
+  if (_offsets.empty() || !_robot_name)
+    return 0;
+
+  auto it = _offsets.find(_robot_name);
+  return it == _offsets.end() ? 0 : it->second.offset;
+}
+
+std::vector<ClockOffset> Server::ServerImpl::get_clock_offsets() const
+{
+  auto offsets = clock_offsets.load();
+  std::vector<ClockOffset> sorted_offsets;
+  sorted_offsets.reserve(offsets->size());
+  for (const auto& it : *offsets)
+    sorted_offsets.push_back(it.second);
+  std::sort(
+      sorted_offsets.begin(), sorted_offsets.end(),
+      [](const ClockOffset& _a, const ClockOffset& _b)
+      {
+        return _a.robot_name < _b.robot_name;
+      });
+  return sorted_offsets;
+}
+
+void Server::ServerImpl::resize_robot_states(
+    std::vector<messages::RobotState>& _robot_states, size_t _size,
+    std::vector<messages::RobotState>* _spare_robot_states)
+{
+  if (!_spare_robot_states)
+  {
+    _robot_states.resize(_size);
+    return;
+  }
+
+  while (_robot_states.size() > _size)
+  {
+    _spare_robot_states->push_back(std::move(_robot_states.back()));
+    _robot_states.pop_back();
+  }
+  while (_robot_states.size() < _size && !_spare_robot_states->empty())
+  {
+    _robot_states.push_back(std::move(_spare_robot_states->back()));
+    _spare_robot_states->pop_back();
+  }
+  _robot_states.resize(_size);
+}
+
+bool Server::ServerImpl::read_robot_states(
+    std::vector<messages::RobotState>& _new_robot_states,
+    std::vector<messages::RobotState>* _spare_robot_states)
+{
+  std::vector<std::string> lost;
+  std::vector<std::string> rejoined;
+  size_t valid_num = 0;
+  {
+    std::lock_guard<std::mutex> lock(robot_state_mutex);
+    handle_registrations();
+
+    // With one instance per robot, the reader holds at most one state for
+    // each robot, keep taking until the reader has been drained so that every
+    // robot gets reported regardless of the size of the fleet. The loans are
+    // held on to until everything has been converted.
+    std::vector<RobotStateSubscribeHandler::LoanedSamples>& loans =
+        robot_state_loans;
+    const auto offsets = clock_offsets.load();
+    taken_robot_states.clear();
+    taken_clock_offsets.clear();
+    unalive_robots.clear();
+    while (true)
+    {
+      loans.push_back(fields.robot_state_sub->take_loaned());
+      const auto& robot_states = loans.back();
+      const dds_time_t received_time = dds_time();
+      for (size_t i = 0; i < robot_states.size(); ++i)
+      {
+        if (robot_states.valid(i))
+        {
+          const int64_t clock_offset =
+              find_clock_offset(*offsets, robot_states[i].name);
+          record_robot_state(
+              robot_states[i], robot_states.info(i), received_time,
+              clock_offset);
+          taken_robot_states.push_back(&robot_states[i]);
+          taken_clock_offsets.push_back(clock_offset);
+          continue;
+        }
+
+        // Samples without data still carry the robot name, which is the key,
+        // when the robot's instance is no longer alive
+        if (robot_states.info(i).instance_state != DDS_IST_ALIVE &&
+            robot_states[i].name)
+          unalive_robots.emplace_back(robot_states[i].name);
+      }
+
+      if (!robot_states.full())
+        break;
+    }
+
+    // Existing elements are converted into in place, keeping their string
+    // and path capacities around for callers that reuse the same vector.
+    // Each state is converted into its own slot, so the results come out in
+    // the order they were taken in, however the conversion gets split up.
+    valid_num = taken_robot_states.size();
+    if (_new_robot_states.size() < valid_num)
+      resize_robot_states(_new_robot_states, valid_num, _spare_robot_states);
+    ingest_pool->parallel_for(
+        valid_num, IngestRangeSize,
+        [this, &_new_robot_states](size_t _begin, size_t _end)
+        {
+          // Timing the whole range keeps the clock off the way of each
+          // state, every state is counted with the average of its range
+          const auto convert_start = std::chrono::steady_clock::now();
+          for (size_t i = _begin; i < _end; ++i)
+          {
+            convert(*taken_robot_states[i], _new_robot_states[i]);
+            messages::correct_clock_offset(
+                taken_clock_offsets[i], _new_robot_states[i].location.sec,
+                _new_robot_states[i].location.nanosec);
+            apply_registration(_new_robot_states[i]);
+            expand_path_progress(_new_robot_states[i]);
+          }
+          if (_end > _begin)
+            conversion_time.record(
+                nanoseconds_since(convert_start) / (_end - _begin),
+                _end - _begin);
+        });
+    loans.clear();
+
+    if (fields.robot_pose_sub)
+      valid_num = take_robot_poses(
+          _new_robot_states, valid_num, _spare_robot_states);
+
+    // Expiry is checked on every read, even without any new states
+    if (valid_num > 0)
+    {
+      resize_robot_states(_new_robot_states, valid_num, _spare_robot_states);
+      update_fleet_snapshot(_new_robot_states, lost, rejoined);
+    }
+    else
+    {
+      update_fleet_snapshot({}, lost, rejoined);
+    }
+
+    if (server_config.dds_request_partitions && valid_num > 0)
+    {
+      for (const auto& robot_state : _new_robot_states)
+        prepare_robot_partitions(robot_state.name);
+    }
+  }
+
+  trigger_robot_events(lost, rejoined);
+  return valid_num > 0;
+}
+
+size_t Server::ServerImpl::append_robot_states(
+    std::vector<messages::RobotState>& _new_robot_states, size_t _count,
+    std::vector<messages::RobotState>* _spare_robot_states)
+{
+  std::lock_guard<std::mutex> lock(appended_robot_states_mutex);
+  if (!read_robot_states(
+      appended_robot_states, &spare_appended_robot_states))
+    return _count;
+
+  // Swapping leaves the string and path capacities of both sides around
+  const size_t total = _count + appended_robot_states.size();
+  if (_new_robot_states.size() < total)
+    resize_robot_states(_new_robot_states, total, _spare_robot_states);
+  for (size_t i = 0; i < appended_robot_states.size(); ++i)
+    std::swap(_new_robot_states[_count + i], appended_robot_states[i]);
+  return total;
+}
+
+bool Server::ServerImpl::read_robot_state_views(
+    const RobotStateViewCallback& _callback)
+{
+  if (!_callback)
+    return false;
+
+  std::vector<std::string> lost;
+  std::vector<std::string> rejoined;
+  bool received = false;
+  {
+    std::lock_guard<std::mutex> lock(robot_state_mutex);
+
+    handle_registrations();
+
+    // Views are handed out one take window at a time, as the callback is done
+    // with them before the next window is taken, no loan is held any longer
+    // than that. Views of registered robots point to the metadata in their
+    // registration, which only changes while taking in registrations.
+    const auto offsets = clock_offsets.load();
+    unalive_robots.clear();
+    while (true)
+    {
+      auto robot_states = fields.robot_state_sub->take_loaned();
+      const dds_time_t received_time = dds_time();
+      for (size_t i = 0; i < robot_states.size(); ++i)
+      {
+        if (robot_states.valid(i))
+        {
+          const int64_t clock_offset =
+              find_clock_offset(*offsets, robot_states[i].name);
+          record_robot_state(
+              robot_states[i], robot_states.info(i), received_time,
+              clock_offset);
+          const RegisteredRobot* robot =
+              find_registered_robot(
+                  robot_states[i].robot_id, robot_states[i].name);
+          if (robot)
+            _callback(messages::RobotStateView(
+                robot_states[i], robot->model.c_str(),
+                robot->task_id.c_str(), clock_offset));
+          else
+            _callback(messages::RobotStateView(robot_states[i], clock_offset));
+          received = true;
+          continue;
+        }
+
+        if (robot_states.info(i).instance_state != DDS_IST_ALIVE &&
+            robot_states[i].name)
+          unalive_robots.emplace_back(robot_states[i].name);
+      }
+
+      if (!robot_states.full())
+        break;
+    }
+
+    // Poses are viewed along with the metadata sample of their robot, they
+    // are held back the same way until the metadata has arrived
+    if (fields.robot_pose_sub)
+    {
+      handle_robot_metadata();
+      while (true)
+      {
+        auto poses = fields.robot_pose_sub->take_loaned();
+        const dds_time_t received_time = dds_time();
+        for (size_t i = 0; i < poses.size(); ++i)
+        {
+          const FreeFleetData_RobotPose& pose = poses[i];
+          if (!poses.valid(i))
+          {
+            if (poses.info(i).instance_state != DDS_IST_ALIVE && pose.name)
+              unalive_robots.emplace_back(pose.name);
+            continue;
+          }
+
+          const int64_t clock_offset =
+              find_clock_offset(*offsets, pose.name);
+          topic_stats[RobotPoseStats].record_received(
+              messages::payload_size(pose));
+          receipt_age.record(
+              sample_age(poses.info(i), received_time, clock_offset));
+          if (!pose.name)
+            continue;
+          auto it = robot_metadata.find(pose.name);
+          if (it == robot_metadata.end())
+            continue;
+
+          const FreeFleetData_RobotState& metadata = *it->second.sample;
+          const RegisteredRobot* robot =
+              find_registered_robot(metadata.robot_id, metadata.name);
+          _callback(messages::RobotStateView(
+              metadata, pose,
+              robot ? robot->model.c_str() : nullptr,
+              robot ? robot->task_id.c_str() : nullptr,
+              clock_offset));
+          received = true;
+        }
+
+        if (!poses.full())
+          break;
+      }
+    }
+
+    // Robots that are gone still get removed from the snapshot and reported
+    update_fleet_snapshot({}, lost, rejoined);
+  }
+
+  trigger_robot_events(lost, rejoined);
+  return received;
+}
+
+void Server::ServerImpl::handle_robot_metadata()
+{
+  while (true)
+  {
+    auto metadata = fields.robot_metadata_sub->take_loaned();
+    for (size_t i = 0; i < metadata.size(); ++i)
+    {
+      const FreeFleetData_RobotState& sample = metadata[i];
+      if (!metadata.valid(i))
+      {
+        // The metadata goes away along with the robot's writer, a robot that
+        // comes back sends its metadata again before its first pose
+        if (metadata.info(i).instance_state != DDS_IST_ALIVE && sample.name)
+          robot_metadata.erase(sample.name);
+        continue;
+      }
+
+      topic_stats[RobotMetadataStats].record_received(
+          messages::payload_size(sample));
+      if (!sample.name)
+        continue;
+
+      RobotMetadata& entry = robot_metadata[sample.name];
+      convert(sample, entry.state);
+      if (!entry.sample)
+        entry.sample.reset(
+            static_cast<FreeFleetData_RobotState*>(
+                dds_alloc(sizeof(FreeFleetData_RobotState))),
+            [](FreeFleetData_RobotState* _sample)
+            {
+              FreeFleetData_RobotState_free(_sample, DDS_FREE_ALL);
+            });
+      convert(entry.state, *entry.sample);
+    }
+
+    if (!metadata.full())
+      break;
+  }
+}
+
+size_t Server::ServerImpl::take_robot_poses(
+    std::vector<messages::RobotState>& _robot_states, size_t _count,
+    std::vector<messages::RobotState>* _spare_robot_states)
+{
+  handle_robot_metadata();
+
+  // Copying the metadata into existing states reuses their string and path
+  // capacities the same way converting into them does
+  const auto offsets = clock_offsets.load();
+  while (true)
+  {
+    auto poses = fields.robot_pose_sub->take_loaned();
+    const dds_time_t received_time = dds_time();
+    for (size_t i = 0; i < poses.size(); ++i)
+    {
+      const FreeFleetData_RobotPose& pose = poses[i];
+      if (!poses.valid(i))
+      {
+        if (poses.info(i).instance_state != DDS_IST_ALIVE && pose.name)
+          unalive_robots.emplace_back(pose.name);
+        continue;
+      }
+
+      const int64_t clock_offset = find_clock_offset(*offsets, pose.name);
+      topic_stats[RobotPoseStats].record_received(
+          messages::payload_size(pose));
+      receipt_age.record(
+          sample_age(poses.info(i), received_time, clock_offset));
+      if (!pose.name)
+        continue;
+      auto it = robot_metadata.find(pose.name);
+      if (it == robot_metadata.end())
+        continue;
+
+      if (_robot_states.size() <= _count)
+        resize_robot_states(_robot_states, _count + 1, _spare_robot_states);
+      messages::RobotState& robot_state = _robot_states[_count++];
+      const auto convert_start = std::chrono::steady_clock::now();
+      robot_state = it->second.state;
+      convert(pose.mode, robot_state.mode);
+      convert(pose.location, robot_state.location);
+      messages::correct_clock_offset(
+          clock_offset, robot_state.location.sec,
+          robot_state.location.nanosec);
+      apply_registration(robot_state);
+      expand_path_progress(robot_state);
+      conversion_time.record(nanoseconds_since(convert_start));
+    }
+
+    if (!poses.full())
+      break;
+  }
+  return _count;
+}
+
+void Server::ServerImpl::record_robot_state(
+    const FreeFleetData_RobotState& _robot_state,
+    const dds_sample_info_t& _info,
+    dds_time_t _received,
+    int64_t _clock_offset)
+{
+  topic_stats[RobotStateStats].record_received(
+      messages::payload_size(_robot_state));
+  receipt_age.record(sample_age(_info, _received, _clock_offset));
+}
+
+void Server::ServerImpl::update_fleet_snapshot(
+    const std::vector<messages::RobotState>& _new_robot_states,
+    std::vector<std::string>& _lost,
+    std::vector<std::string>& _rejoined)
+{
+  const auto now = std::chrono::steady_clock::now();
+  auto current_snapshot = fleet_snapshot.load();
+
+  // Robots that have been quiet for longer than the timeout expire, unless
+  // they are part of this update
+  std::vector<std::string> expired;
+  if (server_config.robot_expiry_timeout > 0.0)
+  {
+    const auto deadline = now -
+        std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+            std::chrono::duration<double>(server_config.robot_expiry_timeout));
+    for (const auto& it : *current_snapshot)
+    {
+      if (it.second->last_seen < deadline)
+        expired.push_back(it.first);
+    }
+    for (size_t i = 0; i < _new_robot_states.size() && !expired.empty(); ++i)
+    {
+      const auto& robot_state = _new_robot_states[i];
+      auto expired_it =
+          std::find(expired.begin(), expired.end(), robot_state.name);
+      if (expired_it != expired.end())
+        expired.erase(expired_it);
+    }
+  }
+
+  if (_new_robot_states.empty() && unalive_robots.empty() && expired.empty())
+    return;
+
+  // Copying the snapshot only copies the pointers to the records, records of
+  // robots that were not updated are shared with the previous snapshot.
+  auto new_snapshot = std::make_shared<FleetSnapshot>(*current_snapshot);
+  for (const auto& robot_state : _new_robot_states)
+  {
+    if (lost_robots.erase(robot_state.name) > 0)
+      _rejoined.push_back(robot_state.name);
+
+    (*new_snapshot)[robot_state.name] =
+        std::make_shared<const RobotStateRecord>(
+            RobotStateRecord{robot_state, now});
+  }
+  update_state_histories(_new_robot_states);
+  if (server_config.spatial_index_cell_size > 0.0 &&
+      !_new_robot_states.empty())
+  {
+    std::lock_guard<std::mutex> lock(spatial_index_mutex);
+    for (const auto& robot_state : _new_robot_states)
+      spatial_index.update(robot_state.name, robot_state.location);
+  }
+
+  // Only the names of lost robots are kept around, for telling when they
+  // rejoin
+  auto remove_robot = [&](const std::string& _robot_name)
+  {
+    if (new_snapshot->erase(_robot_name) == 0)
+      return;
+
+    lost_robots.insert(_robot_name);
+    _lost.push_back(_robot_name);
+
+    if (server_config.spatial_index_cell_size > 0.0)
+    {
+      std::lock_guard<std::mutex> lock(spatial_index_mutex);
+      spatial_index.remove(_robot_name);
+    }
+
+    std::lock_guard<std::mutex> lock(sent_paths_mutex);
+    sent_paths.erase(_robot_name);
+    queued_paths.erase(_robot_name);
+  };
+  for (const auto& robot_name : unalive_robots)
+    remove_robot(robot_name);
+  for (const auto& robot_name : expired)
+    remove_robot(robot_name);
+
+  fleet_snapshot.store(std::move(new_snapshot));
+}
+
+void Server::ServerImpl::update_state_histories(
+    const std::vector<messages::RobotState>& _new_robot_states)
+{
+  const size_t capacity = server_config.robot_state_history_capacity;
+  if (capacity == 0 || _new_robot_states.empty())
+    return;
+
+  std::lock_guard<std::mutex> lock(state_history_mutex);
+  for (const auto& robot_state : _new_robot_states)
+  {
+    auto it = state_histories.find(robot_state.name);
+    if (it == state_histories.end())
+      it = state_histories.emplace(
+          robot_state.name, RobotStateHistory(capacity)).first;
+    it->second.append(robot_state);
+  }
+}
+
+bool Server::ServerImpl::get_state_history(
+    const std::string& _robot_name,
+    int64_t _start_time,
+    int64_t _end_time,
+    StateHistory& _history) const
+{
+  _history.clear();
+  std::lock_guard<std::mutex> lock(state_history_mutex);
+  const auto it = state_histories.find(_robot_name);
+  if (it == state_histories.end())
+    return false;
+  it->second.query(_start_time, _end_time, _history);
+  return true;
+}
+
+std::vector<std::string> Server::ServerImpl::query_radius(
+    const std::string& _level_name,
+    double _x,
+    double _y,
+    double _radius) const
+{
+  std::vector<std::string> robot_names;
+  if (server_config.spatial_index_cell_size > 0.0)
+  {
+    std::lock_guard<std::mutex> lock(spatial_index_mutex);
+    spatial_index.query_radius(_level_name, _x, _y, _radius, robot_names);
+    return robot_names;
+  }
+
+  if (!(_radius >= 0.0))
+    return robot_names;
+
+  const double squared_radius = _radius * _radius;
+  auto snapshot = fleet_snapshot.load();
+  for (const auto& it : *snapshot)
+  {
+    const auto& location = it.second->state.location;
+    const double dx = location.x - _x;
+    const double dy = location.y - _y;
+    if (location.level_name == _level_name &&
+        dx * dx + dy * dy <= squared_radius)
+      robot_names.push_back(it.first);
+  }
+  return robot_names;
+}
+
+std::vector<std::string> Server::ServerImpl::query_box(
+    const std::string& _level_name,
+    double _min_x,
+    double _min_y,
+    double _max_x,
+    double _max_y) const
+{
+  std::vector<std::string> robot_names;
+  if (server_config.spatial_index_cell_size > 0.0)
+  {
+    std::lock_guard<std::mutex> lock(spatial_index_mutex);
+    spatial_index.query_box(
+        _level_name, _min_x, _min_y, _max_x, _max_y, robot_names);
+    return robot_names;
+  }
+
+  auto snapshot = fleet_snapshot.load();
+  for (const auto& it : *snapshot)
+  {
+    const auto& location = it.second->state.location;
+    if (location.level_name == _level_name &&
+        location.x >= _min_x && location.x <= _max_x &&
+        location.y >= _min_y && location.y <= _max_y)
+      robot_names.push_back(it.first);
+  }
+  return robot_names;
+}
+
+bool Server::ServerImpl::on_robot_lost(RobotEventCallback _callback)
+{
+  if (!_callback)
+    return false;
+
+  std::lock_guard<std::mutex> lock(robot_event_callbacks_mutex);
+  robot_lost_callback = std::move(_callback);
+  return true;
+}
+
+bool Server::ServerImpl::on_robot_rejoined(RobotEventCallback _callback)
+{
+  if (!_callback)
+    return false;
+
+  std::lock_guard<std::mutex> lock(robot_event_callbacks_mutex);
+  robot_rejoined_callback = std::move(_callback);
+  return true;
+}
+
+void Server::ServerImpl::trigger_robot_events(
+    const std::vector<std::string>& _lost,
+    const std::vector<std::string>& _rejoined)
+{
+  if (_lost.empty() && _rejoined.empty())
+    return;
+
+  RobotEventCallback lost_callback;
+  RobotEventCallback rejoined_callback;
+  {
+    std::lock_guard<std::mutex> lock(robot_event_callbacks_mutex);
+    lost_callback = robot_lost_callback;
+    rejoined_callback = robot_rejoined_callback;
+  }
+
+  if (rejoined_callback)
+  {
+    for (const auto& robot_name : _rejoined)
+      rejoined_callback(robot_name);
+  }
+  if (lost_callback)
+  {
+    for (const auto& robot_name : _lost)
+      lost_callback(robot_name);
+  }
+}
+
+void Server::ServerImpl::handle_registrations()
+{
+  while (true)
+  {
+    auto registrations = fields.registration_sub->take_loaned();
+    for (size_t i = 0; i < registrations.size(); ++i)
+    {
+      const FreeFleetData_RobotRegistration& registration = registrations[i];
+      if (!registrations.valid(i))
+        continue;
+
+      topic_stats[RegistrationStats].record_received(
+          messages::payload_size(registration));
+      if (registration.fleet_name && registration.robot_name &&
+          server_config.fleet_name == registration.fleet_name)
+        register_robot(registration);
+    }
+
+    if (!registrations.full())
+      break;
+  }
+}
+
+void Server::ServerImpl::register_robot(
+    const FreeFleetData_RobotRegistration& _registration)
+{
+  std::lock_guard<std::mutex> lock(registry_mutex);
+
+  // Robots register again whenever their metadata changes, they keep the id
+  // they were first assigned, and so do robots that were lost and rejoined
+  auto it = registered_indices.find(_registration.robot_name);
+  if (it != registered_indices.end())
+  {
+    RegisteredRobot& robot = registered_robots[it->second];
+    robot.model = _registration.model ? _registration.model : "";
+    robot.task_id = _registration.task_id ? _registration.task_id : "";
+    return;
+  }
+
+  if (registered_robots.size() >= MaxRegisteredRobots)
+  {
+    DDS_WARNING(
+        "too many registered robots, %s is left unregistered\n",
+        _registration.robot_name);
+    return;
+  }
+
+  const size_t index = registered_robots.size();
+  registered_robots.push_back(RegisteredRobot{
+      (registration_session << 16) | static_cast<uint32_t>(index + 1),
+      _registration.robot_name,
+      _registration.model ? _registration.model : "",
+      _registration.task_id ? _registration.task_id : ""});
+  registered_indices[_registration.robot_name] = index;
+
+  // The ack is kept around by the writer, clients that restart get their id
+  // back as soon as they join
+  auto sample = fields.registration_ack_pub->lock_sample();
+  common::dds_string_assign(sample->fleet_name, server_config.fleet_name);
+  common::dds_string_assign(sample->robot_name, _registration.robot_name);
+  sample->robot_id = registered_robots.back().id;
+  topic_stats[RegistrationAckStats].record_write(
+      fields.registration_ack_pub->write(sample.get()),
+      messages::payload_size(*sample));
+}
+
+const Server::ServerImpl::RegisteredRobot*
+Server::ServerImpl::find_registered_robot(
+    uint32_t _robot_id, const char* _robot_name) const
+{
+  if (_robot_id == 0)
+    return nullptr;
+
+  if ((_robot_id >> 16) == registration_session)
+  {
+    const size_t index = (_robot_id & 0xFFFF) - 1;
+    return index < registered_robots.size() ?
+        &registered_robots[index] : nullptr;
+  }
+
+  if (!_robot_name)
+    return nullptr;
+  auto it = registered_indices.find(_robot_name);
+  if (it == registered_indices.end())
+    return nullptr;
+  return &registered_robots[it->second];
+}
+
+void Server::ServerImpl::apply_registration(
+    messages::RobotState& _robot_state) const
+{
+  if (_robot_state.robot_id == 0)
+    return;
+
+  // Robots still using the id of an earlier run of the server, that this
+  // run has not seen register yet, are reported as unregistered until they
+  // register again
+  const RegisteredRobot* robot = find_registered_robot(
+      _robot_state.robot_id, _robot_state.name.c_str());
+  if (!robot)
+  {
+    _robot_state.robot_id = 0;
+    return;
+  }
+  _robot_state.robot_id = robot->id;
+  _robot_state.model = robot->model;
+  _robot_state.task_id = robot->task_id;
+}
 
-namespace free_fleet {
+uint32_t Server::ServerImpl::registered_robot_id(
+    const std::string& _robot_name)
+{
+  std::lock_guard<std::mutex> lock(registry_mutex);
+  auto it = registered_indices.find(_robot_name);
+  if (it == registered_indices.end())
+    return 0;
+  return registered_robots[it->second].id;
+}
 
-Server::ServerImpl::ServerImpl(const ServerConfig& _config) :
-  server_config(_config)
+void Server::ServerImpl::prepare_robot_partitions(
+    const std::string& _robot_name)
+{
+  if (partitioned_robots.find(_robot_name) != partitioned_robots.end())
+    return;
+
+  // Setting up the writers as soon as the robot shows up, gives them time to
+  // be matched with the client before the first request gets sent
+  const std::string partition =
+      common::robot_partition(server_config.fleet_name, _robot_name);
+  if (fields.mode_request_pub->prepare_partition(partition) &&
+      fields.path_request_pub->prepare_partition(partition) &&
+      fields.destination_request_pub->prepare_partition(partition))
+    partitioned_robots.insert(_robot_name);
+}
+
+uint32_t Server::ServerImpl::next_path_version()
+{
+  // Version 0 is reserved for robots that are not following any path
+  if (++last_path_version == 0)
+    ++last_path_version;
+  return last_path_version;
+}
+
+uint32_t Server::ServerImpl::record_sent_path(
+    const std::string& _robot_name, std::vector<messages::Location> _path,
+    bool _queued)
+{
+  std::lock_guard<std::mutex> lock(sent_paths_mutex);
+  const uint32_t version = next_path_version();
+  if (_queued)
+  {
+    queued_paths[_robot_name].push_back(SentPath{version, std::move(_path)});
+    return version;
+  }
+
+  queued_paths.erase(_robot_name);
+  SentPath& sent_path = sent_paths[_robot_name];
+  sent_path.version = version;
+  sent_path.path = std::move(_path);
+  return sent_path.version;
+}
+
+auto Server::ServerImpl::find_sent_path(
+    const std::string& _robot_name, uint32_t _version) -> const SentPath*
+{
+  auto it = sent_paths.find(_robot_name);
+  if (it != sent_paths.end() && it->second.version == _version)
+    return &it->second;
+
+  auto queued_it = queued_paths.find(_robot_name);
+  if (queued_it == queued_paths.end())
+    return nullptr;
+
+  // Paths queued before the one the robot is following have been completed
+  std::vector<SentPath>& queued = queued_it->second;
+  for (size_t i = 0; i < queued.size(); ++i)
+  {
+    if (queued[i].version != _version)
+      continue;
+    SentPath& sent_path = sent_paths[_robot_name];
+    sent_path = std::move(queued[i]);
+    queued.erase(queued.begin(), queued.begin() + i + 1);
+    if (queued.empty())
+      queued_paths.erase(queued_it);
+    return &sent_path;
+  }
+  return nullptr;
+}
+
+uint32_t Server::ServerImpl::record_path_update(
+    const messages::PathRequest& _update, uint32_t& _base_version)
+{
+  std::lock_guard<std::mutex> lock(sent_paths_mutex);
+  auto it = sent_paths.find(_update.robot_name);
+  if (it == sent_paths.end())
+    return 0;
+
+  SentPath& sent_path = it->second;
+  sent_path.path.resize(_update.kept_waypoints(sent_path.path.size()));
+  sent_path.path.insert(
+      sent_path.path.end(), _update.path.begin(), _update.path.end());
+  _base_version = sent_path.version;
+  sent_path.version = next_path_version();
+  return sent_path.version;
+}
+
+namespace {
+
+bool same_waypoint(
+    const messages::Location& _first, const messages::Location& _second)
+{
+  return _first.sec == _second.sec &&
+      _first.nanosec == _second.nanosec &&
+      _first.x == _second.x &&
+      _first.y == _second.y &&
+      _first.yaw == _second.yaw &&
+      _first.level_name == _second.level_name;
+}
+
+} // namespace anonymous
+
+bool Server::ServerImpl::make_path_update(
+    const messages::PathRequest& _path_request,
+    messages::PathRequest& _update)
+{
+  // Queued paths do not start from where the robot currently is
+  if (!_path_request.after_task_id.empty())
+    return false;
+
+  RobotStateRecord::ConstPtr robot = get_robot_state(_path_request.robot_name);
+  if (!robot || robot->state.path_version == 0)
+    return false;
+
+  std::lock_guard<std::mutex> lock(sent_paths_mutex);
+  const SentPath* sent_path =
+      find_sent_path(_path_request.robot_name, robot->state.path_version);
+  if (!sent_path)
+    return false;
+
+  // The new path is expected to start from the waypoint the robot was last
+  // heading to, nothing is saved if even that one has changed
+  const std::vector<messages::Location>& base = sent_path->path;
+  const std::vector<messages::Location>& path = _path_request.path;
+  const size_t offset =
+      std::min(static_cast<size_t>(robot->state.path_index), base.size());
+  size_t matched = 0;
+  while (matched < path.size() && offset + matched < base.size() &&
+      same_waypoint(path[matched], base[offset + matched]))
+    ++matched;
+  if (matched == 0)
+    return false;
+
+  _update.fleet_name = _path_request.fleet_name;
+  _update.robot_name = _path_request.robot_name;
+  _update.task_id = _path_request.task_id;
+  _update.path.assign(path.begin() + matched, path.end());
+  _update.start_index = static_cast<uint32_t>(offset + matched);
+  if (_update.path.empty())
+    _update.operation = messages::PathRequest::PATH_TRUNCATE;
+  else if (offset + matched == base.size())
+    _update.operation = messages::PathRequest::PATH_APPEND;
+  else
+    _update.operation = messages::PathRequest::PATH_REPLACE_FROM;
+  return true;
+}
+
+void Server::ServerImpl::expand_path_progress(
+    messages::RobotState& _robot_state)
+{
+  if (_robot_state.path_version == 0 || !_robot_state.path.empty())
+    return;
+
+  std::lock_guard<std::mutex> lock(sent_paths_mutex);
+  const SentPath* sent_path =
+      find_sent_path(_robot_state.name, _robot_state.path_version);
+  if (!sent_path)
+    return;
+
+  const std::vector<messages::Location>& path = sent_path->path;
+  size_t path_index =
+      std::min(static_cast<size_t>(_robot_state.path_index), path.size());
+  _robot_state.path.assign(path.begin() + path_index, path.end());
+}
+
+bool Server::ServerImpl::on_robot_states(RobotStatesCallback _callback)
+{
+  if (!_callback)
+    return false;
+
+  // Poses wake the waitset up the same way states do, every read takes in
+  // both of them
+  if (fields.robot_pose_sub &&
+      !fields.waitset->attach(
+          fields.robot_pose_sub->get_reader(),
+          std::bind(&ServerImpl::handle_robot_states, this, _callback)))
+    return false;
+
+  return fields.waitset->attach(
+      fields.robot_state_sub->get_reader(),
+      std::bind(&ServerImpl::handle_robot_states, this, std::move(_callback)));
+}
+
+bool Server::ServerImpl::start_robot_state_ingest()
+{
+  // Taking the states is enough to have the snapshot updated
+  return on_robot_states([](const std::vector<messages::RobotState>&) {});
+}
+
+std::shared_ptr<const FleetSnapshot>
+Server::ServerImpl::get_fleet_snapshot() const
+{
+  return fleet_snapshot.load();
+}
+
+RobotStateRecord::ConstPtr Server::ServerImpl::get_robot_state(
+    const std::string& _robot_name) const
+{
+  auto snapshot = fleet_snapshot.load();
+  auto it = snapshot->find(_robot_name);
+  if (it == snapshot->end())
+    return nullptr;
+  return it->second;
+}
+
+Stats Server::ServerImpl::get_stats() const
+{
+  Stats stats;
+  for (const TopicCounters& counters : topic_stats)
+    stats.topics.push_back(counters.snapshot());
+  conversion_time.snapshot(stats.conversion_time);
+  receipt_age.snapshot(stats.receipt_age);
+  request_ack_time.snapshot(stats.request_ack_time);
+  stats.request_retries = request_retries.load(std::memory_order_relaxed);
+  stats.unacknowledged_requests =
+      unacknowledged_requests.load(std::memory_order_relaxed);
+  return stats;
+}
+
+void Server::ServerImpl::handle_robot_states(RobotStatesCallback _callback)
+{
+  std::vector<messages::RobotState> new_robot_states;
+  std::vector<messages::RobotState> spare_robot_states;
+  while (read_robot_states(new_robot_states, &spare_robot_states))
+    _callback(new_robot_states);
+}
+
+namespace {
+
+constexpr tracing::RequestKind request_kind(const messages::ModeRequest&)
+{
+  return tracing::RequestKind::Mode;
+}
+
+constexpr tracing::RequestKind request_kind(const messages::PathRequest&)
+{
+  return tracing::RequestKind::Path;
+}
+
+constexpr tracing::RequestKind request_kind(
+    const messages::DestinationRequest&)
+{
+  return tracing::RequestKind::Destination;
+}
+
+template<typename DDSMessage, typename Message>
+bool write_request(
+    dds::DDSPublishHandler<DDSMessage>& _publisher,
+    TopicCounters& _stats,
+    DDSMessage* _dds_request,
+    const Message& _request,
+    bool _use_partitions,
+    bool _flush)
+{
+  const bool written = _stats.record_write(
+      _use_partitions ?
+          _publisher.write(
+              _dds_request,
+              common::robot_partition(
+                  _request.fleet_name, _request.robot_name),
+              _flush) :
+          _publisher.write(_dds_request, _flush),
+      messages::payload_size(*_dds_request));
+  if (written)
+    FREE_FLEET_TRACEPOINT(server_request_written, request_kind(_request),
+        _request.robot_name.c_str(), _request.task_id.c_str());
+  return written;
+}
+
+bool is_queued(const messages::ModeRequest&)
+{
+  return false;
+}
+
+bool is_queued(const messages::PathRequest& _request)
+{
+  return !_request.after_task_id.empty();
+}
+
+bool is_queued(const messages::DestinationRequest& _request)
+{
+  return !_request.after_task_id.empty();
+}
+
+/// Whether a request of the kind replaces the pending requests of the other
+/// kind for the same robot. Paths and destinations both replace what the
+/// robot is doing, while mode requests only replace each other.
+bool supersedes(tracing::RequestKind _kind, tracing::RequestKind _pending)
+{
+  if (_kind == tracing::RequestKind::Mode)
+    return _pending == tracing::RequestKind::Mode;
+  return _pending != tracing::RequestKind::Mode;
+}
+
+uint32_t request_version(const FreeFleetData_ModeRequest&)
+{
+  return 0;
+}
+
+uint32_t request_version(const FreeFleetData_PathRequest& _sample)
+{
+  return _sample.version;
+}
+
+uint32_t request_version(const FreeFleetData_DestinationRequest&)
+{
+  return 0;
+}
+
+uint32_t request_base_version(const FreeFleetData_ModeRequest&)
+{
+  return 0;
+}
+
+uint32_t request_base_version(const FreeFleetData_PathRequest& _sample)
+{
+  return _sample.base_version;
+}
+
+uint32_t request_base_version(const FreeFleetData_DestinationRequest&)
+{
+  return 0;
+}
+
+/// Path requests are written again with the versions they were first
+/// written with and packed the same way, instead of being recorded as new
+/// paths
+void prepare_retry(FreeFleetData_ModeRequest&, uint32_t, uint32_t, size_t)
 {}
 
-Server::ServerImpl::~ServerImpl()
+void prepare_retry(
+    FreeFleetData_PathRequest& _sample, uint32_t _version,
+    uint32_t _base_version, size_t _path_packing_threshold)
+{
+  _sample.version = _version;
+  _sample.base_version = _base_version;
+  messages::pack_path(_sample, _path_packing_threshold);
+}
+
+void prepare_retry(
+    FreeFleetData_DestinationRequest&, uint32_t, uint32_t, size_t)
+{}
+
+} // namespace anonymous
+
+template <typename DDSMessage, typename Message>
+void Server::ServerImpl::track_request(
+    const typename dds::DDSPublishHandler<DDSMessage>::SharedPtr& _publisher,
+    TopicCounters& _stats,
+    const Message& _request,
+    const DDSMessage& _sample)
 {
-  dds_return_t return_code = dds_delete(fields.participant);
-  if (return_code != DDS_RETCODE_OK)
+  const auto now = std::chrono::steady_clock::now();
+  const auto timeout =
+      std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+          std::chrono::duration<double>(server_config.request_retry_timeout));
+  const uint32_t version = request_version(_sample);
+  const uint32_t base_version = request_base_version(_sample);
+
+  std::lock_guard<std::mutex> lock(retry_mutex);
+  const uint64_t id = ++last_pending_request_id;
+  std::vector<PendingRequest>& pending = pending_requests[_request.robot_name];
+  if (!is_queued(_request))
+    pending.erase(
+        std::remove_if(pending.begin(), pending.end(),
+            [&](const PendingRequest& _pending)
+            {
+              return supersedes(request_kind(_request), _pending.kind);
+            }),
+        pending.end());
+
+  PendingRequest pending_request;
+  pending_request.id = id;
+  pending_request.kind = request_kind(_request);
+  pending_request.task_id = _request.task_id;
+  pending_request.version = version;
+  pending_request.first_sent = now;
+  pending_request.deadline = now + timeout;
+  pending_request.timeout = timeout;
+  pending_request.retries = 0;
+  pending_request.write =
+      [this, _publisher, &_stats, id, version, base_version,
+          request = _request]()
+      {
+        // The sample is locked before checking, a request that supersedes
+        // this one is then either already tracked, or written after it
+        auto sample = _publisher->lock_sample();
+        if (!is_pending(request.robot_name, id))
+          return false;
+
+        const auto convert_start = std::chrono::steady_clock::now();
+        convert(request, *sample);
+        prepare_retry(
+            *sample, version, base_version,
+            server_config.path_packing_threshold);
+        conversion_time.record(nanoseconds_since(convert_start));
+        sample->robot_id = registered_robot_id(request.robot_name);
+        return write_request(
+            *_publisher, _stats, sample.get(), request,
+            server_config.dds_request_partitions, true);
+      };
+  pending.push_back(std::move(pending_request));
+
+  if (now + timeout < next_retry_deadline)
   {
-    DDS_FATAL("dds_delete: %s", dds_strretcode(-return_code));
+    next_retry_deadline = now + timeout;
+    retry_cv.notify_one();
   }
 }
 
-void Server::ServerImpl::start(Fields _fields)
+bool Server::ServerImpl::is_pending(
+    const std::string& _robot_name, uint64_t _id)
 {
-  fields = std::move(_fields);
+  std::lock_guard<std::mutex> lock(retry_mutex);
+  auto it = pending_requests.find(_robot_name);
+  if (it == pending_requests.end())
+    return false;
+  return std::any_of(it->second.begin(), it->second.end(),
+      [_id](const PendingRequest& _pending) { return _pending.id == _id; });
 }
 
-bool Server::ServerImpl::read_robot_states(
-    std::vector<messages::RobotState>& _new_robot_states)
+void Server::ServerImpl::handle_request_acks()
+{
+  while (true)
+  {
+    auto acks = fields.request_ack_sub->take_loaned();
+    const auto received = std::chrono::steady_clock::now();
+    {
+      std::lock_guard<std::mutex> lock(retry_mutex);
+      for (size_t i = 0; i < acks.size(); ++i)
+      {
+        if (!acks.valid(i))
+          continue;
+
+        const FreeFleetData_RequestAck& ack = acks[i];
+        topic_stats[RequestAckStats].record_received(
+            messages::payload_size(ack));
+        if (!ack.fleet_name || !ack.robot_name || !ack.task_id ||
+            server_config.fleet_name != ack.fleet_name)
+          continue;
+
+        auto it = pending_requests.find(ack.robot_name);
+        if (it == pending_requests.end())
+          continue;
+
+        std::vector<PendingRequest>& pending = it->second;
+        auto acked = std::find_if(pending.begin(), pending.end(),
+            [&ack](const PendingRequest& _pending)
+            {
+              return static_cast<uint32_t>(_pending.kind) == ack.kind &&
+                  _pending.version == ack.version &&
+                  _pending.task_id == ack.task_id;
+            });
+        if (acked == pending.end())
+          continue;
+
+        request_ack_time.record(
+            static_cast<uint64_t>(
+                std::chrono::duration_cast<std::chrono::nanoseconds>(
+                    received - acked->first_sent).count()));
+        pending.erase(acked);
+        if (pending.empty())
+          pending_requests.erase(it);
+      }
+    }
+
+    if (!acks.full())
+      break;
+  }
+}
+
+void Server::ServerImpl::retry_thread_fn()
 {
-  auto robot_states = fields.robot_state_sub->read();
-  if (!robot_states.empty())
+  server_config.threads.apply("retry");
+
+  const auto max_timeout =
+      std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+          std::chrono::duration<double>(
+              server_config.request_retry_max_timeout));
+
+  std::vector<std::function<bool()>> due;
+  while (true)
   {
-    _new_robot_states.clear();
-    for (size_t i = 0; i < robot_states.size(); ++i)
+    due.clear();
+    {
+      // New requests may bring the deadline forward while waiting
+      std::unique_lock<std::mutex> lock(retry_mutex);
+      while (retry_thread_running &&
+          next_retry_deadline > std::chrono::steady_clock::now())
+      {
+        if (next_retry_deadline ==
+            std::chrono::steady_clock::time_point::max())
+          retry_cv.wait(lock);
+        else
+          retry_cv.wait_until(lock, next_retry_deadline);
+      }
+      if (!retry_thread_running)
+        return;
+
+      const auto now = std::chrono::steady_clock::now();
+      next_retry_deadline = std::chrono::steady_clock::time_point::max();
+      for (auto it = pending_requests.begin(); it != pending_requests.end();)
+      {
+        std::vector<PendingRequest>& pending = it->second;
+        for (auto request = pending.begin(); request != pending.end();)
+        {
+          if (request->deadline > now)
+          {
+            next_retry_deadline =
+                std::min(next_retry_deadline, request->deadline);
+            ++request;
+            continue;
+          }
+
+          if (request->retries >= server_config.request_max_retries)
+          {
+            DDS_WARNING(
+                "%s did not acknowledge request %s after %zu retries\n",
+                it->first.c_str(), request->task_id.c_str(),
+                request->retries);
+            unacknowledged_requests.fetch_add(1, std::memory_order_relaxed);
+            request = pending.erase(request);
+            continue;
+          }
+
+          ++request->retries;
+          request->timeout = std::min(request->timeout * 2, max_timeout);
+          request->deadline = now + request->timeout;
+          next_retry_deadline =
+              std::min(next_retry_deadline, request->deadline);
+          due.push_back(request->write);
+          ++request;
+        }
+
+        if (pending.empty())
+          it = pending_requests.erase(it);
+        else
+          ++it;
+      }
+    }
+
+    // Retries are written without holding the retry_mutex, each of them
+    // checks that it is still pending once its sample is locked
+    for (const auto& write : due)
     {
-      messages::RobotState tmp_robot_state;
-      convert(*(robot_states[i]), tmp_robot_state);
-      _new_robot_states.push_back(tmp_robot_state);
+      if (write())
+        request_retries.fetch_add(1, std::memory_order_relaxed);
     }
-    return true;
   }
-  return false;
+}
+
+void Server::ServerImpl::stop_retry_thread()
+{
+  {
+    std::lock_guard<std::mutex> lock(retry_mutex);
+    if (!retry_thread_running)
+      return;
+    retry_thread_running = false;
+  }
+  retry_cv.notify_one();
+  if (retry_thread.joinable())
+    retry_thread.join();
+}
+
+bool Server::ServerImpl::write_mode_request(
+    const messages::ModeRequest& _mode_request, bool _flush)
+{
+  auto sample = fields.mode_request_pub->lock_sample();
+  const auto convert_start = std::chrono::steady_clock::now();
+  convert(_mode_request, *sample);
+  conversion_time.record(nanoseconds_since(convert_start));
+  sample->robot_id = registered_robot_id(_mode_request.robot_name);
+  if (!write_request(
+      *fields.mode_request_pub, topic_stats[ModeRequestStats],
+      sample.get(), _mode_request,
+      server_config.dds_request_partitions, _flush))
+    return false;
+
+  if (fields.request_ack_sub)
+    track_request(
+        fields.mode_request_pub, topic_stats[ModeRequestStats],
+        _mode_request, *sample);
+  return true;
+}
+
+bool Server::ServerImpl::write_path_request(
+    const messages::PathRequest& _path_request, bool _flush)
+{
+  // The sample stays locked while the update is made, so that no other path
+  // gets sent to the robot in between
+  auto sample = fields.path_request_pub->lock_sample();
+  if (_path_request.operation != messages::PathRequest::PATH_REPLACE)
+    return write_path_update(_path_request, sample, _flush);
+
+  messages::PathRequest update;
+  if (server_config.incremental_path_requests &&
+      make_path_update(_path_request, update))
+    return write_path_update(update, sample, _flush);
+
+  const auto convert_start = std::chrono::steady_clock::now();
+  convert(_path_request, *sample);
+  messages::pack_path(*sample, server_config.path_packing_threshold);
+  conversion_time.record(nanoseconds_since(convert_start));
+  sample->robot_id = registered_robot_id(_path_request.robot_name);
+  sample->version = record_sent_path(
+      _path_request.robot_name, _path_request.path,
+      !_path_request.after_task_id.empty());
+  if (!write_request(
+      *fields.path_request_pub, topic_stats[PathRequestStats],
+      sample.get(), _path_request,
+      server_config.dds_request_partitions, _flush))
+    return false;
+
+  if (fields.request_ack_sub)
+    track_request(
+        fields.path_request_pub, topic_stats[PathRequestStats],
+        _path_request, *sample);
+  return true;
+}
+
+bool Server::ServerImpl::write_path_request(
+    messages::PathRequest&& _path_request, bool _flush)
+{
+  // Requests that may need to be sent again keep their path around
+  if (fields.request_ack_sub)
+    return write_path_request(
+        static_cast<const messages::PathRequest&>(_path_request), _flush);
+
+  // Only the names are needed once the request has been converted, the path
+  // is moved into the record of sent paths
+  auto sample = fields.path_request_pub->lock_sample();
+  if (_path_request.operation != messages::PathRequest::PATH_REPLACE)
+    return write_path_update(_path_request, sample, _flush);
+
+  messages::PathRequest update;
+  if (server_config.incremental_path_requests &&
+      make_path_update(_path_request, update))
+    return write_path_update(update, sample, _flush);
+
+  const auto convert_start = std::chrono::steady_clock::now();
+  convert(_path_request, *sample);
+  messages::pack_path(*sample, server_config.path_packing_threshold);
+  conversion_time.record(nanoseconds_since(convert_start));
+  sample->robot_id = registered_robot_id(_path_request.robot_name);
+  sample->version = record_sent_path(
+      _path_request.robot_name, std::move(_path_request.path),
+      !_path_request.after_task_id.empty());
+  return write_request(
+      *fields.path_request_pub, topic_stats[PathRequestStats],
+      sample.get(), _path_request,
+      server_config.dds_request_partitions, _flush);
+}
+
+bool Server::ServerImpl::write_path_update(
+    const messages::PathRequest& _update, PathRequestSample& _sample,
+    bool _flush)
+{
+  if (!_update.after_task_id.empty())
+  {
+    DDS_WARNING(
+        "path updates can not be queued, dropping the path update of %s\n",
+        _update.robot_name.c_str());
+    return false;
+  }
+
+  uint32_t base_version = 0;
+  const uint32_t version = record_path_update(_update, base_version);
+  if (version == 0)
+  {
+    DDS_WARNING(
+        "no path was sent to %s yet, dropping its path update\n",
+        _update.robot_name.c_str());
+    return false;
+  }
+
+  const auto convert_start = std::chrono::steady_clock::now();
+  convert(_update, *_sample);
+  messages::pack_path(*_sample, server_config.path_packing_threshold);
+  conversion_time.record(nanoseconds_since(convert_start));
+  _sample->robot_id = registered_robot_id(_update.robot_name);
+  _sample->version = version;
+  _sample->base_version = base_version;
+  if (!write_request(
+      *fields.path_request_pub, topic_stats[PathRequestStats],
+      _sample.get(), _update,
+      server_config.dds_request_partitions, _flush))
+    return false;
+
+  if (fields.request_ack_sub)
+    track_request(
+        fields.path_request_pub, topic_stats[PathRequestStats],
+        _update, *_sample);
+  return true;
+}
+
+bool Server::ServerImpl::write_destination_request(
+    const messages::DestinationRequest& _destination_request, bool _flush)
+{
+  auto sample = fields.destination_request_pub->lock_sample();
+  const auto convert_start = std::chrono::steady_clock::now();
+  convert(_destination_request, *sample);
+  conversion_time.record(nanoseconds_since(convert_start));
+  sample->robot_id = registered_robot_id(_destination_request.robot_name);
+  if (!write_request(
+      *fields.destination_request_pub, topic_stats[DestinationRequestStats],
+      sample.get(), _destination_request,
+      server_config.dds_request_partitions, _flush))
+    return false;
+
+  if (fields.request_ack_sub)
+    track_request(
+        fields.destination_request_pub, topic_stats[DestinationRequestStats],
+        _destination_request, *sample);
+  return true;
 }
 
 bool Server::ServerImpl::send_mode_request(
     const messages::ModeRequest& _mode_request)
 {
-  FreeFleetData_ModeRequest* new_mr = FreeFleetData_ModeRequest__alloc();
-  convert(_mode_request, *new_mr);
-  bool sent = fields.mode_request_pub->write(new_mr);
-  FreeFleetData_ModeRequest_free(new_mr, DDS_FREE_ALL);
-  return sent;
+  return write_mode_request(_mode_request, true);
+}
+
+bool Server::ServerImpl::send_mode_requests(
+    const std::vector<messages::ModeRequest>& _mode_requests)
+{
+  bool all_sent = true;
+  for (const auto& mode_request : _mode_requests)
+    all_sent &= write_mode_request(mode_request, false);
+  fields.mode_request_pub->flush();
+  return all_sent;
 }
 
 bool Server::ServerImpl::send_path_request(
     const messages::PathRequest& _path_request)
 {
-  FreeFleetData_PathRequest* new_pr = FreeFleetData_PathRequest__alloc();
-  convert(_path_request, *new_pr);
-  bool sent = fields.path_request_pub->write(new_pr);
-  FreeFleetData_PathRequest_free(new_pr, DDS_FREE_ALL);
-  return sent;
+  return write_path_request(_path_request, true);
+}
+
+bool Server::ServerImpl::send_path_request(
+    messages::PathRequest&& _path_request)
+{
+  return write_path_request(std::move(_path_request), true);
+}
+
+bool Server::ServerImpl::send_path_requests(
+    const std::vector<messages::PathRequest>& _path_requests)
+{
+  bool all_sent = true;
+  for (const auto& path_request : _path_requests)
+    all_sent &= write_path_request(path_request, false);
+  fields.path_request_pub->flush();
+  return all_sent;
+}
+
+bool Server::ServerImpl::send_path_requests(
+    std::vector<messages::PathRequest>&& _path_requests)
+{
+  bool all_sent = true;
+  for (auto& path_request : _path_requests)
+    all_sent &= write_path_request(std::move(path_request), false);
+  fields.path_request_pub->flush();
+  return all_sent;
 }
 
 bool Server::ServerImpl::send_destination_request(
     const messages::DestinationRequest& _destination_request)
 {
-  FreeFleetData_DestinationRequest* new_dr = 
-      FreeFleetData_DestinationRequest__alloc();
-  convert(_destination_request, *new_dr);
-  bool sent = fields.destination_request_pub->write(new_dr);
-  FreeFleetData_DestinationRequest_free(new_dr, DDS_FREE_ALL);
-  return sent;
+  return write_destination_request(_destination_request, true);
+}
+
+bool Server::ServerImpl::send_destination_requests(
+    const std::vector<messages::DestinationRequest>& _destination_requests)
+{
+  bool all_sent = true;
+  for (const auto& destination_request : _destination_requests)
+    all_sent &= write_destination_request(destination_request, false);
+  fields.destination_request_pub->flush();
+  return all_sent;
+}
+
+bool Server::ServerImpl::send_mode_request_async(
+    const messages::ModeRequest& _mode_request)
+{
+  return enqueue_request(QueuedRequest{
+      QueuedRequest::Kind::Mode,
+      _mode_request.robot_name,
+      "",
+      [this, _mode_request]()
+      {
+        return write_mode_request(_mode_request, false);
+      }});
+}
+
+bool Server::ServerImpl::send_mode_request_async(
+    messages::ModeRequest&& _mode_request)
+{
+  // The robot name is copied out before the request is moved into the write
+  return enqueue_request(QueuedRequest{
+      QueuedRequest::Kind::Mode,
+      _mode_request.robot_name,
+      "",
+      [this, mode_request = std::move(_mode_request)]()
+      {
+        return write_mode_request(mode_request, false);
+      }});
+}
+
+bool Server::ServerImpl::send_path_request_async(
+    const messages::PathRequest& _path_request)
+{
+  const QueuedRequest::Kind kind =
+      _path_request.operation == messages::PathRequest::PATH_REPLACE ?
+          QueuedRequest::Kind::Path : QueuedRequest::Kind::PathUpdate;
+  return enqueue_request(QueuedRequest{
+      kind,
+      _path_request.robot_name,
+      _path_request.after_task_id,
+      [this, _path_request]()
+      {
+        return write_path_request(_path_request, false);
+      }});
+}
+
+bool Server::ServerImpl::send_path_request_async(
+    messages::PathRequest&& _path_request)
+{
+  // Queued writes only ever run once, the path can be moved out of the queue
+  // into the record of sent paths
+  const QueuedRequest::Kind kind =
+      _path_request.operation == messages::PathRequest::PATH_REPLACE ?
+          QueuedRequest::Kind::Path : QueuedRequest::Kind::PathUpdate;
+  return enqueue_request(QueuedRequest{
+      kind,
+      _path_request.robot_name,
+      _path_request.after_task_id,
+      [this, path_request = std::move(_path_request)]() mutable
+      {
+        return write_path_request(std::move(path_request), false);
+      }});
+}
+
+bool Server::ServerImpl::send_destination_request_async(
+    const messages::DestinationRequest& _destination_request)
+{
+  return enqueue_request(QueuedRequest{
+      QueuedRequest::Kind::Destination,
+      _destination_request.robot_name,
+      _destination_request.after_task_id,
+      [this, _destination_request]()
+      {
+        return write_destination_request(_destination_request, false);
+      }});
+}
+
+bool Server::ServerImpl::send_destination_request_async(
+    messages::DestinationRequest&& _destination_request)
+{
+  return enqueue_request(QueuedRequest{
+      QueuedRequest::Kind::Destination,
+      _destination_request.robot_name,
+      _destination_request.after_task_id,
+      [this, destination_request = std::move(_destination_request)]()
+      {
+        return write_destination_request(destination_request, false);
+      }});
+}
+
+bool Server::ServerImpl::enqueue_request(QueuedRequest _request)
+{
+  if (server_config.send_queue_capacity == 0)
+    return false;
+
+  {
+    std::lock_guard<std::mutex> lock(send_queue_mutex);
+    if (!send_thread_running)
+    {
+      send_thread_running = true;
+      send_thread = std::thread(&ServerImpl::send_thread_fn, this);
+    }
+
+    std::deque<QueuedRequest>& queue =
+        _request.kind == QueuedRequest::Kind::Mode ?
+            urgent_send_queue : send_queue;
+
+    // A newer request for a robot supersedes the last one queued for it when
+    // both are of the same kind and queued after the same task, it is
+    // replaced in place, keeping its position in the queue. Anything else
+    // queued last for the robot stays, so that follow-on tasks never lose
+    // the task they come after, replacing requests never get moved ahead of
+    // follow-on tasks, and path updates keep everything sent before them.
+    if (server_config.send_queue_policy ==
+        ServerConfig::SendQueuePolicy::CoalescePerRobot &&
+        _request.kind != QueuedRequest::Kind::PathUpdate)
+    {
+      auto it = std::find_if(queue.rbegin(), queue.rend(),
+          [&_request](const QueuedRequest& _queued)
+          {
+            return _queued.robot_name == _request.robot_name;
+          });
+      if (it != queue.rend() && it->kind == _request.kind &&
+          it->after_task_id == _request.after_task_id)
+      {
+        *it = std::move(_request);
+        return true;
+      }
+    }
+
+    // Mode requests are only dropped once nothing else is left to drop
+    if (send_queue.size() + urgent_send_queue.size() >=
+        server_config.send_queue_capacity)
+    {
+      std::deque<QueuedRequest>& dropped =
+          send_queue.empty() ? urgent_send_queue : send_queue;
+      DDS_WARNING(
+          "send queue is full, dropping a request for %s\n",
+          dropped.front().robot_name.c_str());
+      dropped.pop_front();
+    }
+    queue.push_back(std::move(_request));
+  }
+  send_queue_cv.notify_one();
+  return true;
+}
+
+void Server::ServerImpl::send_thread_fn()
+{
+  server_config.threads.apply("send");
+
+  std::deque<QueuedRequest> batch;
+  std::deque<QueuedRequest> urgent_batch;
+  while (true)
+  {
+    {
+      std::unique_lock<std::mutex> lock(send_queue_mutex);
+      send_queue_cv.wait(lock,
+          [this]()
+          {
+            return !send_queue.empty() || !urgent_send_queue.empty() ||
+                !send_thread_running;
+          });
+      if (send_queue.empty() && urgent_send_queue.empty())
+        return;
+      batch.swap(send_queue);
+    }
+
+    // Everything that piled up while the previous batch was being written
+    // goes out together, with a single flush. Mode requests that come in
+    // meanwhile do not wait for the rest of the batch, so that a large batch
+    // of paths never holds back stopping a robot for longer than a single
+    // path takes to write.
+    write_urgent_requests(urgent_batch);
+    for (const QueuedRequest& request : batch)
+    {
+      request.write();
+      write_urgent_requests(urgent_batch);
+    }
+    batch.clear();
+
+    fields.path_request_pub->flush();
+    fields.destination_request_pub->flush();
+  }
+}
+
+void Server::ServerImpl::write_urgent_requests(
+    std::deque<QueuedRequest>& _batch)
+{
+  {
+    std::lock_guard<std::mutex> lock(send_queue_mutex);
+    if (urgent_send_queue.empty())
+      return;
+    _batch.swap(urgent_send_queue);
+  }
+
+  for (const QueuedRequest& request : _batch)
+    request.write();
+  _batch.clear();
+  fields.mode_request_pub->flush();
+}
+
+void Server::ServerImpl::stop_send_thread()
+{
+  {
+    std::lock_guard<std::mutex> lock(send_queue_mutex);
+    if (!send_thread_running)
+      return;
+    send_thread_running = false;
+  }
+  send_queue_cv.notify_one();
+  if (send_thread.joinable())
+    send_thread.join();
 }
 
 } // namespace free_fleet
@@ -18,18 +18,42 @@
 #ifndef FREE_FLEET__SRC__SERVERIMPL_HPP
 #define FREE_FLEET__SRC__SERVERIMPL_HPP
 
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <functional>
+#include <condition_variable>
+#include <unordered_map>
+#include <unordered_set>
+
 #include <free_fleet/messages/RobotState.hpp>
 #include <free_fleet/messages/ModeRequest.hpp>
 #include <free_fleet/messages/PathRequest.hpp>
 #include <free_fleet/messages/DestinationRequest.hpp>
 #include <free_fleet/Server.hpp>
+#include <free_fleet/AtomicSnapshot.hpp>
+#include <free_fleet/ClockOffset.hpp>
+#include <free_fleet/FleetSnapshot.hpp>
 #include <free_fleet/ServerConfig.hpp>
+#include <free_fleet/Stats.hpp>
+#include <free_fleet/Tracing.hpp>
+#include <free_fleet/WorkerPool.hpp>
 
 #include <dds/dds.h>
 
+#include "ClockFilter.hpp"
+#include "RobotStateHistory.hpp"
+#include "SpatialIndex.hpp"
+#include "StatsRecorder.hpp"
 #include "messages/FleetMessages.h"
+#include "dds_utils/DDSParticipant.hpp"
 #include "dds_utils/DDSPublishHandler.hpp"
 #include "dds_utils/DDSSubscribeHandler.hpp"
+#include "dds_utils/DDSWaitSetHandler.hpp"
 
 namespace free_fleet {
 
@@ -37,15 +61,35 @@ class Server::ServerImpl
 {
 public:
 
+  /// Smallest number of robot states converted by each ingest thread
+  static constexpr size_t IngestRangeSize = 16;
+
+  /// Robot states, registrations and time sync pongs are taken in windows
+  /// that grow with the fleet, see ServerConfig::robot_state_take_window
+  using RobotStateSubscribeHandler =
+      dds::DDSSubscribeHandler<FreeFleetData_RobotState>;
+
+  using RegistrationSubscribeHandler =
+      dds::DDSSubscribeHandler<FreeFleetData_RobotRegistration>;
+
+  using TimeSyncPongSubscribeHandler =
+      dds::DDSSubscribeHandler<FreeFleetData_TimeSyncPong>;
+
+  using RobotPoseSubscribeHandler =
+      dds::DDSSubscribeHandler<FreeFleetData_RobotPose>;
+
+  using RequestAckSubscribeHandler =
+      dds::DDSSubscribeHandler<FreeFleetData_RequestAck>;
+
   /// DDS related fields required for the server to operate
   struct Fields
   {
-    /// DDS participant that is tied to the configured dds_domain_id
-    dds_entity_t participant;
+    /// DDS participant that is tied to the configured dds_domain_id, shared
+    /// with the other servers of this process on the same domain
+    dds::DDSParticipant::SharedPtr participant;
 
     /// DDS subscribers for new incoming robot states from clients
-    dds::DDSSubscribeHandler<FreeFleetData_RobotState, 10>::SharedPtr 
-        robot_state_sub;
+    RobotStateSubscribeHandler::SharedPtr robot_state_sub;
 
     /// DDS publisher for mode requests to be sent to clients
     dds::DDSPublishHandler<FreeFleetData_ModeRequest>::SharedPtr
@@ -58,6 +102,48 @@ public:
     /// DDS publisher for destination requests to be sent to clients
     dds::DDSPublishHandler<FreeFleetData_DestinationRequest>::SharedPtr
         destination_request_pub;
+
+    /// DDS waitset that wakes up the reader thread when callbacks are used
+    dds::DDSWaitSetHandler::SharedPtr waitset;
+
+    /// DDS publisher for the aggregated state of the fleet, only when it is
+    /// enabled in the config
+    dds::DDSPublishHandler<FreeFleetData_FleetState>::SharedPtr
+        fleet_state_pub;
+
+    /// DDS subscriber for robots registering with the server
+    RegistrationSubscribeHandler::SharedPtr registration_sub;
+
+    /// DDS publisher for the ids assigned to registered robots
+    dds::DDSPublishHandler<FreeFleetData_RobotRegistrationAck>::SharedPtr
+        registration_ack_pub;
+
+    /// DDS publisher for the pings that clients answer to sync their
+    /// clocks, only when time sync is enabled in the config
+    dds::DDSPublishHandler<FreeFleetData_TimeSyncPing>::SharedPtr
+        time_sync_ping_pub;
+
+    /// DDS subscriber for the answers of the clients to the pings, only when
+    /// time sync is enabled in the config
+    TimeSyncPongSubscribeHandler::SharedPtr time_sync_pong_sub;
+
+    /// DDS waitset with a thread of its own for the pongs, which need to be
+    /// stamped as soon as they arrive, only when time sync is enabled in the
+    /// config
+    dds::DDSWaitSetHandler::SharedPtr time_sync_waitset;
+
+    /// DDS subscribers for the poses and the metadata of robots that split
+    /// their states, only when split robot states are enabled in the config
+    RobotPoseSubscribeHandler::SharedPtr robot_pose_sub;
+
+    RobotStateSubscribeHandler::SharedPtr robot_metadata_sub;
+
+    /// DDS subscriber for the acks of the clients to the requests, along
+    /// with a waitset with a thread of its own for them, only when request
+    /// retries are enabled in the config
+    RequestAckSubscribeHandler::SharedPtr request_ack_sub;
+
+    dds::DDSWaitSetHandler::SharedPtr request_ack_waitset;
   };
 
   ServerImpl(const ServerConfig& config);
@@ -66,21 +152,542 @@ public:
 
   void start(Fields fields);
 
-  bool read_robot_states(std::vector<messages::RobotState>& new_robot_states);
+  /// Reads new robot states into new_robot_states, taking states from and
+  /// setting states aside into spare_robot_states when provided, see
+  /// RobotStateBatch.
+  bool read_robot_states(
+      std::vector<messages::RobotState>& new_robot_states,
+      std::vector<messages::RobotState>* spare_robot_states = nullptr);
+
+  /// Reads new robot states the same way as read_robot_states, placing them
+  /// after the first count states of new_robot_states, for servers that take
+  /// states in from more than one shard. The vector is only ever grown, and
+  /// the total number of states is returned.
+  size_t append_robot_states(
+      std::vector<messages::RobotState>& new_robot_states, size_t count,
+      std::vector<messages::RobotState>* spare_robot_states = nullptr);
+
+  /// Resizes the states, moving states to and from the spare states when
+  /// provided instead of constructing and destroying them.
+  static void resize_robot_states(
+      std::vector<messages::RobotState>& robot_states, size_t size,
+      std::vector<messages::RobotState>* spare_robot_states);
+
+  bool read_robot_state_views(const RobotStateViewCallback& callback);
+
+  bool on_robot_states(RobotStatesCallback callback);
+
+  bool start_robot_state_ingest();
+
+  bool on_robot_lost(RobotEventCallback callback);
+
+  bool on_robot_rejoined(RobotEventCallback callback);
+
+  std::shared_ptr<const FleetSnapshot> get_fleet_snapshot() const;
+
+  RobotStateRecord::ConstPtr get_robot_state(
+      const std::string& robot_name) const;
 
   bool send_mode_request(const messages::ModeRequest& mode_request);
 
+  bool send_mode_requests(
+      const std::vector<messages::ModeRequest>& mode_requests);
+
   bool send_path_request(const messages::PathRequest& path_request);
 
+  bool send_path_request(messages::PathRequest&& path_request);
+
+  bool send_path_requests(
+      const std::vector<messages::PathRequest>& path_requests);
+
+  bool send_path_requests(std::vector<messages::PathRequest>&& path_requests);
+
   bool send_destination_request(
       const messages::DestinationRequest& destination_request);
 
+  bool send_destination_requests(
+      const std::vector<messages::DestinationRequest>& destination_requests);
+
+  bool send_mode_request_async(const messages::ModeRequest& mode_request);
+
+  bool send_mode_request_async(messages::ModeRequest&& mode_request);
+
+  bool send_path_request_async(const messages::PathRequest& path_request);
+
+  bool send_path_request_async(messages::PathRequest&& path_request);
+
+  bool send_destination_request_async(
+      const messages::DestinationRequest& destination_request);
+
+  bool send_destination_request_async(
+      messages::DestinationRequest&& destination_request);
+
+  Stats get_stats() const;
+
+  std::vector<ClockOffset> get_clock_offsets() const;
+
+  bool get_state_history(
+      const std::string& robot_name,
+      int64_t start_time,
+      int64_t end_time,
+      StateHistory& history) const;
+
+  std::vector<std::string> query_radius(
+      const std::string& level_name, double x, double y, double radius) const;
+
+  std::vector<std::string> query_box(
+      const std::string& level_name,
+      double min_x,
+      double min_y,
+      double max_x,
+      double max_y) const;
+
 private:
 
   Fields fields;
 
   ServerConfig server_config;
 
+  /// Topics that traffic is counted for, indexing topic_stats
+  enum StatsTopic : size_t
+  {
+    RobotStateStats = 0,
+    ModeRequestStats,
+    PathRequestStats,
+    DestinationRequestStats,
+    FleetStateStats,
+    RegistrationStats,
+    RegistrationAckStats,
+    TimeSyncPingStats,
+    TimeSyncPongStats,
+    RobotPoseStats,
+    RobotMetadataStats,
+    RequestAckStats,
+    StatsTopicCount
+  };
+
+  std::array<TopicCounters, StatsTopicCount> topic_stats;
+
+  AtomicHistogram conversion_time;
+
+  /// Age of the robot states as they are taken in
+  AtomicHistogram receipt_age;
+
+  /// Counts a robot state that was taken in, along with its age by the
+  /// server's clock, given the clock offset of the robot
+  void record_robot_state(
+      const FreeFleetData_RobotState& robot_state,
+      const dds_sample_info_t& info,
+      dds_time_t received,
+      int64_t clock_offset);
+
+  /// Guards the robot state reader, which may be taken from by both the
+  /// polling calls and the waitset thread
+  std::mutex robot_state_mutex;
+
+  /// Splits the conversion of large batches of robot states between threads
+  WorkerPool::SharedPtr ingest_pool;
+
+  /// Loans of the current read, held on to until every state is converted
+  std::vector<RobotStateSubscribeHandler::LoanedSamples> robot_state_loans;
+
+  /// Valid samples of the current read, along with the clock offsets of
+  /// their robots, kept around to reuse their capacity
+  std::vector<const FreeFleetData_RobotState*> taken_robot_states;
+
+  std::vector<int64_t> taken_clock_offsets;
+
+  /// States read by append_robot_states before being swapped into place,
+  /// kept around to reuse their capacity
+  std::vector<messages::RobotState> appended_robot_states;
+
+  std::vector<messages::RobotState> spare_appended_robot_states;
+
+  std::mutex appended_robot_states_mutex;
+
+  /// Latest metadata of every robot that splits its state, converted for
+  /// merging with its poses, and converted back into a sample of its own for
+  /// the views of its poses. Only used while holding the robot_state_mutex.
+  struct RobotMetadata
+  {
+    messages::RobotState state;
+
+    std::shared_ptr<FreeFleetData_RobotState> sample;
+  };
+
+  std::unordered_map<std::string, RobotMetadata> robot_metadata;
+
+  /// Takes in every pending metadata, needs to be called with the
+  /// robot_state_mutex locked
+  void handle_robot_metadata();
+
+  /// Takes in every pending pose, merged with the metadata of its robot into
+  /// the states after the first count states, and returns the total number
+  /// of states. Needs to be called with the robot_state_mutex locked.
+  size_t take_robot_poses(
+      std::vector<messages::RobotState>& robot_states, size_t count,
+      std::vector<messages::RobotState>* spare_robot_states);
+
+  /// Robots whose instances were no longer alive in the current read
+  std::vector<std::string> unalive_robots;
+
+  /// Names of robots that were lost, and have not been heard from since
+  std::unordered_set<std::string> lost_robots;
+
+  std::mutex robot_event_callbacks_mutex;
+
+  RobotEventCallback robot_lost_callback;
+
+  RobotEventCallback robot_rejoined_callback;
+
+  void trigger_robot_events(
+      const std::vector<std::string>& lost,
+      const std::vector<std::string>& rejoined);
+
+  /// Robot that registered with the server. Its id is its index in
+  /// registered_robots plus one, in the lower 16 bits, with the registration
+  /// session in the upper 16 bits, so that ids handed out by an earlier run
+  /// of the server are never mistaken for the ones of this run.
+  struct RegisteredRobot
+  {
+    uint32_t id;
+
+    std::string name;
+
+    std::string model;
+
+    std::string task_id;
+  };
+
+  uint32_t registration_session;
+
+  /// Only modified while holding both the robot_state_mutex and the
+  /// registry_mutex, it is read while holding either of them
+  std::vector<RegisteredRobot> registered_robots;
+
+  /// Modified along with registered_robots, under the same locks
+  std::unordered_map<std::string, size_t> registered_indices;
+
+  std::mutex registry_mutex;
+
+  /// Takes in every pending registration, needs to be called with the
+  /// robot_state_mutex locked
+  void handle_registrations();
+
+  void register_robot(const FreeFleetData_RobotRegistration& registration);
+
+  /// Needs to be called with the robot_state_mutex locked, returns nullptr
+  /// for robots that have not registered. Robots keep the id of whichever
+  /// server acknowledged them last, ids that were not assigned by this run
+  /// of the server are looked up by robot name instead, as every server
+  /// takes in the same registrations.
+  const RegisteredRobot* find_registered_robot(
+      uint32_t robot_id, const char* robot_name) const;
+
+  /// Fills in the model and task id that registered robots leave out of
+  /// their states, and the id that this server assigned them
+  void apply_registration(messages::RobotState& robot_state) const;
+
+  /// Id that requests for the robot are addressed with, 0 if it has not
+  /// registered
+  uint32_t registered_robot_id(const std::string& robot_name);
+
+  /// Robots that already have their request partitions set up
+  std::unordered_set<std::string> partitioned_robots;
+
+  void prepare_robot_partitions(const std::string& robot_name);
+
+  /// Latest path sent to each robot, keyed by robot name, used for rebuilding
+  /// the remaining path of robots that only report their path progress
+  struct SentPath
+  {
+    uint32_t version;
+
+    std::vector<messages::Location> path;
+  };
+
+  std::mutex sent_paths_mutex;
+
+  std::unordered_map<std::string, SentPath> sent_paths;
+
+  /// Paths queued on each robot behind its latest path, in the order they
+  /// were sent, which become the latest path once the robot reports that it
+  /// moved on to them
+  std::unordered_map<std::string, std::vector<SentPath>> queued_paths;
+
+  uint32_t last_path_version = 0;
+
+  /// Needs to be called with sent_paths_mutex locked
+  uint32_t next_path_version();
+
+  /// Keeps the path that is sent out to the robot and returns the version it
+  /// is sent out with. Paths that replace the current one also drop the
+  /// paths queued behind it, the same way the robot does.
+  uint32_t record_sent_path(
+      const std::string& robot_name, std::vector<messages::Location> path,
+      bool queued);
+
+  /// Gets the sent path of the robot with the given version, promoting it
+  /// from the queued paths when the robot has moved on to it, nullptr if
+  /// there is none. Needs to be called with sent_paths_mutex locked.
+  const SentPath* find_sent_path(
+      const std::string& robot_name, uint32_t version);
+
+  /// Applies the path update on top of the latest path sent to the robot and
+  /// keeps the result. Returns the version the update is sent out with, and
+  /// the version it applies to as base_version, 0 if the robot has no path
+  /// to update.
+  uint32_t record_path_update(
+      const messages::PathRequest& update, uint32_t& base_version);
+
+  /// Turns a request for a whole path into an update that only carries the
+  /// changed tail of the latest path sent to the robot, when the robot
+  /// reports that it is following that path and the new path picks up from
+  /// where the robot is along it. Returns false when the whole path needs to
+  /// be sent.
+  bool make_path_update(
+      const messages::PathRequest& path_request,
+      messages::PathRequest& update);
+
+  /// Fills in the remaining path of robot states that only carry the version
+  /// of their path request and their waypoint index
+  void expand_path_progress(messages::RobotState& robot_state);
+
+  void handle_robot_states(RobotStatesCallback callback);
+
+  /// Converts and writes a single request, without flushing the writer when
+  /// flush is false
+  bool write_mode_request(
+      const messages::ModeRequest& mode_request, bool flush);
+
+  bool write_path_request(
+      const messages::PathRequest& path_request, bool flush);
+
+  /// Takes the path of the request once it has been converted
+  bool write_path_request(messages::PathRequest&& path_request, bool flush);
+
+  using PathRequestSample =
+      dds::DDSPublishHandler<FreeFleetData_PathRequest>::LockedSample;
+
+  /// Writes a request that carries its own path operation, the sample needs
+  /// to stay locked from when the update was made
+  bool write_path_update(
+      const messages::PathRequest& update, PathRequestSample& sample,
+      bool flush);
+
+  bool write_destination_request(
+      const messages::DestinationRequest& destination_request, bool flush);
+
+  /// Request waiting in the send queue, along with what it is coalesced by
+  struct QueuedRequest
+  {
+    enum class Kind
+    {
+      Mode,
+      Path,
+      /// Path requests that update an earlier path, which are never
+      /// coalesced
+      PathUpdate,
+      Destination
+    };
+
+    Kind kind;
+
+    std::string robot_name;
+
+    /// Task that the request is queued after on the robot, empty for
+    /// requests that replace whatever the robot is doing
+    std::string after_task_id;
+
+    /// Writes the request without flushing
+    std::function<bool()> write;
+  };
+
+  std::mutex send_queue_mutex;
+
+  std::condition_variable send_queue_cv;
+
+  std::deque<QueuedRequest> send_queue;
+
+  /// Mode requests, which are written and flushed ahead of everything in
+  /// send_queue, including the rest of a batch that is already being written
+  std::deque<QueuedRequest> urgent_send_queue;
+
+  std::thread send_thread;
+
+  bool send_thread_running = false;
+
+  /// Pushes the request onto the send queue, applying the configured policy
+  /// when it is full, and starts the send thread the first time around
+  bool enqueue_request(QueuedRequest request);
+
+  /// Writes everything that has been queued up in batches, flushing once per
+  /// batch, until stopped and the queue has been drained
+  void send_thread_fn();
+
+  /// Writes and flushes the mode requests queued up so far, called from the
+  /// send thread in between the other requests
+  void write_urgent_requests(std::deque<QueuedRequest>& batch);
+
+  void stop_send_thread();
+
+  /// Latest state of every robot, only ever replaced while holding the
+  /// robot_state_mutex
+  AtomicSnapshot<FleetSnapshot> fleet_snapshot;
+
+  /// Adds the new robot states to the snapshot, and removes the robots that
+  /// are no longer alive or have expired, filling in the names of those that
+  /// were lost or have rejoined since the last update.
+  void update_fleet_snapshot(
+      const std::vector<messages::RobotState>& new_robot_states,
+      std::vector<std::string>& lost,
+      std::vector<std::string>& rejoined);
+
+  /// State history of every robot heard from, only appended to from
+  /// update_fleet_snapshot, and only used while holding the
+  /// state_history_mutex
+  std::unordered_map<std::string, RobotStateHistory> state_histories;
+
+  mutable std::mutex state_history_mutex;
+
+  /// Appends the new robot states to the history of their robots
+  void update_state_histories(
+      const std::vector<messages::RobotState>& new_robot_states);
+
+  /// Positions of the robots in the fleet snapshot, updated along with it
+  /// when spatial_index_cell_size is set, and only used while holding the
+  /// spatial_index_mutex
+  SpatialIndex spatial_index;
+
+  mutable std::mutex spatial_index_mutex;
+
+  std::mutex fleet_state_mutex;
+
+  std::condition_variable fleet_state_cv;
+
+  std::thread fleet_state_thread;
+
+  bool fleet_state_thread_running = false;
+
+  /// Publishes the fleet snapshot every fleet_state_period, skipping periods
+  /// in which it has not been replaced
+  void fleet_state_thread_fn();
+
+  void stop_fleet_state_thread();
+
+  using ClockOffsets = std::unordered_map<std::string, ClockOffset>;
+
+  /// Latest clock offset estimate of every robot that has answered a ping,
+  /// replaced by the time sync thread once every time_sync_period
+  AtomicSnapshot<ClockOffsets> clock_offsets;
+
+  /// Clock offset of the robot in the snapshot, 0 if it has not answered any
+  /// ping yet
+  static int64_t find_clock_offset(
+      const ClockOffsets& offsets, const char* robot_name);
+
+  /// Clock filter of every robot that has answered a ping, only used while
+  /// holding the clock_filters_mutex
+  std::unordered_map<std::string, ClockFilter> clock_filters;
+
+  std::mutex clock_filters_mutex;
+
+  /// Takes in every pending pong, called from the time sync waitset thread
+  void handle_time_sync_pongs();
+
+  std::mutex time_sync_mutex;
+
+  std::condition_variable time_sync_cv;
+
+  std::thread time_sync_thread;
+
+  bool time_sync_thread_running = false;
+
+  /// Pings the clients every time_sync_period, storing the estimates that
+  /// came out of the pongs to the previous pings before each ping
+  void time_sync_thread_fn();
+
+  void stop_time_sync_thread();
+
+  /// Request that was written and is waiting to be acknowledged by its
+  /// robot, only used while holding the retry_mutex
+  struct PendingRequest
+  {
+    uint64_t id;
+
+    tracing::RequestKind kind;
+
+    std::string task_id;
+
+    /// Version of path requests, which is what tells apart the requests of
+    /// the same task, 0 for the other kinds
+    uint32_t version;
+
+    std::chrono::steady_clock::time_point first_sent;
+
+    std::chrono::steady_clock::time_point deadline;
+
+    /// Time waited for an ack since the request was last written, doubled
+    /// with every retry
+    std::chrono::steady_clock::duration timeout;
+
+    size_t retries;
+
+    /// Writes the request again and flushes it, unless it has been
+    /// acknowledged or superseded since
+    std::function<bool()> write;
+  };
+
+  std::mutex retry_mutex;
+
+  std::condition_variable retry_cv;
+
+  /// Requests waiting to be acknowledged, keyed by the name of their robot
+  std::unordered_map<std::string, std::vector<PendingRequest>>
+      pending_requests;
+
+  uint64_t last_pending_request_id = 0;
+
+  /// Earliest deadline of the pending requests, the retry thread only needs
+  /// to be woken up for requests that are due before it
+  std::chrono::steady_clock::time_point next_retry_deadline =
+      std::chrono::steady_clock::time_point::max();
+
+  std::thread retry_thread;
+
+  bool retry_thread_running = false;
+
+  AtomicHistogram request_ack_time;
+
+  std::atomic<uint64_t> request_retries{0};
+
+  std::atomic<uint64_t> unacknowledged_requests{0};
+
+  /// Starts waiting for the robot to acknowledge the request that was just
+  /// written as the sample, dropping the pending requests that it
+  /// supersedes. Needs to be called with the sample still locked, so that
+  /// retries of superseded requests are never written after the request
+  /// that superseded them.
+  template <typename DDSMessage, typename Message>
+  void track_request(
+      const typename dds::DDSPublishHandler<DDSMessage>::SharedPtr& publisher,
+      TopicCounters& stats,
+      const Message& request,
+      const DDSMessage& sample);
+
+  /// Whether the request is still waiting to be acknowledged
+  bool is_pending(const std::string& robot_name, uint64_t id);
+
+  /// Takes in every pending ack, called from the request ack waitset thread
+  void handle_request_acks();
+
+  /// Writes the requests that have not been acknowledged by their deadlines
+  /// again, backing off exponentially, and gives up on the ones that have
+  /// run out of retries
+  void retry_thread_fn();
+
+  void stop_retry_thread();
+
 };
 
 } // namespace free_fleet
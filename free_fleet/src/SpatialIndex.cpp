@@ -0,0 +1,225 @@
+/*
+ * Copyright (C) 2019 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#include <cmath>
+#include <limits>
+#include <algorithm>
+
+#include "SpatialIndex.hpp"
+
+namespace free_fleet {
+
+SpatialIndex::SpatialIndex(double _cell_size) :
+  cell_size(_cell_size)
+{}
+
+void SpatialIndex::update(
+    const std::string& _robot_name, const messages::Location& _location)
+{
+  const CellKey cell = cell_key(
+      cell_coordinate(_location.x), cell_coordinate(_location.y));
+
+  auto it = slots.find(_robot_name);
+  if (it != slots.end())
+  {
+    Robot& robot = robots[it->second];
+    robot.x = _location.x;
+    robot.y = _location.y;
+    if (robot.cell == cell && robot.level_name == _location.level_name)
+      return;
+
+    remove_from_cell(it->second);
+    robot.level_name = _location.level_name;
+    robot.cell = cell;
+    insert_into_cell(it->second);
+    return;
+  }
+
+  size_t slot;
+  if (!free_slots.empty())
+  {
+    slot = free_slots.back();
+    free_slots.pop_back();
+  }
+  else
+  {
+    slot = robots.size();
+    robots.emplace_back();
+  }
+  robots[slot] =
+      Robot{_robot_name, _location.level_name, _location.x, _location.y, cell};
+  slots.emplace(_robot_name, slot);
+  insert_into_cell(slot);
+}
+
+void SpatialIndex::remove(const std::string& _robot_name)
+{
+  auto it = slots.find(_robot_name);
+  if (it == slots.end())
+    return;
+
+  remove_from_cell(it->second);
+  free_slots.push_back(it->second);
+  slots.erase(it);
+}
+
+void SpatialIndex::query_radius(
+    const std::string& _level_name,
+    double _x,
+    double _y,
+    double _radius,
+    std::vector<std::string>& _robot_names) const
+{
+  _robot_names.clear();
+  if (!(_radius >= 0.0))
+    return;
+
+  const double squared_radius = _radius * _radius;
+  visit(_level_name, _x - _radius, _y - _radius, _x + _radius, _y + _radius,
+      [&](const Robot& _robot)
+      {
+        const double dx = _robot.x - _x;
+        const double dy = _robot.y - _y;
+        if (dx * dx + dy * dy <= squared_radius)
+          _robot_names.push_back(_robot.name);
+      });
+}
+
+void SpatialIndex::query_box(
+    const std::string& _level_name,
+    double _min_x,
+    double _min_y,
+    double _max_x,
+    double _max_y,
+    std::vector<std::string>& _robot_names) const
+{
+  _robot_names.clear();
+  if (!(_min_x <= _max_x && _min_y <= _max_y))
+    return;
+
+  visit(_level_name, _min_x, _min_y, _max_x, _max_y,
+      [&](const Robot& _robot)
+      {
+        if (_robot.x >= _min_x && _robot.x <= _max_x &&
+            _robot.y >= _min_y && _robot.y <= _max_y)
+          _robot_names.push_back(_robot.name);
+      });
+}
+
+size_t SpatialIndex::size() const
+{
+  return slots.size();
+}
+
+int32_t SpatialIndex::cell_coordinate(double _coordinate) const
+{
+  // Also catches coordinates that are not a number
+  const double cell = std::floor(_coordinate / cell_size);
+  if (!(cell > std::numeric_limits<int32_t>::min()))
+    return std::numeric_limits<int32_t>::min();
+  if (cell > std::numeric_limits<int32_t>::max())
+    return std::numeric_limits<int32_t>::max();
+  return static_cast<int32_t>(cell);
+}
+
+SpatialIndex::CellKey SpatialIndex::cell_key(int32_t _column, int32_t _row)
+{
+  return (static_cast<CellKey>(static_cast<uint32_t>(_column)) << 32) |
+      static_cast<CellKey>(static_cast<uint32_t>(_row));
+}
+
+void SpatialIndex::insert_into_cell(size_t _slot)
+{
+  const Robot& robot = robots[_slot];
+  levels[robot.level_name].cells[robot.cell].push_back(_slot);
+}
+
+void SpatialIndex::remove_from_cell(size_t _slot)
+{
+  const Robot& robot = robots[_slot];
+  auto level_it = levels.find(robot.level_name);
+  if (level_it == levels.end())
+    return;
+
+  auto& cells = level_it->second.cells;
+  auto cell_it = cells.find(robot.cell);
+  if (cell_it == cells.end())
+    return;
+
+  // Cells only hold a handful of robots, the order within them is not kept
+  std::vector<size_t>& cell = cell_it->second;
+  auto it = std::find(cell.begin(), cell.end(), _slot);
+  if (it != cell.end())
+  {
+    *it = cell.back();
+    cell.pop_back();
+  }
+  if (cell.empty())
+    cells.erase(cell_it);
+  if (cells.empty())
+    levels.erase(level_it);
+}
+
+template <typename Visitor>
+void SpatialIndex::visit(
+    const std::string& _level_name,
+    double _min_x,
+    double _min_y,
+    double _max_x,
+    double _max_y,
+    Visitor&& _visitor) const
+{
+  auto level_it = levels.find(_level_name);
+  if (level_it == levels.end())
+    return;
+  const auto& cells = level_it->second.cells;
+
+  const int32_t min_column = cell_coordinate(_min_x);
+  const int32_t max_column = cell_coordinate(_max_x);
+  const int32_t min_row = cell_coordinate(_min_y);
+  const int32_t max_row = cell_coordinate(_max_y);
+
+  // Boxes that span more cells than are occupied are cheaper to answer by
+  // going through the occupied cells instead
+  const double cell_count =
+      (static_cast<double>(max_column) - min_column + 1.0) *
+      (static_cast<double>(max_row) - min_row + 1.0);
+  if (cell_count > static_cast<double>(cells.size()))
+  {
+    for (const auto& cell : cells)
+    {
+      for (const size_t slot : cell.second)
+        _visitor(robots[slot]);
+    }
+    return;
+  }
+
+  for (int64_t column = min_column; column <= max_column; ++column)
+  {
+    for (int64_t row = min_row; row <= max_row; ++row)
+    {
+      auto cell_it = cells.find(cell_key(
+          static_cast<int32_t>(column), static_cast<int32_t>(row)));
+      if (cell_it == cells.end())
+        continue;
+      for (const size_t slot : cell_it->second)
+        _visitor(robots[slot]);
+    }
+  }
+}
+
+} // namespace free_fleet
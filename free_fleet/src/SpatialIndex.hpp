@@ -0,0 +1,131 @@
+/*
+ * Copyright (C) 2019 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#ifndef FREE_FLEET__SRC__SPATIALINDEX_HPP
+#define FREE_FLEET__SRC__SPATIALINDEX_HPP
+
+#include <string>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+
+#include <free_fleet/messages/Location.hpp>
+
+namespace free_fleet {
+
+/// Uniform grid of robot positions for every level, so that looking up the
+/// robots within an area only visits the cells overlapping it instead of
+/// every robot. Robots are kept in slots that are reused once their robots
+/// are removed, and moving a robot within its cell only overwrites its
+/// position. Not thread safe.
+class SpatialIndex
+{
+public:
+
+  /// \param[in] cell_size
+  ///   Width of the square cells in meters, which has to be positive.
+  explicit SpatialIndex(double cell_size);
+
+  /// Adds the robot at the location, or moves it there if it was already
+  /// indexed.
+  void update(
+      const std::string& robot_name, const messages::Location& location);
+
+  void remove(const std::string& robot_name);
+
+  /// \param[out] robot_names
+  ///   Filled with the names of the robots on the level within the radius of
+  ///   the point, inclusive, in no particular order.
+  void query_radius(
+      const std::string& level_name,
+      double x,
+      double y,
+      double radius,
+      std::vector<std::string>& robot_names) const;
+
+  /// \param[out] robot_names
+  ///   Filled with the names of the robots on the level within the box,
+  ///   inclusive, in no particular order.
+  void query_box(
+      const std::string& level_name,
+      double min_x,
+      double min_y,
+      double max_x,
+      double max_y,
+      std::vector<std::string>& robot_names) const;
+
+  size_t size() const;
+
+private:
+
+  using CellKey = uint64_t;
+
+  /// Column or row of the cell that the coordinate falls in, clamped to the
+  /// range of the cell keys
+  int32_t cell_coordinate(double coordinate) const;
+
+  static CellKey cell_key(int32_t column, int32_t row);
+
+  struct Robot
+  {
+    std::string name;
+
+    std::string level_name;
+
+    double x;
+
+    double y;
+
+    CellKey cell;
+  };
+
+  struct Level
+  {
+    /// Slots of the robots within each occupied cell
+    std::unordered_map<CellKey, std::vector<size_t>> cells;
+  };
+
+  void insert_into_cell(size_t slot);
+
+  void remove_from_cell(size_t slot);
+
+  /// Calls the visitor with every robot on the level in the cells that
+  /// overlap the box, which may lie outside of the box itself.
+  template <typename Visitor>
+  void visit(
+      const std::string& level_name,
+      double min_x,
+      double min_y,
+      double max_x,
+      double max_y,
+      Visitor&& visitor) const;
+
+  double cell_size;
+
+  std::vector<Robot> robots;
+
+  std::vector<size_t> free_slots;
+
+  std::unordered_map<std::string, size_t> slots;
+
+  std::unordered_map<std::string, Level> levels;
+};
+
+} // namespace free_fleet
+
+#endif // FREE_FLEET__SRC__SPATIALINDEX_HPP
@@ -0,0 +1,87 @@
+/*
+ * Copyright (C) 2019 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#include <cmath>
+#include <algorithm>
+
+#include <free_fleet/Stats.hpp>
+
+namespace free_fleet {
+
+constexpr size_t LatencyHistogram::SubBucketBits;
+constexpr size_t LatencyHistogram::SubBuckets;
+constexpr size_t LatencyHistogram::MaxValueBits;
+constexpr size_t LatencyHistogram::BucketCount;
+
+size_t LatencyHistogram::bucket_of(uint64_t _value)
+{
+  const uint64_t largest = (uint64_t(1) << MaxValueBits) - 1;
+  _value = std::min(_value, largest);
+  if (_value < SubBuckets)
+    return static_cast<size_t>(_value);
+
+  // Values from 2^(e + SubBucketBits) up are split into SubBuckets buckets
+  // that are 2^e wide each
+  const size_t magnitude =
+      static_cast<size_t>(63 - __builtin_clzll(_value)) - SubBucketBits;
+  return (magnitude + 1) * SubBuckets +
+      static_cast<size_t>((_value >> magnitude) - SubBuckets);
+}
+
+uint64_t LatencyHistogram::bucket_upper_bound(size_t _bucket)
+{
+  if (_bucket < SubBuckets)
+    return _bucket;
+
+  const size_t magnitude = _bucket / SubBuckets - 1;
+  const uint64_t sub_bucket = _bucket % SubBuckets + SubBuckets;
+  return ((sub_bucket + 1) << magnitude) - 1;
+}
+
+double LatencyHistogram::mean() const
+{
+  return count > 0 ? static_cast<double>(sum) / count : 0.0;
+}
+
+void LatencyHistogram::merge(const LatencyHistogram& _other)
+{
+  for (size_t i = 0; i < BucketCount; ++i)
+    counts[i] += _other.counts[i];
+  count += _other.count;
+  sum += _other.sum;
+  max = std::max(max, _other.max);
+}
+
+uint64_t LatencyHistogram::percentile(double _percentile) const
+{
+  if (count == 0)
+    return 0;
+
+  const double clamped = std::min(100.0, std::max(0.0, _percentile));
+  const uint64_t rank = std::max<uint64_t>(
+      1, static_cast<uint64_t>(std::ceil(clamped / 100.0 * count)));
+  uint64_t counted = 0;
+  for (size_t i = 0; i < BucketCount; ++i)
+  {
+    counted += counts[i];
+    if (counted >= rank)
+      return std::min(bucket_upper_bound(i), max);
+  }
+  return max;
+}
+
+} // namespace free_fleet
@@ -0,0 +1,188 @@
+/*
+ * Copyright (C) 2019 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#ifndef FREE_FLEET__SRC__STATSRECORDER_HPP
+#define FREE_FLEET__SRC__STATSRECORDER_HPP
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <cstdint>
+
+#include <dds/dds.h>
+
+#include <free_fleet/Stats.hpp>
+
+namespace free_fleet {
+
+/// Lock-free counterpart of LatencyHistogram that durations are recorded
+/// into from any number of threads. Every count is relaxed, a snapshot may
+/// tear between buckets that are recorded into while it is taken, which only
+/// ever shifts the counts by the few durations that are in flight.
+class AtomicHistogram
+{
+public:
+
+  AtomicHistogram()
+  {
+    for (auto& bucket : counts)
+      bucket.store(0, std::memory_order_relaxed);
+  }
+
+  /// Records the same duration a number of times, for durations that were
+  /// measured over a whole batch and split evenly between its messages
+  void record(uint64_t _value, uint64_t _times = 1)
+  {
+    if (_times == 0)
+      return;
+
+    counts[LatencyHistogram::bucket_of(_value)].fetch_add(
+        _times, std::memory_order_relaxed);
+    count.fetch_add(_times, std::memory_order_relaxed);
+    sum.fetch_add(_value * _times, std::memory_order_relaxed);
+
+    uint64_t current_max = max.load(std::memory_order_relaxed);
+    while (_value > current_max &&
+        !max.compare_exchange_weak(
+            current_max, _value, std::memory_order_relaxed))
+    {}
+  }
+
+  void snapshot(LatencyHistogram& _histogram) const
+  {
+    for (size_t i = 0; i < counts.size(); ++i)
+      _histogram.counts[i] = counts[i].load(std::memory_order_relaxed);
+    _histogram.count = count.load(std::memory_order_relaxed);
+    _histogram.sum = sum.load(std::memory_order_relaxed);
+    _histogram.max = max.load(std::memory_order_relaxed);
+  }
+
+private:
+
+  std::array<std::atomic<uint64_t>, LatencyHistogram::BucketCount> counts;
+
+  std::atomic<uint64_t> count{0};
+
+  std::atomic<uint64_t> sum{0};
+
+  std::atomic<uint64_t> max{0};
+};
+
+/// Lock-free counters of the traffic through a single topic. The topic name
+/// and reader are set before the counters are shared between threads.
+class TopicCounters
+{
+public:
+
+  std::string topic;
+
+  /// Reader that the DDS sample statuses are queried from, 0 for topics
+  /// that are only written to or not enabled
+  dds_entity_t reader = 0;
+
+  void record_sent(size_t _bytes)
+  {
+    messages_sent.fetch_add(1, std::memory_order_relaxed);
+    bytes_sent.fetch_add(_bytes, std::memory_order_relaxed);
+  }
+
+  void record_received(size_t _bytes)
+  {
+    messages_received.fetch_add(1, std::memory_order_relaxed);
+    bytes_received.fetch_add(_bytes, std::memory_order_relaxed);
+  }
+
+  void record_write_failure()
+  {
+    write_failures.fetch_add(1, std::memory_order_relaxed);
+  }
+
+  /// Records the outcome of a write of a message of the given size
+  bool record_write(bool _written, size_t _bytes)
+  {
+    if (_written)
+      record_sent(_bytes);
+    else
+      record_write_failure();
+    return _written;
+  }
+
+  TopicStats snapshot() const
+  {
+    TopicStats stats;
+    stats.topic = topic;
+    stats.messages_sent = messages_sent.load(std::memory_order_relaxed);
+    stats.messages_received =
+        messages_received.load(std::memory_order_relaxed);
+    stats.bytes_sent = bytes_sent.load(std::memory_order_relaxed);
+    stats.bytes_received = bytes_received.load(std::memory_order_relaxed);
+    stats.write_failures = write_failures.load(std::memory_order_relaxed);
+
+    // DDS keeps the totals itself, they are only queried here and never on
+    // the way of the samples
+    if (reader > 0)
+    {
+      dds_sample_lost_status_t lost_status;
+      if (dds_get_sample_lost_status(reader, &lost_status) == DDS_RETCODE_OK)
+        stats.samples_lost = lost_status.total_count;
+
+      dds_sample_rejected_status_t rejected_status;
+      if (dds_get_sample_rejected_status(reader, &rejected_status) ==
+          DDS_RETCODE_OK)
+        stats.samples_rejected = rejected_status.total_count;
+    }
+    return stats;
+  }
+
+private:
+
+  std::atomic<uint64_t> messages_sent{0};
+
+  std::atomic<uint64_t> messages_received{0};
+
+  std::atomic<uint64_t> bytes_sent{0};
+
+  std::atomic<uint64_t> bytes_received{0};
+
+  std::atomic<uint64_t> write_failures{0};
+};
+
+/// Nanoseconds elapsed since the given time
+inline uint64_t nanoseconds_since(
+    const std::chrono::steady_clock::time_point& _start)
+{
+  return static_cast<uint64_t>(
+      std::chrono::duration_cast<std::chrono::nanoseconds>(
+          std::chrono::steady_clock::now() - _start).count());
+}
+
+/// Nanoseconds between the sample being written, by the clock of its writer,
+/// and the given time of receipt, 0 for samples from ahead of it. Writers
+/// whose clock is known to be ahead of the reader's by clock_offset have
+/// their timestamps moved back by it first.
+inline uint64_t sample_age(
+    const dds_sample_info_t& _info, dds_time_t _received,
+    int64_t _clock_offset = 0)
+{
+  const dds_time_t sent = _info.source_timestamp - _clock_offset;
+  return _received > sent ? static_cast<uint64_t>(_received - sent) : 0;
+}
+
+} // namespace free_fleet
+
+#endif // FREE_FLEET__SRC__STATSRECORDER_HPP
@@ -0,0 +1,51 @@
+/*
+ * Copyright (C) 2019 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#include <free_fleet/Tracing.hpp>
+
+#ifdef FREE_FLEET_TRACING
+
+#define TRACEPOINT_CREATE_PROBES
+#define TRACEPOINT_DEFINE
+#include "free_fleet_tracepoints.h"
+
+namespace free_fleet {
+namespace tracing {
+
+#define FREE_FLEET_DEFINE_TRACE(stage) \
+  void trace_##stage( \
+      RequestKind _kind, const char* _robot_name, const char* _task_id) \
+  { \
+    tracepoint(free_fleet, stage, \
+        static_cast<int>(_kind), \
+        _robot_name ? _robot_name : "", \
+        _task_id ? _task_id : ""); \
+  }
+
+FREE_FLEET_DEFINE_TRACE(rmf_request_received)
+FREE_FLEET_DEFINE_TRACE(server_request_queued)
+FREE_FLEET_DEFINE_TRACE(server_request_written)
+FREE_FLEET_DEFINE_TRACE(client_request_taken)
+FREE_FLEET_DEFINE_TRACE(client_request_accepted)
+FREE_FLEET_DEFINE_TRACE(client_goal_sent)
+
+#undef FREE_FLEET_DEFINE_TRACE
+
+} // namespace tracing
+} // namespace free_fleet
+
+#endif // FREE_FLEET_TRACING
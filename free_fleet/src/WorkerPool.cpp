@@ -0,0 +1,126 @@
+/*
+ * Copyright (C) 2019 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#include <algorithm>
+
+#include <free_fleet/WorkerPool.hpp>
+
+namespace free_fleet {
+
+WorkerPool::WorkerPool(size_t _threads, const ThreadConfig& _thread_config) :
+  thread_config(_thread_config),
+  generation(0),
+  pending(0),
+  range_size(0),
+  range_count(0),
+  element_count(0),
+  range_function(nullptr),
+  running(true)
+{
+  // The calling thread takes the first range of every loop itself
+  for (size_t i = 1; i < _threads; ++i)
+    workers.emplace_back(&WorkerPool::thread_fn, this, i);
+}
+
+WorkerPool::~WorkerPool()
+{
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    running = false;
+  }
+  work_cv.notify_all();
+  for (auto& worker : workers)
+    worker.join();
+}
+
+size_t WorkerPool::size() const
+{
+  return workers.size() + 1;
+}
+
+void WorkerPool::parallel_for(
+    size_t _count, size_t _min_range, const RangeFunction& _function)
+{
+  if (_count == 0)
+    return;
+
+  const size_t ranges = std::min(
+      size(), (_count + std::max<size_t>(_min_range, 1) - 1) /
+          std::max<size_t>(_min_range, 1));
+  if (ranges <= 1)
+  {
+    _function(0, _count);
+    return;
+  }
+
+  std::lock_guard<std::mutex> loop_lock(loop_mutex);
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    range_size = (_count + ranges - 1) / ranges;
+    range_count = ranges;
+    element_count = _count;
+    range_function = &_function;
+    pending = ranges - 1;
+    ++generation;
+  }
+  work_cv.notify_all();
+
+  _function(0, std::min(range_size, _count));
+
+  std::unique_lock<std::mutex> lock(mutex);
+  done_cv.wait(lock, [this]() { return pending == 0; });
+  range_function = nullptr;
+}
+
+void WorkerPool::thread_fn(size_t _worker_index)
+{
+  thread_config.apply("worker");
+
+  size_t seen_generation = 0;
+  while (true)
+  {
+    size_t begin = 0;
+    size_t end = 0;
+    const RangeFunction* function = nullptr;
+    {
+      std::unique_lock<std::mutex> lock(mutex);
+      work_cv.wait(lock,
+          [&]() { return !running || generation != seen_generation; });
+      if (!running)
+        return;
+      seen_generation = generation;
+
+      // Workers beyond the number of ranges of this loop sit it out
+      if (_worker_index >= range_count)
+        continue;
+      begin = _worker_index * range_size;
+      end = std::min(begin + range_size, element_count);
+      function = range_function;
+    }
+
+    if (begin < end)
+      (*function)(begin, end);
+
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      --pending;
+    }
+    done_cv.notify_one();
+  }
+}
+
+} // namespace free_fleet
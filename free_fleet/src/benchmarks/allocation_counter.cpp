@@ -0,0 +1,79 @@
+/*
+ * Copyright (C) 2019 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#include "allocation_counter.hpp"
+
+namespace {
+
+// Initial-exec thread local storage of the executable, accessing it never
+// allocates, which makes it safe to use from within malloc itself.
+thread_local size_t allocations = 0;
+
+} // namespace anonymous
+
+#ifdef __GLIBC__
+
+// Interposes the allocation functions of glibc for the whole process,
+// including the allocations made from within the DDS shared library, and
+// forwards them to the glibc implementations.
+extern "C" {
+
+void* __libc_malloc(size_t size);
+void* __libc_calloc(size_t num, size_t size);
+void* __libc_realloc(void* ptr, size_t size);
+
+void* malloc(size_t _size)
+{
+  ++allocations;
+  return __libc_malloc(_size);
+}
+
+void* calloc(size_t _num, size_t _size)
+{
+  ++allocations;
+  return __libc_calloc(_num, _size);
+}
+
+void* realloc(void* _ptr, size_t _size)
+{
+  ++allocations;
+  return __libc_realloc(_ptr, _size);
+}
+
+} // extern "C"
+
+#endif // __GLIBC__
+
+namespace free_fleet {
+namespace benchmarks {
+
+bool allocation_counting_supported()
+{
+#ifdef __GLIBC__
+  return true;
+#else
+  return false;
+#endif
+}
+
+size_t thread_allocations()
+{
+  return allocations;
+}
+
+} // namespace benchmarks
+} // namespace free_fleet
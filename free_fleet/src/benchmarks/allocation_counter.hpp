@@ -0,0 +1,36 @@
+/*
+ * Copyright (C) 2019 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#ifndef FREE_FLEET__SRC__BENCHMARKS__ALLOCATIONCOUNTER_HPP
+#define FREE_FLEET__SRC__BENCHMARKS__ALLOCATIONCOUNTER_HPP
+
+#include <cstddef>
+
+namespace free_fleet {
+namespace benchmarks {
+
+/// Whether heap allocations are being counted at all, which requires glibc.
+bool allocation_counting_supported();
+
+/// Number of heap allocations made so far by the calling thread, this covers
+/// operator new as well as every allocation made inside the DDS library.
+size_t thread_allocations();
+
+} // namespace benchmarks
+} // namespace free_fleet
+
+#endif // FREE_FLEET__SRC__BENCHMARKS__ALLOCATIONCOUNTER_HPP
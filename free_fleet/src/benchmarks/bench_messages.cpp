@@ -0,0 +1,142 @@
+/*
+ * Copyright (C) 2019 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+#include <dds/dds.h>
+
+#include <free_fleet/messages/RobotState.hpp>
+#include <free_fleet/messages/PathRequest.hpp>
+
+#include "../messages/FleetMessages.h"
+#include "../messages/message_utils.hpp"
+#include "../dds_utils/DDSPublishHandler.hpp"
+
+#include "allocation_counter.hpp"
+#include "benchmark_utils.hpp"
+
+using namespace free_fleet;
+using namespace free_fleet::benchmarks;
+
+namespace {
+
+messages::RobotState make_robot_state(size_t _path_length)
+{
+  messages::RobotState robot_state;
+  robot_state.name = "benchmark_robot";
+  robot_state.model = "benchmark_model";
+  robot_state.task_id = "benchmark_task_0000";
+  robot_state.mode.mode = messages::RobotMode::MODE_MOVING;
+  robot_state.battery_percent = 80.f;
+  robot_state.location =
+      messages::Location{0, 0, 1.f, 2.f, 0.f, "L1_warehouse"};
+  robot_state.path = make_path(_path_length);
+  return robot_state;
+}
+
+/// Runs the function a few times first, so that reused buffers have grown to
+/// their final capacity, then reports the average time and the number of heap
+/// allocations per call.
+template<typename Function>
+void run(
+    const char* _name, size_t _path_length, size_t _iterations,
+    Function&& _function)
+{
+  for (size_t i = 0; i < 10; ++i)
+    _function();
+
+  size_t allocations_before = thread_allocations();
+  auto start = Clock::now();
+  for (size_t i = 0; i < _iterations; ++i)
+    _function();
+  auto end = Clock::now();
+  size_t allocations = thread_allocations() - allocations_before;
+
+  printf("%-30s %8zu %12.3f %12.2f\n",
+      _name, _path_length,
+      elapsed_us(start, end) / static_cast<double>(_iterations),
+      static_cast<double>(allocations) / static_cast<double>(_iterations));
+}
+
+} // namespace anonymous
+
+int main(int argc, char** argv)
+{
+  int domain = argc > 1 ? std::atoi(argv[1]) : 99;
+
+  dds_entity_t participant = dds_create_participant(
+      static_cast<dds_domainid_t>(domain), NULL, NULL);
+  if (participant < 0)
+    DDS_FATAL("dds_create_participant: %s\n", dds_strretcode(-participant));
+
+  dds::DDSPublishHandler<FreeFleetData_RobotState> state_pub(
+      participant, &FreeFleetData_RobotState_desc, "benchmark_robot_state");
+  if (!state_pub.is_ready())
+    return 1;
+
+  if (!allocation_counting_supported())
+    printf("heap allocations are not counted on this platform\n");
+
+  printf("%-30s %8s %12s %12s\n", "benchmark", "path", "us/op", "allocs/op");
+
+  const std::vector<size_t> path_lengths = {1, 10, 100, 1000};
+  for (size_t path_length : path_lengths)
+  {
+    const size_t iterations = std::max<size_t>(100, 100000 / path_length);
+    const messages::RobotState robot_state = make_robot_state(path_length);
+
+    run("convert to dds, new sample", path_length, iterations,
+        [&]()
+        {
+          FreeFleetData_RobotState* sample = FreeFleetData_RobotState__alloc();
+          messages::convert(robot_state, *sample);
+          FreeFleetData_RobotState_free(sample, DDS_FREE_ALL);
+        });
+
+    FreeFleetData_RobotState* reused_sample = FreeFleetData_RobotState__alloc();
+    run("convert to dds, reused sample", path_length, iterations,
+        [&]()
+        {
+          messages::convert(robot_state, *reused_sample);
+        });
+
+    messages::RobotState reused_state;
+    run("convert from dds", path_length, iterations,
+        [&]()
+        {
+          messages::convert(*reused_sample, reused_state);
+        });
+    FreeFleetData_RobotState_free(reused_sample, DDS_FREE_ALL);
+
+    // Serialization happens on every write, even without matched readers
+    run("publish handler write", path_length, iterations,
+        [&]()
+        {
+          auto sample = state_pub.lock_sample();
+          messages::convert(robot_state, *sample);
+          state_pub.write(sample.get());
+        });
+  }
+
+  dds_return_t return_code = dds_delete(participant);
+  if (return_code != DDS_RETCODE_OK)
+    DDS_FATAL("dds_delete: %s\n", dds_strretcode(-return_code));
+  return 0;
+}
@@ -0,0 +1,133 @@
+/*
+ * Copyright (C) 2019 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <cstdio>
+#include <cstdlib>
+#include <condition_variable>
+
+#include <free_fleet/Client.hpp>
+#include <free_fleet/ClientConfig.hpp>
+#include <free_fleet/Server.hpp>
+#include <free_fleet/ServerConfig.hpp>
+
+#include "benchmark_utils.hpp"
+
+using namespace free_fleet;
+using namespace free_fleet::benchmarks;
+
+/// Round trip between a server and a client running in the same process: the
+/// server sends a mode request, the client answers right away from its
+/// request callback with a robot state carrying the same task id, and the
+/// server measures how long it took for that state to come back.
+int main(int argc, char** argv)
+{
+  const size_t iterations = argc > 1 ? std::strtoul(argv[1], NULL, 10) : 1000;
+  const int domain = argc > 2 ? std::atoi(argv[2]) : 99;
+  const std::string fleet_name = "benchmark_fleet";
+  const std::string robot_name = "benchmark_robot";
+
+  // Declared ahead of the server and the client, so that it outlives the
+  // callbacks running on their reader threads
+  std::mutex mutex;
+  std::condition_variable received_cv;
+  std::string received_task_id;
+
+  ServerConfig server_config;
+  server_config.fleet_name = fleet_name;
+  server_config.dds_domain = domain;
+  auto server = Server::make(server_config);
+
+  ClientConfig client_config;
+  client_config.fleet_name = fleet_name;
+  client_config.robot_name = robot_name;
+  client_config.dds_domain = domain;
+  auto client = Client::make(client_config);
+
+  if (!server || !client)
+  {
+    printf("failed to create the server or the client\n");
+    return 1;
+  }
+
+  client->on_mode_request(
+      [&client, &robot_name](const messages::ModeRequest& _request)
+      {
+        messages::RobotState robot_state;
+        robot_state.name = robot_name;
+        robot_state.task_id = _request.task_id;
+        client->send_robot_state(robot_state);
+      });
+
+  server->on_robot_states(
+      [&](const std::vector<messages::RobotState>& _robot_states)
+      {
+        std::lock_guard<std::mutex> lock(mutex);
+        for (const auto& robot_state : _robot_states)
+          received_task_id = robot_state.task_id;
+        received_cv.notify_all();
+      });
+
+  auto round_trip = [&](const std::string& _task_id)
+  {
+    messages::ModeRequest request;
+    request.fleet_name = fleet_name;
+    request.robot_name = robot_name;
+    request.mode.mode = messages::RobotMode::MODE_MOVING;
+    request.task_id = _task_id;
+
+    std::unique_lock<std::mutex> lock(mutex);
+    server->send_mode_request(request);
+    return received_cv.wait_for(
+        lock, std::chrono::seconds(1),
+        [&]() { return received_task_id == _task_id; });
+  };
+
+  // Gives discovery some time to match the readers and writers
+  size_t attempts = 0;
+  while (!round_trip("warm_up_" + std::to_string(attempts)))
+  {
+    if (++attempts == 10)
+    {
+      printf("client never answered, giving up\n");
+      return 1;
+    }
+  }
+
+  std::vector<double> latencies_us;
+  latencies_us.reserve(iterations);
+  size_t lost = 0;
+
+  auto start = Clock::now();
+  for (size_t i = 0; i < iterations; ++i)
+  {
+    auto sent_time = Clock::now();
+    if (round_trip("task_" + std::to_string(i)))
+      latencies_us.push_back(elapsed_us(sent_time, Clock::now()));
+    else
+      ++lost;
+  }
+  double total_s = elapsed_us(start, Clock::now()) / 1e6;
+
+  print_percentiles("mode request to robot state round trip", latencies_us);
+  printf("throughput: %.1f round trips/s\n", latencies_us.size() / total_s);
+  printf("lost: %zu\n", lost);
+  return 0;
+}
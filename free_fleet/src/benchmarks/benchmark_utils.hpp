@@ -0,0 +1,91 @@
+/*
+ * Copyright (C) 2019 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#ifndef FREE_FLEET__SRC__BENCHMARKS__BENCHMARKUTILS_HPP
+#define FREE_FLEET__SRC__BENCHMARKS__BENCHMARKUTILS_HPP
+
+#include <cstdio>
+#include <chrono>
+#include <string>
+#include <vector>
+#include <algorithm>
+
+#include <free_fleet/messages/Location.hpp>
+
+namespace free_fleet {
+namespace benchmarks {
+
+using Clock = std::chrono::steady_clock;
+
+inline double elapsed_us(const Clock::time_point& _start,
+    const Clock::time_point& _end)
+{
+  return std::chrono::duration<double, std::micro>(_end - _start).count();
+}
+
+/// Path of straight line waypoints, all on the same level.
+inline std::vector<messages::Location> make_path(size_t _length)
+{
+  std::vector<messages::Location> path;
+  path.reserve(_length);
+  for (size_t i = 0; i < _length; ++i)
+  {
+    path.push_back(messages::Location{
+        static_cast<int32_t>(i), 0, static_cast<float>(i), 0.f, 0.f,
+        "L1_warehouse"});
+  }
+  return path;
+}
+
+/// Gets the percentile of the values, 0 without any values.
+inline double percentile(std::vector<double> _values, double _p)
+{
+  if (_values.empty())
+    return 0.0;
+  std::sort(_values.begin(), _values.end());
+  return _values[static_cast<size_t>(_p * (_values.size() - 1))];
+}
+
+/// Prints the percentiles of the recorded latencies, in microseconds.
+inline void print_percentiles(
+    const std::string& _name, std::vector<double> _latencies_us)
+{
+  if (_latencies_us.empty())
+  {
+    printf("%s: no samples\n", _name.c_str());
+    return;
+  }
+
+  std::sort(_latencies_us.begin(), _latencies_us.end());
+  auto percentile = [&_latencies_us](double _p)
+  {
+    size_t index = static_cast<size_t>(_p * (_latencies_us.size() - 1));
+    return _latencies_us[index];
+  };
+
+  printf("%s (us, %zu samples)\n", _name.c_str(), _latencies_us.size());
+  printf("  p50: %10.1f\n", percentile(0.5));
+  printf("  p90: %10.1f\n", percentile(0.9));
+  printf("  p99: %10.1f\n", percentile(0.99));
+  printf("  p99.9: %8.1f\n", percentile(0.999));
+  printf("  max: %10.1f\n", _latencies_us.back());
+}
+
+} // namespace benchmarks
+} // namespace free_fleet
+
+#endif // FREE_FLEET__SRC__BENCHMARKS__BENCHMARKUTILS_HPP
@@ -0,0 +1,379 @@
+/*
+ * Copyright (C) 2019 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#include <mutex>
+#include <atomic>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#include <utility>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <unordered_map>
+
+#include <free_fleet/Client.hpp>
+#include <free_fleet/ClientConfig.hpp>
+#include <free_fleet/Server.hpp>
+#include <free_fleet/ServerConfig.hpp>
+
+#include "benchmark_utils.hpp"
+
+using namespace free_fleet;
+using namespace free_fleet::benchmarks;
+
+namespace {
+
+struct Options
+{
+  size_t robots = 100;
+  double publish_rate = 2.0;
+  size_t path_length = 20;
+  double request_period = 5.0;
+  double duration = 30.0;
+  int domain = 99;
+
+  /// Robots answer requests straight away from the request callback instead
+  /// of waiting for their next publish tick
+  bool respond_immediately = false;
+
+  /// Runs a free fleet server in the same process to measure ingestion and
+  /// request latency, otherwise only the robots are emulated for an external
+  /// server to be sized against
+  bool run_server = true;
+
+  std::string fleet_name = "load_fleet";
+};
+
+void print_usage(const char* _program)
+{
+  printf("Usage: %s [options]\n", _program);
+  printf("  --robots N            number of emulated robots (100)\n");
+  printf("  --publish-rate HZ     robot state rate of each robot (2.0)\n");
+  printf("  --path-length N       waypoints of each path request (20)\n");
+  printf("  --request-period S    seconds between path requests (5.0)\n");
+  printf("  --duration S          length of the run in seconds (30.0)\n");
+  printf("  --domain N            DDS domain (99)\n");
+  printf("  --fleet-name NAME     fleet name (load_fleet)\n");
+  printf("  --respond-immediately answer requests from the callback\n");
+  printf("  --no-server           only emulate the robots\n");
+}
+
+bool parse_options(int argc, char** argv, Options& _options)
+{
+  for (int i = 1; i < argc; ++i)
+  {
+    const bool has_value = i + 1 < argc;
+    if (!strcmp(argv[i], "--robots") && has_value)
+      _options.robots = std::strtoul(argv[++i], NULL, 10);
+    else if (!strcmp(argv[i], "--publish-rate") && has_value)
+      _options.publish_rate = std::atof(argv[++i]);
+    else if (!strcmp(argv[i], "--path-length") && has_value)
+      _options.path_length = std::strtoul(argv[++i], NULL, 10);
+    else if (!strcmp(argv[i], "--request-period") && has_value)
+      _options.request_period = std::atof(argv[++i]);
+    else if (!strcmp(argv[i], "--duration") && has_value)
+      _options.duration = std::atof(argv[++i]);
+    else if (!strcmp(argv[i], "--domain") && has_value)
+      _options.domain = std::atoi(argv[++i]);
+    else if (!strcmp(argv[i], "--fleet-name") && has_value)
+      _options.fleet_name = argv[++i];
+    else if (!strcmp(argv[i], "--respond-immediately"))
+      _options.respond_immediately = true;
+    else if (!strcmp(argv[i], "--no-server"))
+      _options.run_server = false;
+    else
+      return false;
+  }
+  return _options.robots > 0 && _options.publish_rate > 0.0;
+}
+
+/// A robot that only exists as a free fleet client, following whatever path
+/// it was last sent by reporting it back in its robot states.
+class EmulatedRobot
+{
+public:
+
+  EmulatedRobot(const Options& _options, const std::string& _robot_name) :
+    respond_immediately(_options.respond_immediately)
+  {
+    ClientConfig client_config;
+    client_config.fleet_name = _options.fleet_name;
+    client_config.robot_name = _robot_name;
+    client_config.dds_domain = _options.domain;
+    client = Client::make(client_config);
+
+    robot_state.name = _robot_name;
+    robot_state.model = "load_generator";
+    robot_state.mode.mode = messages::RobotMode::MODE_IDLE;
+    robot_state.battery_percent = 100.f;
+    robot_state.location =
+        messages::Location{0, 0, 0.f, 0.f, 0.f, "L1_warehouse"};
+  }
+
+  bool is_ready() const
+  {
+    return client != nullptr;
+  }
+
+  bool start()
+  {
+    return client->on_path_request(
+        [this](const messages::PathRequest& _path_request)
+        {
+          {
+            std::lock_guard<std::mutex> lock(mutex);
+            robot_state.task_id = _path_request.task_id;
+            robot_state.mode.mode = messages::RobotMode::MODE_MOVING;
+            robot_state.path = _path_request.path;
+            robot_state.path_version = _path_request.version;
+            robot_state.path_index = 0;
+          }
+          ++received_requests;
+          if (respond_immediately)
+            publish();
+        });
+  }
+
+  void publish()
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (client->send_robot_state(robot_state))
+      ++published_states;
+  }
+
+  std::atomic<size_t> published_states{0};
+
+  std::atomic<size_t> received_requests{0};
+
+private:
+
+  Client::SharedPtr client;
+
+  bool respond_immediately;
+
+  std::mutex mutex;
+
+  messages::RobotState robot_state;
+};
+
+/// Server side of the measurements, counting every state it takes in and
+/// timing how long it takes for each robot to report the task id of the last
+/// path request it was sent.
+class LoadMonitor
+{
+public:
+
+  LoadMonitor(const Options& _options) :
+    options(_options),
+    path(make_path(_options.path_length))
+  {
+    ServerConfig server_config;
+    server_config.fleet_name = _options.fleet_name;
+    server_config.dds_domain = _options.domain;
+    server = Server::make(server_config);
+  }
+
+  bool start()
+  {
+    if (!server)
+      return false;
+
+    return server->on_robot_states(
+        [this](const std::vector<messages::RobotState>& _robot_states)
+        {
+          auto now = Clock::now();
+          ingested_states += _robot_states.size();
+
+          std::lock_guard<std::mutex> lock(mutex);
+          for (const auto& robot_state : _robot_states)
+          {
+            auto it = pending_requests.find(robot_state.name);
+            if (it == pending_requests.end() ||
+                it->second.task_id != robot_state.task_id)
+              continue;
+            latencies_us.push_back(elapsed_us(it->second.sent_time, now));
+            pending_requests.erase(it);
+          }
+        });
+  }
+
+  void send_path_requests(size_t _round)
+  {
+    std::vector<messages::PathRequest> path_requests;
+    path_requests.reserve(options.robots);
+    for (size_t i = 0; i < options.robots; ++i)
+    {
+      messages::PathRequest path_request;
+      path_request.fleet_name = options.fleet_name;
+      path_request.robot_name = "robot_" + std::to_string(i);
+      path_request.path = path;
+      path_request.task_id =
+          "task_" + std::to_string(_round) + "_" + std::to_string(i);
+      path_requests.push_back(std::move(path_request));
+    }
+
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      auto now = Clock::now();
+      for (const auto& path_request : path_requests)
+      {
+        pending_requests[path_request.robot_name] =
+            PendingRequest{path_request.task_id, now};
+      }
+    }
+    server->send_path_requests(path_requests);
+  }
+
+  size_t take_ingested_states()
+  {
+    return ingested_states.exchange(0);
+  }
+
+  void print_summary()
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    print_percentiles("path request to acknowledged state", latencies_us);
+    printf("unacknowledged requests at the end: %zu\n",
+        pending_requests.size());
+  }
+
+private:
+
+  struct PendingRequest
+  {
+    std::string task_id;
+    Clock::time_point sent_time;
+  };
+
+  const Options& options;
+
+  std::vector<messages::Location> path;
+
+  Server::SharedPtr server;
+
+  std::atomic<size_t> ingested_states{0};
+
+  std::mutex mutex;
+
+  std::unordered_map<std::string, PendingRequest> pending_requests;
+
+  std::vector<double> latencies_us;
+};
+
+} // namespace anonymous
+
+int main(int argc, char** argv)
+{
+  Options options;
+  if (!parse_options(argc, argv, options))
+  {
+    print_usage(argv[0]);
+    return 1;
+  }
+
+  std::unique_ptr<LoadMonitor> monitor;
+  if (options.run_server)
+  {
+    monitor.reset(new LoadMonitor(options));
+    if (!monitor->start())
+    {
+      printf("failed to start the server\n");
+      return 1;
+    }
+  }
+
+  std::vector<std::unique_ptr<EmulatedRobot>> robots;
+  robots.reserve(options.robots);
+  for (size_t i = 0; i < options.robots; ++i)
+  {
+    robots.emplace_back(
+        new EmulatedRobot(options, "robot_" + std::to_string(i)));
+    if (!robots.back()->is_ready() || !robots.back()->start())
+    {
+      printf("failed to start robot_%zu\n", i);
+      return 1;
+    }
+  }
+  printf("emulating %zu robots at %.1f Hz each\n",
+      options.robots, options.publish_rate);
+
+  // A single thread publishes for every robot, spreading the robots evenly
+  // over each publish period instead of having them all publish at once
+  const auto start = Clock::now();
+  const auto end = start + std::chrono::duration_cast<Clock::duration>(
+      std::chrono::duration<double>(options.duration));
+  const auto publish_interval = std::chrono::duration_cast<Clock::duration>(
+      std::chrono::duration<double>(
+          1.0 / (options.publish_rate * options.robots)));
+  const auto request_interval = std::chrono::duration_cast<Clock::duration>(
+      std::chrono::duration<double>(options.request_period));
+  const auto report_interval = std::chrono::seconds(1);
+
+  auto next_publish = start;
+  auto next_request = start + request_interval;
+  auto next_report = start + report_interval;
+  size_t next_robot = 0;
+  size_t request_round = 0;
+  size_t last_published = 0;
+
+  while (Clock::now() < end)
+  {
+    auto now = Clock::now();
+    while (next_publish <= now)
+    {
+      robots[next_robot]->publish();
+      next_robot = (next_robot + 1) % robots.size();
+      next_publish += publish_interval;
+    }
+
+    if (monitor && now >= next_request)
+    {
+      monitor->send_path_requests(request_round++);
+      next_request += request_interval;
+    }
+
+    if (now >= next_report)
+    {
+      size_t published = 0;
+      size_t received = 0;
+      for (const auto& robot : robots)
+      {
+        published += robot->published_states;
+        received += robot->received_requests;
+      }
+      printf("[%5.1fs] published states/s: %zu, received requests: %zu",
+          elapsed_us(start, now) / 1e6, published - last_published, received);
+      if (monitor)
+        printf(", ingested states/s: %zu", monitor->take_ingested_states());
+      printf("\n");
+      last_published = published;
+      next_report += report_interval;
+    }
+
+    std::this_thread::sleep_until(std::min(next_publish, next_report));
+  }
+
+  if (monitor)
+    monitor->print_summary();
+
+  // Robots go first, the server may still be ingesting their last states
+  robots.clear();
+  monitor.reset();
+  return 0;
+}
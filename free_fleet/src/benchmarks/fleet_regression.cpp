@@ -0,0 +1,587 @@
+/*
+ * Copyright (C) 2019 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#include <sys/time.h>
+#include <sys/resource.h>
+
+#include <cmath>
+#include <mutex>
+#include <atomic>
+#include <memory>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include <free_fleet/Client.hpp>
+#include <free_fleet/ClientConfig.hpp>
+#include <free_fleet/Server.hpp>
+#include <free_fleet/ServerConfig.hpp>
+
+#include "benchmark_utils.hpp"
+
+using namespace free_fleet;
+using namespace free_fleet::benchmarks;
+
+namespace {
+
+struct Options
+{
+  size_t robots = 50;
+
+  /// Length of the scripted workload, in simulated seconds
+  double duration = 60.0;
+
+  /// Simulated seconds that go by for every second of wall time
+  double time_scale = 1.0;
+
+  /// Simulated seconds between two steps of the simulation
+  double step = 0.01;
+
+  double publish_rate = 2.0;
+  double request_period = 10.0;
+  size_t path_length = 20;
+  double robot_speed = 0.5;
+  unsigned int seed = 1;
+  int domain = 98;
+  std::string fleet_name = "regression_fleet";
+
+  /// Budgets that fail the run when exceeded, budgets of 0 are not checked
+  double max_request_latency_us = 50000.0;
+  double max_staleness_us = 100000.0;
+  double max_cpu_per_robot = 0.0;
+  double min_delivery = 0.99;
+};
+
+void print_usage(const char* _program)
+{
+  printf("Usage: %s [options]\n", _program);
+  printf("  --robots N                 number of simulated robots (50)\n");
+  printf("  --duration S               simulated seconds of workload (60.0)\n");
+  printf("  --time-scale X             simulated seconds per wall second "
+      "(1.0)\n");
+  printf("  --step S                   simulated seconds per step (0.01)\n");
+  printf("  --publish-rate HZ          simulated robot state rate (2.0)\n");
+  printf("  --request-period S         simulated seconds between path "
+      "requests (10.0)\n");
+  printf("  --path-length N            waypoints of each path request (20)\n");
+  printf("  --robot-speed M/S          simulated robot speed (0.5)\n");
+  printf("  --seed N                   seed of the scripted workload (1)\n");
+  printf("  --domain N                 DDS domain (98)\n");
+  printf("  --fleet-name NAME          fleet name (regression_fleet)\n");
+  printf("  --max-request-latency US   p99 request to goal budget (50000)\n");
+  printf("  --max-staleness US         p99 state staleness budget (100000)\n");
+  printf("  --max-cpu-per-robot PCT    CPU budget per robot, in percent of a "
+      "core (unchecked)\n");
+  printf("  --min-delivery FRACTION    requests that must reach their robot "
+      "(0.99)\n");
+  printf("Exits with 2 when any budget is exceeded.\n");
+}
+
+bool parse_options(int argc, char** argv, Options& _options)
+{
+  for (int i = 1; i < argc; ++i)
+  {
+    const bool has_value = i + 1 < argc;
+    if (!strcmp(argv[i], "--robots") && has_value)
+      _options.robots = std::strtoul(argv[++i], NULL, 10);
+    else if (!strcmp(argv[i], "--duration") && has_value)
+      _options.duration = std::atof(argv[++i]);
+    else if (!strcmp(argv[i], "--time-scale") && has_value)
+      _options.time_scale = std::atof(argv[++i]);
+    else if (!strcmp(argv[i], "--step") && has_value)
+      _options.step = std::atof(argv[++i]);
+    else if (!strcmp(argv[i], "--publish-rate") && has_value)
+      _options.publish_rate = std::atof(argv[++i]);
+    else if (!strcmp(argv[i], "--request-period") && has_value)
+      _options.request_period = std::atof(argv[++i]);
+    else if (!strcmp(argv[i], "--path-length") && has_value)
+      _options.path_length = std::strtoul(argv[++i], NULL, 10);
+    else if (!strcmp(argv[i], "--robot-speed") && has_value)
+      _options.robot_speed = std::atof(argv[++i]);
+    else if (!strcmp(argv[i], "--seed") && has_value)
+      _options.seed =
+          static_cast<unsigned int>(std::strtoul(argv[++i], NULL, 10));
+    else if (!strcmp(argv[i], "--domain") && has_value)
+      _options.domain = std::atoi(argv[++i]);
+    else if (!strcmp(argv[i], "--fleet-name") && has_value)
+      _options.fleet_name = argv[++i];
+    else if (!strcmp(argv[i], "--max-request-latency") && has_value)
+      _options.max_request_latency_us = std::atof(argv[++i]);
+    else if (!strcmp(argv[i], "--max-staleness") && has_value)
+      _options.max_staleness_us = std::atof(argv[++i]);
+    else if (!strcmp(argv[i], "--max-cpu-per-robot") && has_value)
+      _options.max_cpu_per_robot = std::atof(argv[++i]);
+    else if (!strcmp(argv[i], "--min-delivery") && has_value)
+      _options.min_delivery = std::atof(argv[++i]);
+    else
+      return false;
+  }
+  return _options.robots > 0 && _options.duration > 0.0 &&
+      _options.time_scale > 0.0 && _options.step > 0.0 &&
+      _options.publish_rate > 0.0 && _options.request_period > 0.0 &&
+      _options.path_length > 1 && _options.robot_speed > 0.0;
+}
+
+/// Steps of the simulation are numbered from the start of the workload, each
+/// of them is due at a fixed wall time, so that the wall time at which any
+/// simulated time stamp was due can be worked out from any thread.
+class SimClock
+{
+public:
+
+  SimClock(const Options& _options) :
+    step(_options.step),
+    time_scale(_options.time_scale)
+  {}
+
+  void start()
+  {
+    start_time = Clock::now();
+  }
+
+  double sim_time(uint64_t _step) const
+  {
+    return _step * step;
+  }
+
+  Clock::time_point wall_time(double _sim_time) const
+  {
+    return start_time + std::chrono::duration_cast<Clock::duration>(
+        std::chrono::duration<double>(_sim_time / time_scale));
+  }
+
+  static double to_seconds(const messages::Location& _location)
+  {
+    return _location.sec + _location.nanosec * 1e-9;
+  }
+
+  static void stamp(double _sim_time, messages::Location& _location)
+  {
+    const double sec = std::floor(_sim_time);
+    _location.sec = static_cast<int32_t>(sec);
+    _location.nanosec = static_cast<uint32_t>((_sim_time - sec) * 1e9);
+  }
+
+private:
+
+  double step;
+
+  double time_scale;
+
+  Clock::time_point start_time;
+};
+
+/// Path request of the scripted workload, sent once the simulation reaches
+/// its step.
+struct ScriptedRequest
+{
+  uint64_t step;
+  messages::PathRequest request;
+};
+
+/// Builds the whole workload up front from the seed, every request round
+/// sends each robot a straight path from the end of its previous path to a
+/// new random destination, timed at the robot speed from the round onwards.
+/// The same options always give the same requests at the same steps,
+/// regardless of how the robots get on with them.
+std::vector<ScriptedRequest> make_script(const Options& _options)
+{
+  std::mt19937 generator(_options.seed);
+  std::uniform_real_distribution<float> coordinate(0.f, 50.f);
+
+  std::vector<messages::Location> ends;
+  for (size_t i = 0; i < _options.robots; ++i)
+  {
+    ends.push_back(messages::Location{
+        0, 0, static_cast<float>(i), 0.f, 0.f, "L1_warehouse"});
+  }
+
+  std::vector<ScriptedRequest> script;
+  const uint64_t steps_per_round = static_cast<uint64_t>(
+      std::llround(_options.request_period / _options.step));
+  const uint64_t total_steps = static_cast<uint64_t>(
+      std::llround(_options.duration / _options.step));
+  size_t round = 0;
+  for (uint64_t step = steps_per_round; step < total_steps;
+      step += steps_per_round, ++round)
+  {
+    const double round_time = step * _options.step;
+    for (size_t i = 0; i < _options.robots; ++i)
+    {
+      const messages::Location from = ends[i];
+      const float to_x = coordinate(generator);
+      const float to_y = coordinate(generator);
+      const double length = std::hypot(to_x - from.x, to_y - from.y);
+      const float yaw = static_cast<float>(
+          std::atan2(to_y - from.y, to_x - from.x));
+
+      ScriptedRequest scripted{step, messages::PathRequest()};
+      messages::PathRequest& request = scripted.request;
+      request.fleet_name = _options.fleet_name;
+      request.robot_name = "robot_" + std::to_string(i);
+      request.task_id =
+          "task_" + std::to_string(round) + "_" + std::to_string(i);
+      for (size_t w = 0; w < _options.path_length; ++w)
+      {
+        const double s = static_cast<double>(w) / (_options.path_length - 1);
+        messages::Location waypoint{
+            0, 0,
+            static_cast<float>(from.x + s * (to_x - from.x)),
+            static_cast<float>(from.y + s * (to_y - from.y)),
+            yaw, from.level_name};
+        SimClock::stamp(
+            round_time + s * length / _options.robot_speed, waypoint);
+        request.path.push_back(waypoint);
+      }
+      ends[i] = request.path.back();
+      script.push_back(std::move(scripted));
+    }
+  }
+  return script;
+}
+
+/// A robot that only exists as a free fleet client, standing in for the
+/// navigation stack of the fake action servers: paths are accepted as goals
+/// as soon as they arrive, and followed along their waypoint times as the
+/// simulated time goes by.
+class SimulatedRobot
+{
+public:
+
+  SimulatedRobot(const Options& _options, size_t _index) :
+    name("robot_" + std::to_string(_index))
+  {
+    ClientConfig client_config;
+    client_config.fleet_name = _options.fleet_name;
+    client_config.robot_name = name;
+    client_config.dds_domain = _options.domain;
+    client = Client::make(client_config);
+
+    robot_state.name = name;
+    robot_state.model = "regression_robot";
+    robot_state.mode.mode = messages::RobotMode::MODE_IDLE;
+    robot_state.battery_percent = 100.f;
+    robot_state.location = messages::Location{
+        0, 0, static_cast<float>(_index), 0.f, 0.f, "L1_warehouse"};
+  }
+
+  bool is_ready() const
+  {
+    return client != nullptr;
+  }
+
+  bool start()
+  {
+    const bool mode_registered = client->on_mode_request(
+        [this](const messages::ModeRequest&)
+        {
+          matched = true;
+        });
+    const bool path_registered = client->on_path_request(
+        [this](const messages::PathRequest& _path_request)
+        {
+          const auto now = Clock::now();
+          std::lock_guard<std::mutex> lock(mutex);
+          if (_path_request.task_id == robot_state.task_id)
+            return;
+          robot_state.task_id = _path_request.task_id;
+          robot_state.path = _path_request.path;
+          robot_state.path_version = _path_request.version;
+          robot_state.path_index = 0;
+          robot_state.mode.mode = messages::RobotMode::MODE_MOVING;
+          goals.push_back(Goal{_path_request.task_id, now});
+        });
+    return mode_registered && path_registered;
+  }
+
+  /// Moves the robot along its path up to the simulated time and sends its
+  /// state, stamped with that time.
+  void publish(double _sim_time)
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto& path = robot_state.path;
+    while (robot_state.path_index < path.size() &&
+        SimClock::to_seconds(path[robot_state.path_index]) <= _sim_time)
+    {
+      robot_state.location.x = path[robot_state.path_index].x;
+      robot_state.location.y = path[robot_state.path_index].y;
+      robot_state.location.yaw = path[robot_state.path_index].yaw;
+      ++robot_state.path_index;
+    }
+    if (!path.empty() && robot_state.path_index == path.size())
+      robot_state.mode.mode = messages::RobotMode::MODE_IDLE;
+    SimClock::stamp(_sim_time, robot_state.location);
+    client->send_robot_state(robot_state);
+  }
+
+  struct Goal
+  {
+    std::string task_id;
+    Clock::time_point accepted_time;
+  };
+
+  std::vector<Goal> take_goals()
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    std::vector<Goal> taken;
+    taken.swap(goals);
+    return taken;
+  }
+
+  const std::string name;
+
+  std::atomic<bool> matched{false};
+
+private:
+
+  Client::SharedPtr client;
+
+  std::mutex mutex;
+
+  messages::RobotState robot_state;
+
+  std::vector<Goal> goals;
+};
+
+double cpu_seconds()
+{
+  struct rusage usage;
+  getrusage(RUSAGE_SELF, &usage);
+  return usage.ru_utime.tv_sec + usage.ru_utime.tv_usec * 1e-6 +
+      usage.ru_stime.tv_sec + usage.ru_stime.tv_usec * 1e-6;
+}
+
+/// Checks a measurement against its budget, budgets of 0 are not checked.
+bool check_budget(
+    const char* _name, double _value, double _budget, bool _upper_bound)
+{
+  if (_budget <= 0.0)
+  {
+    printf("  %-28s %12.3f (unchecked)\n", _name, _value);
+    return true;
+  }
+  const bool met = _upper_bound ? _value <= _budget : _value >= _budget;
+  printf("  %-28s %12.3f %s %.3f %s\n", _name, _value,
+      _upper_bound ? "<=" : ">=", _budget, met ? "ok" : "EXCEEDED");
+  return met;
+}
+
+} // namespace anonymous
+
+/// Runs a free fleet server and a fleet of simulated robots in the same
+/// process, through a scripted workload of path requests under a simulated
+/// clock, and checks request to goal latency, robot state staleness, request
+/// delivery and CPU per robot against their budgets. Meant to be run
+/// headless on every change, failing with exit code 2 on a regression.
+int main(int argc, char** argv)
+{
+  Options options;
+  if (!parse_options(argc, argv, options))
+  {
+    print_usage(argv[0]);
+    return 1;
+  }
+
+  const std::vector<ScriptedRequest> script = make_script(options);
+  SimClock sim_clock(options);
+
+  // Declared ahead of the server and the robots, so that they outlive the
+  // callbacks running on their reader threads
+  std::mutex staleness_mutex;
+  std::vector<double> staleness_us;
+  std::atomic<bool> measuring{false};
+
+  ServerConfig server_config;
+  server_config.fleet_name = options.fleet_name;
+  server_config.dds_domain = options.domain;
+  auto server = Server::make(server_config);
+  if (!server)
+  {
+    printf("failed to create the server\n");
+    return 1;
+  }
+
+  std::vector<std::unique_ptr<SimulatedRobot>> robots;
+  robots.reserve(options.robots);
+  for (size_t i = 0; i < options.robots; ++i)
+  {
+    robots.emplace_back(new SimulatedRobot(options, i));
+    if (!robots.back()->is_ready() || !robots.back()->start())
+    {
+      printf("failed to start robot_%zu\n", i);
+      return 1;
+    }
+  }
+
+  // Staleness is how long after its simulated time stamp was due that a
+  // state got to the server
+  const bool registered = server->on_robot_states(
+      [&](const std::vector<messages::RobotState>& _robot_states)
+      {
+        if (!measuring)
+          return;
+        const auto now = Clock::now();
+        std::lock_guard<std::mutex> lock(staleness_mutex);
+        for (const auto& robot_state : _robot_states)
+        {
+          staleness_us.push_back(elapsed_us(
+              sim_clock.wall_time(
+                  SimClock::to_seconds(robot_state.location)),
+              now));
+        }
+      });
+  if (!registered)
+  {
+    printf("failed to register the robot state callback\n");
+    return 1;
+  }
+
+  // Every robot has to hear from the server and be heard from before the
+  // workload starts, otherwise discovery would count as latency
+  bool all_matched = false;
+  for (size_t attempt = 0; attempt < 100 && !all_matched; ++attempt)
+  {
+    all_matched = server->get_fleet_snapshot()->size() == robots.size();
+    for (const auto& robot : robots)
+    {
+      robot->publish(0.0);
+      if (robot->matched)
+        continue;
+      all_matched = false;
+      messages::ModeRequest request;
+      request.fleet_name = options.fleet_name;
+      request.robot_name = robot->name;
+      request.mode.mode = messages::RobotMode::MODE_IDLE;
+      request.task_id = "warm_up_" + std::to_string(attempt);
+      server->send_mode_request(request);
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+  }
+  if (!all_matched)
+  {
+    printf("robots never matched with the server, giving up\n");
+    return 1;
+  }
+  printf("running %zu robots through %zu scripted requests over %.1f "
+      "simulated seconds at %.1fx\n",
+      robots.size(), script.size(), options.duration, options.time_scale);
+
+  // Robots publish on their own steps, spread evenly over each publish
+  // period instead of all publishing at once
+  const uint64_t total_steps = static_cast<uint64_t>(
+      std::llround(options.duration / options.step));
+  const uint64_t steps_per_publish = std::max<uint64_t>(1,
+      static_cast<uint64_t>(
+          std::llround(1.0 / (options.publish_rate * options.step))));
+
+  std::vector<Clock::time_point> sent_times(script.size());
+  std::vector<double> lag_us;
+  lag_us.reserve(total_steps);
+  size_t next_request = 0;
+
+  sim_clock.start();
+  measuring = true;
+  const double cpu_start = cpu_seconds();
+  for (uint64_t step = 0; step < total_steps; ++step)
+  {
+    const double sim_time = sim_clock.sim_time(step);
+    const auto due = sim_clock.wall_time(sim_time);
+    std::this_thread::sleep_until(due);
+    lag_us.push_back(elapsed_us(due, Clock::now()));
+
+    while (next_request < script.size() &&
+        script[next_request].step == step)
+    {
+      sent_times[next_request] = Clock::now();
+      server->send_path_request(script[next_request].request);
+      ++next_request;
+    }
+
+    for (size_t i = step % steps_per_publish; i < robots.size();
+        i += steps_per_publish)
+      robots[i]->publish(sim_time);
+  }
+  const double wall_s =
+      elapsed_us(sim_clock.wall_time(0.0), Clock::now()) / 1e6;
+  const double cpu_s = cpu_seconds() - cpu_start;
+  measuring = false;
+
+  // Late goals still count, as long as they arrive within a second
+  std::this_thread::sleep_for(std::chrono::seconds(1));
+
+  std::vector<double> latencies_us;
+  size_t delivered = 0;
+  for (size_t r = 0; r < robots.size(); ++r)
+  {
+    for (const auto& goal : robots[r]->take_goals())
+    {
+      // Every round scripts one request for each robot, in robot order
+      for (size_t i = r; i < script.size(); i += robots.size())
+      {
+        if (script[i].request.task_id != goal.task_id)
+          continue;
+        latencies_us.push_back(elapsed_us(sent_times[i], goal.accepted_time));
+        ++delivered;
+        break;
+      }
+    }
+  }
+
+  std::vector<double> staleness;
+  {
+    std::lock_guard<std::mutex> lock(staleness_mutex);
+    staleness.swap(staleness_us);
+  }
+
+  print_percentiles("path request to accepted goal", latencies_us);
+  print_percentiles("robot state staleness", staleness);
+  print_percentiles("simulation lag behind the wall clock", lag_us);
+
+  const double delivery = script.empty() ?
+      1.0 : static_cast<double>(delivered) / script.size();
+  const double cpu_per_robot =
+      wall_s > 0.0 ? 100.0 * cpu_s / wall_s / robots.size() : 0.0;
+
+  printf("budgets\n");
+  bool passed = true;
+  passed = check_budget(
+      "request latency p99 (us)", percentile(latencies_us, 0.99),
+      options.max_request_latency_us, true) && passed;
+  passed = check_budget(
+      "state staleness p99 (us)", percentile(staleness, 0.99),
+      options.max_staleness_us, true) && passed;
+  passed = check_budget(
+      "cpu per robot (% of a core)", cpu_per_robot,
+      options.max_cpu_per_robot, true) && passed;
+  passed = check_budget(
+      "request delivery", delivery, options.min_delivery, false) && passed;
+
+  // A simulation that could not keep up with the wall clock skews every
+  // measurement, which is reported without failing the run
+  if (percentile(lag_us, 0.99) > options.step / options.time_scale * 1e6)
+    printf("warning: the simulation fell behind, lower --time-scale\n");
+
+  // Robots go first, the server may still be ingesting their last states
+  robots.clear();
+  server.reset();
+  printf("%s\n", passed ? "PASSED" : "FAILED");
+  return passed ? 0 : 2;
+}
@@ -0,0 +1,466 @@
+/*
+ * Copyright (C) 2019 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#ifndef FREE_FLEET__SRC__BENCHMARKS__TRAFFICLOG_HPP
+#define FREE_FLEET__SRC__BENCHMARKS__TRAFFICLOG_HPP
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include <tuple>
+#include <string>
+#include <vector>
+#include <cstdio>
+#include <cstdint>
+#include <cstring>
+#include <utility>
+#include <type_traits>
+
+#include "../messages/message_traits.hpp"
+
+namespace free_fleet {
+namespace benchmarks {
+
+/// Recorded free fleet traffic is an append-only log of records, each made of
+/// a RecordHeader followed by the message serialized from its field list, see
+/// messages::MessageTraits. Everything is written in host byte order, logs
+/// are meant to be replayed on the machine or architecture they were
+/// recorded on.
+enum class RecordTopic : uint32_t
+{
+  RobotState = 0,
+  ModeRequest = 1,
+  PathRequest = 2,
+  DestinationRequest = 3
+};
+
+struct LogHeader
+{
+  char magic[8];
+  uint32_t version;
+  uint32_t reserved;
+};
+
+struct RecordHeader
+{
+  /// Nanoseconds since the recording started
+  uint64_t time_ns;
+  RecordTopic topic;
+  uint32_t size;
+};
+
+constexpr char LogMagic[8] = {'F', 'F', 'T', 'R', 'A', 'F', 'F', 'C'};
+
+constexpr uint32_t LogVersion = 4;
+
+//==============================================================================
+
+inline void serialize(std::vector<char>& _buffer, const std::string& _value);
+
+template <typename T>
+void serialize(std::vector<char>& _buffer, const std::vector<T>& _values);
+
+template <typename Message>
+auto serialize(std::vector<char>& _buffer, const Message& _message)
+    -> decltype(messages::MessageTraits<Message>::fields(), void());
+
+template <typename T>
+typename std::enable_if<std::is_arithmetic<T>::value>::type serialize(
+    std::vector<char>& _buffer, T _value)
+{
+  const char* bytes = reinterpret_cast<const char*>(&_value);
+  _buffer.insert(_buffer.end(), bytes, bytes + sizeof(T));
+}
+
+template <typename Message, typename Fields, size_t... I>
+void serialize_fields(std::vector<char>& _buffer, const Message& _message,
+    const Fields& _fields, std::index_sequence<I...>)
+{
+  using expand = int[];
+  (void)expand{0, (serialize(_buffer, _message.*std::get<I>(_fields).member),
+      0)...};
+}
+
+/// Messages are serialized field by field in the order of their field list,
+/// both Field and PathField expose the member of the message they map.
+template <typename Message>
+auto serialize(std::vector<char>& _buffer, const Message& _message)
+    -> decltype(messages::MessageTraits<Message>::fields(), void())
+{
+  constexpr auto fields = messages::MessageTraits<Message>::fields();
+  serialize_fields(_buffer, _message, fields,
+      std::make_index_sequence<std::tuple_size<decltype(fields)>::value>());
+}
+
+inline void serialize(std::vector<char>& _buffer, const std::string& _value)
+{
+  serialize(_buffer, static_cast<uint32_t>(_value.size()));
+  _buffer.insert(_buffer.end(), _value.begin(), _value.end());
+}
+
+template <typename T>
+void serialize(std::vector<char>& _buffer, const std::vector<T>& _values)
+{
+  serialize(_buffer, static_cast<uint32_t>(_values.size()));
+  for (const auto& value : _values)
+    serialize(_buffer, value);
+}
+
+//==============================================================================
+
+/// Reads serialized fields back out of a record, every read is bounds checked
+/// so that a truncated or corrupted record is rejected instead of being read
+/// past its end.
+class RecordReader
+{
+public:
+
+  RecordReader(const char* _data, size_t _size) :
+    data(_data),
+    remaining(_size)
+  {}
+
+  bool read(void* _output, size_t _size)
+  {
+    if (_size > remaining)
+      return false;
+    memcpy(_output, data, _size);
+    data += _size;
+    remaining -= _size;
+    return true;
+  }
+
+  bool exhausted() const
+  {
+    return remaining == 0;
+  }
+
+private:
+
+  const char* data;
+
+  size_t remaining;
+};
+
+inline bool deserialize(RecordReader& _reader, std::string& _value);
+
+template <typename T>
+bool deserialize(RecordReader& _reader, std::vector<T>& _values);
+
+template <typename Message>
+auto deserialize(RecordReader& _reader, Message& _message)
+    -> decltype(messages::MessageTraits<Message>::fields(), bool());
+
+template <typename T>
+typename std::enable_if<std::is_arithmetic<T>::value, bool>::type
+deserialize(RecordReader& _reader, T& _value)
+{
+  return _reader.read(&_value, sizeof(T));
+}
+
+template <typename Message, typename Fields, size_t... I>
+bool deserialize_fields(RecordReader& _reader, Message& _message,
+    const Fields& _fields, std::index_sequence<I...>)
+{
+  bool ok = true;
+  using expand = int[];
+  (void)expand{0, (ok = ok &&
+      deserialize(_reader, _message.*std::get<I>(_fields).member), 0)...};
+  return ok;
+}
+
+template <typename Message>
+auto deserialize(RecordReader& _reader, Message& _message)
+    -> decltype(messages::MessageTraits<Message>::fields(), bool())
+{
+  constexpr auto fields = messages::MessageTraits<Message>::fields();
+  return deserialize_fields(_reader, _message, fields,
+      std::make_index_sequence<std::tuple_size<decltype(fields)>::value>());
+}
+
+inline bool deserialize(RecordReader& _reader, std::string& _value)
+{
+  uint32_t size = 0;
+  if (!deserialize(_reader, size))
+    return false;
+  _value.resize(size);
+  return size == 0 || _reader.read(&_value[0], size);
+}
+
+template <typename T>
+bool deserialize(RecordReader& _reader, std::vector<T>& _values)
+{
+  uint32_t size = 0;
+  if (!deserialize(_reader, size))
+    return false;
+  // Do not trust the count to reserve, a corrupted count fails on reading
+  _values.clear();
+  for (uint32_t i = 0; i < size; ++i)
+  {
+    _values.emplace_back();
+    if (!deserialize(_reader, _values.back()))
+      return false;
+  }
+  return true;
+}
+
+//==============================================================================
+
+/// Appends records to a memory-mapped log file. The file is grown and mapped
+/// in large chunks so that appending a record is only a copy into the
+/// mapping, and is truncated down to what was written when the writer is
+/// closed. Records are only appended from a single thread.
+class TrafficLogWriter
+{
+public:
+
+  /// Size by which the file and its mapping are grown
+  static constexpr size_t ChunkSize = 64 * 1024 * 1024;
+
+  TrafficLogWriter(const std::string& _path)
+  {
+    fd = open(_path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0)
+    {
+      perror("open");
+      return;
+    }
+
+    LogHeader header;
+    memcpy(header.magic, LogMagic, sizeof(header.magic));
+    header.version = LogVersion;
+    header.reserved = 0;
+    if (!reserve(sizeof(header)))
+      return;
+    append(&header, sizeof(header));
+  }
+
+  ~TrafficLogWriter()
+  {
+    close();
+  }
+
+  bool is_ready() const
+  {
+    return data != nullptr;
+  }
+
+  bool write(RecordTopic _topic, uint64_t _time_ns,
+      const std::vector<char>& _payload)
+  {
+    if (!data)
+      return false;
+
+    RecordHeader header{_time_ns, _topic,
+        static_cast<uint32_t>(_payload.size())};
+    if (!reserve(sizeof(header) + _payload.size()))
+      return false;
+    append(&header, sizeof(header));
+    append(_payload.data(), _payload.size());
+    ++records;
+    return true;
+  }
+
+  size_t record_count() const
+  {
+    return records;
+  }
+
+  size_t size() const
+  {
+    return used;
+  }
+
+  /// Unmaps the log and trims the file down to the written records
+  void close()
+  {
+    if (fd < 0)
+      return;
+
+    if (data)
+    {
+      msync(data, used, MS_SYNC);
+      munmap(data, capacity);
+      data = nullptr;
+    }
+    if (ftruncate(fd, static_cast<off_t>(used)) != 0)
+      perror("ftruncate");
+    ::close(fd);
+    fd = -1;
+  }
+
+private:
+
+  bool reserve(size_t _size)
+  {
+    if (used + _size <= capacity)
+      return true;
+
+    size_t new_capacity = capacity;
+    while (used + _size > new_capacity)
+      new_capacity += ChunkSize;
+
+    if (data)
+    {
+      munmap(data, capacity);
+      data = nullptr;
+    }
+    if (ftruncate(fd, static_cast<off_t>(new_capacity)) != 0)
+    {
+      perror("ftruncate");
+      return false;
+    }
+    void* mapping = mmap(
+        nullptr, new_capacity, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (mapping == MAP_FAILED)
+    {
+      perror("mmap");
+      return false;
+    }
+    data = static_cast<char*>(mapping);
+    capacity = new_capacity;
+    return true;
+  }
+
+  void append(const void* _bytes, size_t _size)
+  {
+    memcpy(data + used, _bytes, _size);
+    used += _size;
+  }
+
+  int fd = -1;
+
+  char* data = nullptr;
+
+  size_t capacity = 0;
+
+  size_t used = 0;
+
+  size_t records = 0;
+};
+
+//==============================================================================
+
+/// Maps a recorded log read-only and walks through its records in order.
+class TrafficLogReader
+{
+public:
+
+  struct Record
+  {
+    RecordHeader header;
+    const char* payload;
+  };
+
+  TrafficLogReader(const std::string& _path)
+  {
+    fd = open(_path.c_str(), O_RDONLY);
+    if (fd < 0)
+    {
+      perror("open");
+      return;
+    }
+
+    struct stat file_stat;
+    if (fstat(fd, &file_stat) != 0)
+    {
+      perror("fstat");
+      return;
+    }
+    size = static_cast<size_t>(file_stat.st_size);
+    if (size < sizeof(LogHeader))
+    {
+      fprintf(stderr, "%s is too small to be a traffic log\n", _path.c_str());
+      return;
+    }
+
+    void* mapping = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (mapping == MAP_FAILED)
+    {
+      perror("mmap");
+      return;
+    }
+    data = static_cast<const char*>(mapping);
+
+    LogHeader header;
+    memcpy(&header, data, sizeof(header));
+    if (memcmp(header.magic, LogMagic, sizeof(header.magic)) != 0 ||
+        header.version != LogVersion)
+    {
+      fprintf(stderr, "%s is not a version %u traffic log\n",
+          _path.c_str(), LogVersion);
+      return;
+    }
+    offset = sizeof(LogHeader);
+    valid = true;
+  }
+
+  ~TrafficLogReader()
+  {
+    if (data)
+      munmap(const_cast<char*>(data), size);
+    if (fd >= 0)
+      close(fd);
+  }
+
+  bool is_ready() const
+  {
+    return valid;
+  }
+
+  /// Gets the next record, false once the end of the log is reached or the
+  /// next record is truncated. The payload points into the mapping and stays
+  /// valid for as long as the reader.
+  bool next(Record& _record)
+  {
+    if (!valid || size - offset < sizeof(RecordHeader))
+      return false;
+
+    memcpy(&_record.header, data + offset, sizeof(RecordHeader));
+    if (size - offset - sizeof(RecordHeader) < _record.header.size)
+      return false;
+
+    _record.payload = data + offset + sizeof(RecordHeader);
+    offset += sizeof(RecordHeader) + _record.header.size;
+    return true;
+  }
+
+  /// Goes back to the first record
+  void rewind()
+  {
+    offset = sizeof(LogHeader);
+  }
+
+private:
+
+  int fd = -1;
+
+  const char* data = nullptr;
+
+  size_t size = 0;
+
+  size_t offset = 0;
+
+  bool valid = false;
+};
+
+} // namespace benchmarks
+} // namespace free_fleet
+
+#endif // FREE_FLEET__SRC__BENCHMARKS__TRAFFICLOG_HPP
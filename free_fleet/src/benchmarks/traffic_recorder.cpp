@@ -0,0 +1,274 @@
+/*
+ * Copyright (C) 2019 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#include <csignal>
+#include <atomic>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include <dds/dds.h>
+
+#include <free_fleet/ServerConfig.hpp>
+
+#include "../messages/FleetMessages.h"
+#include "../messages/message_utils.hpp"
+#include "../dds_utils/common.hpp"
+#include "../dds_utils/DDSParticipant.hpp"
+#include "../dds_utils/DDSSubscribeHandler.hpp"
+#include "../dds_utils/DDSWaitSetHandler.hpp"
+
+#include "benchmark_utils.hpp"
+#include "traffic_log.hpp"
+
+using namespace free_fleet;
+using namespace free_fleet::benchmarks;
+
+namespace {
+
+/// Samples taken from a reader at once to begin with, the window grows up
+/// to the maximum when the recorder falls behind
+constexpr size_t RecordTakeWindow = 32;
+
+constexpr size_t MaxRecordTakeWindow = 1024;
+
+struct Options
+{
+  std::string output;
+  double duration = 0.0;
+  int domain = 42;
+  std::string partition;
+
+  /// Topic names and QoS default to the ones of the server
+  ServerConfig config;
+};
+
+void print_usage(const char* _program)
+{
+  printf("Usage: %s --output FILE [options]\n", _program);
+  printf("  --output FILE         traffic log to write\n");
+  printf("  --duration S          stop after S seconds, 0 until interrupted "
+      "(0)\n");
+  printf("  --domain N            DDS domain (42)\n");
+  printf("  --partition NAME      DDS partition to record from (default)\n");
+  printf("  --robot-state-topic NAME\n");
+  printf("  --mode-request-topic NAME\n");
+  printf("  --path-request-topic NAME\n");
+  printf("  --destination-request-topic NAME\n");
+}
+
+bool parse_options(int argc, char** argv, Options& _options)
+{
+  for (int i = 1; i < argc; ++i)
+  {
+    const bool has_value = i + 1 < argc;
+    if (!strcmp(argv[i], "--output") && has_value)
+      _options.output = argv[++i];
+    else if (!strcmp(argv[i], "--duration") && has_value)
+      _options.duration = std::atof(argv[++i]);
+    else if (!strcmp(argv[i], "--domain") && has_value)
+      _options.domain = std::atoi(argv[++i]);
+    else if (!strcmp(argv[i], "--partition") && has_value)
+      _options.partition = argv[++i];
+    else if (!strcmp(argv[i], "--robot-state-topic") && has_value)
+      _options.config.dds_robot_state_topic = argv[++i];
+    else if (!strcmp(argv[i], "--mode-request-topic") && has_value)
+      _options.config.dds_mode_request_topic = argv[++i];
+    else if (!strcmp(argv[i], "--path-request-topic") && has_value)
+      _options.config.dds_path_request_topic = argv[++i];
+    else if (!strcmp(argv[i], "--destination-request-topic") && has_value)
+      _options.config.dds_destination_request_topic = argv[++i];
+    else
+      return false;
+  }
+  return !_options.output.empty();
+}
+
+std::atomic<bool> interrupted{false};
+
+void handle_signal(int)
+{
+  interrupted = true;
+}
+
+/// Records every sample of a single topic, converting it into its free fleet
+/// message so that it is stored in the same form it is replayed from.
+template <typename DDSMessage, typename Message>
+class TopicRecorder
+{
+public:
+
+  using SubscribeHandler =
+      dds::DDSSubscribeHandler<DDSMessage>;
+
+  TopicRecorder(
+      dds_entity_t _participant,
+      const dds_topic_descriptor_t* _topic_desc,
+      const std::string& _topic_name,
+      const TopicQoS& _qos,
+      const std::string& _partition,
+      RecordTopic _topic) :
+    topic(_topic)
+  {
+    dds_qos_t* qos = common::create_qos(_qos);
+    sub.reset(new SubscribeHandler(
+        _participant, _topic_desc, _topic_name, qos, _partition,
+        RecordTakeWindow, MaxRecordTakeWindow));
+    dds_delete_qos(qos);
+  }
+
+  bool is_ready() const
+  {
+    return sub->is_ready();
+  }
+
+  dds_entity_t get_reader() const
+  {
+    return sub->get_reader();
+  }
+
+  /// Called from the waitset thread only, which makes it the single writer
+  /// of the log
+  void take(TrafficLogWriter& _log, const Clock::time_point& _start)
+  {
+    auto samples = sub->take_loaned();
+    for (size_t i = 0; i < samples.size(); ++i)
+    {
+      if (!samples.valid(i))
+        continue;
+
+      const uint64_t time_ns = static_cast<uint64_t>(
+          std::chrono::duration_cast<std::chrono::nanoseconds>(
+              Clock::now() - _start).count());
+      messages::convert(samples[i], message);
+      payload.clear();
+      serialize(payload, message);
+      if (_log.write(topic, time_ns, payload))
+        ++recorded;
+    }
+  }
+
+  std::atomic<size_t> recorded{0};
+
+private:
+
+  typename SubscribeHandler::SharedPtr sub;
+
+  RecordTopic topic;
+
+  Message message;
+
+  std::vector<char> payload;
+};
+
+} // namespace anonymous
+
+int main(int argc, char** argv)
+{
+  Options options;
+  if (!parse_options(argc, argv, options))
+  {
+    print_usage(argv[0]);
+    return 1;
+  }
+
+  dds::DDSParticipant::SharedPtr participant =
+      dds::DDSParticipant::get(static_cast<dds_domainid_t>(options.domain));
+  if (!participant)
+    return 1;
+  const dds_entity_t entity = participant->get_entity();
+
+  TrafficLogWriter log(options.output);
+  if (!log.is_ready())
+  {
+    printf("failed to create %s\n", options.output.c_str());
+    return 1;
+  }
+
+  const ServerConfig& config = options.config;
+  TopicRecorder<FreeFleetData_RobotState, messages::RobotState>
+      robot_states(entity, &FreeFleetData_RobotState_desc,
+          config.dds_robot_state_topic, config.dds_robot_state_qos,
+          options.partition, RecordTopic::RobotState);
+  TopicRecorder<FreeFleetData_ModeRequest, messages::ModeRequest>
+      mode_requests(entity, &FreeFleetData_ModeRequest_desc,
+          config.dds_mode_request_topic, config.dds_mode_request_qos,
+          options.partition, RecordTopic::ModeRequest);
+  TopicRecorder<FreeFleetData_PathRequest, messages::PathRequest>
+      path_requests(entity, &FreeFleetData_PathRequest_desc,
+          config.dds_path_request_topic, config.dds_path_request_qos,
+          options.partition, RecordTopic::PathRequest);
+  TopicRecorder<FreeFleetData_DestinationRequest, messages::DestinationRequest>
+      destination_requests(entity, &FreeFleetData_DestinationRequest_desc,
+          config.dds_destination_request_topic,
+          config.dds_destination_request_qos,
+          options.partition, RecordTopic::DestinationRequest);
+
+  dds::DDSWaitSetHandler::SharedPtr waitset(
+      new dds::DDSWaitSetHandler(entity));
+  if (!robot_states.is_ready() ||
+      !mode_requests.is_ready() ||
+      !path_requests.is_ready() ||
+      !destination_requests.is_ready() ||
+      !waitset->is_ready())
+  {
+    printf("failed to create the readers\n");
+    return 1;
+  }
+
+  // Every reader is taken from the same waitset thread, so records are
+  // appended to the log one at a time and in the order they were taken
+  const auto start = Clock::now();
+  const bool attached =
+      waitset->attach(robot_states.get_reader(),
+          [&]() { robot_states.take(log, start); }) &&
+      waitset->attach(mode_requests.get_reader(),
+          [&]() { mode_requests.take(log, start); }) &&
+      waitset->attach(path_requests.get_reader(),
+          [&]() { path_requests.take(log, start); }) &&
+      waitset->attach(destination_requests.get_reader(),
+          [&]() { destination_requests.take(log, start); });
+  if (!attached)
+  {
+    printf("failed to attach the readers\n");
+    return 1;
+  }
+
+  std::signal(SIGINT, handle_signal);
+  std::signal(SIGTERM, handle_signal);
+  printf("recording into %s\n", options.output.c_str());
+
+  const auto end = start + std::chrono::duration_cast<Clock::duration>(
+      std::chrono::duration<double>(options.duration));
+  while (!interrupted && (options.duration <= 0.0 || Clock::now() < end))
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+  // The waitset thread has to be done with the log before it gets closed
+  waitset->stop();
+  log.close();
+
+  printf("recorded %zu robot states, %zu mode requests, %zu path requests, "
+      "%zu destination requests\n",
+      robot_states.recorded.load(), mode_requests.recorded.load(),
+      path_requests.recorded.load(), destination_requests.recorded.load());
+  printf("wrote %zu bytes\n", log.size());
+  return 0;
+}
@@ -0,0 +1,258 @@
+/*
+ * Copyright (C) 2019 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include <dds/dds.h>
+
+#include <free_fleet/ServerConfig.hpp>
+
+#include "../messages/FleetMessages.h"
+#include "../messages/message_utils.hpp"
+#include "../dds_utils/common.hpp"
+#include "../dds_utils/DDSParticipant.hpp"
+#include "../dds_utils/DDSPublishHandler.hpp"
+
+#include "benchmark_utils.hpp"
+#include "traffic_log.hpp"
+
+using namespace free_fleet;
+using namespace free_fleet::benchmarks;
+
+namespace {
+
+struct Options
+{
+  std::string input;
+
+  /// Playback rate relative to the recording, 0 replays every record as fast
+  /// as it can be written
+  double speed = 1.0;
+
+  size_t loops = 1;
+  int domain = 42;
+
+  /// Topic names and QoS default to the ones of the server
+  ServerConfig config;
+};
+
+void print_usage(const char* _program)
+{
+  printf("Usage: %s --input FILE [options]\n", _program);
+  printf("  --input FILE          traffic log to replay\n");
+  printf("  --speed X             playback rate, 0 for as fast as possible "
+      "(1.0)\n");
+  printf("  --loops N             number of times the log is replayed (1)\n");
+  printf("  --domain N            DDS domain (42)\n");
+  printf("  --robot-state-topic NAME\n");
+  printf("  --mode-request-topic NAME\n");
+  printf("  --path-request-topic NAME\n");
+  printf("  --destination-request-topic NAME\n");
+}
+
+bool parse_options(int argc, char** argv, Options& _options)
+{
+  for (int i = 1; i < argc; ++i)
+  {
+    const bool has_value = i + 1 < argc;
+    if (!strcmp(argv[i], "--input") && has_value)
+      _options.input = argv[++i];
+    else if (!strcmp(argv[i], "--speed") && has_value)
+      _options.speed = std::atof(argv[++i]);
+    else if (!strcmp(argv[i], "--loops") && has_value)
+      _options.loops = std::strtoul(argv[++i], NULL, 10);
+    else if (!strcmp(argv[i], "--domain") && has_value)
+      _options.domain = std::atoi(argv[++i]);
+    else if (!strcmp(argv[i], "--robot-state-topic") && has_value)
+      _options.config.dds_robot_state_topic = argv[++i];
+    else if (!strcmp(argv[i], "--mode-request-topic") && has_value)
+      _options.config.dds_mode_request_topic = argv[++i];
+    else if (!strcmp(argv[i], "--path-request-topic") && has_value)
+      _options.config.dds_path_request_topic = argv[++i];
+    else if (!strcmp(argv[i], "--destination-request-topic") && has_value)
+      _options.config.dds_destination_request_topic = argv[++i];
+    else
+      return false;
+  }
+  return !_options.input.empty() && _options.speed >= 0.0;
+}
+
+/// Publishes the records of a single topic, reusing the handler's sample and
+/// a single message between records.
+template <typename DDSMessage, typename Message>
+class TopicReplayer
+{
+public:
+
+  using PublishHandler = dds::DDSPublishHandler<DDSMessage>;
+
+  TopicReplayer(
+      dds_entity_t _participant,
+      const dds_topic_descriptor_t* _topic_desc,
+      const std::string& _topic_name,
+      const TopicQoS& _qos)
+  {
+    dds_qos_t* qos = common::create_qos(_qos);
+    pub.reset(new PublishHandler(_participant, _topic_desc, _topic_name, qos));
+    dds_delete_qos(qos);
+  }
+
+  bool is_ready() const
+  {
+    return pub->is_ready();
+  }
+
+  bool replay(const TrafficLogReader::Record& _record)
+  {
+    RecordReader reader(_record.payload, _record.header.size);
+    if (!deserialize(reader, message) || !reader.exhausted())
+    {
+      ++rejected;
+      return false;
+    }
+
+    auto sample = pub->lock_sample();
+    messages::convert(message, *sample);
+    if (!pub->write(sample.get()))
+      return false;
+    ++replayed;
+    return true;
+  }
+
+  size_t replayed = 0;
+
+  size_t rejected = 0;
+
+private:
+
+  typename PublishHandler::SharedPtr pub;
+
+  Message message;
+};
+
+} // namespace anonymous
+
+int main(int argc, char** argv)
+{
+  Options options;
+  if (!parse_options(argc, argv, options))
+  {
+    print_usage(argv[0]);
+    return 1;
+  }
+
+  TrafficLogReader log(options.input);
+  if (!log.is_ready())
+    return 1;
+
+  dds::DDSParticipant::SharedPtr participant =
+      dds::DDSParticipant::get(static_cast<dds_domainid_t>(options.domain));
+  if (!participant)
+    return 1;
+  const dds_entity_t entity = participant->get_entity();
+
+  const ServerConfig& config = options.config;
+  TopicReplayer<FreeFleetData_RobotState, messages::RobotState>
+      robot_states(entity, &FreeFleetData_RobotState_desc,
+          config.dds_robot_state_topic, config.dds_robot_state_qos);
+  TopicReplayer<FreeFleetData_ModeRequest, messages::ModeRequest>
+      mode_requests(entity, &FreeFleetData_ModeRequest_desc,
+          config.dds_mode_request_topic, config.dds_mode_request_qos);
+  TopicReplayer<FreeFleetData_PathRequest, messages::PathRequest>
+      path_requests(entity, &FreeFleetData_PathRequest_desc,
+          config.dds_path_request_topic, config.dds_path_request_qos);
+  TopicReplayer<FreeFleetData_DestinationRequest, messages::DestinationRequest>
+      destination_requests(entity, &FreeFleetData_DestinationRequest_desc,
+          config.dds_destination_request_topic,
+          config.dds_destination_request_qos);
+  if (!robot_states.is_ready() ||
+      !mode_requests.is_ready() ||
+      !path_requests.is_ready() ||
+      !destination_requests.is_ready())
+  {
+    printf("failed to create the writers\n");
+    return 1;
+  }
+
+  // Give the readers on the other end a moment to match with the new
+  // writers, otherwise the first records are published to nobody
+  std::this_thread::sleep_for(std::chrono::seconds(1));
+
+  size_t unknown = 0;
+  std::vector<double> lag_us;
+  const auto replay_start = Clock::now();
+  for (size_t loop = 0; loop < options.loops; ++loop)
+  {
+    log.rewind();
+    const auto loop_start = Clock::now();
+    TrafficLogReader::Record record;
+    while (log.next(record))
+    {
+      if (options.speed > 0.0)
+      {
+        const auto due = loop_start +
+            std::chrono::duration_cast<Clock::duration>(
+                std::chrono::duration<double, std::nano>(
+                    record.header.time_ns / options.speed));
+        std::this_thread::sleep_until(due);
+        lag_us.push_back(elapsed_us(due, Clock::now()));
+      }
+
+      switch (record.header.topic)
+      {
+        case RecordTopic::RobotState:
+          robot_states.replay(record);
+          break;
+        case RecordTopic::ModeRequest:
+          mode_requests.replay(record);
+          break;
+        case RecordTopic::PathRequest:
+          path_requests.replay(record);
+          break;
+        case RecordTopic::DestinationRequest:
+          destination_requests.replay(record);
+          break;
+        default:
+          ++unknown;
+          break;
+      }
+    }
+  }
+  const double total_us = elapsed_us(replay_start, Clock::now());
+
+  const size_t replayed = robot_states.replayed + mode_requests.replayed +
+      path_requests.replayed + destination_requests.replayed;
+  const size_t rejected = robot_states.rejected + mode_requests.rejected +
+      path_requests.rejected + destination_requests.rejected;
+  printf("replayed %zu robot states, %zu mode requests, %zu path requests, "
+      "%zu destination requests\n",
+      robot_states.replayed, mode_requests.replayed, path_requests.replayed,
+      destination_requests.replayed);
+  printf("rejected %zu malformed and %zu unknown records\n",
+      rejected, unknown);
+  printf("%.0f records/s over %.2f s\n",
+      total_us > 0.0 ? replayed / (total_us / 1e6) : 0.0, total_us / 1e6);
+  if (options.speed > 0.0)
+    print_percentiles("lag behind the recorded timing", lag_us);
+  return 0;
+}
@@ -24,13 +24,60 @@ namespace free_fleet {
 void ClientConfig::print_config() const
 {
   printf("CLIENT-SERVER DDS CONFIGURATION\n");
+  printf("  fleet name: %s\n", fleet_name.c_str());
+  printf("  robot name: %s\n", robot_name.c_str());
   printf("  dds domain: %d\n", dds_domain);
+  printf("  dds partition: %s\n",
+      dds_partition.empty() ? "default" : dds_partition.c_str());
+  printf("  per-robot request partitions: %s\n",
+      dds_request_partitions ? "enabled" : "disabled");
+  printf("  shared memory: %s\n",
+      dds_shared_memory ? "enabled" : "disabled");
+  printf("  discovery: %s\n", dds_discovery.to_string().c_str());
+  printf("  dds threads: %s\n", dds_threads.to_string().c_str());
+  printf("  threads: %s\n", threads.to_string().c_str());
+  printf("  robot registration: %s\n",
+      robot_registration ? "enabled" : "disabled");
+  printf("  time sync: %s\n", time_sync ? "enabled" : "disabled");
+  printf("  request acks: %s\n", request_acks ? "enabled" : "disabled");
+  if (split_robot_state)
+    printf("  split robot state: battery tolerance %.1f%%\n",
+        metadata_battery_tolerance);
+  else
+    printf("  split robot state: disabled\n");
+  if (path_simplification_tolerance > 0.0)
+    printf("  path simplification tolerance: %.3f m, %.3f rad\n",
+        path_simplification_tolerance, path_simplification_yaw_tolerance);
+  else
+    printf("  path simplification: disabled\n");
+  if (path_packing_threshold > 0)
+    printf("  path packing: from %zu waypoints\n", path_packing_threshold);
+  else
+    printf("  path packing: disabled\n");
   printf("  TOPICS\n");
   printf("    robot state: %s\n", dds_state_topic.c_str());
   printf("    mode request: %s\n", dds_mode_request_topic.c_str());
   printf("    path request: %s\n", dds_path_request_topic.c_str());
   printf("    destination request: %s\n", 
       dds_destination_request_topic.c_str());
+  printf("    registration: %s\n", dds_registration_topic.c_str());
+  printf("    registration ack: %s\n", dds_registration_ack_topic.c_str());
+  printf("    time sync ping: %s\n", dds_time_sync_ping_topic.c_str());
+  printf("    time sync pong: %s\n", dds_time_sync_pong_topic.c_str());
+  printf("    pose: %s\n", dds_pose_topic.c_str());
+  printf("    metadata: %s\n", dds_metadata_topic.c_str());
+  printf("    request ack: %s\n", dds_request_ack_topic.c_str());
+  printf("  QOS\n");
+  printf("    robot state: %s\n", dds_state_qos.to_string().c_str());
+  printf("    mode request: %s\n", dds_mode_request_qos.to_string().c_str());
+  printf("    path request: %s\n", dds_path_request_qos.to_string().c_str());
+  printf("    destination request: %s\n",
+      dds_destination_request_qos.to_string().c_str());
+  printf("    registration: %s\n", dds_registration_qos.to_string().c_str());
+  printf("    time sync: %s\n", dds_time_sync_qos.to_string().c_str());
+  printf("    pose: %s\n", dds_pose_qos.to_string().c_str());
+  printf("    metadata: %s\n", dds_metadata_qos.to_string().c_str());
+  printf("    request ack: %s\n", dds_request_ack_qos.to_string().c_str());
 }
 
 } // namespace free_fleet
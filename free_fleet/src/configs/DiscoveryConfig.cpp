@@ -0,0 +1,76 @@
+/*
+ * Copyright (C) 2019 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#include <free_fleet/DiscoveryConfig.hpp>
+
+#include <cstdio>
+
+namespace free_fleet {
+
+namespace {
+
+const char* mode_name(DiscoveryConfig::Mode _mode)
+{
+  switch (_mode)
+  {
+    case DiscoveryConfig::Mode::Multicast:
+      return "multicast";
+    case DiscoveryConfig::Mode::SpdpMulticast:
+      return "spdp_multicast";
+    case DiscoveryConfig::Mode::Unicast:
+      return "unicast";
+    default:
+      return "default";
+  }
+}
+
+} // namespace anonymous
+
+bool DiscoveryConfig::is_default() const
+{
+  return mode == Mode::Default && peers.empty() &&
+      network_interface.empty() && spdp_interval <= 0.0;
+}
+
+std::string DiscoveryConfig::to_string() const
+{
+  char buffer[160];
+  snprintf(
+      buffer, sizeof(buffer),
+      "mode %s, %zu peers, interface %s, spdp interval %.3fs",
+      mode_name(mode),
+      peers.size(),
+      network_interface.empty() ? "auto" : network_interface.c_str(),
+      spdp_interval);
+  return std::string(buffer);
+}
+
+bool DiscoveryConfig::parse_mode(const std::string& _name, Mode& _mode)
+{
+  for (Mode mode :
+      {Mode::Default, Mode::Multicast, Mode::SpdpMulticast, Mode::Unicast})
+  {
+    if (_name == mode_name(mode))
+    {
+      _mode = mode;
+      return true;
+    }
+  }
+  return false;
+}
+
+} // namespace free_fleet
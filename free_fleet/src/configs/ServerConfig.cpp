@@ -24,13 +24,78 @@ namespace free_fleet {
 void ServerConfig::print_config() const
 {
   printf("SERVER-CLIENT DDS CONFIGURATION\n");
+  printf("  fleet name: %s\n", fleet_name.c_str());
   printf("  dds domain: %d\n", dds_domain);
+  printf("  dds partition: %s\n",
+      dds_partition.empty() ? "default" : dds_partition.c_str());
+  for (size_t i = 0; i < shards.size(); ++i)
+    printf("  shard %zu: dds domain %d, dds partition %s\n", i,
+        shards[i].dds_domain,
+        shards[i].dds_partition.empty() ?
+            "default" : shards[i].dds_partition.c_str());
+  printf("  per-robot request partitions: %s\n",
+      dds_request_partitions ? "enabled" : "disabled");
+  printf("  writer batching: %s\n",
+      dds_write_batching ? "enabled" : "disabled");
+  printf("  shared memory: %s\n",
+      dds_shared_memory ? "enabled" : "disabled");
+  printf("  discovery: %s\n", dds_discovery.to_string().c_str());
+  printf("  dds threads: %s\n", dds_threads.to_string().c_str());
+  printf("  threads: %s\n", threads.to_string().c_str());
+  printf("  send queue: capacity %zu, %s\n", send_queue_capacity,
+      send_queue_policy == SendQueuePolicy::CoalescePerRobot ?
+          "coalesce per robot" : "drop oldest");
+  printf("  ingest threads: %zu\n", ingest_threads);
+  printf("  take window: %zu, growing up to %zu\n",
+      robot_state_take_window, max_take_window);
+  printf("  robot expiry timeout (seconds): %.1f\n", robot_expiry_timeout);
+  printf("  fleet state period (seconds): %.1f\n", fleet_state_period);
+  printf("  incremental path requests: %s\n",
+      incremental_path_requests ? "enabled" : "disabled");
+  if (path_packing_threshold > 0)
+    printf("  path packing: from %zu waypoints\n", path_packing_threshold);
+  else
+    printf("  path packing: disabled\n");
+  printf("  split robot states: %s\n",
+      split_robot_states ? "enabled" : "disabled");
+  printf("  time sync period (seconds): %.1f\n", time_sync_period);
+  if (request_retry_timeout > 0.0)
+    printf("  request retries: after %.1f s, backing off up to %.1f s, "
+        "at most %zu\n", request_retry_timeout, request_retry_max_timeout,
+        request_max_retries);
+  else
+    printf("  request retries: disabled\n");
+  printf("  robot state history capacity: %zu\n",
+      robot_state_history_capacity);
+  printf("  spatial index cell size (meters): %.1f\n",
+      spatial_index_cell_size);
   printf("  TOPICS\n");
   printf("    robot state: %s\n", dds_robot_state_topic.c_str());
   printf("    mode request: %s\n", dds_mode_request_topic.c_str());
   printf("    path request: %s\n", dds_path_request_topic.c_str());
   printf("    destination request: %s\n", 
       dds_destination_request_topic.c_str());
+  printf("    fleet state: %s\n", dds_fleet_state_topic.c_str());
+  printf("    registration: %s\n", dds_registration_topic.c_str());
+  printf("    registration ack: %s\n", dds_registration_ack_topic.c_str());
+  printf("    time sync ping: %s\n", dds_time_sync_ping_topic.c_str());
+  printf("    time sync pong: %s\n", dds_time_sync_pong_topic.c_str());
+  printf("    robot pose: %s\n", dds_robot_pose_topic.c_str());
+  printf("    robot metadata: %s\n", dds_robot_metadata_topic.c_str());
+  printf("    request ack: %s\n", dds_request_ack_topic.c_str());
+  printf("  QOS\n");
+  printf("    robot state: %s\n", dds_robot_state_qos.to_string().c_str());
+  printf("    mode request: %s\n", dds_mode_request_qos.to_string().c_str());
+  printf("    path request: %s\n", dds_path_request_qos.to_string().c_str());
+  printf("    destination request: %s\n",
+      dds_destination_request_qos.to_string().c_str());
+  printf("    fleet state: %s\n", dds_fleet_state_qos.to_string().c_str());
+  printf("    registration: %s\n", dds_registration_qos.to_string().c_str());
+  printf("    time sync: %s\n", dds_time_sync_qos.to_string().c_str());
+  printf("    robot pose: %s\n", dds_robot_pose_qos.to_string().c_str());
+  printf("    robot metadata: %s\n",
+      dds_robot_metadata_qos.to_string().c_str());
+  printf("    request ack: %s\n", dds_request_ack_qos.to_string().c_str());
 }
 
 } // namespace free_fleet
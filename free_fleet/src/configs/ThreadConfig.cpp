@@ -0,0 +1,87 @@
+/*
+ * Copyright (C) 2019 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#include <free_fleet/ThreadConfig.hpp>
+
+#include <sched.h>
+#include <pthread.h>
+
+#include <cstdio>
+#include <cstring>
+
+#include <dds/dds.h>
+
+namespace free_fleet {
+
+bool ThreadConfig::is_default() const
+{
+  return cpus.empty() && fifo_priority <= 0;
+}
+
+bool ThreadConfig::apply(const char* _name) const
+{
+  bool applied = true;
+  if (!cpus.empty())
+  {
+    cpu_set_t cpu_set;
+    CPU_ZERO(&cpu_set);
+    for (int cpu : cpus)
+    {
+      if (cpu >= 0 && cpu < CPU_SETSIZE)
+        CPU_SET(cpu, &cpu_set);
+    }
+    const int error =
+        pthread_setaffinity_np(pthread_self(), sizeof(cpu_set), &cpu_set);
+    if (error != 0)
+    {
+      DDS_WARNING("unable to pin the %s thread to its cpus: %s\n",
+          _name, strerror(error));
+      applied = false;
+    }
+  }
+
+  if (fifo_priority > 0)
+  {
+    sched_param param;
+    param.sched_priority = fifo_priority;
+    const int error = pthread_setschedparam(pthread_self(), SCHED_FIFO, &param);
+    if (error != 0)
+    {
+      DDS_WARNING("unable to set SCHED_FIFO priority %d for the %s thread: "
+          "%s\n", fifo_priority, _name, strerror(error));
+      applied = false;
+    }
+  }
+  return applied;
+}
+
+std::string ThreadConfig::to_string() const
+{
+  std::string cpu_list;
+  for (int cpu : cpus)
+    cpu_list += (cpu_list.empty() ? "" : ",") + std::to_string(cpu);
+
+  char buffer[64];
+  if (fifo_priority > 0)
+    snprintf(buffer, sizeof(buffer), "SCHED_FIFO %d", fifo_priority);
+  else
+    snprintf(buffer, sizeof(buffer), "default scheduling");
+  return "cpus " + (cpu_list.empty() ? std::string("any") : cpu_list) +
+      ", " + buffer;
+}
+
+} // namespace free_fleet
@@ -0,0 +1,79 @@
+/*
+ * Copyright (C) 2019 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#include <free_fleet/TopicQoS.hpp>
+
+#include <cstdio>
+
+namespace free_fleet {
+
+TopicQoS TopicQoS::best_effort()
+{
+  TopicQoS qos;
+  qos.reliable = false;
+  qos.history_depth = 1;
+  return qos;
+}
+
+TopicQoS TopicQoS::reliable_requests()
+{
+  // Requests are not keyed, a deeper history makes sure that a burst of 
+  // requests for different robots does not overwrite each other before being
+  // acknowledged.
+  TopicQoS qos;
+  qos.reliable = true;
+  qos.history_depth = 10;
+  return qos;
+}
+
+TopicQoS TopicQoS::urgent_requests()
+{
+  // Samples go out as soon as they are written, and ahead of the samples of
+  // the other writers
+  TopicQoS qos = reliable_requests();
+  qos.latency_budget = 0.0;
+  qos.transport_priority = 100;
+  return qos;
+}
+
+TopicQoS TopicQoS::latest_state()
+{
+  TopicQoS qos;
+  qos.reliable = true;
+  qos.history_depth = 1;
+  qos.transient_local = true;
+  return qos;
+}
+
+std::string TopicQoS::to_string() const
+{
+  char buffer[160];
+  snprintf(
+      buffer, sizeof(buffer),
+      "%s, %s, %s, deadline %.3fs, budget %.3fs, lease %.3fs, priority %d",
+      reliable ? "reliable" : "best effort",
+      history_depth > 0 ? 
+          ("depth " + std::to_string(history_depth)).c_str() : "keep all",
+      transient_local ? "transient local" : "volatile",
+      deadline,
+      latency_budget,
+      liveliness_lease,
+      transport_priority);
+  return std::string(buffer);
+}
+
+} // namespace free_fleet
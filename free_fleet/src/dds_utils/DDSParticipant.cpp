@@ -0,0 +1,161 @@
+/*
+ * Copyright (C) 2019 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#include <map>
+#include <mutex>
+#include <cstdlib>
+#include <cstring>
+
+#include <sched.h>
+#include <pthread.h>
+
+#include "DDSParticipant.hpp"
+
+namespace free_fleet {
+namespace dds {
+
+namespace {
+
+std::mutex registry_mutex;
+
+std::map<dds_domainid_t, std::weak_ptr<DDSParticipant>> registry;
+
+/// CycloneDDS has no setting for the CPUs of its threads, which inherit the
+/// CPUs of the thread that starts them instead. The calling thread is pinned
+/// to the given CPUs for as long as this is around, and gets its own CPUs
+/// back afterwards.
+class ThreadCpusScope
+{
+public:
+
+  ThreadCpusScope(const std::vector<int>& _cpus)
+  {
+    if (_cpus.empty())
+      return;
+
+    if (pthread_getaffinity_np(
+        pthread_self(), sizeof(previous_cpus), &previous_cpus) != 0)
+      return;
+
+    cpu_set_t cpus;
+    CPU_ZERO(&cpus);
+    for (int cpu : _cpus)
+    {
+      if (cpu >= 0 && cpu < CPU_SETSIZE)
+        CPU_SET(cpu, &cpus);
+    }
+    const int error =
+        pthread_setaffinity_np(pthread_self(), sizeof(cpus), &cpus);
+    if (error != 0)
+    {
+      DDS_WARNING("unable to pin the DDS threads to their cpus: %s\n",
+          strerror(error));
+      return;
+    }
+    pinned = true;
+  }
+
+  ~ThreadCpusScope()
+  {
+    if (pinned)
+      pthread_setaffinity_np(
+          pthread_self(), sizeof(previous_cpus), &previous_cpus);
+  }
+
+private:
+
+  cpu_set_t previous_cpus;
+
+  bool pinned = false;
+};
+
+} // namespace anonymous
+
+DDSParticipant::SharedPtr DDSParticipant::get(
+    dds_domainid_t _domain, const std::string& _config,
+    const std::vector<int>& _dds_thread_cpus)
+{
+  std::lock_guard<std::mutex> lock(registry_mutex);
+  SharedPtr participant = registry[_domain].lock();
+  if (participant)
+  {
+    if (participant->config != _config)
+      DDS_WARNING("participant of domain %d already exists with another "
+          "configuration, keeping it\n", static_cast<int>(_domain));
+    return participant;
+  }
+
+  // The threads of the domain are started along with it, or with its first
+  // participant when it is left to its existing configuration
+  ThreadCpusScope thread_cpus(_dds_thread_cpus);
+
+  // Later configuration fragments override earlier ones, so the user's own
+  // configuration is kept and only the given settings are changed
+  dds_entity_t domain = 0;
+  if (!_config.empty())
+  {
+    std::string config = _config;
+    const char* uri = std::getenv("CYCLONEDDS_URI");
+    if (uri && uri[0] != '\0')
+      config = std::string(uri) + "," + config;
+
+    domain = dds_create_domain(_domain, config.c_str());
+    if (domain < 0)
+    {
+      DDS_WARNING("dds_create_domain: %s, the domain keeps its existing "
+          "configuration\n", dds_strretcode(-domain));
+      domain = 0;
+    }
+  }
+
+  dds_entity_t entity = dds_create_participant(_domain, NULL, NULL);
+  if (entity < 0)
+  {
+    DDS_FATAL("dds_create_participant: %s\n", dds_strretcode(-entity));
+    if (domain > 0)
+      dds_delete(domain);
+    return nullptr;
+  }
+
+  participant = SharedPtr(new DDSParticipant(entity, domain, _config));
+  registry[_domain] = participant;
+  return participant;
+}
+
+DDSParticipant::DDSParticipant(
+    dds_entity_t _entity, dds_entity_t _domain, const std::string& _config) :
+  entity(_entity),
+  domain(_domain),
+  config(_config)
+{}
+
+DDSParticipant::~DDSParticipant()
+{
+  dds_return_t return_code = dds_delete(entity);
+  if (return_code != DDS_RETCODE_OK)
+  {
+    DDS_FATAL("dds_delete: %s", dds_strretcode(-return_code));
+  }
+
+  // The domain goes along with the participant so that the next participant
+  // of the domain gets created with its own configuration
+  if (domain > 0)
+    dds_delete(domain);
+}
+
+} // namespace dds
+} // namespace free_fleet
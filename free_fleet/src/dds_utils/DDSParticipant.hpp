@@ -0,0 +1,88 @@
+/*
+ * Copyright (C) 2019 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#ifndef FREE_FLEET__SRC__DDS_UTILS__DDSPARTICIPANT_HPP
+#define FREE_FLEET__SRC__DDS_UTILS__DDSPARTICIPANT_HPP
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <dds/dds.h>
+
+namespace free_fleet {
+namespace dds {
+
+/// DDS participant shared by everything within the process that uses the
+/// same domain, the participant gets deleted once the last user lets go of
+/// it. Users are in charge of deleting the entities they create under it.
+class DDSParticipant
+{
+public:
+
+  using SharedPtr = std::shared_ptr<DDSParticipant>;
+
+  /// Gets the participant of the domain, creating it if this process does
+  /// not have one yet. Returns nullptr if the participant could not be
+  /// created.
+  ///
+  /// \param[in] domain
+  ///   DDS domain of the participant.
+  /// \param[in] config
+  ///   CycloneDDS configuration that the domain is created with, on top of
+  ///   the configuration found in CYCLONEDDS_URI, see common::domain_config.
+  ///   This only takes effect when the participant gets created, an existing
+  ///   participant is shared as is.
+  /// \param[in] dds_thread_cpus
+  ///   CPUs that the threads DDS starts for the domain are pinned to, any
+  ///   CPU if empty. Like the config, this only takes effect when the
+  ///   participant gets created.
+  static SharedPtr get(
+      dds_domainid_t domain, const std::string& config = std::string(),
+      const std::vector<int>& dds_thread_cpus = std::vector<int>());
+
+  dds_entity_t get_entity() const
+  {
+    return entity;
+  }
+
+  const std::string& get_config() const
+  {
+    return config;
+  }
+
+  ~DDSParticipant();
+
+private:
+
+  DDSParticipant(
+      dds_entity_t entity, dds_entity_t domain, const std::string& config);
+
+  dds_entity_t entity;
+
+  /// Domain created along with the participant, 0 if the participant is on
+  /// a domain that it did not create itself
+  dds_entity_t domain;
+
+  std::string config;
+
+};
+
+} // namespace dds
+} // namespace free_fleet
+
+#endif // FREE_FLEET__SRC__DDS_UTILS__DDSPARTICIPANT_HPP
@@ -18,7 +18,11 @@
 #ifndef FREE_FLEET__SRC__DDS_UTILS__DDSPUBLISHHANDLER_HPP
 #define FREE_FLEET__SRC__DDS_UTILS__DDSPUBLISHHANDLER_HPP
 
+#include <map>
+#include <mutex>
 #include <memory>
+#include <string>
+#include <vector>
 
 #include <dds/dds.h>
 
@@ -32,6 +36,40 @@ public:
 
   using SharedPtr = std::shared_ptr<DDSPublishHandler>;
 
+  /// Exclusive access to the sample that is kept alive by the handler, its
+  /// strings and sequences are left allocated between writes so that they can
+  /// be reused by the next conversion into it.
+  class LockedSample
+  {
+  public:
+
+    LockedSample(Message* _sample, std::mutex& _mutex) :
+      lock(_mutex),
+      sample(_sample)
+    {}
+
+    Message* get()
+    {
+      return sample;
+    }
+
+    Message& operator*()
+    {
+      return *sample;
+    }
+
+    Message* operator->()
+    {
+      return sample;
+    }
+
+  private:
+
+    std::unique_lock<std::mutex> lock;
+
+    Message* sample;
+  };
+
 private:
 
   dds_return_t return_code;
@@ -40,20 +78,98 @@ private:
 
   dds_entity_t topic;
 
+  /// Publisher that the default writer was created under, only when
+  /// publishing into a partition
+  dds_entity_t publisher;
+
   dds_entity_t writer;
 
+  dds_entity_t participant;
+
+  /// QoS used for creating every writer of this handler
+  dds_qos_t* writer_qos;
+
+  /// Publisher and writer pairs that only publish into a single partition
+  struct PartitionWriter
+  {
+    dds_entity_t publisher;
+
+    dds_entity_t writer;
+  };
+
+  std::map<std::string, PartitionWriter> partition_writers;
+
+  /// Partition writers that were written to without being flushed
+  std::vector<dds_entity_t> unflushed_writers;
+
+  std::mutex partition_writers_mutex;
+
+  /// Sample that gets reused for every write, freed with the handler
+  Message* sample;
+
+  std::mutex sample_mutex;
+
   bool ready;
 
+  /// Gets the writer that publishes into the partition, creating it if it
+  /// does not exist yet. Returns a negative entity on failure.
+  dds_entity_t get_partition_writer(const std::string& _partition)
+  {
+    std::lock_guard<std::mutex> lock(partition_writers_mutex);
+    auto it = partition_writers.find(_partition);
+    if (it != partition_writers.end())
+      return it->second.writer;
+
+    dds_qos_t* publisher_qos = dds_create_qos();
+    dds_qset_partition1(publisher_qos, _partition.c_str());
+    dds_entity_t publisher =
+        dds_create_publisher(participant, publisher_qos, NULL);
+    dds_delete_qos(publisher_qos);
+    if (publisher < 0)
+    {
+      DDS_FATAL("dds_create_publisher: %s\n", dds_strretcode(-publisher));
+      return publisher;
+    }
+
+    dds_entity_t new_writer =
+        dds_create_writer(publisher, topic, writer_qos, NULL);
+    if (new_writer < 0)
+    {
+      DDS_FATAL("dds_create_writer: %s\n", dds_strretcode(-new_writer));
+      dds_delete(publisher);
+      return new_writer;
+    }
+
+    partition_writers[_partition] = PartitionWriter{publisher, new_writer};
+    return new_writer;
+  }
+
 public:
 
   DDSPublishHandler(
       const dds_entity_t& _participant,
       const dds_topic_descriptor_t* _topic_desc,
-      const std::string& _topic_name) :
-    topic_desc(_topic_desc)
+      const std::string& _topic_name,
+      const dds_qos_t* _qos = nullptr,
+      const std::string& _partition = "") :
+    topic_desc(_topic_desc),
+    topic(0),
+    publisher(0),
+    writer(0),
+    participant(_participant)
   {
     ready = false;
 
+    // dds_alloc zeroes the sample, leaving every string and sequence empty
+    sample = static_cast<Message*>(dds_alloc(sizeof(Message)));
+
+    // Writers are best effort unless the caller provides its own QoS
+    writer_qos = dds_create_qos();
+    if (_qos)
+      dds_copy_qos(writer_qos, _qos);
+    else
+      dds_qset_reliability(writer_qos, DDS_RELIABILITY_BEST_EFFORT, 0);
+
     topic = dds_create_topic(
         _participant, _topic_desc, _topic_name.c_str(), NULL, NULL);
     if (topic < 0)
@@ -62,28 +178,75 @@ public:
       return;
     }
 
-    dds_qos_t* qos = dds_create_qos();
-    dds_qset_reliability(qos, DDS_RELIABILITY_BEST_EFFORT, 0);
-    writer = dds_create_writer(_participant, topic, qos, NULL);
+    // The default writer only publishes into a single partition when one is
+    // provided, otherwise it is created directly under the participant, in
+    // the default partition
+    dds_entity_t writer_parent = _participant;
+    if (!_partition.empty())
+    {
+      dds_qos_t* publisher_qos = dds_create_qos();
+      dds_qset_partition1(publisher_qos, _partition.c_str());
+      publisher = dds_create_publisher(_participant, publisher_qos, NULL);
+      dds_delete_qos(publisher_qos);
+      if (publisher < 0)
+      {
+        DDS_FATAL("dds_create_publisher: %s\n", dds_strretcode(-publisher));
+        return;
+      }
+      writer_parent = publisher;
+    }
+
+    writer = dds_create_writer(writer_parent, topic, writer_qos, NULL);
     if (writer < 0)
     {
       DDS_FATAL("dds_create_writer: %s\n", dds_strretcode(-writer));
       return;
     }
-    dds_delete_qos(qos);
 
     ready = true;
   }
 
+  /// Deletes the entities created by this handler, the participant may be
+  /// shared with other handlers and is left alone. Entities that were already
+  /// deleted along with their participant are skipped over.
   ~DDSPublishHandler()
-  {}
+  {
+    for (const auto& partition_writer : partition_writers)
+      dds_delete(partition_writer.second.publisher);
+
+    if (publisher > 0)
+      dds_delete(publisher);
+    else if (writer > 0)
+      dds_delete(writer);
+
+    if (topic > 0)
+      dds_delete(topic);
+
+    dds_sample_free(sample, topic_desc, DDS_FREE_ALL);
+    dds_delete_qos(writer_qos);
+  }
 
   bool is_ready()
   {
     return ready;
   }
 
-  bool write(Message* msg)
+  /// Locks and returns the reusable sample of this handler. Messages
+  /// converted into it only allocate when they need more string or sequence
+  /// capacity than any message converted before.
+  LockedSample lock_sample()
+  {
+    return LockedSample(sample, sample_mutex);
+  }
+
+  /// Writes the message into the default partition.
+  ///
+  /// \param[in] flush
+  ///   When writer batching is enabled through dds_write_set_batch, samples
+  ///   are queued up until the writer gets flushed. Setting this to false
+  ///   allows several messages to be written back to back before calling
+  ///   flush once.
+  bool write(Message* msg, bool flush = true)
   {
     return_code = dds_write(writer, msg);
     if (return_code != DDS_RETCODE_OK)
@@ -91,9 +254,59 @@ public:
       DDS_FATAL("dds_write failed: %s", dds_strretcode(-return_code));
       return false;
     }
+    if (flush)
+      dds_write_flush(writer);
     return true;
   }
 
+  /// Writes the message only into the given partition, so that only readers
+  /// subscribed to that partition will receive it. Writers for each partition
+  /// are created the first time they are needed.
+  bool write(Message* msg, const std::string& partition, bool flush = true)
+  {
+    dds_entity_t partition_writer = get_partition_writer(partition);
+    if (partition_writer < 0)
+      return false;
+
+    dds_return_t partition_return_code = dds_write(partition_writer, msg);
+    if (partition_return_code != DDS_RETCODE_OK)
+    {
+      DDS_FATAL(
+          "dds_write failed: %s", dds_strretcode(-partition_return_code));
+      return false;
+    }
+
+    if (flush)
+    {
+      dds_write_flush(partition_writer);
+    }
+    else
+    {
+      std::lock_guard<std::mutex> lock(partition_writers_mutex);
+      unflushed_writers.push_back(partition_writer);
+    }
+    return true;
+  }
+
+  /// Sends out everything that was written without being flushed, on the
+  /// default writer as well as on all the partition writers.
+  void flush()
+  {
+    dds_write_flush(writer);
+
+    std::lock_guard<std::mutex> lock(partition_writers_mutex);
+    for (const dds_entity_t& unflushed_writer : unflushed_writers)
+      dds_write_flush(unflushed_writer);
+    unflushed_writers.clear();
+  }
+
+  /// Creates the writer for the partition ahead of time, giving it time to
+  /// be discovered by remote readers before anything gets written into it.
+  bool prepare_partition(const std::string& partition)
+  {
+    return get_partition_writer(partition) >= 0;
+  }
+
 };
 
 } // namespace dds
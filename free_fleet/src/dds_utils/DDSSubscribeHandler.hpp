@@ -19,20 +19,154 @@
 #define FREE_FLEET__SRC__DDS_UTILS__DDSSUBSCRIBEHANDLER_HPP
 
 #include <memory>
+#include <string>
 #include <vector>
+#include <algorithm>
 
 #include <dds/dds.h>
 
 namespace free_fleet {
 namespace dds {
 
-template <typename Message, size_t MaxSamplesNum = 1>
+/// Takes samples from a reader a window at a time. The window starts out at
+/// the size given to the handler, and doubles up to the maximum size every
+/// time a take fills it up, so that readers that keep up with more samples
+/// than expected take them in fewer, larger takes. A handler is only taken
+/// from by one thread at a time.
+template <typename Message>
 class DDSSubscribeHandler
 {
+private:
+
+  /// Sample infos and the matching sample pointers of a single take, out of
+  /// a single allocation
+  class TakeBuffer
+  {
+  public:
+
+    TakeBuffer() = default;
+
+    explicit TakeBuffer(size_t _capacity) :
+      capacity(_capacity),
+      storage(new unsigned char[
+          _capacity * (sizeof(dds_sample_info_t) + sizeof(void*))])
+    {
+      // The infos come first, their alignment covers the pointers after them
+      infos = reinterpret_cast<dds_sample_info_t*>(storage.get());
+      samples = reinterpret_cast<void**>(
+          storage.get() + _capacity * sizeof(dds_sample_info_t));
+      std::fill_n(samples, _capacity, nullptr);
+    }
+
+    size_t capacity = 0;
+
+    std::unique_ptr<unsigned char[]> storage;
+
+    dds_sample_info_t* infos = nullptr;
+
+    void** samples = nullptr;
+  };
+
 public:
 
   using SharedPtr = std::shared_ptr<DDSSubscribeHandler>;
 
+  /// RAII view over samples that were loaned from the reader's own cache
+  /// through take_loaned. The samples are read in place, and the loan is
+  /// returned to the reader when this goes out of scope, and its buffer to
+  /// the handler, which needs to outlive it. Samples must not be accessed
+  /// once the view has been destroyed.
+  class LoanedSamples
+  {
+  public:
+
+    LoanedSamples(LoanedSamples&& _other) :
+      handler(_other.handler),
+      reader(_other.reader),
+      count(_other.count),
+      buffer(std::move(_other.buffer))
+    {
+      _other.handler = nullptr;
+      _other.count = 0;
+    }
+
+    LoanedSamples(const LoanedSamples&) = delete;
+
+    LoanedSamples& operator=(const LoanedSamples&) = delete;
+
+    LoanedSamples& operator=(LoanedSamples&&) = delete;
+
+    ~LoanedSamples()
+    {
+      if (count > 0)
+      {
+        dds_return_t return_code = dds_return_loan(
+            reader, buffer.samples, static_cast<int32_t>(count));
+        if (return_code != DDS_RETCODE_OK)
+        {
+          DDS_FATAL("dds_return_loan: %s\n", dds_strretcode(-return_code));
+        }
+      }
+
+      if (handler)
+        handler->reclaim_take_buffer(std::move(buffer));
+    }
+
+    /// Number of samples taken, including samples without valid data
+    size_t size() const
+    {
+      return count;
+    }
+
+    /// Whether the take filled up its whole window, in which case the reader
+    /// may still be holding on to more samples
+    bool full() const
+    {
+      return count > 0 && count == buffer.capacity;
+    }
+
+    /// Checks if the sample at the index carries data, samples that only
+    /// carry instance state changes do not.
+    bool valid(size_t _index) const
+    {
+      return buffer.infos[_index].valid_data;
+    }
+
+    const Message& operator[](size_t _index) const
+    {
+      return *static_cast<const Message*>(buffer.samples[_index]);
+    }
+
+    const dds_sample_info_t& info(size_t _index) const
+    {
+      return buffer.infos[_index];
+    }
+
+  private:
+
+    friend class DDSSubscribeHandler;
+
+    LoanedSamples(
+        DDSSubscribeHandler* _handler,
+        dds_entity_t _reader,
+        TakeBuffer&& _buffer) :
+      handler(_handler),
+      reader(_reader),
+      count(0),
+      buffer(std::move(_buffer))
+    {}
+
+    /// Handler that lent the buffer, which gets it back once the loan is
+    /// returned
+    DDSSubscribeHandler* handler;
+
+    dds_entity_t reader;
+
+    size_t count;
+
+    TakeBuffer buffer;
+  };
+
 private:
 
   dds_return_t return_code;
@@ -40,24 +174,92 @@ private:
   const dds_topic_descriptor_t* topic_desc;
 
   dds_entity_t topic;
+
+  /// Subscriber that the reader was created under, only when subscribed to a
+  /// partition
+  dds_entity_t subscriber;
   
   dds_entity_t reader;
-  
-  std::array<std::shared_ptr<Message>, MaxSamplesNum> shared_msgs;
 
-  void* samples[MaxSamplesNum];
+  size_t take_window;
+
+  size_t max_take_window;
+
+  /// Samples that read takes into, a single block of samples that the
+  /// pointers handed out by read share the ownership of, along with the
+  /// buffer pointing into it. Only allocated once read is used.
+  std::shared_ptr<Message> read_samples;
 
-  dds_sample_info_t infos[MaxSamplesNum];
+  TakeBuffer read_buffer;
+
+  /// Buffers that take_loaned lends out to its views, kept for the next
+  /// takes once the views are done with them. Several views may be held at
+  /// once, while a reader is being drained.
+  std::vector<TakeBuffer> spare_take_buffers;
 
   bool ready;
 
+  /// Doubles the window when the take filled it up, up to the maximum
+  void grow_take_window(size_t _taken)
+  {
+    if (_taken == take_window && take_window < max_take_window)
+      take_window = std::min(2 * take_window, max_take_window);
+  }
+
+  /// Keeps a buffer that a view is done with for the next takes, buffers
+  /// that were lent out before the window grew are let go of
+  void reclaim_take_buffer(TakeBuffer&& _buffer)
+  {
+    if (!_buffer.storage || _buffer.capacity != take_window)
+      return;
+
+    // Takes only loan samples into a buffer that starts with a null pointer,
+    // the pointers into the returned loan are cleared
+    std::fill_n(_buffer.samples, _buffer.capacity, nullptr);
+    spare_take_buffers.push_back(std::move(_buffer));
+  }
+
+  void allocate_read_samples()
+  {
+    const size_t capacity = take_window;
+    const dds_topic_descriptor_t* desc = topic_desc;
+    Message* block =
+        static_cast<Message*>(dds_alloc(capacity * sizeof(Message)));
+    read_samples = std::shared_ptr<Message>(
+        block,
+        [capacity, desc](Message* _block)
+        {
+          for (size_t i = 0; i < capacity; ++i)
+            dds_sample_free(&_block[i], desc, DDS_FREE_CONTENTS);
+          dds_free(_block);
+        });
+
+    read_buffer = TakeBuffer(capacity);
+    for (size_t i = 0; i < capacity; ++i)
+      read_buffer.samples[i] = &block[i];
+  }
+
 public:
 
+  /// \param[in] take_window
+  ///   Number of samples taken at a time to begin with, at least 1.
+  /// \param[in] max_take_window
+  ///   Largest number of samples that the window can grow to, the window
+  ///   stays at its initial size if this is not larger.
   DDSSubscribeHandler(
       const dds_entity_t& _participant, 
       const dds_topic_descriptor_t* _topic_desc, 
-      const std::string& _topic_name) :
-    topic_desc(_topic_desc)
+      const std::string& _topic_name,
+      const dds_qos_t* _qos = nullptr,
+      const std::string& _partition = "",
+      size_t _take_window = 1,
+      size_t _max_take_window = 0) :
+    topic_desc(_topic_desc),
+    topic(0),
+    subscriber(0),
+    reader(0),
+    take_window(std::max<size_t>(_take_window, 1)),
+    max_take_window(std::max(take_window, _max_take_window))
   {
     ready = false;
 
@@ -70,58 +272,145 @@ public:
       return;
     }
 
+    // Readers only subscribe to a single partition when one is provided,
+    // otherwise they are created directly under the participant, in the
+    // default partition
+    dds_entity_t reader_parent = _participant;
+    if (!_partition.empty())
+    {
+      dds_qos_t* subscriber_qos = dds_create_qos();
+      dds_qset_partition1(subscriber_qos, _partition.c_str());
+      subscriber = dds_create_subscriber(_participant, subscriber_qos, NULL);
+      dds_delete_qos(subscriber_qos);
+      if (subscriber < 0)
+      {
+        DDS_FATAL(
+            "dds_create_subscriber: %s\n", dds_strretcode(-subscriber));
+        return;
+      }
+      reader_parent = subscriber;
+    }
+
+    // Readers are best effort unless the caller provides its own QoS
     dds_qos_t* qos = dds_create_qos();
-    dds_qset_reliability(qos, DDS_RELIABILITY_BEST_EFFORT, 0);
-    reader = dds_create_reader(_participant, topic, qos, NULL);
+    if (_qos)
+      dds_copy_qos(qos, _qos);
+    else
+      dds_qset_reliability(qos, DDS_RELIABILITY_BEST_EFFORT, 0);
+    reader = dds_create_reader(reader_parent, topic, qos, NULL);
+    dds_delete_qos(qos);
     if (reader < 0)
     {
       DDS_FATAL(
           "dds_create_reader: %s\n", dds_strretcode(-reader));
       return;
     }
-    dds_delete_qos(qos);
-
-    for (size_t i = 0; i < shared_msgs.size(); ++i)
-    {
-      shared_msgs[i] = std::shared_ptr<Message>((Message*)dds_alloc(sizeof(Message)));
-      samples[i] = (void*)shared_msgs[i].get();
-    }
 
     ready = true;
   }
 
+  /// Deletes the entities created by this handler, the participant may be
+  /// shared with other handlers and is left alone. Entities that were already
+  /// deleted along with their participant are skipped over.
   ~DDSSubscribeHandler()
-  {}
+  {
+    if (subscriber > 0)
+      dds_delete(subscriber);
+    else if (reader > 0)
+      dds_delete(reader);
+
+    if (topic > 0)
+      dds_delete(topic);
+  }
 
   bool is_ready()
   {
     return ready;
   }
 
+  /// Returns the underlying DDS reader entity, used for attaching the reader
+  /// to a waitset.
+  dds_entity_t get_reader() const
+  {
+    return reader;
+  }
+
+  /// Number of samples that the next take takes at most
+  size_t get_take_window() const
+  {
+    return take_window;
+  }
+
+  /// Takes up to a window of samples without copying them out of the
+  /// reader. Unlike read, the samples returned stay valid until the returned
+  /// view is destroyed, even if the reader is taken from again.
+  LoanedSamples take_loaned()
+  {
+    // Buffers are only allocated when more views are held at once than
+    // before, or the window has grown
+    TakeBuffer buffer;
+    while (!spare_take_buffers.empty() &&
+        spare_take_buffers.back().capacity != take_window)
+      spare_take_buffers.pop_back();
+    if (!spare_take_buffers.empty())
+    {
+      buffer = std::move(spare_take_buffers.back());
+      spare_take_buffers.pop_back();
+    }
+    else
+    {
+      buffer = TakeBuffer(take_window);
+    }
+
+    LoanedSamples loaned(this, reader, std::move(buffer));
+    if (!is_ready())
+      return loaned;
+
+    return_code = dds_take(
+        reader, loaned.buffer.samples, loaned.buffer.infos,
+        take_window, static_cast<uint32_t>(take_window));
+    if (return_code < 0)
+    {
+      DDS_FATAL("dds_take: %s\n", dds_strretcode(-return_code));
+      return loaned;
+    }
+    loaned.count = static_cast<size_t>(return_code);
+    grow_take_window(loaned.count);
+    return loaned;
+  }
+
+  /// Takes up to a window of samples into the handler's own buffer. The
+  /// returned pointers alias that buffer, and will be overwritten by the next
+  /// read, prefer take_loaned when the samples are only needed briefly.
   std::vector<std::shared_ptr<const Message>> read()
   {
     std::vector<std::shared_ptr<const Message>> msgs;
     if (!is_ready())
       return msgs;
 
-    return_code = dds_take(reader, samples, infos, MaxSamplesNum, MaxSamplesNum);
+    // A grown window gets a block of its own, the pointers handed out before
+    // keep the previous block alive
+    if (read_buffer.capacity != take_window)
+      allocate_read_samples();
+
+    const size_t capacity = read_buffer.capacity;
+    return_code = dds_take(
+        reader, read_buffer.samples, read_buffer.infos,
+        capacity, static_cast<uint32_t>(capacity));
     if (return_code < 0)
     {
       DDS_FATAL("dds_take: %s\n", dds_strretcode(-return_code));
-      msgs.clear();
       return msgs;
     }
-    
-    if (return_code > 0)
+
+    const size_t taken = static_cast<size_t>(return_code);
+    for (size_t i = 0; i < taken; ++i)
     {
-      for (size_t i = 0; i < MaxSamplesNum; ++i)
-      {
-        if (infos[i].valid_data)
-          msgs.push_back(std::shared_ptr<const Message>(shared_msgs[i]));
-      }
-      return msgs;
+      if (read_buffer.infos[i].valid_data)
+        msgs.push_back(std::shared_ptr<const Message>(
+            read_samples, static_cast<Message*>(read_buffer.samples[i])));
     }
-    msgs.clear();
+    grow_take_window(taken);
     return msgs;
   }
 
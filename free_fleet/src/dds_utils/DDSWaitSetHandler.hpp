@@ -0,0 +1,241 @@
+/*
+ * Copyright (C) 2019 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#ifndef FREE_FLEET__SRC__DDS_UTILS__DDSWAITSETHANDLER_HPP
+#define FREE_FLEET__SRC__DDS_UTILS__DDSWAITSETHANDLER_HPP
+
+#include <map>
+#include <mutex>
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <vector>
+#include <functional>
+
+#include <dds/dds.h>
+
+#include <free_fleet/ThreadConfig.hpp>
+
+namespace free_fleet {
+namespace dds {
+
+/// Owns a DDS waitset and a dedicated thread that blocks on it, invoking the
+/// callback attached to a reader whenever that reader has samples available.
+/// The thread is only spawned once the first reader has been attached.
+class DDSWaitSetHandler
+{
+public:
+
+  using SharedPtr = std::shared_ptr<DDSWaitSetHandler>;
+
+  using Callback = std::function<void()>;
+
+private:
+
+  dds_entity_t waitset;
+
+  dds_entity_t guard_condition;
+
+  /// Read conditions that were created for each attached reader, keyed by
+  /// the reader entity
+  std::map<dds_entity_t, dds_entity_t> read_conditions;
+
+  /// Callbacks keyed by the attached read condition
+  std::map<dds_attach_t, Callback> callbacks;
+
+  std::mutex callbacks_mutex;
+
+  std::thread thread;
+
+  std::atomic<bool> running;
+
+  bool ready;
+
+  ThreadConfig thread_config;
+
+  void thread_fn()
+  {
+    thread_config.apply("waitset");
+
+    std::vector<dds_attach_t> triggered;
+    while (running)
+    {
+      {
+        std::lock_guard<std::mutex> lock(callbacks_mutex);
+        triggered.resize(callbacks.size() + 1);
+      }
+
+      dds_return_t return_code = dds_waitset_wait(
+          waitset, triggered.data(), triggered.size(), DDS_INFINITY);
+      if (return_code < 0)
+      {
+        DDS_FATAL("dds_waitset_wait: %s\n", dds_strretcode(-return_code));
+        return;
+      }
+
+      for (dds_return_t i = 0; i < return_code && running; ++i)
+      {
+        if (triggered[i] == static_cast<dds_attach_t>(guard_condition))
+        {
+          bool triggered_guard = false;
+          dds_take_guardcondition(guard_condition, &triggered_guard);
+          continue;
+        }
+
+        Callback callback;
+        {
+          std::lock_guard<std::mutex> lock(callbacks_mutex);
+          auto it = callbacks.find(triggered[i]);
+          if (it == callbacks.end())
+            continue;
+          callback = it->second;
+        }
+        if (callback)
+          callback();
+      }
+    }
+  }
+
+public:
+
+  /// \param[in] participant
+  ///   Participant that the waitset is created under.
+  /// \param[in] thread_config
+  ///   CPUs and scheduling of the waitset thread.
+  DDSWaitSetHandler(
+      const dds_entity_t& _participant,
+      const ThreadConfig& _thread_config = ThreadConfig()) :
+    waitset(0),
+    guard_condition(0),
+    running(false),
+    thread_config(_thread_config)
+  {
+    ready = false;
+
+    waitset = dds_create_waitset(_participant);
+    if (waitset < 0)
+    {
+      DDS_FATAL("dds_create_waitset: %s\n", dds_strretcode(-waitset));
+      return;
+    }
+
+    guard_condition = dds_create_guardcondition(_participant);
+    if (guard_condition < 0)
+    {
+      DDS_FATAL(
+          "dds_create_guardcondition: %s\n", dds_strretcode(-guard_condition));
+      return;
+    }
+
+    dds_return_t return_code = dds_waitset_attach(
+        waitset, guard_condition,
+        static_cast<dds_attach_t>(guard_condition));
+    if (return_code < 0)
+    {
+      DDS_FATAL("dds_waitset_attach: %s\n", dds_strretcode(-return_code));
+      return;
+    }
+
+    ready = true;
+  }
+
+  /// Stops the waitset thread before deleting the waitset and its guard
+  /// condition, the read conditions go away together with their readers.
+  ~DDSWaitSetHandler()
+  {
+    stop();
+
+    if (waitset > 0)
+      dds_delete(waitset);
+
+    if (guard_condition > 0)
+      dds_delete(guard_condition);
+  }
+
+  bool is_ready()
+  {
+    return ready;
+  }
+
+  /// Attaches a reader to the waitset, the callback gets triggered from the
+  /// waitset thread every time the reader has samples that have not been
+  /// taken yet. The callback is expected to take all available samples.
+  /// Attaching the same reader again replaces its callback.
+  bool attach(const dds_entity_t& _reader, Callback _callback)
+  {
+    if (!is_ready())
+      return false;
+
+    {
+      std::lock_guard<std::mutex> lock(callbacks_mutex);
+      auto it = read_conditions.find(_reader);
+      if (it != read_conditions.end())
+      {
+        callbacks[static_cast<dds_attach_t>(it->second)] = std::move(_callback);
+        return true;
+      }
+    }
+
+    dds_entity_t read_condition =
+        dds_create_readcondition(_reader, DDS_ANY_STATE);
+    if (read_condition < 0)
+    {
+      DDS_FATAL(
+          "dds_create_readcondition: %s\n", dds_strretcode(-read_condition));
+      return false;
+    }
+
+    {
+      std::lock_guard<std::mutex> lock(callbacks_mutex);
+      read_conditions[_reader] = read_condition;
+      callbacks[static_cast<dds_attach_t>(read_condition)] =
+          std::move(_callback);
+    }
+
+    dds_return_t return_code = dds_waitset_attach(
+        waitset, read_condition, static_cast<dds_attach_t>(read_condition));
+    if (return_code < 0)
+    {
+      DDS_FATAL("dds_waitset_attach: %s\n", dds_strretcode(-return_code));
+      return false;
+    }
+
+    if (!running.exchange(true))
+      thread = std::thread(&DDSWaitSetHandler::thread_fn, this);
+    else
+      dds_set_guardcondition(guard_condition, true);
+    return true;
+  }
+
+  /// Stops and joins the waitset thread, callbacks will no longer be
+  /// triggered after this returns.
+  void stop()
+  {
+    if (!running.exchange(false))
+      return;
+
+    dds_set_guardcondition(guard_condition, true);
+    if (thread.joinable())
+      thread.join();
+  }
+
+};
+
+} // namespace dds
+} // namespace free_fleet
+
+#endif // FREE_FLEET__SRC__DDS_UTILS__DDSWAITSETHANDLER_HPP
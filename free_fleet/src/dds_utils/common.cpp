@@ -17,11 +17,38 @@
 
 #include "common.hpp"
 
+#include <cmath>
+#include <cstring>
+
 #include <dds/dds.h>
 
 namespace free_fleet {
 namespace common {
 
+namespace {
+
+std::string xml_escape(const std::string& _str)
+{
+  std::string escaped;
+  escaped.reserve(_str.size());
+  for (const char c : _str)
+  {
+    if (c == '&')
+      escaped += "&amp;";
+    else if (c == '<')
+      escaped += "&lt;";
+    else if (c == '>')
+      escaped += "&gt;";
+    else if (c == '"')
+      escaped += "&quot;";
+    else
+      escaped += c;
+  }
+  return escaped;
+}
+
+} // namespace anonymous
+
 char* dds_string_alloc_and_copy(const std::string& _str)
 {
   char* ptr = dds_string_alloc(_str.length());
@@ -32,5 +59,143 @@ char* dds_string_alloc_and_copy(const std::string& _str)
   return ptr;
 }
 
+void dds_string_assign(char*& _dds_str, const std::string& _str)
+{
+  if (_dds_str && std::strlen(_dds_str) >= _str.length())
+  {
+    std::memcpy(_dds_str, _str.c_str(), _str.length() + 1);
+    return;
+  }
+  dds_string_free(_dds_str);
+  _dds_str = dds_string_alloc_and_copy(_str);
+}
+
+dds_qos_t* create_qos(const TopicQoS& _topic_qos)
+{
+  dds_qos_t* qos = dds_create_qos();
+  dds_qset_reliability(
+      qos,
+      _topic_qos.reliable ? 
+          DDS_RELIABILITY_RELIABLE : DDS_RELIABILITY_BEST_EFFORT,
+      DDS_MSECS(100));
+
+  if (_topic_qos.history_depth > 0)
+    dds_qset_history(qos, DDS_HISTORY_KEEP_LAST, _topic_qos.history_depth);
+  else
+    dds_qset_history(qos, DDS_HISTORY_KEEP_ALL, 0);
+
+  dds_qset_durability(
+      qos, 
+      _topic_qos.transient_local ?
+          DDS_DURABILITY_TRANSIENT_LOCAL : DDS_DURABILITY_VOLATILE);
+
+  if (_topic_qos.deadline > 0.0)
+    dds_qset_deadline(
+        qos, static_cast<dds_duration_t>(_topic_qos.deadline * 1e9));
+
+  if (_topic_qos.latency_budget > 0.0)
+    dds_qset_latency_budget(
+        qos, static_cast<dds_duration_t>(_topic_qos.latency_budget * 1e9));
+
+  if (_topic_qos.liveliness_lease > 0.0)
+    dds_qset_liveliness(
+        qos, DDS_LIVELINESS_AUTOMATIC,
+        static_cast<dds_duration_t>(_topic_qos.liveliness_lease * 1e9));
+
+  if (_topic_qos.transport_priority != 0)
+    dds_qset_transport_priority(qos, _topic_qos.transport_priority);
+  return qos;
+}
+
+std::string robot_partition(
+    const std::string& _fleet_name, const std::string& _robot_name)
+{
+  return _fleet_name + "/" + _robot_name;
+}
+
+std::string domain_config(
+    bool _shared_memory, const DiscoveryConfig& _discovery,
+    const ThreadConfig& _dds_threads)
+{
+  std::string general;
+  std::string discovery;
+  std::string shared_memory;
+  std::string threads;
+
+  if (!_discovery.network_interface.empty())
+    general += "<NetworkInterfaceAddress>" +
+        xml_escape(_discovery.network_interface) +
+        "</NetworkInterfaceAddress>";
+
+  switch (_discovery.mode)
+  {
+    case DiscoveryConfig::Mode::Multicast:
+      general += "<AllowMulticast>true</AllowMulticast>";
+      break;
+    case DiscoveryConfig::Mode::SpdpMulticast:
+      general += "<AllowMulticast>spdp</AllowMulticast>";
+      break;
+    case DiscoveryConfig::Mode::Unicast:
+      // Without multicast, peers are only found on the ports of the
+      // participant indices that they get assigned
+      general += "<AllowMulticast>false</AllowMulticast>";
+      discovery += "<ParticipantIndex>auto</ParticipantIndex>";
+      break;
+    default:
+      break;
+  }
+
+  if (!_discovery.peers.empty())
+  {
+    discovery += "<Peers>";
+    for (const auto& peer : _discovery.peers)
+      discovery += "<Peer Address=\"" + xml_escape(peer) + "\"/>";
+    discovery += "</Peers>";
+  }
+
+  if (_discovery.spdp_interval > 0.0)
+    discovery += "<SPDPInterval>" +
+        std::to_string(static_cast<long long>(
+            std::ceil(_discovery.spdp_interval * 1e3))) +
+        "ms</SPDPInterval>";
+
+  if (_shared_memory)
+  {
+#ifdef FREE_FLEET_SHARED_MEMORY
+    shared_memory = "<SharedMemory><Enable>true</Enable></SharedMemory>";
+#else
+    DDS_WARNING("shared memory transport requested, but free fleet was built "
+        "without FREE_FLEET_SHARED_MEMORY, using the network instead\n");
+#endif
+  }
+
+  // The realtime class is SCHED_FIFO on Linux
+  if (_dds_threads.fifo_priority > 0)
+  {
+    const std::string scheduling =
+        "<Scheduling><Class>realtime</Class><Priority>" +
+        std::to_string(_dds_threads.fifo_priority) +
+        "</Priority></Scheduling>";
+    for (const char* name :
+        {"recv", "recvUC", "recvMC", "dq.builtins", "dq.user", "tev"})
+      threads += "<Thread name=\"" + std::string(name) + "\">" +
+          scheduling + "</Thread>";
+  }
+
+  if (general.empty() && discovery.empty() && shared_memory.empty() &&
+      threads.empty())
+    return std::string();
+
+  std::string config = "<CycloneDDS><Domain>";
+  if (!general.empty())
+    config += "<General>" + general + "</General>";
+  if (!discovery.empty())
+    config += "<Discovery>" + discovery + "</Discovery>";
+  if (!threads.empty())
+    config += "<Threads>" + threads + "</Threads>";
+  config += shared_memory + "</Domain></CycloneDDS>";
+  return config;
+}
+
 } // namespace common
 } // namespace free_fleet
@@ -20,11 +20,42 @@
 
 #include <string>
 
+#include <dds/dds.h>
+
+#include <free_fleet/TopicQoS.hpp>
+#include <free_fleet/DiscoveryConfig.hpp>
+#include <free_fleet/ThreadConfig.hpp>
+
 namespace free_fleet {
 namespace common {
 
 char* dds_string_alloc_and_copy(const std::string& str);
 
+/// Copies the string into an existing DDS string, reusing its buffer when the
+/// new string fits in it, otherwise the old buffer is freed and a new one is
+/// allocated.
+void dds_string_assign(char*& dds_str, const std::string& str);
+
+/// Creates a new DDS QoS from the topic settings, the caller is in charge of
+/// deleting it using dds_delete_qos.
+dds_qos_t* create_qos(const TopicQoS& topic_qos);
+
+/// Name of the DDS partition that carries requests addressed to a single
+/// robot of a fleet.
+std::string robot_partition(
+    const std::string& fleet_name, const std::string& robot_name);
+
+/// CycloneDDS configuration fragment that enables the shared memory
+/// transport when wanted and applies the discovery settings, along with the
+/// scheduling of the receive, delivery and timed event threads of the
+/// domain, to be layered on top of the configuration found in
+/// CYCLONEDDS_URI. Empty if everything is left to that configuration. The
+/// CPUs of the DDS threads can not be configured this way, see
+/// dds::DDSParticipant::get.
+std::string domain_config(
+    bool shared_memory, const DiscoveryConfig& discovery,
+    const ThreadConfig& dds_threads = ThreadConfig());
+
 } // namespace common
 } // namespace free_fleet
 
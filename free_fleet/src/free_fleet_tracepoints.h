@@ -0,0 +1,66 @@
+/*
+ * Copyright (C) 2019 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+/// LTTng-UST provider of the request tracepoints, only ever included by
+/// Tracing.cpp, see free_fleet/Tracing.hpp.
+
+#undef TRACEPOINT_PROVIDER
+#define TRACEPOINT_PROVIDER free_fleet
+
+#undef TRACEPOINT_INCLUDE
+#define TRACEPOINT_INCLUDE "free_fleet_tracepoints.h"
+
+#if !defined(FREE_FLEET__SRC__FREE_FLEET_TRACEPOINTS_H) || \
+    defined(TRACEPOINT_HEADER_MULTI_READ)
+#define FREE_FLEET__SRC__FREE_FLEET_TRACEPOINTS_H
+
+#include <lttng/tracepoint.h>
+
+TRACEPOINT_EVENT_CLASS(
+  free_fleet,
+  request_stage,
+  TP_ARGS(
+    int, kind,
+    const char*, robot_name,
+    const char*, task_id),
+  TP_FIELDS(
+    ctf_integer(int, kind, kind)
+    ctf_string(robot_name, robot_name)
+    ctf_string(task_id, task_id)))
+
+#define FREE_FLEET_REQUEST_STAGE(stage) \
+  TRACEPOINT_EVENT_INSTANCE( \
+    free_fleet, \
+    request_stage, \
+    stage, \
+    TP_ARGS( \
+      int, kind, \
+      const char*, robot_name, \
+      const char*, task_id))
+
+FREE_FLEET_REQUEST_STAGE(rmf_request_received)
+FREE_FLEET_REQUEST_STAGE(server_request_queued)
+FREE_FLEET_REQUEST_STAGE(server_request_written)
+FREE_FLEET_REQUEST_STAGE(client_request_taken)
+FREE_FLEET_REQUEST_STAGE(client_request_accepted)
+FREE_FLEET_REQUEST_STAGE(client_goal_sent)
+
+#undef FREE_FLEET_REQUEST_STAGE
+
+#endif // FREE_FLEET__SRC__FREE_FLEET_TRACEPOINTS_H
+
+#include <lttng/tracepoint-event.h>
@@ -54,9 +54,34 @@ const dds_topic_descriptor_t FreeFleetData_Location_desc =
 };
 
 
+static const uint32_t FreeFleetData_PathLocation_ops [] =
+{
+  DDS_OP_ADR | DDS_OP_TYPE_4BY, offsetof (FreeFleetData_PathLocation, sec),
+  DDS_OP_ADR | DDS_OP_TYPE_4BY, offsetof (FreeFleetData_PathLocation, nanosec),
+  DDS_OP_ADR | DDS_OP_TYPE_4BY, offsetof (FreeFleetData_PathLocation, x),
+  DDS_OP_ADR | DDS_OP_TYPE_4BY, offsetof (FreeFleetData_PathLocation, y),
+  DDS_OP_ADR | DDS_OP_TYPE_4BY, offsetof (FreeFleetData_PathLocation, yaw),
+  DDS_OP_ADR | DDS_OP_TYPE_4BY, offsetof (FreeFleetData_PathLocation, level_index),
+  DDS_OP_RTS
+};
+
+const dds_topic_descriptor_t FreeFleetData_PathLocation_desc =
+{
+  sizeof (FreeFleetData_PathLocation),
+  4u,
+  0u,
+  0u,
+  "FreeFleetData::PathLocation",
+  NULL,
+  7,
+  FreeFleetData_PathLocation_ops,
+  "<MetaData version=\"1.0.0\"><Module name=\"FreeFleetData\"><Struct name=\"PathLocation\"><Member name=\"sec\"><Long/></Member><Member name=\"nanosec\"><ULong/></Member><Member name=\"x\"><Float/></Member><Member name=\"y\"><Float/></Member><Member name=\"yaw\"><Float/></Member><Member name=\"level_index\"><ULong/></Member></Struct></Module></MetaData>"
+};
+
+
 static const uint32_t FreeFleetData_RobotState_ops [] =
 {
-  DDS_OP_ADR | DDS_OP_TYPE_STR, offsetof (FreeFleetData_RobotState, name),
+  DDS_OP_ADR | DDS_OP_TYPE_STR | DDS_OP_FLAG_KEY, offsetof (FreeFleetData_RobotState, name),
   DDS_OP_ADR | DDS_OP_TYPE_STR, offsetof (FreeFleetData_RobotState, model),
   DDS_OP_ADR | DDS_OP_TYPE_STR, offsetof (FreeFleetData_RobotState, task_id),
   DDS_OP_ADR | DDS_OP_TYPE_4BY, offsetof (FreeFleetData_RobotState, mode.mode),
@@ -67,29 +92,124 @@ static const uint32_t FreeFleetData_RobotState_ops [] =
   DDS_OP_ADR | DDS_OP_TYPE_4BY, offsetof (FreeFleetData_RobotState, location.y),
   DDS_OP_ADR | DDS_OP_TYPE_4BY, offsetof (FreeFleetData_RobotState, location.yaw),
   DDS_OP_ADR | DDS_OP_TYPE_STR, offsetof (FreeFleetData_RobotState, location.level_name),
+  DDS_OP_ADR | DDS_OP_TYPE_SEQ | DDS_OP_SUBTYPE_STR, offsetof (FreeFleetData_RobotState, level_names),
   DDS_OP_ADR | DDS_OP_TYPE_SEQ | DDS_OP_SUBTYPE_STU, offsetof (FreeFleetData_RobotState, path),
-  sizeof (FreeFleetData_Location), (17u << 16u) + 4u,
-  DDS_OP_ADR | DDS_OP_TYPE_4BY, offsetof (FreeFleetData_Location, sec),
-  DDS_OP_ADR | DDS_OP_TYPE_4BY, offsetof (FreeFleetData_Location, nanosec),
-  DDS_OP_ADR | DDS_OP_TYPE_4BY, offsetof (FreeFleetData_Location, x),
-  DDS_OP_ADR | DDS_OP_TYPE_4BY, offsetof (FreeFleetData_Location, y),
-  DDS_OP_ADR | DDS_OP_TYPE_4BY, offsetof (FreeFleetData_Location, yaw),
-  DDS_OP_ADR | DDS_OP_TYPE_STR, offsetof (FreeFleetData_Location, level_name),
+  sizeof (FreeFleetData_PathLocation), (17u << 16u) + 4u,
+  DDS_OP_ADR | DDS_OP_TYPE_4BY, offsetof (FreeFleetData_PathLocation, sec),
+  DDS_OP_ADR | DDS_OP_TYPE_4BY, offsetof (FreeFleetData_PathLocation, nanosec),
+  DDS_OP_ADR | DDS_OP_TYPE_4BY, offsetof (FreeFleetData_PathLocation, x),
+  DDS_OP_ADR | DDS_OP_TYPE_4BY, offsetof (FreeFleetData_PathLocation, y),
+  DDS_OP_ADR | DDS_OP_TYPE_4BY, offsetof (FreeFleetData_PathLocation, yaw),
+  DDS_OP_ADR | DDS_OP_TYPE_4BY, offsetof (FreeFleetData_PathLocation, level_index),
   DDS_OP_RTS,
+  DDS_OP_ADR | DDS_OP_TYPE_4BY, offsetof (FreeFleetData_RobotState, path_version),
+  DDS_OP_ADR | DDS_OP_TYPE_4BY, offsetof (FreeFleetData_RobotState, path_index),
+  DDS_OP_ADR | DDS_OP_TYPE_4BY, offsetof (FreeFleetData_RobotState, robot_id),
+  DDS_OP_ADR | DDS_OP_TYPE_SEQ | DDS_OP_SUBTYPE_1BY, offsetof (FreeFleetData_RobotState, packed_path),
   DDS_OP_RTS
 };
 
+static const dds_key_descriptor_t FreeFleetData_RobotState_keys[1] =
+{
+  { "name", 0 }
+};
+
 const dds_topic_descriptor_t FreeFleetData_RobotState_desc =
 {
   sizeof (FreeFleetData_RobotState),
   sizeof (char *),
   DDS_TOPIC_NO_OPTIMIZE,
-  0u,
+  1u,
   "FreeFleetData::RobotState",
-  NULL,
-  21,
+  FreeFleetData_RobotState_keys,
+  26,
   FreeFleetData_RobotState_ops,
-  "<MetaData version=\"1.0.0\"><Module name=\"FreeFleetData\"><Struct name=\"RobotMode\"><Member name=\"mode\"><ULong/></Member></Struct><Struct name=\"Location\"><Member name=\"sec\"><Long/></Member><Member name=\"nanosec\"><ULong/></Member><Member name=\"x\"><Float/></Member><Member name=\"y\"><Float/></Member><Member name=\"yaw\"><Float/></Member><Member name=\"level_name\"><String/></Member></Struct><Struct name=\"RobotState\"><Member name=\"name\"><String/></Member><Member name=\"model\"><String/></Member><Member name=\"task_id\"><String/></Member><Member name=\"mode\"><Type name=\"RobotMode\"/></Member><Member name=\"battery_percent\"><Float/></Member><Member name=\"location\"><Type name=\"Location\"/></Member><Member name=\"path\"><Sequence><Type name=\"Location\"/></Sequence></Member></Struct></Module></MetaData>"
+  "<MetaData version=\"1.0.0\"><Module name=\"FreeFleetData\"><Struct name=\"RobotMode\"><Member name=\"mode\"><ULong/></Member></Struct><Struct name=\"Location\"><Member name=\"sec\"><Long/></Member><Member name=\"nanosec\"><ULong/></Member><Member name=\"x\"><Float/></Member><Member name=\"y\"><Float/></Member><Member name=\"yaw\"><Float/></Member><Member name=\"level_name\"><String/></Member></Struct><Struct name=\"PathLocation\"><Member name=\"sec\"><Long/></Member><Member name=\"nanosec\"><ULong/></Member><Member name=\"x\"><Float/></Member><Member name=\"y\"><Float/></Member><Member name=\"yaw\"><Float/></Member><Member name=\"level_index\"><ULong/></Member></Struct><Struct name=\"RobotState\"><Member name=\"name\"><String/></Member><Member name=\"model\"><String/></Member><Member name=\"task_id\"><String/></Member><Member name=\"mode\"><Type name=\"RobotMode\"/></Member><Member name=\"battery_percent\"><Float/></Member><Member name=\"location\"><Type name=\"Location\"/></Member><Member name=\"level_names\"><Sequence><String/></Sequence></Member><Member name=\"path\"><Sequence><Type name=\"PathLocation\"/></Sequence></Member><Member name=\"path_version\"><ULong/></Member><Member name=\"path_index\"><ULong/></Member><Member name=\"robot_id\"><ULong/></Member><Member name=\"packed_path\"><Sequence><Octet/></Sequence></Member></Struct></Module></MetaData>"
+};
+
+
+static const uint32_t FreeFleetData_RobotPose_ops [] =
+{
+  DDS_OP_ADR | DDS_OP_TYPE_STR | DDS_OP_FLAG_KEY, offsetof (FreeFleetData_RobotPose, name),
+  DDS_OP_ADR | DDS_OP_TYPE_4BY, offsetof (FreeFleetData_RobotPose, mode.mode),
+  DDS_OP_ADR | DDS_OP_TYPE_4BY, offsetof (FreeFleetData_RobotPose, location.sec),
+  DDS_OP_ADR | DDS_OP_TYPE_4BY, offsetof (FreeFleetData_RobotPose, location.nanosec),
+  DDS_OP_ADR | DDS_OP_TYPE_4BY, offsetof (FreeFleetData_RobotPose, location.x),
+  DDS_OP_ADR | DDS_OP_TYPE_4BY, offsetof (FreeFleetData_RobotPose, location.y),
+  DDS_OP_ADR | DDS_OP_TYPE_4BY, offsetof (FreeFleetData_RobotPose, location.yaw),
+  DDS_OP_ADR | DDS_OP_TYPE_STR, offsetof (FreeFleetData_RobotPose, location.level_name),
+  DDS_OP_RTS
+};
+
+static const dds_key_descriptor_t FreeFleetData_RobotPose_keys[1] =
+{
+  { "name", 0 }
+};
+
+const dds_topic_descriptor_t FreeFleetData_RobotPose_desc =
+{
+  sizeof (FreeFleetData_RobotPose),
+  sizeof (char *),
+  DDS_TOPIC_NO_OPTIMIZE,
+  1u,
+  "FreeFleetData::RobotPose",
+  FreeFleetData_RobotPose_keys,
+  9,
+  FreeFleetData_RobotPose_ops,
+  "<MetaData version=\"1.0.0\"><Module name=\"FreeFleetData\"><Struct name=\"RobotMode\"><Member name=\"mode\"><ULong/></Member></Struct><Struct name=\"Location\"><Member name=\"sec\"><Long/></Member><Member name=\"nanosec\"><ULong/></Member><Member name=\"x\"><Float/></Member><Member name=\"y\"><Float/></Member><Member name=\"yaw\"><Float/></Member><Member name=\"level_name\"><String/></Member></Struct><Struct name=\"RobotPose\"><Member name=\"name\"><String/></Member><Member name=\"mode\"><Type name=\"RobotMode\"/></Member><Member name=\"location\"><Type name=\"Location\"/></Member></Struct></Module></MetaData>"
+};
+
+
+static const uint32_t FreeFleetData_FleetState_ops [] =
+{
+  DDS_OP_ADR | DDS_OP_TYPE_STR | DDS_OP_FLAG_KEY, offsetof (FreeFleetData_FleetState, name),
+  DDS_OP_ADR | DDS_OP_TYPE_SEQ | DDS_OP_SUBTYPE_STU, offsetof (FreeFleetData_FleetState, robots),
+  sizeof (FreeFleetData_RobotState), (54u << 16u) + 4u,
+  DDS_OP_ADR | DDS_OP_TYPE_STR, offsetof (FreeFleetData_RobotState, name),
+  DDS_OP_ADR | DDS_OP_TYPE_STR, offsetof (FreeFleetData_RobotState, model),
+  DDS_OP_ADR | DDS_OP_TYPE_STR, offsetof (FreeFleetData_RobotState, task_id),
+  DDS_OP_ADR | DDS_OP_TYPE_4BY, offsetof (FreeFleetData_RobotState, mode.mode),
+  DDS_OP_ADR | DDS_OP_TYPE_4BY, offsetof (FreeFleetData_RobotState, battery_percent),
+  DDS_OP_ADR | DDS_OP_TYPE_4BY, offsetof (FreeFleetData_RobotState, location.sec),
+  DDS_OP_ADR | DDS_OP_TYPE_4BY, offsetof (FreeFleetData_RobotState, location.nanosec),
+  DDS_OP_ADR | DDS_OP_TYPE_4BY, offsetof (FreeFleetData_RobotState, location.x),
+  DDS_OP_ADR | DDS_OP_TYPE_4BY, offsetof (FreeFleetData_RobotState, location.y),
+  DDS_OP_ADR | DDS_OP_TYPE_4BY, offsetof (FreeFleetData_RobotState, location.yaw),
+  DDS_OP_ADR | DDS_OP_TYPE_STR, offsetof (FreeFleetData_RobotState, location.level_name),
+  DDS_OP_ADR | DDS_OP_TYPE_SEQ | DDS_OP_SUBTYPE_STR, offsetof (FreeFleetData_RobotState, level_names),
+  DDS_OP_ADR | DDS_OP_TYPE_SEQ | DDS_OP_SUBTYPE_STU, offsetof (FreeFleetData_RobotState, path),
+  sizeof (FreeFleetData_PathLocation), (17u << 16u) + 4u,
+  DDS_OP_ADR | DDS_OP_TYPE_4BY, offsetof (FreeFleetData_PathLocation, sec),
+  DDS_OP_ADR | DDS_OP_TYPE_4BY, offsetof (FreeFleetData_PathLocation, nanosec),
+  DDS_OP_ADR | DDS_OP_TYPE_4BY, offsetof (FreeFleetData_PathLocation, x),
+  DDS_OP_ADR | DDS_OP_TYPE_4BY, offsetof (FreeFleetData_PathLocation, y),
+  DDS_OP_ADR | DDS_OP_TYPE_4BY, offsetof (FreeFleetData_PathLocation, yaw),
+  DDS_OP_ADR | DDS_OP_TYPE_4BY, offsetof (FreeFleetData_PathLocation, level_index),
+  DDS_OP_RTS,
+  DDS_OP_ADR | DDS_OP_TYPE_4BY, offsetof (FreeFleetData_RobotState, path_version),
+  DDS_OP_ADR | DDS_OP_TYPE_4BY, offsetof (FreeFleetData_RobotState, path_index),
+  DDS_OP_ADR | DDS_OP_TYPE_4BY, offsetof (FreeFleetData_RobotState, robot_id),
+  DDS_OP_ADR | DDS_OP_TYPE_SEQ | DDS_OP_SUBTYPE_1BY, offsetof (FreeFleetData_RobotState, packed_path),
+  DDS_OP_RTS,
+  DDS_OP_RTS
+};
+
+static const dds_key_descriptor_t FreeFleetData_FleetState_keys[1] =
+{
+  { "name", 0 }
+};
+
+const dds_topic_descriptor_t FreeFleetData_FleetState_desc =
+{
+  sizeof (FreeFleetData_FleetState),
+  sizeof (char *),
+  DDS_TOPIC_NO_OPTIMIZE,
+  1u,
+  "FreeFleetData::FleetState",
+  FreeFleetData_FleetState_keys,
+  30,
+  FreeFleetData_FleetState_ops,
+  "<MetaData version=\"1.0.0\"><Module name=\"FreeFleetData\"><Struct name=\"RobotMode\"><Member name=\"mode\"><ULong/></Member></Struct><Struct name=\"Location\"><Member name=\"sec\"><Long/></Member><Member name=\"nanosec\"><ULong/></Member><Member name=\"x\"><Float/></Member><Member name=\"y\"><Float/></Member><Member name=\"yaw\"><Float/></Member><Member name=\"level_name\"><String/></Member></Struct><Struct name=\"PathLocation\"><Member name=\"sec\"><Long/></Member><Member name=\"nanosec\"><ULong/></Member><Member name=\"x\"><Float/></Member><Member name=\"y\"><Float/></Member><Member name=\"yaw\"><Float/></Member><Member name=\"level_index\"><ULong/></Member></Struct><Struct name=\"RobotState\"><Member name=\"name\"><String/></Member><Member name=\"model\"><String/></Member><Member name=\"task_id\"><String/></Member><Member name=\"mode\"><Type name=\"RobotMode\"/></Member><Member name=\"battery_percent\"><Float/></Member><Member name=\"location\"><Type name=\"Location\"/></Member><Member name=\"level_names\"><Sequence><String/></Sequence></Member><Member name=\"path\"><Sequence><Type name=\"PathLocation\"/></Sequence></Member><Member name=\"path_version\"><ULong/></Member><Member name=\"path_index\"><ULong/></Member><Member name=\"robot_id\"><ULong/></Member><Member name=\"packed_path\"><Sequence><Octet/></Sequence></Member></Struct><Struct name=\"FleetState\"><Member name=\"name\"><String/></Member><Member name=\"robots\"><Sequence><Type name=\"RobotState\"/></Sequence></Member></Struct></Module></MetaData>"
 };
 
 
@@ -125,6 +245,7 @@ static const uint32_t FreeFleetData_ModeRequest_ops [] =
   DDS_OP_ADR | DDS_OP_TYPE_STR, offsetof (FreeFleetData_ModeParameter, name),
   DDS_OP_ADR | DDS_OP_TYPE_STR, offsetof (FreeFleetData_ModeParameter, value),
   DDS_OP_RTS,
+  DDS_OP_ADR | DDS_OP_TYPE_4BY, offsetof (FreeFleetData_ModeRequest, robot_id),
   DDS_OP_RTS
 };
 
@@ -136,9 +257,9 @@ const dds_topic_descriptor_t FreeFleetData_ModeRequest_desc =
   0u,
   "FreeFleetData::ModeRequest",
   NULL,
-  10,
+  11,
   FreeFleetData_ModeRequest_ops,
-  "<MetaData version=\"1.0.0\"><Module name=\"FreeFleetData\"><Struct name=\"RobotMode\"><Member name=\"mode\"><ULong/></Member></Struct><Struct name=\"ModeParameter\"><Member name=\"name\"><String/></Member><Member name=\"value\"><String/></Member></Struct><Struct name=\"ModeRequest\"><Member name=\"fleet_name\"><String/></Member><Member name=\"robot_name\"><String/></Member><Member name=\"mode\"><Type name=\"RobotMode\"/></Member><Member name=\"task_id\"><String/></Member><Member name=\"parameters\"><Sequence><Type name=\"ModeParameter\"/></Sequence></Member></Struct></Module></MetaData>"
+  "<MetaData version=\"1.0.0\"><Module name=\"FreeFleetData\"><Struct name=\"RobotMode\"><Member name=\"mode\"><ULong/></Member></Struct><Struct name=\"ModeParameter\"><Member name=\"name\"><String/></Member><Member name=\"value\"><String/></Member></Struct><Struct name=\"ModeRequest\"><Member name=\"fleet_name\"><String/></Member><Member name=\"robot_name\"><String/></Member><Member name=\"mode\"><Type name=\"RobotMode\"/></Member><Member name=\"task_id\"><String/></Member><Member name=\"parameters\"><Sequence><Type name=\"ModeParameter\"/></Sequence></Member><Member name=\"robot_id\"><ULong/></Member></Struct></Module></MetaData>"
 };
 
 
@@ -146,16 +267,24 @@ static const uint32_t FreeFleetData_PathRequest_ops [] =
 {
   DDS_OP_ADR | DDS_OP_TYPE_STR, offsetof (FreeFleetData_PathRequest, fleet_name),
   DDS_OP_ADR | DDS_OP_TYPE_STR, offsetof (FreeFleetData_PathRequest, robot_name),
+  DDS_OP_ADR | DDS_OP_TYPE_SEQ | DDS_OP_SUBTYPE_STR, offsetof (FreeFleetData_PathRequest, level_names),
   DDS_OP_ADR | DDS_OP_TYPE_SEQ | DDS_OP_SUBTYPE_STU, offsetof (FreeFleetData_PathRequest, path),
-  sizeof (FreeFleetData_Location), (17u << 16u) + 4u,
-  DDS_OP_ADR | DDS_OP_TYPE_4BY, offsetof (FreeFleetData_Location, sec),
-  DDS_OP_ADR | DDS_OP_TYPE_4BY, offsetof (FreeFleetData_Location, nanosec),
-  DDS_OP_ADR | DDS_OP_TYPE_4BY, offsetof (FreeFleetData_Location, x),
-  DDS_OP_ADR | DDS_OP_TYPE_4BY, offsetof (FreeFleetData_Location, y),
-  DDS_OP_ADR | DDS_OP_TYPE_4BY, offsetof (FreeFleetData_Location, yaw),
-  DDS_OP_ADR | DDS_OP_TYPE_STR, offsetof (FreeFleetData_Location, level_name),
+  sizeof (FreeFleetData_PathLocation), (17u << 16u) + 4u,
+  DDS_OP_ADR | DDS_OP_TYPE_4BY, offsetof (FreeFleetData_PathLocation, sec),
+  DDS_OP_ADR | DDS_OP_TYPE_4BY, offsetof (FreeFleetData_PathLocation, nanosec),
+  DDS_OP_ADR | DDS_OP_TYPE_4BY, offsetof (FreeFleetData_PathLocation, x),
+  DDS_OP_ADR | DDS_OP_TYPE_4BY, offsetof (FreeFleetData_PathLocation, y),
+  DDS_OP_ADR | DDS_OP_TYPE_4BY, offsetof (FreeFleetData_PathLocation, yaw),
+  DDS_OP_ADR | DDS_OP_TYPE_4BY, offsetof (FreeFleetData_PathLocation, level_index),
   DDS_OP_RTS,
   DDS_OP_ADR | DDS_OP_TYPE_STR, offsetof (FreeFleetData_PathRequest, task_id),
+  DDS_OP_ADR | DDS_OP_TYPE_4BY, offsetof (FreeFleetData_PathRequest, version),
+  DDS_OP_ADR | DDS_OP_TYPE_4BY, offsetof (FreeFleetData_PathRequest, operation),
+  DDS_OP_ADR | DDS_OP_TYPE_4BY, offsetof (FreeFleetData_PathRequest, base_version),
+  DDS_OP_ADR | DDS_OP_TYPE_4BY, offsetof (FreeFleetData_PathRequest, start_index),
+  DDS_OP_ADR | DDS_OP_TYPE_4BY, offsetof (FreeFleetData_PathRequest, robot_id),
+  DDS_OP_ADR | DDS_OP_TYPE_SEQ | DDS_OP_SUBTYPE_1BY, offsetof (FreeFleetData_PathRequest, packed_path),
+  DDS_OP_ADR | DDS_OP_TYPE_STR, offsetof (FreeFleetData_PathRequest, after_task_id),
   DDS_OP_RTS
 };
 
@@ -167,9 +296,9 @@ const dds_topic_descriptor_t FreeFleetData_PathRequest_desc =
   0u,
   "FreeFleetData::PathRequest",
   NULL,
-  13,
+  21,
   FreeFleetData_PathRequest_ops,
-  "<MetaData version=\"1.0.0\"><Module name=\"FreeFleetData\"><Struct name=\"Location\"><Member name=\"sec\"><Long/></Member><Member name=\"nanosec\"><ULong/></Member><Member name=\"x\"><Float/></Member><Member name=\"y\"><Float/></Member><Member name=\"yaw\"><Float/></Member><Member name=\"level_name\"><String/></Member></Struct><Struct name=\"PathRequest\"><Member name=\"fleet_name\"><String/></Member><Member name=\"robot_name\"><String/></Member><Member name=\"path\"><Sequence><Type name=\"Location\"/></Sequence></Member><Member name=\"task_id\"><String/></Member></Struct></Module></MetaData>"
+  "<MetaData version=\"1.0.0\"><Module name=\"FreeFleetData\"><Struct name=\"PathLocation\"><Member name=\"sec\"><Long/></Member><Member name=\"nanosec\"><ULong/></Member><Member name=\"x\"><Float/></Member><Member name=\"y\"><Float/></Member><Member name=\"yaw\"><Float/></Member><Member name=\"level_index\"><ULong/></Member></Struct><Struct name=\"PathRequest\"><Member name=\"fleet_name\"><String/></Member><Member name=\"robot_name\"><String/></Member><Member name=\"level_names\"><Sequence><String/></Sequence></Member><Member name=\"path\"><Sequence><Type name=\"PathLocation\"/></Sequence></Member><Member name=\"task_id\"><String/></Member><Member name=\"version\"><ULong/></Member><Member name=\"operation\"><ULong/></Member><Member name=\"base_version\"><ULong/></Member><Member name=\"start_index\"><ULong/></Member><Member name=\"robot_id\"><ULong/></Member><Member name=\"packed_path\"><Sequence><Octet/></Sequence></Member><Member name=\"after_task_id\"><String/></Member></Struct></Module></MetaData>"
 };
 
 
@@ -184,6 +313,8 @@ static const uint32_t FreeFleetData_DestinationRequest_ops [] =
   DDS_OP_ADR | DDS_OP_TYPE_4BY, offsetof (FreeFleetData_DestinationRequest, destination.yaw),
   DDS_OP_ADR | DDS_OP_TYPE_STR, offsetof (FreeFleetData_DestinationRequest, destination.level_name),
   DDS_OP_ADR | DDS_OP_TYPE_STR, offsetof (FreeFleetData_DestinationRequest, task_id),
+  DDS_OP_ADR | DDS_OP_TYPE_4BY, offsetof (FreeFleetData_DestinationRequest, robot_id),
+  DDS_OP_ADR | DDS_OP_TYPE_STR, offsetof (FreeFleetData_DestinationRequest, after_task_id),
   DDS_OP_RTS
 };
 
@@ -195,7 +326,139 @@ const dds_topic_descriptor_t FreeFleetData_DestinationRequest_desc =
   0u,
   "FreeFleetData::DestinationRequest",
   NULL,
-  10,
+  12,
   FreeFleetData_DestinationRequest_ops,
-  "<MetaData version=\"1.0.0\"><Module name=\"FreeFleetData\"><Struct name=\"Location\"><Member name=\"sec\"><Long/></Member><Member name=\"nanosec\"><ULong/></Member><Member name=\"x\"><Float/></Member><Member name=\"y\"><Float/></Member><Member name=\"yaw\"><Float/></Member><Member name=\"level_name\"><String/></Member></Struct><Struct name=\"DestinationRequest\"><Member name=\"fleet_name\"><String/></Member><Member name=\"robot_name\"><String/></Member><Member name=\"destination\"><Type name=\"Location\"/></Member><Member name=\"task_id\"><String/></Member></Struct></Module></MetaData>"
+  "<MetaData version=\"1.0.0\"><Module name=\"FreeFleetData\"><Struct name=\"Location\"><Member name=\"sec\"><Long/></Member><Member name=\"nanosec\"><ULong/></Member><Member name=\"x\"><Float/></Member><Member name=\"y\"><Float/></Member><Member name=\"yaw\"><Float/></Member><Member name=\"level_name\"><String/></Member></Struct><Struct name=\"DestinationRequest\"><Member name=\"fleet_name\"><String/></Member><Member name=\"robot_name\"><String/></Member><Member name=\"destination\"><Type name=\"Location\"/></Member><Member name=\"task_id\"><String/></Member><Member name=\"robot_id\"><ULong/></Member><Member name=\"after_task_id\"><String/></Member></Struct></Module></MetaData>"
+};
+
+
+static const uint32_t FreeFleetData_RobotRegistration_ops [] =
+{
+  DDS_OP_ADR | DDS_OP_TYPE_STR | DDS_OP_FLAG_KEY, offsetof (FreeFleetData_RobotRegistration, fleet_name),
+  DDS_OP_ADR | DDS_OP_TYPE_STR | DDS_OP_FLAG_KEY, offsetof (FreeFleetData_RobotRegistration, robot_name),
+  DDS_OP_ADR | DDS_OP_TYPE_STR, offsetof (FreeFleetData_RobotRegistration, model),
+  DDS_OP_ADR | DDS_OP_TYPE_STR, offsetof (FreeFleetData_RobotRegistration, task_id),
+  DDS_OP_RTS
+};
+
+static const dds_key_descriptor_t FreeFleetData_RobotRegistration_keys[2] =
+{
+  { "fleet_name", 0 },
+  { "robot_name", 2 }
+};
+
+const dds_topic_descriptor_t FreeFleetData_RobotRegistration_desc =
+{
+  sizeof (FreeFleetData_RobotRegistration),
+  sizeof (char *),
+  DDS_TOPIC_NO_OPTIMIZE,
+  2u,
+  "FreeFleetData::RobotRegistration",
+  FreeFleetData_RobotRegistration_keys,
+  5,
+  FreeFleetData_RobotRegistration_ops,
+  "<MetaData version=\"1.0.0\"><Module name=\"FreeFleetData\"><Struct name=\"RobotRegistration\"><Member name=\"fleet_name\"><String/></Member><Member name=\"robot_name\"><String/></Member><Member name=\"model\"><String/></Member><Member name=\"task_id\"><String/></Member></Struct></Module></MetaData>"
+};
+
+
+static const uint32_t FreeFleetData_RobotRegistrationAck_ops [] =
+{
+  DDS_OP_ADR | DDS_OP_TYPE_STR | DDS_OP_FLAG_KEY, offsetof (FreeFleetData_RobotRegistrationAck, fleet_name),
+  DDS_OP_ADR | DDS_OP_TYPE_STR | DDS_OP_FLAG_KEY, offsetof (FreeFleetData_RobotRegistrationAck, robot_name),
+  DDS_OP_ADR | DDS_OP_TYPE_4BY, offsetof (FreeFleetData_RobotRegistrationAck, robot_id),
+  DDS_OP_RTS
+};
+
+static const dds_key_descriptor_t FreeFleetData_RobotRegistrationAck_keys[2] =
+{
+  { "fleet_name", 0 },
+  { "robot_name", 2 }
+};
+
+const dds_topic_descriptor_t FreeFleetData_RobotRegistrationAck_desc =
+{
+  sizeof (FreeFleetData_RobotRegistrationAck),
+  sizeof (char *),
+  DDS_TOPIC_NO_OPTIMIZE,
+  2u,
+  "FreeFleetData::RobotRegistrationAck",
+  FreeFleetData_RobotRegistrationAck_keys,
+  4,
+  FreeFleetData_RobotRegistrationAck_ops,
+  "<MetaData version=\"1.0.0\"><Module name=\"FreeFleetData\"><Struct name=\"RobotRegistrationAck\"><Member name=\"fleet_name\"><String/></Member><Member name=\"robot_name\"><String/></Member><Member name=\"robot_id\"><ULong/></Member></Struct></Module></MetaData>"
+};
+
+
+static const uint32_t FreeFleetData_TimeSyncPing_ops [] =
+{
+  DDS_OP_ADR | DDS_OP_TYPE_STR, offsetof (FreeFleetData_TimeSyncPing, fleet_name),
+  DDS_OP_ADR | DDS_OP_TYPE_8BY, offsetof (FreeFleetData_TimeSyncPing, server_send_time),
+  DDS_OP_RTS
+};
+
+const dds_topic_descriptor_t FreeFleetData_TimeSyncPing_desc =
+{
+  sizeof (FreeFleetData_TimeSyncPing),
+  sizeof (int64_t),
+  DDS_TOPIC_NO_OPTIMIZE,
+  0u,
+  "FreeFleetData::TimeSyncPing",
+  NULL,
+  3,
+  FreeFleetData_TimeSyncPing_ops,
+  "<MetaData version=\"1.0.0\"><Module name=\"FreeFleetData\"><Struct name=\"TimeSyncPing\"><Member name=\"fleet_name\"><String/></Member><Member name=\"server_send_time\"><LongLong/></Member></Struct></Module></MetaData>"
+};
+
+
+static const uint32_t FreeFleetData_TimeSyncPong_ops [] =
+{
+  DDS_OP_ADR | DDS_OP_TYPE_STR | DDS_OP_FLAG_KEY, offsetof (FreeFleetData_TimeSyncPong, fleet_name),
+  DDS_OP_ADR | DDS_OP_TYPE_STR | DDS_OP_FLAG_KEY, offsetof (FreeFleetData_TimeSyncPong, robot_name),
+  DDS_OP_ADR | DDS_OP_TYPE_8BY, offsetof (FreeFleetData_TimeSyncPong, server_send_time),
+  DDS_OP_ADR | DDS_OP_TYPE_8BY, offsetof (FreeFleetData_TimeSyncPong, client_receive_time),
+  DDS_OP_ADR | DDS_OP_TYPE_8BY, offsetof (FreeFleetData_TimeSyncPong, client_send_time),
+  DDS_OP_RTS
+};
+
+static const dds_key_descriptor_t FreeFleetData_TimeSyncPong_keys[2] =
+{
+  { "fleet_name", 0 },
+  { "robot_name", 2 }
+};
+
+const dds_topic_descriptor_t FreeFleetData_TimeSyncPong_desc =
+{
+  sizeof (FreeFleetData_TimeSyncPong),
+  sizeof (int64_t),
+  DDS_TOPIC_NO_OPTIMIZE,
+  2u,
+  "FreeFleetData::TimeSyncPong",
+  FreeFleetData_TimeSyncPong_keys,
+  6,
+  FreeFleetData_TimeSyncPong_ops,
+  "<MetaData version=\"1.0.0\"><Module name=\"FreeFleetData\"><Struct name=\"TimeSyncPong\"><Member name=\"fleet_name\"><String/></Member><Member name=\"robot_name\"><String/></Member><Member name=\"server_send_time\"><LongLong/></Member><Member name=\"client_receive_time\"><LongLong/></Member><Member name=\"client_send_time\"><LongLong/></Member></Struct></Module></MetaData>"
+};
+
+
+static const uint32_t FreeFleetData_RequestAck_ops [] =
+{
+  DDS_OP_ADR | DDS_OP_TYPE_STR, offsetof (FreeFleetData_RequestAck, fleet_name),
+  DDS_OP_ADR | DDS_OP_TYPE_STR, offsetof (FreeFleetData_RequestAck, robot_name),
+  DDS_OP_ADR | DDS_OP_TYPE_STR, offsetof (FreeFleetData_RequestAck, task_id),
+  DDS_OP_ADR | DDS_OP_TYPE_4BY, offsetof (FreeFleetData_RequestAck, kind),
+  DDS_OP_ADR | DDS_OP_TYPE_4BY, offsetof (FreeFleetData_RequestAck, version),
+  DDS_OP_RTS
+};
+
+const dds_topic_descriptor_t FreeFleetData_RequestAck_desc =
+{
+  sizeof (FreeFleetData_RequestAck),
+  sizeof (char *),
+  DDS_TOPIC_NO_OPTIMIZE,
+  0u,
+  "FreeFleetData::RequestAck",
+  NULL,
+  6,
+  FreeFleetData_RequestAck_ops,
+  "<MetaData version=\"1.0.0\"><Module name=\"FreeFleetData\"><Struct name=\"RequestAck\"><Member name=\"fleet_name\"><String/></Member><Member name=\"robot_name\"><String/></Member><Member name=\"task_id\"><String/></Member><Member name=\"kind\"><ULong/></Member><Member name=\"version\"><ULong/></Member></Struct></Module></MetaData>"
 };
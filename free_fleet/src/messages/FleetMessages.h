@@ -60,11 +60,43 @@ extern const dds_topic_descriptor_t FreeFleetData_Location_desc;
 #define FreeFleetData_Location_free(d,o) \
 dds_sample_free ((d), &FreeFleetData_Location_desc, (o))
 
+typedef struct FreeFleetData_PathLocation
+{
+  int32_t sec;
+  uint32_t nanosec;
+  float x;
+  float y;
+  float yaw;
+  uint32_t level_index;
+} FreeFleetData_PathLocation;
+
+extern const dds_topic_descriptor_t FreeFleetData_PathLocation_desc;
+
+#define FreeFleetData_PathLocation__alloc() \
+((FreeFleetData_PathLocation*) dds_alloc (sizeof (FreeFleetData_PathLocation)));
+
+#define FreeFleetData_PathLocation_free(d,o) \
+dds_sample_free ((d), &FreeFleetData_PathLocation_desc, (o))
+
+typedef struct FreeFleetData_RobotState_level_names_seq
+{
+  uint32_t _maximum;
+  uint32_t _length;
+  char * *_buffer;
+  bool _release;
+} FreeFleetData_RobotState_level_names_seq;
+
+#define FreeFleetData_RobotState_level_names_seq__alloc() \
+((FreeFleetData_RobotState_level_names_seq*) dds_alloc (sizeof (FreeFleetData_RobotState_level_names_seq)));
+
+#define FreeFleetData_RobotState_level_names_seq_allocbuf(l) \
+((char * *) dds_alloc ((l) * sizeof (char *)))
+
 typedef struct FreeFleetData_RobotState_path_seq
 {
   uint32_t _maximum;
   uint32_t _length;
-  FreeFleetData_Location *_buffer;
+  FreeFleetData_PathLocation *_buffer;
   bool _release;
 } FreeFleetData_RobotState_path_seq;
 
@@ -72,7 +104,21 @@ typedef struct FreeFleetData_RobotState_path_seq
 ((FreeFleetData_RobotState_path_seq*) dds_alloc (sizeof (FreeFleetData_RobotState_path_seq)));
 
 #define FreeFleetData_RobotState_path_seq_allocbuf(l) \
-((FreeFleetData_Location *) dds_alloc ((l) * sizeof (FreeFleetData_Location)))
+((FreeFleetData_PathLocation *) dds_alloc ((l) * sizeof (FreeFleetData_PathLocation)))
+
+typedef struct FreeFleetData_RobotState_packed_path_seq
+{
+  uint32_t _maximum;
+  uint32_t _length;
+  uint8_t *_buffer;
+  bool _release;
+} FreeFleetData_RobotState_packed_path_seq;
+
+#define FreeFleetData_RobotState_packed_path_seq__alloc() \
+((FreeFleetData_RobotState_packed_path_seq*) dds_alloc (sizeof (FreeFleetData_RobotState_packed_path_seq)));
+
+#define FreeFleetData_RobotState_packed_path_seq_allocbuf(l) \
+((uint8_t *) dds_alloc ((l) * sizeof (uint8_t)))
 
 
 typedef struct FreeFleetData_RobotState
@@ -83,7 +129,12 @@ typedef struct FreeFleetData_RobotState
   FreeFleetData_RobotMode mode;
   float battery_percent;
   FreeFleetData_Location location;
+  FreeFleetData_RobotState_level_names_seq level_names;
   FreeFleetData_RobotState_path_seq path;
+  uint32_t path_version;
+  uint32_t path_index;
+  uint32_t robot_id;
+  FreeFleetData_RobotState_packed_path_seq packed_path;
 } FreeFleetData_RobotState;
 
 extern const dds_topic_descriptor_t FreeFleetData_RobotState_desc;
@@ -94,6 +145,50 @@ extern const dds_topic_descriptor_t FreeFleetData_RobotState_desc;
 #define FreeFleetData_RobotState_free(d,o) \
 dds_sample_free ((d), &FreeFleetData_RobotState_desc, (o))
 
+typedef struct FreeFleetData_RobotPose
+{
+  char * name;
+  FreeFleetData_RobotMode mode;
+  FreeFleetData_Location location;
+} FreeFleetData_RobotPose;
+
+extern const dds_topic_descriptor_t FreeFleetData_RobotPose_desc;
+
+#define FreeFleetData_RobotPose__alloc() \
+((FreeFleetData_RobotPose*) dds_alloc (sizeof (FreeFleetData_RobotPose)));
+
+#define FreeFleetData_RobotPose_free(d,o) \
+dds_sample_free ((d), &FreeFleetData_RobotPose_desc, (o))
+
+typedef struct FreeFleetData_FleetState_robots_seq
+{
+  uint32_t _maximum;
+  uint32_t _length;
+  FreeFleetData_RobotState *_buffer;
+  bool _release;
+} FreeFleetData_FleetState_robots_seq;
+
+#define FreeFleetData_FleetState_robots_seq__alloc() \
+((FreeFleetData_FleetState_robots_seq*) dds_alloc (sizeof (FreeFleetData_FleetState_robots_seq)));
+
+#define FreeFleetData_FleetState_robots_seq_allocbuf(l) \
+((FreeFleetData_RobotState *) dds_alloc ((l) * sizeof (FreeFleetData_RobotState)))
+
+
+typedef struct FreeFleetData_FleetState
+{
+  char * name;
+  FreeFleetData_FleetState_robots_seq robots;
+} FreeFleetData_FleetState;
+
+extern const dds_topic_descriptor_t FreeFleetData_FleetState_desc;
+
+#define FreeFleetData_FleetState__alloc() \
+((FreeFleetData_FleetState*) dds_alloc (sizeof (FreeFleetData_FleetState)));
+
+#define FreeFleetData_FleetState_free(d,o) \
+dds_sample_free ((d), &FreeFleetData_FleetState_desc, (o))
+
 
 typedef struct FreeFleetData_ModeParameter
 {
@@ -131,6 +226,7 @@ typedef struct FreeFleetData_ModeRequest
   FreeFleetData_RobotMode mode;
   char * task_id;
   FreeFleetData_ModeRequest_parameters_seq parameters;
+  uint32_t robot_id;
 } FreeFleetData_ModeRequest;
 
 extern const dds_topic_descriptor_t FreeFleetData_ModeRequest_desc;
@@ -141,11 +237,25 @@ extern const dds_topic_descriptor_t FreeFleetData_ModeRequest_desc;
 #define FreeFleetData_ModeRequest_free(d,o) \
 dds_sample_free ((d), &FreeFleetData_ModeRequest_desc, (o))
 
+typedef struct FreeFleetData_PathRequest_level_names_seq
+{
+  uint32_t _maximum;
+  uint32_t _length;
+  char * *_buffer;
+  bool _release;
+} FreeFleetData_PathRequest_level_names_seq;
+
+#define FreeFleetData_PathRequest_level_names_seq__alloc() \
+((FreeFleetData_PathRequest_level_names_seq*) dds_alloc (sizeof (FreeFleetData_PathRequest_level_names_seq)));
+
+#define FreeFleetData_PathRequest_level_names_seq_allocbuf(l) \
+((char * *) dds_alloc ((l) * sizeof (char *)))
+
 typedef struct FreeFleetData_PathRequest_path_seq
 {
   uint32_t _maximum;
   uint32_t _length;
-  FreeFleetData_Location *_buffer;
+  FreeFleetData_PathLocation *_buffer;
   bool _release;
 } FreeFleetData_PathRequest_path_seq;
 
@@ -153,15 +263,37 @@ typedef struct FreeFleetData_PathRequest_path_seq
 ((FreeFleetData_PathRequest_path_seq*) dds_alloc (sizeof (FreeFleetData_PathRequest_path_seq)));
 
 #define FreeFleetData_PathRequest_path_seq_allocbuf(l) \
-((FreeFleetData_Location *) dds_alloc ((l) * sizeof (FreeFleetData_Location)))
+((FreeFleetData_PathLocation *) dds_alloc ((l) * sizeof (FreeFleetData_PathLocation)))
+
+typedef struct FreeFleetData_PathRequest_packed_path_seq
+{
+  uint32_t _maximum;
+  uint32_t _length;
+  uint8_t *_buffer;
+  bool _release;
+} FreeFleetData_PathRequest_packed_path_seq;
+
+#define FreeFleetData_PathRequest_packed_path_seq__alloc() \
+((FreeFleetData_PathRequest_packed_path_seq*) dds_alloc (sizeof (FreeFleetData_PathRequest_packed_path_seq)));
+
+#define FreeFleetData_PathRequest_packed_path_seq_allocbuf(l) \
+((uint8_t *) dds_alloc ((l) * sizeof (uint8_t)))
 
 
 typedef struct FreeFleetData_PathRequest
 {
   char * fleet_name;
   char * robot_name;
+  FreeFleetData_PathRequest_level_names_seq level_names;
   FreeFleetData_PathRequest_path_seq path;
   char * task_id;
+  uint32_t version;
+  uint32_t operation;
+  uint32_t base_version;
+  uint32_t start_index;
+  uint32_t robot_id;
+  FreeFleetData_PathRequest_packed_path_seq packed_path;
+  char * after_task_id;
 } FreeFleetData_PathRequest;
 
 extern const dds_topic_descriptor_t FreeFleetData_PathRequest_desc;
@@ -179,6 +311,8 @@ typedef struct FreeFleetData_DestinationRequest
   char * robot_name;
   FreeFleetData_Location destination;
   char * task_id;
+  uint32_t robot_id;
+  char * after_task_id;
 } FreeFleetData_DestinationRequest;
 
 extern const dds_topic_descriptor_t FreeFleetData_DestinationRequest_desc;
@@ -189,6 +323,85 @@ extern const dds_topic_descriptor_t FreeFleetData_DestinationRequest_desc;
 #define FreeFleetData_DestinationRequest_free(d,o) \
 dds_sample_free ((d), &FreeFleetData_DestinationRequest_desc, (o))
 
+typedef struct FreeFleetData_RobotRegistration
+{
+  char * fleet_name;
+  char * robot_name;
+  char * model;
+  char * task_id;
+} FreeFleetData_RobotRegistration;
+
+extern const dds_topic_descriptor_t FreeFleetData_RobotRegistration_desc;
+
+#define FreeFleetData_RobotRegistration__alloc() \
+((FreeFleetData_RobotRegistration*) dds_alloc (sizeof (FreeFleetData_RobotRegistration)));
+
+#define FreeFleetData_RobotRegistration_free(d,o) \
+dds_sample_free ((d), &FreeFleetData_RobotRegistration_desc, (o))
+
+typedef struct FreeFleetData_RobotRegistrationAck
+{
+  char * fleet_name;
+  char * robot_name;
+  uint32_t robot_id;
+} FreeFleetData_RobotRegistrationAck;
+
+extern const dds_topic_descriptor_t FreeFleetData_RobotRegistrationAck_desc;
+
+#define FreeFleetData_RobotRegistrationAck__alloc() \
+((FreeFleetData_RobotRegistrationAck*) dds_alloc (sizeof (FreeFleetData_RobotRegistrationAck)));
+
+#define FreeFleetData_RobotRegistrationAck_free(d,o) \
+dds_sample_free ((d), &FreeFleetData_RobotRegistrationAck_desc, (o))
+
+typedef struct FreeFleetData_TimeSyncPing
+{
+  char * fleet_name;
+  int64_t server_send_time;
+} FreeFleetData_TimeSyncPing;
+
+extern const dds_topic_descriptor_t FreeFleetData_TimeSyncPing_desc;
+
+#define FreeFleetData_TimeSyncPing__alloc() \
+((FreeFleetData_TimeSyncPing*) dds_alloc (sizeof (FreeFleetData_TimeSyncPing)));
+
+#define FreeFleetData_TimeSyncPing_free(d,o) \
+dds_sample_free ((d), &FreeFleetData_TimeSyncPing_desc, (o))
+
+typedef struct FreeFleetData_TimeSyncPong
+{
+  char * fleet_name;
+  char * robot_name;
+  int64_t server_send_time;
+  int64_t client_receive_time;
+  int64_t client_send_time;
+} FreeFleetData_TimeSyncPong;
+
+extern const dds_topic_descriptor_t FreeFleetData_TimeSyncPong_desc;
+
+#define FreeFleetData_TimeSyncPong__alloc() \
+((FreeFleetData_TimeSyncPong*) dds_alloc (sizeof (FreeFleetData_TimeSyncPong)));
+
+#define FreeFleetData_TimeSyncPong_free(d,o) \
+dds_sample_free ((d), &FreeFleetData_TimeSyncPong_desc, (o))
+
+typedef struct FreeFleetData_RequestAck
+{
+  char * fleet_name;
+  char * robot_name;
+  char * task_id;
+  uint32_t kind;
+  uint32_t version;
+} FreeFleetData_RequestAck;
+
+extern const dds_topic_descriptor_t FreeFleetData_RequestAck_desc;
+
+#define FreeFleetData_RequestAck__alloc() \
+((FreeFleetData_RequestAck*) dds_alloc (sizeof (FreeFleetData_RequestAck)));
+
+#define FreeFleetData_RequestAck_free(d,o) \
+dds_sample_free ((d), &FreeFleetData_RequestAck_desc, (o))
+
 #ifdef __cplusplus
 }
 #endif
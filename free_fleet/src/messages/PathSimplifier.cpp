@@ -0,0 +1,142 @@
+/*
+ * Copyright (C) 2019 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#include <cmath>
+#include <limits>
+#include <algorithm>
+
+#include "PathSimplifier.hpp"
+
+namespace free_fleet {
+namespace messages {
+
+namespace {
+
+double time_of(const Location& _location)
+{
+  return _location.sec + _location.nanosec * 1e-9;
+}
+
+double wrap_angle(double _angle)
+{
+  return std::atan2(std::sin(_angle), std::cos(_angle));
+}
+
+} // namespace anonymous
+
+PathSimplifier::PathSimplifier(
+    double _distance_tolerance, double _yaw_tolerance) :
+  distance_tolerance(_distance_tolerance),
+  yaw_tolerance(_yaw_tolerance)
+{}
+
+double PathSimplifier::error(
+    const Location& _first, const Location& _last,
+    const Location& _waypoint) const
+{
+  const double dx = _last.x - _first.x;
+  const double dy = _last.y - _first.y;
+
+  // The waypoint is compared to where the robot would be at its time,
+  // paths without timing fall back to the closest point of the segment
+  double s = 0.0;
+  const double duration = time_of(_last) - time_of(_first);
+  if (duration > 0.0)
+    s = (time_of(_waypoint) - time_of(_first)) / duration;
+  else if (dx != 0.0 || dy != 0.0)
+    s = ((_waypoint.x - _first.x) * dx + (_waypoint.y - _first.y) * dy) /
+        (dx * dx + dy * dy);
+  s = std::min(1.0, std::max(0.0, s));
+
+  const double distance = std::hypot(
+      _waypoint.x - (_first.x + s * dx), _waypoint.y - (_first.y + s * dy));
+  const double yaw = _first.yaw + s * wrap_angle(_last.yaw - _first.yaw);
+  const double yaw_error = std::abs(wrap_angle(_waypoint.yaw - yaw));
+
+  const double infinity = std::numeric_limits<double>::infinity();
+  return std::max(
+      distance_tolerance > 0.0 ?
+          distance / distance_tolerance : (distance > 0.0 ? infinity : 0.0),
+      yaw_tolerance > 0.0 ?
+          yaw_error / yaw_tolerance : (yaw_error > 0.0 ? infinity : 0.0));
+}
+
+const std::vector<Location>& PathSimplifier::simplify(
+    const std::vector<Location>& _path)
+{
+  const size_t length = _path.size();
+  keep.assign(length, 0);
+  segments.clear();
+
+  // Each stretch of the path on the same level is simplified on its own
+  size_t level_start = 0;
+  for (size_t i = 1; i <= length; ++i)
+  {
+    if (i < length && _path[i].level_name == _path[level_start].level_name)
+      continue;
+    keep[level_start] = 1;
+    keep[i - 1] = 1;
+    if (i - 1 > level_start + 1)
+      segments.emplace_back(level_start, i - 1);
+    level_start = i;
+  }
+
+  while (!segments.empty())
+  {
+    const size_t first = segments.back().first;
+    const size_t last = segments.back().second;
+    segments.pop_back();
+
+    size_t furthest = first;
+    double furthest_error = 1.0;
+    for (size_t i = first + 1; i < last; ++i)
+    {
+      const double waypoint_error = error(_path[first], _path[last], _path[i]);
+      if (waypoint_error > furthest_error)
+      {
+        furthest = i;
+        furthest_error = waypoint_error;
+      }
+    }
+    if (furthest == first)
+      continue;
+
+    keep[furthest] = 1;
+    if (furthest > first + 1)
+      segments.emplace_back(first, furthest);
+    if (last > furthest + 1)
+      segments.emplace_back(furthest, last);
+  }
+
+  // Copying into the existing waypoints keeps their level name capacities
+  size_t kept = 0;
+  for (size_t i = 0; i < length; ++i)
+  {
+    if (!keep[i])
+      continue;
+    if (kept < simplified.size())
+      simplified[kept] = _path[i];
+    else
+      simplified.push_back(_path[i]);
+    ++kept;
+  }
+  simplified.resize(kept);
+  return simplified;
+}
+
+} // namespace messages
+} // namespace free_fleet
@@ -0,0 +1,78 @@
+/*
+ * Copyright (C) 2019 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#ifndef FREE_FLEET__SRC__MESSAGES__PATHSIMPLIFIER_HPP
+#define FREE_FLEET__SRC__MESSAGES__PATHSIMPLIFIER_HPP
+
+#include <vector>
+#include <utility>
+
+#include <free_fleet/messages/Location.hpp>
+
+namespace free_fleet {
+namespace messages {
+
+/// Drops the waypoints of a path that are within tolerance of the segment
+/// between the waypoints that are kept around them, using Douglas-Peucker.
+/// Each waypoint is compared to where the robot would be along the segment
+/// at the time of the waypoint, and with the yaw it would have by then, so
+/// that waypoints the robot is meant to wait at, turn at, or reach at a
+/// different pace are kept. The first and last waypoints, and the waypoints
+/// on either side of a level change, are always kept. Buffers are reused
+/// between calls, a simplifier is only used from one thread at a time.
+class PathSimplifier
+{
+public:
+
+  /// \param[in] distance_tolerance
+  ///   Largest distance in meters between a dropped waypoint and where the
+  ///   robot would be at its time along the simplified path.
+  /// \param[in] yaw_tolerance
+  ///   Largest yaw difference in radians between a dropped waypoint and the
+  ///   simplified path.
+  PathSimplifier(double distance_tolerance, double yaw_tolerance);
+
+  /// \param[in] path
+  ///   Path to be simplified.
+  /// \return
+  ///   Simplified path, which stays valid until the next call.
+  const std::vector<Location>& simplify(const std::vector<Location>& path);
+
+private:
+
+  /// How far off the waypoint is from the segment between the first and
+  /// last waypoints, relative to the tolerances, only waypoints above 1 are
+  /// kept.
+  double error(
+      const Location& first, const Location& last,
+      const Location& waypoint) const;
+
+  double distance_tolerance;
+
+  double yaw_tolerance;
+
+  std::vector<char> keep;
+
+  std::vector<std::pair<size_t, size_t>> segments;
+
+  std::vector<Location> simplified;
+};
+
+} // namespace messages
+} // namespace free_fleet
+
+#endif // FREE_FLEET__SRC__MESSAGES__PATHSIMPLIFIER_HPP
@@ -0,0 +1,179 @@
+/*
+ * Copyright (C) 2019 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#include <free_fleet/messages/RobotStateView.hpp>
+
+#include "FleetMessages.h"
+#include "path_packing.hpp"
+#include "message_utils.hpp"
+
+namespace free_fleet {
+namespace messages {
+
+namespace {
+
+const char* view_string(const char* _dds_str)
+{
+  return _dds_str ? _dds_str : "";
+}
+
+LocationView waypoint_view(
+    const FreeFleetData_RobotState& _sample,
+    const FreeFleetData_PathLocation& _location)
+{
+  const char* level_name =
+      _location.level_index < _sample.level_names._length ?
+      _sample.level_names._buffer[_location.level_index] : nullptr;
+  return LocationView{
+      _location.sec, _location.nanosec, _location.x, _location.y,
+      _location.yaw, view_string(level_name)};
+}
+
+} // namespace anonymous
+
+RobotStateView::RobotStateView(
+    const FreeFleetData_RobotState& _sample,
+    int64_t _clock_offset) :
+  sample(&_sample),
+  clock_offset(_clock_offset)
+{}
+
+RobotStateView::RobotStateView(
+    const FreeFleetData_RobotState& _sample,
+    const char* _model,
+    const char* _task_id,
+    int64_t _clock_offset) :
+  sample(&_sample),
+  registered_model(_model),
+  registered_task_id(_task_id),
+  clock_offset(_clock_offset)
+{}
+
+RobotStateView::RobotStateView(
+    const FreeFleetData_RobotState& _metadata,
+    const FreeFleetData_RobotPose& _pose,
+    const char* _model,
+    const char* _task_id,
+    int64_t _clock_offset) :
+  sample(&_metadata),
+  pose(&_pose),
+  registered_model(_model),
+  registered_task_id(_task_id),
+  clock_offset(_clock_offset)
+{}
+
+const char* RobotStateView::name() const
+{
+  return view_string(sample->name);
+}
+
+const char* RobotStateView::model() const
+{
+  return registered_model ? registered_model : view_string(sample->model);
+}
+
+const char* RobotStateView::task_id() const
+{
+  return registered_task_id ?
+      registered_task_id : view_string(sample->task_id);
+}
+
+RobotMode RobotStateView::mode() const
+{
+  RobotMode mode;
+  mode.mode = pose ? pose->mode.mode : sample->mode.mode;
+  return mode;
+}
+
+float RobotStateView::battery_percent() const
+{
+  return sample->battery_percent;
+}
+
+LocationView RobotStateView::location() const
+{
+  const FreeFleetData_Location& location =
+      pose ? pose->location : sample->location;
+  LocationView view{
+      location.sec, location.nanosec, location.x, location.y, location.yaw,
+      view_string(location.level_name)};
+  correct_clock_offset(clock_offset, view.sec, view.nanosec);
+  return view;
+}
+
+size_t RobotStateView::path_size() const
+{
+  if (sample->packed_path._length > 0)
+    return unpacked_path().size();
+  return sample->path._length;
+}
+
+LocationView RobotStateView::path(size_t _index) const
+{
+  if (sample->packed_path._length > 0)
+    return unpacked_path()[_index];
+  return waypoint_view(*sample, sample->path._buffer[_index]);
+}
+
+const std::vector<LocationView>& RobotStateView::unpacked_path() const
+{
+  if (path_unpacked)
+    return unpacked_waypoints;
+
+  PackedPathReader reader(
+      sample->packed_path._buffer, sample->packed_path._length);
+  unpacked_waypoints.reserve(reader.size());
+  FreeFleetData_PathLocation location;
+  while (reader.next(location))
+    unpacked_waypoints.push_back(waypoint_view(*sample, location));
+  path_unpacked = true;
+  return unpacked_waypoints;
+}
+
+uint32_t RobotStateView::path_version() const
+{
+  return sample->path_version;
+}
+
+uint32_t RobotStateView::path_index() const
+{
+  return sample->path_index;
+}
+
+uint32_t RobotStateView::robot_id() const
+{
+  return sample->robot_id;
+}
+
+void convert(const RobotStateView& _input, RobotState& _output)
+{
+  convert(*_input.sample, _output);
+  if (_input.pose)
+  {
+    convert(_input.pose->mode, _output.mode);
+    convert(_input.pose->location, _output.location);
+  }
+  correct_clock_offset(
+      _input.clock_offset, _output.location.sec, _output.location.nanosec);
+  if (_input.registered_model)
+    _output.model = _input.registered_model;
+  if (_input.registered_task_id)
+    _output.task_id = _input.registered_task_id;
+}
+
+} // namespace messages
+} // namespace free_fleet
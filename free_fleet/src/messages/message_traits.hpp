@@ -0,0 +1,226 @@
+/*
+ * Copyright (C) 2019 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#ifndef FREE_FLEET__SRC__MESSAGES__MESSAGE_TRAITS_HPP
+#define FREE_FLEET__SRC__MESSAGES__MESSAGE_TRAITS_HPP
+
+#include <tuple>
+#include <vector>
+
+#include <free_fleet/messages/Location.hpp>
+#include <free_fleet/messages/RobotMode.hpp>
+#include <free_fleet/messages/RobotState.hpp>
+#include <free_fleet/messages/FleetState.hpp>
+#include <free_fleet/messages/ModeParameter.hpp>
+#include <free_fleet/messages/ModeRequest.hpp>
+#include <free_fleet/messages/PathRequest.hpp>
+#include <free_fleet/messages/DestinationRequest.hpp>
+
+#include "FleetMessages.h"
+
+namespace free_fleet {
+namespace messages {
+
+/// Pairs up a field of a message with the field of its DDS message that it
+/// is sent as.
+template <typename Message, typename DDSMessage, typename Type,
+    typename DDSType>
+struct Field
+{
+  Type Message::* member;
+  DDSType DDSMessage::* dds_member;
+};
+
+template <typename Message, typename DDSMessage, typename Type,
+    typename DDSType>
+constexpr Field<Message, DDSMessage, Type, DDSType> field(
+    Type Message::* _member, DDSType DDSMessage::* _dds_member)
+{
+  return {_member, _dds_member};
+}
+
+/// Path of a message, which is sent as waypoints that index into a table of
+/// level names, either as they are or packed, see path_packing.hpp.
+template <typename Message, typename DDSMessage, typename LevelNames,
+    typename Path, typename PackedPath>
+struct PathField
+{
+  std::vector<Location> Message::* member;
+  LevelNames DDSMessage::* dds_level_names;
+  Path DDSMessage::* dds_path;
+  PackedPath DDSMessage::* dds_packed_path;
+};
+
+template <typename Message, typename DDSMessage, typename LevelNames,
+    typename Path, typename PackedPath>
+constexpr PathField<Message, DDSMessage, LevelNames, Path, PackedPath>
+path_field(
+    std::vector<Location> Message::* _member,
+    LevelNames DDSMessage::* _dds_level_names,
+    Path DDSMessage::* _dds_path,
+    PackedPath DDSMessage::* _dds_packed_path)
+{
+  return {_member, _dds_level_names, _dds_path, _dds_packed_path};
+}
+
+/// Describes how each message is laid out as its DDS message, the
+/// converters in message_utils are generated from these field lists. Every
+/// field of the DDS message needs to be listed, new fields only need to be
+/// added here.
+template <typename Message>
+struct MessageTraits;
+
+template <>
+struct MessageTraits<RobotMode>
+{
+  using DDSMessage = FreeFleetData_RobotMode;
+
+  static constexpr auto fields()
+  {
+    return std::make_tuple(
+        field(&RobotMode::mode, &DDSMessage::mode));
+  }
+};
+
+template <>
+struct MessageTraits<Location>
+{
+  using DDSMessage = FreeFleetData_Location;
+
+  static constexpr auto fields()
+  {
+    return std::make_tuple(
+        field(&Location::sec, &DDSMessage::sec),
+        field(&Location::nanosec, &DDSMessage::nanosec),
+        field(&Location::x, &DDSMessage::x),
+        field(&Location::y, &DDSMessage::y),
+        field(&Location::yaw, &DDSMessage::yaw),
+        field(&Location::level_name, &DDSMessage::level_name));
+  }
+};
+
+template <>
+struct MessageTraits<RobotState>
+{
+  using DDSMessage = FreeFleetData_RobotState;
+
+  static constexpr auto fields()
+  {
+    return std::make_tuple(
+        field(&RobotState::name, &DDSMessage::name),
+        field(&RobotState::model, &DDSMessage::model),
+        field(&RobotState::task_id, &DDSMessage::task_id),
+        field(&RobotState::mode, &DDSMessage::mode),
+        field(&RobotState::battery_percent, &DDSMessage::battery_percent),
+        field(&RobotState::location, &DDSMessage::location),
+        path_field(
+            &RobotState::path, &DDSMessage::level_names, &DDSMessage::path,
+            &DDSMessage::packed_path),
+        field(&RobotState::path_version, &DDSMessage::path_version),
+        field(&RobotState::path_index, &DDSMessage::path_index),
+        field(&RobotState::robot_id, &DDSMessage::robot_id));
+  }
+};
+
+template <>
+struct MessageTraits<FleetState>
+{
+  using DDSMessage = FreeFleetData_FleetState;
+
+  static constexpr auto fields()
+  {
+    return std::make_tuple(
+        field(&FleetState::name, &DDSMessage::name),
+        field(&FleetState::robots, &DDSMessage::robots));
+  }
+};
+
+template <>
+struct MessageTraits<ModeParameter>
+{
+  using DDSMessage = FreeFleetData_ModeParameter;
+
+  static constexpr auto fields()
+  {
+    return std::make_tuple(
+        field(&ModeParameter::name, &DDSMessage::name),
+        field(&ModeParameter::value, &DDSMessage::value));
+  }
+};
+
+template <>
+struct MessageTraits<ModeRequest>
+{
+  using DDSMessage = FreeFleetData_ModeRequest;
+
+  static constexpr auto fields()
+  {
+    return std::make_tuple(
+        field(&ModeRequest::fleet_name, &DDSMessage::fleet_name),
+        field(&ModeRequest::robot_name, &DDSMessage::robot_name),
+        field(&ModeRequest::mode, &DDSMessage::mode),
+        field(&ModeRequest::task_id, &DDSMessage::task_id),
+        field(&ModeRequest::parameters, &DDSMessage::parameters),
+        field(&ModeRequest::robot_id, &DDSMessage::robot_id));
+  }
+};
+
+template <>
+struct MessageTraits<PathRequest>
+{
+  using DDSMessage = FreeFleetData_PathRequest;
+
+  static constexpr auto fields()
+  {
+    return std::make_tuple(
+        field(&PathRequest::fleet_name, &DDSMessage::fleet_name),
+        field(&PathRequest::robot_name, &DDSMessage::robot_name),
+        path_field(
+            &PathRequest::path, &DDSMessage::level_names, &DDSMessage::path,
+            &DDSMessage::packed_path),
+        field(&PathRequest::task_id, &DDSMessage::task_id),
+        field(&PathRequest::version, &DDSMessage::version),
+        field(&PathRequest::operation, &DDSMessage::operation),
+        field(&PathRequest::base_version, &DDSMessage::base_version),
+        field(&PathRequest::start_index, &DDSMessage::start_index),
+        field(&PathRequest::robot_id, &DDSMessage::robot_id),
+        field(&PathRequest::after_task_id, &DDSMessage::after_task_id));
+  }
+};
+
+template <>
+struct MessageTraits<DestinationRequest>
+{
+  using DDSMessage = FreeFleetData_DestinationRequest;
+
+  static constexpr auto fields()
+  {
+    return std::make_tuple(
+        field(&DestinationRequest::fleet_name, &DDSMessage::fleet_name),
+        field(&DestinationRequest::robot_name, &DDSMessage::robot_name),
+        field(&DestinationRequest::destination, &DDSMessage::destination),
+        field(&DestinationRequest::task_id, &DDSMessage::task_id),
+        field(&DestinationRequest::robot_id, &DDSMessage::robot_id),
+        field(
+            &DestinationRequest::after_task_id, &DDSMessage::after_task_id));
+  }
+};
+
+} // namespace messages
+} // namespace free_fleet
+
+#endif // FREE_FLEET__SRC__MESSAGES__MESSAGE_TRAITS_HPP
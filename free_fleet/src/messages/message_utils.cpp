@@ -15,181 +15,623 @@
  *
  */
 
+#include <tuple>
+#include <string>
+#include <vector>
+#include <cstring>
+#include <utility>
+#include <type_traits>
+
 #include <dds/dds.h>
 
 #include "../dds_utils/common.hpp"
 
+#include "path_packing.hpp"
+#include "message_traits.hpp"
 #include "message_utils.hpp"
 
 namespace free_fleet {
 namespace messages {
 
+namespace {
+
+/// Resizes a DDS sequence, only growing its buffer when the new length goes
+/// beyond its capacity. Elements past the new length are kept around with
+/// their strings, to be reused when the sequence grows back.
+template<typename Sequence>
+void resize_sequence(Sequence& _sequence, size_t _length)
+{
+  using Element = typename std::remove_pointer<
+      decltype(_sequence._buffer)>::type;
+
+  if (_length > _sequence._maximum)
+  {
+    // dds_alloc zeroes the new elements
+    Element* buffer =
+        static_cast<Element*>(dds_alloc(_length * sizeof(Element)));
+    if (_sequence._buffer)
+    {
+      std::memcpy(
+          buffer, _sequence._buffer, _sequence._maximum * sizeof(Element));
+      dds_free(_sequence._buffer);
+    }
+    _sequence._buffer = buffer;
+    _sequence._maximum = static_cast<uint32_t>(_length);
+  }
+  _sequence._length = static_cast<uint32_t>(_length);
+  _sequence._release = true;
+}
+
+/// Fills in a path along with the table of level names its waypoints index
+/// into, so that each level name only goes over the wire once per message.
+/// Consecutive waypoints are mostly on the same level, which saves searching
+/// the table for most of them.
+template<typename LevelNames, typename Path>
+void convert_path(
+    const std::vector<Location>& _input,
+    LevelNames& _level_names,
+    Path& _path)
+{
+  size_t path_length = _input.size();
+  resize_sequence(_path, path_length);
+
+  uint32_t level_names_num = 0;
+  for (size_t i = 0; i < path_length; ++i)
+  {
+    const Location& location = _input[i];
+    auto& path_location = _path._buffer[i];
+    path_location.sec = location.sec;
+    path_location.nanosec = location.nanosec;
+    path_location.x = location.x;
+    path_location.y = location.y;
+    path_location.yaw = location.yaw;
+
+    if (i > 0 && location.level_name == _input[i - 1].level_name)
+    {
+      path_location.level_index = _path._buffer[i - 1].level_index;
+      continue;
+    }
+
+    uint32_t level_index = 0;
+    while (level_index < level_names_num &&
+        std::strcmp(
+            _level_names._buffer[level_index],
+            location.level_name.c_str()) != 0)
+      ++level_index;
+
+    if (level_index == level_names_num)
+    {
+      if (level_names_num >= _level_names._maximum)
+        resize_sequence(_level_names, level_names_num + 1);
+      common::dds_string_assign(
+          _level_names._buffer[level_names_num], location.level_name);
+      ++level_names_num;
+    }
+    path_location.level_index = level_index;
+  }
+  resize_sequence(_level_names, level_names_num);
+}
+
+/// Expands a waypoint received with its table of level names. Waypoints
+/// that index past the table end up with an empty level name.
+template<typename LevelNames>
+void convert_waypoint(
+    const LevelNames& _level_names,
+    const FreeFleetData_PathLocation& _path_location,
+    Location& _location)
+{
+  _location.sec = _path_location.sec;
+  _location.nanosec = _path_location.nanosec;
+  _location.x = _path_location.x;
+  _location.y = _path_location.y;
+  _location.yaw = _path_location.yaw;
+
+  if (_path_location.level_index < _level_names._length &&
+      _level_names._buffer[_path_location.level_index])
+    _location.level_name = _level_names._buffer[_path_location.level_index];
+  else
+    _location.level_name.clear();
+}
+
+/// Expands a path received with its table of level names, out of its packed
+/// waypoints when there are any. A malformed packed path is cut short at
+/// the last waypoint that could be read.
+template<typename LevelNames, typename Path, typename PackedPath>
+void convert_path(
+    const LevelNames& _level_names,
+    const Path& _path,
+    const PackedPath& _packed_path,
+    std::vector<Location>& _output)
+{
+  if (_packed_path._length == 0)
+  {
+    _output.resize(_path._length);
+    for (uint32_t i = 0; i < _path._length; ++i)
+      convert_waypoint(_level_names, _path._buffer[i], _output[i]);
+    return;
+  }
+
+  PackedPathReader reader(_packed_path._buffer, _packed_path._length);
+  _output.resize(reader.size());
+  FreeFleetData_PathLocation path_location;
+  size_t unpacked = 0;
+  while (unpacked < _output.size() && reader.next(path_location))
+    convert_waypoint(_level_names, path_location, _output[unpacked++]);
+  _output.resize(unpacked);
+}
+
+/// Moves the waypoints of a path into its packed path, when it has at least
+/// the threshold number of waypoints and packing makes it smaller.
+template<typename Path, typename PackedPath>
+bool pack_path(Path& _path, PackedPath& _packed_path, size_t _threshold)
+{
+  if (_threshold == 0 || _path._length < _threshold)
+    return false;
+
+  resize_sequence(_packed_path, packed_path_capacity(_path._length));
+  const size_t packed_size =
+      pack_waypoints(_path._buffer, _path._length, _packed_path._buffer);
+  if (packed_size == 0 ||
+      packed_size >= _path._length * sizeof(*_path._buffer))
+  {
+    _packed_path._length = 0;
+    return false;
+  }
+  _packed_path._length = static_cast<uint32_t>(packed_size);
+  _path._length = 0;
+  return true;
+}
+
+// Each value is encoded into, and decoded from, its DDS counterpart through
+// one of the overloads below, they are all declared up front so that they
+// can be nested within each other in any order.
+
+template<typename Type, typename DDSType>
+typename std::enable_if<std::is_arithmetic<Type>::value>::type
+encode(const Type& _input, DDSType& _output);
+
+void encode(const std::string& _input, char*& _output);
+
+template<typename Message>
+void encode(
+    const Message& _input,
+    typename MessageTraits<Message>::DDSMessage& _output);
+
+template<typename Type, typename Sequence>
+void encode(const std::vector<Type>& _input, Sequence& _output);
+
+template<typename DDSType, typename Type>
+typename std::enable_if<std::is_arithmetic<Type>::value>::type
+decode(const DDSType& _input, Type& _output);
+
+void decode(const char* _input, std::string& _output);
+
+template<typename Message>
+void decode(
+    const typename MessageTraits<Message>::DDSMessage& _input,
+    Message& _output);
+
+template<typename Sequence, typename Type>
+void decode(const Sequence& _input, std::vector<Type>& _output);
+
+/// Calls the function on every field description of the message, in the
+/// order they were listed.
+template<typename Fields, typename Function, size_t... Indices>
+void for_each_field(
+    const Fields& _fields, Function&& _function,
+    std::index_sequence<Indices...>)
+{
+  using Expand = int[];
+  (void) Expand{0, (_function(std::get<Indices>(_fields)), 0)...};
+}
+
+template<typename Message, typename Function>
+void for_each_field(Function&& _function)
+{
+  constexpr auto fields = MessageTraits<Message>::fields();
+  for_each_field(
+      fields, std::forward<Function>(_function),
+      std::make_index_sequence<std::tuple_size<decltype(fields)>::value>());
+}
+
+template<typename Message, typename DDSMessage, typename Type,
+    typename DDSType>
+void encode_field(
+    const Field<Message, DDSMessage, Type, DDSType>& _field,
+    const Message& _input,
+    DDSMessage& _output)
+{
+  encode(_input.*_field.member, _output.*_field.dds_member);
+}
+
+/// Paths are always encoded as they are, see pack_path
+template<typename Message, typename DDSMessage, typename LevelNames,
+    typename Path, typename PackedPath>
+void encode_field(
+    const PathField<Message, DDSMessage, LevelNames, Path, PackedPath>& _field,
+    const Message& _input,
+    DDSMessage& _output)
+{
+  convert_path(
+      _input.*_field.member,
+      _output.*_field.dds_level_names,
+      _output.*_field.dds_path);
+  (_output.*_field.dds_packed_path)._length = 0;
+}
+
+/// Encodes the field the same way, with another path in place of the path
+/// of the message
+template<typename Message, typename DDSMessage, typename Type,
+    typename DDSType>
+void encode_field(
+    const Field<Message, DDSMessage, Type, DDSType>& _field,
+    const Message& _input,
+    const std::vector<Location>&,
+    DDSMessage& _output)
+{
+  encode_field(_field, _input, _output);
+}
+
+template<typename Message, typename DDSMessage, typename LevelNames,
+    typename Path, typename PackedPath>
+void encode_field(
+    const PathField<Message, DDSMessage, LevelNames, Path, PackedPath>& _field,
+    const Message&,
+    const std::vector<Location>& _path,
+    DDSMessage& _output)
+{
+  convert_path(
+      _path,
+      _output.*_field.dds_level_names,
+      _output.*_field.dds_path);
+  (_output.*_field.dds_packed_path)._length = 0;
+}
+
+template<typename Message, typename DDSMessage, typename Type,
+    typename DDSType>
+void decode_field(
+    const Field<Message, DDSMessage, Type, DDSType>& _field,
+    const DDSMessage& _input,
+    Message& _output)
+{
+  decode(_input.*_field.dds_member, _output.*_field.member);
+}
+
+template<typename Message, typename DDSMessage, typename LevelNames,
+    typename Path, typename PackedPath>
+void decode_field(
+    const PathField<Message, DDSMessage, LevelNames, Path, PackedPath>& _field,
+    const DDSMessage& _input,
+    Message& _output)
+{
+  convert_path(
+      _input.*_field.dds_level_names,
+      _input.*_field.dds_path,
+      _input.*_field.dds_packed_path,
+      _output.*_field.member);
+}
+
+template<typename Type, typename DDSType>
+typename std::enable_if<std::is_arithmetic<Type>::value>::type
+encode(const Type& _input, DDSType& _output)
+{
+  _output = _input;
+}
+
+void encode(const std::string& _input, char*& _output)
+{
+  common::dds_string_assign(_output, _input);
+}
+
+template<typename Message>
+void encode(
+    const Message& _input,
+    typename MessageTraits<Message>::DDSMessage& _output)
+{
+  for_each_field<Message>(
+      [&](const auto& _field) { encode_field(_field, _input, _output); });
+}
+
+template<typename Type, typename Sequence>
+void encode(const std::vector<Type>& _input, Sequence& _output)
+{
+  size_t length = _input.size();
+  resize_sequence(_output, length);
+  for (size_t i = 0; i < length; ++i)
+    encode(_input[i], _output._buffer[i]);
+}
+
+template<typename DDSType, typename Type>
+typename std::enable_if<std::is_arithmetic<Type>::value>::type
+decode(const DDSType& _input, Type& _output)
+{
+  _output = _input;
+}
+
+void decode(const char* _input, std::string& _output)
+{
+  if (_input)
+    _output = _input;
+  else
+    _output.clear();
+}
+
+template<typename Message>
+void decode(
+    const typename MessageTraits<Message>::DDSMessage& _input,
+    Message& _output)
+{
+  for_each_field<Message>(
+      [&](const auto& _field) { decode_field(_field, _input, _output); });
+}
+
+/// Existing elements are decoded into in place, keeping their capacities
+template<typename Sequence, typename Type>
+void decode(const Sequence& _input, std::vector<Type>& _output)
+{
+  _output.resize(_input._length);
+  for (uint32_t i = 0; i < _input._length; ++i)
+    decode(_input._buffer[i], _output[i]);
+}
+
+} // namespace anonymous
+
 void convert(const RobotMode& _input, FreeFleetData_RobotMode& _output)
 {
-  // Consequently, free fleet robot modes need to be ordered similarly as 
-  // RMF robot modes.
-  _output.mode = _input.mode;
+  encode(_input, _output);
 }
 
 void convert(const FreeFleetData_RobotMode& _input, RobotMode& _output)
 {
-  // Consequently, free fleet robot modes need to be ordered similarly as 
-  // RMF robot modes.
-  _output.mode = _input.mode;
+  decode(_input, _output);
 }
 
 void convert(const Location& _input, FreeFleetData_Location& _output)
 {
-  _output.sec = _input.sec;
-  _output.nanosec = _input.nanosec;
-  _output.x = _input.x;
-  _output.y = _input.y;
-  _output.yaw = _input.yaw;
-  _output.level_name = common::dds_string_alloc_and_copy(_input.level_name);
+  encode(_input, _output);
 }
 
 void convert(const FreeFleetData_Location& _input, Location& _output)
 {
-  _output.sec = _input.sec;
-  _output.nanosec = _input.nanosec;
-  _output.x = _input.x;
-  _output.y = _input.y;
-  _output.yaw = _input.yaw;
-  _output.level_name = std::string(_input.level_name);
+  decode(_input, _output);
 }
 
 void convert(const RobotState& _input, FreeFleetData_RobotState& _output)
 {
-  _output.name = common::dds_string_alloc_and_copy(_input.name);
-  _output.model = common::dds_string_alloc_and_copy(_input.model);
-  _output.task_id = common::dds_string_alloc_and_copy(_input.task_id);
-  convert(_input.mode, _output.mode);
-  _output.battery_percent = _input.battery_percent;
-  convert(_input.location, _output.location);
-
-  size_t path_length = _input.path.size();
-  _output.path._maximum = static_cast<uint32_t>(path_length);
-  _output.path._length = static_cast<uint32_t>(path_length);
-  _output.path._buffer = 
-      FreeFleetData_RobotState_path_seq_allocbuf(path_length);
-  _output.path._release = false;
-  for (size_t i = 0; i < path_length; ++i)
-    convert(_input.path[i], _output.path._buffer[i]);
+  encode(_input, _output);
 }
 
 void convert(const FreeFleetData_RobotState& _input, RobotState& _output)
 {
-  _output.name = std::string(_input.name);
-  _output.model = std::string(_input.model);
-  _output.task_id = std::string(_input.task_id);
-  convert(_input.mode, _output.mode);
-  _output.battery_percent = _input.battery_percent;
-  convert(_input.location, _output.location);
+  decode(_input, _output);
+}
 
-  _output.path.clear();
-  for (uint32_t i = 0; i < _input.path._length; ++i)
-  {
-    Location tmp;
-    convert(_input.path._buffer[i], tmp);
-    _output.path.push_back(tmp);
-  }
+void convert(
+    const RobotState& _input,
+    const std::vector<Location>& _path,
+    FreeFleetData_RobotState& _output)
+{
+  for_each_field<RobotState>(
+      [&](const auto& _field)
+      {
+        encode_field(_field, _input, _path, _output);
+      });
 }
 
+void convert(const FleetState& _input, FreeFleetData_FleetState& _output)
+{
+  encode(_input, _output);
+}
+
+void convert(const FreeFleetData_FleetState& _input, FleetState& _output)
+{
+  decode(_input, _output);
+}
+
+void convert(
+    const FleetSnapshot& _input, FreeFleetData_FleetState_robots_seq& _output)
+{
+  resize_sequence(_output, _input.size());
+  size_t i = 0;
+  for (const auto& it : _input)
+    encode(it.second->state, _output._buffer[i++]);
+}
 
 void convert(const ModeParameter& _input, FreeFleetData_ModeParameter& _output)
 {
-  _output.name = common::dds_string_alloc_and_copy(_input.name);
-  _output.value = common::dds_string_alloc_and_copy(_input.value);
+  encode(_input, _output);
 }
 
 void convert(const FreeFleetData_ModeParameter& _input, ModeParameter& _output)
 {
-  _output.name = std::string(_input.name);
-  _output.value = std::string(_input.value);
+  decode(_input, _output);
 }
 
 void convert(const ModeRequest& _input, FreeFleetData_ModeRequest& _output)
 {
-  _output.fleet_name = common::dds_string_alloc_and_copy(_input.fleet_name);
-  _output.robot_name = common::dds_string_alloc_and_copy(_input.robot_name);
-  convert(_input.mode, _output.mode);
-  _output.task_id = common::dds_string_alloc_and_copy(_input.task_id);
-
-  size_t mode_parameter_num = _input.parameters.size();
-  _output.parameters._maximum = static_cast<uint32_t>(mode_parameter_num);
-  _output.parameters._length = static_cast<uint32_t>(mode_parameter_num);
-  _output.parameters._buffer = 
-      FreeFleetData_ModeRequest_parameters_seq_allocbuf(mode_parameter_num);
-  for (size_t i = 0; i < mode_parameter_num; ++i)
-    convert(_input.parameters[i], _output.parameters._buffer[i]);
+  encode(_input, _output);
 }
 
 void convert(const FreeFleetData_ModeRequest& _input, ModeRequest& _output)
 {
-  _output.fleet_name = std::string(_input.fleet_name);
-  _output.robot_name = std::string(_input.robot_name);
-  convert(_input.mode, _output.mode);
-  _output.task_id = std::string(_input.task_id);
-
-  _output.parameters.clear();
-  for (uint32_t i = 0; i < _input.parameters._length; ++i)
-  {
-    ModeParameter tmp;
-    convert(_input.parameters._buffer[i], tmp);
-    _output.parameters.push_back(tmp);
-  }
+  decode(_input, _output);
 }
 
 void convert(const PathRequest& _input, FreeFleetData_PathRequest& _output)
 {
-  _output.fleet_name = common::dds_string_alloc_and_copy(_input.fleet_name);
-  _output.robot_name = common::dds_string_alloc_and_copy(_input.robot_name);
-
-  size_t path_length = _input.path.size();
-  _output.path._maximum = static_cast<uint32_t>(path_length);
-  _output.path._length = static_cast<uint32_t>(path_length);
-  _output.path._buffer = 
-      FreeFleetData_PathRequest_path_seq_allocbuf(path_length);
-  for (size_t i = 0; i < path_length; ++i)
-    convert(_input.path[i], _output.path._buffer[i]);
-
-  _output.task_id = common::dds_string_alloc_and_copy(_input.task_id);
+  encode(_input, _output);
 }
 
 void convert(const FreeFleetData_PathRequest& _input, PathRequest& _output)
 {
-  _output.fleet_name = std::string(_input.fleet_name);
-  _output.robot_name = std::string(_input.robot_name);
-
-  _output.path.clear();
-  for (uint32_t i = 0; i < _input.path._length; ++i)
-  {
-    Location tmp;
-    convert(_input.path._buffer[i], tmp);
-    _output.path.push_back(tmp);
-  }
-
-  _output.task_id = std::string(_input.task_id);
+  decode(_input, _output);
 }
 
 void convert(
     const DestinationRequest& _input, 
     FreeFleetData_DestinationRequest& _output)
 {
-  _output.fleet_name = common::dds_string_alloc_and_copy(_input.fleet_name);
-  _output.robot_name = common::dds_string_alloc_and_copy(_input.robot_name);
-  convert(_input.destination, _output.destination);
-  _output.task_id = common::dds_string_alloc_and_copy(_input.task_id);
+  encode(_input, _output);
 }
 
 void convert(
     const FreeFleetData_DestinationRequest& _input,
     DestinationRequest& _output)
 {
-  _output.fleet_name = std::string(_input.fleet_name);
-  _output.robot_name = std::string(_input.robot_name);
-  convert(_input.destination, _output.destination);
-  _output.task_id = std::string(_input.task_id);
+  decode(_input, _output);
+}
+
+bool pack_path(FreeFleetData_RobotState& _sample, size_t _threshold)
+{
+  return pack_path(_sample.path, _sample.packed_path, _threshold);
+}
+
+bool pack_path(FreeFleetData_PathRequest& _sample, size_t _threshold)
+{
+  return pack_path(_sample.path, _sample.packed_path, _threshold);
+}
+
+//==============================================================================
+
+namespace {
+
+/// Strings are serialized with their length and terminating null
+size_t payload_size(const char* _string)
+{
+  return sizeof(uint32_t) + (_string ? std::strlen(_string) : 0) + 1;
+}
+
+size_t payload_size(const FreeFleetData_Location& _location)
+{
+  return sizeof(_location.sec) + sizeof(_location.nanosec) +
+      sizeof(_location.x) + sizeof(_location.y) + sizeof(_location.yaw) +
+      payload_size(_location.level_name);
+}
+
+template<typename Sequence>
+size_t string_sequence_size(const Sequence& _sequence)
+{
+  size_t size = sizeof(uint32_t);
+  for (uint32_t i = 0; i < _sequence._length; ++i)
+    size += payload_size(_sequence._buffer[i]);
+  return size;
+}
+
+template<typename Sequence>
+size_t fixed_sequence_size(const Sequence& _sequence)
+{
+  return sizeof(uint32_t) + _sequence._length * sizeof(*_sequence._buffer);
+}
+
+} // namespace anonymous
+
+size_t payload_size(const FreeFleetData_RobotState& _sample)
+{
+  return payload_size(_sample.name) + payload_size(_sample.model) +
+      payload_size(_sample.task_id) + sizeof(_sample.mode) +
+      sizeof(_sample.battery_percent) + payload_size(_sample.location) +
+      string_sequence_size(_sample.level_names) +
+      fixed_sequence_size(_sample.path) + sizeof(_sample.path_version) +
+      sizeof(_sample.path_index) + sizeof(_sample.robot_id) +
+      fixed_sequence_size(_sample.packed_path);
+}
+
+size_t payload_size(const FreeFleetData_RobotPose& _sample)
+{
+  return payload_size(_sample.name) + sizeof(_sample.mode) +
+      payload_size(_sample.location);
+}
+
+size_t payload_size(const FreeFleetData_FleetState& _sample)
+{
+  size_t size = payload_size(_sample.name) + sizeof(uint32_t);
+  for (uint32_t i = 0; i < _sample.robots._length; ++i)
+    size += payload_size(_sample.robots._buffer[i]);
+  return size;
+}
+
+size_t payload_size(const FreeFleetData_ModeRequest& _sample)
+{
+  size_t size = payload_size(_sample.fleet_name) +
+      payload_size(_sample.robot_name) + sizeof(_sample.mode) +
+      payload_size(_sample.task_id) + sizeof(uint32_t) +
+      sizeof(_sample.robot_id);
+  for (uint32_t i = 0; i < _sample.parameters._length; ++i)
+    size += payload_size(_sample.parameters._buffer[i].name) +
+        payload_size(_sample.parameters._buffer[i].value);
+  return size;
+}
+
+size_t payload_size(const FreeFleetData_PathRequest& _sample)
+{
+  return payload_size(_sample.fleet_name) +
+      payload_size(_sample.robot_name) +
+      string_sequence_size(_sample.level_names) +
+      fixed_sequence_size(_sample.path) + payload_size(_sample.task_id) +
+      sizeof(_sample.version) + sizeof(_sample.operation) +
+      sizeof(_sample.base_version) + sizeof(_sample.start_index) +
+      sizeof(_sample.robot_id) + fixed_sequence_size(_sample.packed_path) +
+      payload_size(_sample.after_task_id);
+}
+
+size_t payload_size(const FreeFleetData_DestinationRequest& _sample)
+{
+  return payload_size(_sample.fleet_name) +
+      payload_size(_sample.robot_name) + payload_size(_sample.destination) +
+      payload_size(_sample.task_id) + sizeof(_sample.robot_id) +
+      payload_size(_sample.after_task_id);
+}
+
+size_t payload_size(const FreeFleetData_RobotRegistration& _sample)
+{
+  return payload_size(_sample.fleet_name) +
+      payload_size(_sample.robot_name) + payload_size(_sample.model) +
+      payload_size(_sample.task_id);
+}
+
+size_t payload_size(const FreeFleetData_RobotRegistrationAck& _sample)
+{
+  return payload_size(_sample.fleet_name) +
+      payload_size(_sample.robot_name) + sizeof(_sample.robot_id);
+}
+
+size_t payload_size(const FreeFleetData_TimeSyncPing& _sample)
+{
+  return payload_size(_sample.fleet_name) + sizeof(_sample.server_send_time);
+}
+
+size_t payload_size(const FreeFleetData_TimeSyncPong& _sample)
+{
+  return payload_size(_sample.fleet_name) +
+      payload_size(_sample.robot_name) + sizeof(_sample.server_send_time) +
+      sizeof(_sample.client_receive_time) +
+      sizeof(_sample.client_send_time);
+}
+
+size_t payload_size(const FreeFleetData_RequestAck& _sample)
+{
+  return payload_size(_sample.fleet_name) +
+      payload_size(_sample.robot_name) + payload_size(_sample.task_id) +
+      sizeof(_sample.kind) + sizeof(_sample.version);
+}
+
+void correct_clock_offset(
+    int64_t _clock_offset, int32_t& _sec, uint32_t& _nanosec)
+{
+  if (_clock_offset == 0 || (_sec == 0 && _nanosec == 0))
+    return;
+
+  const int64_t corrected =
+      static_cast<int64_t>(_sec) * 1000000000 + _nanosec - _clock_offset;
+  int64_t sec = corrected / 1000000000;
+  int64_t nanosec = corrected % 1000000000;
+  if (nanosec < 0)
+  {
+    sec -= 1;
+    nanosec += 1000000000;
+  }
+  _sec = static_cast<int32_t>(sec);
+  _nanosec = static_cast<uint32_t>(nanosec);
 }
 
 } // namespace messages
@@ -21,11 +21,14 @@
 #include <free_fleet/messages/Location.hpp>
 #include <free_fleet/messages/RobotMode.hpp>
 #include <free_fleet/messages/RobotState.hpp>
+#include <free_fleet/messages/FleetState.hpp>
 #include <free_fleet/messages/ModeParameter.hpp>
 #include <free_fleet/messages/ModeRequest.hpp>
 #include <free_fleet/messages/PathRequest.hpp>
 #include <free_fleet/messages/DestinationRequest.hpp>
 
+#include <free_fleet/FleetSnapshot.hpp>
+
 #include "FleetMessages.h"
 
 namespace free_fleet {
@@ -43,6 +46,22 @@ void convert(const RobotState& _input, FreeFleetData_RobotState& _output);
 
 void convert(const FreeFleetData_RobotState& _input, RobotState& _output);
 
+/// Converts the robot state with another path in place of its own, such as a
+/// simplified version of it.
+void convert(
+    const RobotState& _input,
+    const std::vector<Location>& _path,
+    FreeFleetData_RobotState& _output);
+
+void convert(const FleetState& _input, FreeFleetData_FleetState& _output);
+
+void convert(const FreeFleetData_FleetState& _input, FleetState& _output);
+
+/// Fills in the robots of a fleet state straight from the records of a fleet
+/// snapshot, without copying the states into a FleetState first.
+void convert(
+    const FleetSnapshot& _input, FreeFleetData_FleetState_robots_seq& _output);
+
 void convert(const ModeParameter& _input, FreeFleetData_ModeParameter& _output);
 
 void convert(const FreeFleetData_ModeParameter& _input, ModeParameter& _output);
@@ -63,6 +82,48 @@ void convert(
     const FreeFleetData_DestinationRequest& _input,
     DestinationRequest& _output);
 
+/// Packs the path of a converted sample in place, when it has at least the
+/// threshold number of waypoints and the packed path is smaller, see
+/// path_packing.hpp. Converting a sample always leaves its path unpacked,
+/// and converting it back unpacks it, a threshold of 0 never packs.
+///
+/// \return
+///   True if the path was packed.
+bool pack_path(FreeFleetData_RobotState& _sample, size_t _threshold);
+
+bool pack_path(FreeFleetData_PathRequest& _sample, size_t _threshold);
+
+/// Size of the samples once serialized, counting every string and sequence
+/// element but neither alignment nor protocol overhead, which is what gets
+/// reported as the bytes sent and received on each topic.
+size_t payload_size(const FreeFleetData_RobotState& _sample);
+
+size_t payload_size(const FreeFleetData_RobotPose& _sample);
+
+size_t payload_size(const FreeFleetData_FleetState& _sample);
+
+size_t payload_size(const FreeFleetData_ModeRequest& _sample);
+
+size_t payload_size(const FreeFleetData_PathRequest& _sample);
+
+size_t payload_size(const FreeFleetData_DestinationRequest& _sample);
+
+size_t payload_size(const FreeFleetData_RobotRegistration& _sample);
+
+size_t payload_size(const FreeFleetData_RobotRegistrationAck& _sample);
+
+size_t payload_size(const FreeFleetData_TimeSyncPing& _sample);
+
+size_t payload_size(const FreeFleetData_TimeSyncPong& _sample);
+
+size_t payload_size(const FreeFleetData_RequestAck& _sample);
+
+/// Moves a time stamped with a robot's clock onto the clock of the server,
+/// given the offset in nanoseconds of the robot's clock from the server's.
+/// Unstamped times, at 0, are left as they are.
+void correct_clock_offset(
+    int64_t _clock_offset, int32_t& _sec, uint32_t& _nanosec);
+
 } // namespace 
 } // namespace free_fleet
 
@@ -0,0 +1,216 @@
+/*
+ * Copyright (C) 2019 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#include <limits>
+#include <cstring>
+
+#include "path_packing.hpp"
+
+namespace free_fleet {
+namespace messages {
+
+namespace {
+
+constexpr int64_t NanosecondsPerSecond = 1000000000;
+
+/// Predicts the next value from the last two, most recent first, with
+/// unsigned arithmetic wrapping around so that every residual is exact.
+template<typename Value>
+Value predict(const Value (&_history)[2], size_t _index)
+{
+  if (_index == 0)
+    return 0;
+  if (_index == 1)
+    return _history[0];
+  return static_cast<Value>(_history[0] + (_history[0] - _history[1]));
+}
+
+template<typename Value>
+void push(Value (&_history)[2], Value _value)
+{
+  _history[1] = _history[0];
+  _history[0] = _value;
+}
+
+template<typename Value>
+Value zigzag(Value _residual)
+{
+  constexpr int sign_bit = std::numeric_limits<Value>::digits - 1;
+  return static_cast<Value>(
+      (_residual << 1) ^ (Value(0) - (_residual >> sign_bit)));
+}
+
+template<typename Value>
+Value unzigzag(Value _encoded)
+{
+  return static_cast<Value>((_encoded >> 1) ^ (Value(0) - (_encoded & 1)));
+}
+
+uint8_t* write_varint(uint64_t _value, uint8_t* _output)
+{
+  while (_value >= 0x80)
+  {
+    *_output++ = static_cast<uint8_t>(_value | 0x80);
+    _value >>= 7;
+  }
+  *_output++ = static_cast<uint8_t>(_value);
+  return _output;
+}
+
+uint32_t float_bits(float _value)
+{
+  uint32_t bits;
+  std::memcpy(&bits, &_value, sizeof(bits));
+  return bits;
+}
+
+float bits_float(uint32_t _bits)
+{
+  float value;
+  std::memcpy(&value, &_bits, sizeof(value));
+  return value;
+}
+
+} // namespace anonymous
+
+size_t pack_waypoints(
+    const FreeFleetData_PathLocation* _waypoints, size_t _length,
+    uint8_t* _output)
+{
+  if (_length > std::numeric_limits<uint32_t>::max())
+    return 0;
+
+  uint8_t* output = _output;
+  *output++ = PackedPathFormat;
+  output = write_varint(_length, output);
+
+  uint64_t times[2] = {0, 0};
+  uint32_t coordinates[3][2] = {{0, 0}, {0, 0}, {0, 0}};
+  uint32_t level_index = 0;
+  for (size_t i = 0; i < _length; ++i)
+  {
+    const FreeFleetData_PathLocation& waypoint = _waypoints[i];
+    if (waypoint.nanosec >= NanosecondsPerSecond)
+      return 0;
+
+    const uint64_t time = static_cast<uint64_t>(
+        waypoint.sec * NanosecondsPerSecond + waypoint.nanosec);
+    output = write_varint(zigzag<uint64_t>(time - predict(times, i)), output);
+    push(times, time);
+
+    const uint32_t values[3] = {
+        float_bits(waypoint.x), float_bits(waypoint.y),
+        float_bits(waypoint.yaw)};
+    for (size_t c = 0; c < 3; ++c)
+    {
+      output = write_varint(
+          zigzag<uint32_t>(values[c] - predict(coordinates[c], i)), output);
+      push(coordinates[c], values[c]);
+    }
+
+    output = write_varint(
+        zigzag<uint32_t>(waypoint.level_index - level_index), output);
+    level_index = waypoint.level_index;
+  }
+  return static_cast<size_t>(output - _output);
+}
+
+PackedPathReader::PackedPathReader(const uint8_t* _data, size_t _size) :
+  data(_data),
+  end(_data + _size)
+{
+  uint64_t packed_length = 0;
+  if (_size == 0 || *data++ != PackedPathFormat ||
+      !read_varint(packed_length))
+    return;
+
+  // Every waypoint takes up at least a byte for each of its five fields,
+  // which keeps a corrupted length from being trusted
+  if (packed_length > static_cast<uint64_t>(end - data) / 5)
+    return;
+  length = static_cast<size_t>(packed_length);
+}
+
+size_t PackedPathReader::size() const
+{
+  return length;
+}
+
+bool PackedPathReader::next(FreeFleetData_PathLocation& _waypoint)
+{
+  if (index >= length)
+    return false;
+
+  uint64_t encoded = 0;
+  if (!read_varint(encoded))
+    return false;
+  const uint64_t time = predict(times, index) + unzigzag(encoded);
+  const int64_t signed_time = static_cast<int64_t>(time);
+  int64_t sec = signed_time / NanosecondsPerSecond;
+  int64_t nanosec = signed_time % NanosecondsPerSecond;
+  if (nanosec < 0)
+  {
+    nanosec += NanosecondsPerSecond;
+    --sec;
+  }
+  if (sec < std::numeric_limits<int32_t>::min() ||
+      sec > std::numeric_limits<int32_t>::max())
+    return false;
+
+  uint32_t values[3];
+  for (size_t c = 0; c < 3; ++c)
+  {
+    if (!read_varint(encoded) ||
+        encoded > std::numeric_limits<uint32_t>::max())
+      return false;
+    values[c] = predict(coordinates[c], index) +
+        unzigzag(static_cast<uint32_t>(encoded));
+  }
+
+  if (!read_varint(encoded) || encoded > std::numeric_limits<uint32_t>::max())
+    return false;
+  level_index += unzigzag(static_cast<uint32_t>(encoded));
+
+  _waypoint.sec = static_cast<int32_t>(sec);
+  _waypoint.nanosec = static_cast<uint32_t>(nanosec);
+  _waypoint.x = bits_float(values[0]);
+  _waypoint.y = bits_float(values[1]);
+  _waypoint.yaw = bits_float(values[2]);
+  _waypoint.level_index = level_index;
+
+  push(times, time);
+  for (size_t c = 0; c < 3; ++c)
+    push(coordinates[c], values[c]);
+  ++index;
+  return true;
+}
+
+bool PackedPathReader::read_varint(uint64_t& _value)
+{
+  _value = 0;
+  for (int shift = 0; shift < 64 && data < end; shift += 7)
+  {
+    const uint8_t byte = *data++;
+    _value |= static_cast<uint64_t>(byte & 0x7f) << shift;
+    if (!(byte & 0x80))
+      return true;
+  }
+  return false;
+}
+
+} // namespace messages
+} // namespace free_fleet
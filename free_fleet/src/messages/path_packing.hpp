@@ -0,0 +1,97 @@
+/*
+ * Copyright (C) 2019 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#ifndef FREE_FLEET__SRC__MESSAGES__PATH_PACKING_HPP
+#define FREE_FLEET__SRC__MESSAGES__PATH_PACKING_HPP
+
+#include <cstddef>
+#include <cstdint>
+
+#include "FleetMessages.h"
+
+namespace free_fleet {
+namespace messages {
+
+/// Packed paths carry their waypoints as a single block of bytes instead of
+/// a sequence of PathLocation, for links where every byte counts. The block
+/// starts with its format and the number of waypoints, followed by each
+/// field of every waypoint as the zigzag varint of how far it is off from
+/// the prediction of the two waypoints before it. Times are predicted in
+/// nanoseconds, and positions and yaws on the bits of their floats, so that
+/// evenly spaced and evenly timed waypoints take up a byte per field while
+/// every value still comes back exactly as it was. Level indices are only
+/// predicted by the previous waypoint.
+constexpr uint8_t PackedPathFormat = 1;
+
+/// Largest number of bytes that a path of the given length packs into.
+constexpr size_t packed_path_capacity(size_t _length)
+{
+  return 1 + 5 + _length * (10 + 3 * 5 + 5);
+}
+
+/// Packs the waypoints into the output, which needs to hold at least
+/// packed_path_capacity bytes.
+///
+/// \return
+///   Size of the packed path, or 0 if the path cannot be packed without
+///   losing anything, which is the case for nanoseconds past a second.
+size_t pack_waypoints(
+    const FreeFleetData_PathLocation* waypoints, size_t length,
+    uint8_t* output);
+
+/// Unpacks the waypoints of a packed path one by one, every read is bounds
+/// checked so that a truncated or corrupted block stops the unpacking
+/// instead of being read past its end.
+class PackedPathReader
+{
+public:
+
+  PackedPathReader(const uint8_t* data, size_t size);
+
+  /// Number of waypoints in the packed path, 0 if it is malformed.
+  size_t size() const;
+
+  /// Reads the next waypoint.
+  ///
+  /// \return
+  ///   False once every waypoint has been read, or if the rest of the block
+  ///   turns out to be malformed.
+  bool next(FreeFleetData_PathLocation& waypoint);
+
+private:
+
+  bool read_varint(uint64_t& value);
+
+  const uint8_t* data;
+
+  const uint8_t* end;
+
+  size_t length = 0;
+
+  size_t index = 0;
+
+  uint64_t times[2] = {0, 0};
+
+  uint32_t coordinates[3][2] = {{0, 0}, {0, 0}, {0, 0}};
+
+  uint32_t level_index = 0;
+};
+
+} // namespace messages
+} // namespace free_fleet
+
+#endif // FREE_FLEET__SRC__MESSAGES__PATH_PACKING_HPP
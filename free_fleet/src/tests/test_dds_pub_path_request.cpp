@@ -64,7 +64,7 @@ int main (int argc, char ** argv)
 
   /* Create a Writer. */
   qos = dds_create_qos();
-  dds_qset_reliability(qos, DDS_RELIABILITY_BEST_EFFORT, 0);
+  dds_qset_reliability(qos, DDS_RELIABILITY_RELIABLE, DDS_MSECS(100));
   writer = dds_create_writer (participant, topic, qos, NULL);
   if (writer < 0)
     DDS_FATAL("dds_create_write: %s\n", dds_strretcode(-writer));
@@ -92,9 +92,15 @@ int main (int argc, char ** argv)
   msg->robot_name = free_fleet::common::dds_string_alloc_and_copy(robot_name);
   msg->task_id = free_fleet::common::dds_string_alloc_and_copy(task_id);
 
+  msg->level_names._maximum = 1;
+  msg->level_names._length = 1;
+  msg->level_names._buffer = FreeFleetData_PathRequest_level_names_seq_allocbuf(1);
+  msg->level_names._release = false;
+  msg->level_names._buffer[0] = free_fleet::common::dds_string_alloc_and_copy(level_name);
+
   msg->path._maximum = 50;
   msg->path._length = 50;
-  msg->path._buffer = FreeFleetData_PathRequest_path_seq_allocbuf(10);
+  msg->path._buffer = FreeFleetData_PathRequest_path_seq_allocbuf(50);
   msg->path._release = false;
 
   for (int i = 0; i < 50; ++i)
@@ -104,7 +110,7 @@ int main (int argc, char ** argv)
     msg->path._buffer[i].x = 6.4166097641 + i;
     msg->path._buffer[i].y = 1.489 + i;
     msg->path._buffer[i].yaw = 0.0;
-    msg->path._buffer[i].level_name = free_fleet::common::dds_string_alloc_and_copy(level_name);
+    msg->path._buffer[i].level_index = 0;
   }
 
   printf ("=== [Publisher]  Writing : ");
@@ -64,7 +64,7 @@ int main (int argc, char ** argv)
 
   /* Create a Writer. */
   qos = dds_create_qos();
-  dds_qset_reliability(qos, DDS_RELIABILITY_BEST_EFFORT, 0);
+  dds_qset_reliability(qos, DDS_RELIABILITY_RELIABLE, DDS_MSECS(100));
   writer = dds_create_writer (participant, topic, qos, NULL);
   if (writer < 0)
     DDS_FATAL("dds_create_write: %s\n", dds_strretcode(-writer));
@@ -92,6 +92,12 @@ int main (int argc, char ** argv)
   msg->robot_name = free_fleet::common::dds_string_alloc_and_copy(robot_name);
   msg->task_id = free_fleet::common::dds_string_alloc_and_copy(task_id);
 
+  msg->level_names._maximum = 1;
+  msg->level_names._length = 1;
+  msg->level_names._buffer = FreeFleetData_PathRequest_level_names_seq_allocbuf(1);
+  msg->level_names._release = false;
+  msg->level_names._buffer[0] = free_fleet::common::dds_string_alloc_and_copy(level_name);
+
   msg->path._maximum = 4;
   msg->path._length = 4;
   msg->path._buffer = FreeFleetData_PathRequest_path_seq_allocbuf(10);
@@ -102,28 +108,28 @@ int main (int argc, char ** argv)
   msg->path._buffer[0].x = 0.735785007477;
   msg->path._buffer[0].y = -1.78202533722;
   msg->path._buffer[0].yaw = 0.0;
-  msg->path._buffer[0].level_name = free_fleet::common::dds_string_alloc_and_copy(level_name);
+  msg->path._buffer[0].level_index = 0;
   
   msg->path._buffer[1].sec = 133;
   msg->path._buffer[1].nanosec = 133;
   msg->path._buffer[1].x = 1.09616982937;
   msg->path._buffer[1].y = 1.89214968681;
   msg->path._buffer[1].yaw = 0.0;
-  msg->path._buffer[1].level_name = free_fleet::common::dds_string_alloc_and_copy(level_name);
+  msg->path._buffer[1].level_index = 0;
 
   msg->path._buffer[2].sec = 143;
   msg->path._buffer[2].nanosec = 143;
   msg->path._buffer[2].x = -1.93706703186;
   msg->path._buffer[2].y = 0.680773854256;
   msg->path._buffer[2].yaw = 0.0;
-  msg->path._buffer[2].level_name = free_fleet::common::dds_string_alloc_and_copy(level_name);
+  msg->path._buffer[2].level_index = 0;
 
   msg->path._buffer[3].sec = 153;
   msg->path._buffer[3].nanosec = 153;
   msg->path._buffer[3].x = -1.98976910114;
   msg->path._buffer[3].y = -0.43612909317;
   msg->path._buffer[3].yaw = 0.0;
-  msg->path._buffer[3].level_name = free_fleet::common::dds_string_alloc_and_copy(level_name);
+  msg->path._buffer[3].level_index = 0;
 
   printf ("=== [Publisher]  Writing : ");
   printf ("Message: path length %u\n", msg->path._length);
@@ -15,6 +15,12 @@
  *
  */
 
+#include <cmath>
+
+#include <boost/make_shared.hpp>
+
+#include <free_fleet/Tracing.hpp>
+
 #include "utilities.hpp"
 #include "ClientNode.hpp"
 #include "ClientNodeConfig.hpp"
@@ -24,6 +30,30 @@ namespace free_fleet
 namespace ros1
 {
 
+namespace {
+
+/// Runs a function once from a callback queue
+class FunctionCallback : public ros::CallbackInterface
+{
+public:
+
+  explicit FunctionCallback(std::function<void()> _function) :
+    function(std::move(_function))
+  {}
+
+  CallResult call() override
+  {
+    function();
+    return Success;
+  }
+
+private:
+
+  std::function<void()> function;
+};
+
+} // namespace anonymous
+
 ClientNode::SharedPtr ClientNode::make(const ClientNodeConfig& _config)
 {
   SharedPtr client_node = SharedPtr(new ClientNode(_config));
@@ -93,23 +123,59 @@ ClientNode::~ClientNode()
     publish_thread.join();
     ROS_INFO("Client: publish_thread joined.");
   }
+
+  // Callbacks only stop once the threads are done, which is when ROS shuts
+  // down
+  if (spinner)
+    spinner->stop();
+  ros::getGlobalCallbackQueue()->removeByID(
+      reinterpret_cast<uint64_t>(this));
 }
 
 void ClientNode::start(Fields _fields)
 {
   fields = std::move(_fields);
 
-  update_rate.reset(new ros::Rate(client_node_config.update_frequency));
-  publish_rate.reset(new ros::Rate(client_node_config.publish_frequency));
+  // With adaptive publishing the thread only checks for changes at the
+  // maximum rate, and most loops publish nothing
+  publish_rate.reset(new ros::Rate(
+      client_node_config.adaptive_publishing ?
+          client_node_config.max_publish_frequency :
+          client_node_config.publish_frequency));
 
   battery_percent_sub = node->subscribe(
       client_node_config.battery_state_topic, 1,
       &ClientNode::battery_state_callback_fn, this);
 
+  // ROS callbacks get their own thread, instead of being spun in between
+  // following up on goals
+  spinner.reset(new ros::AsyncSpinner(1));
+  spinner->start();
+
   request_error = false;
   emergency = false;
   paused = false;
 
+  start_request_callbacks();
+
+  outgoing_robot_state.name = client_node_config.robot_name;
+  outgoing_robot_state.model = client_node_config.robot_model;
+  outgoing_robot_state.path.reserve(OutgoingPathCapacity);
+  last_published_robot_state.path.reserve(OutgoingPathCapacity);
+
+  // Stats are collected without locking, so diagnostics are published from
+  // the callback spinner
+  if (client_node_config.diagnostics_period > 0.0)
+  {
+    diagnostics_pub = node->advertise<diagnostic_msgs::DiagnosticArray>(
+        client_node_config.diagnostics_topic, 10);
+
+    published_stats_time = std::chrono::steady_clock::now();
+    diagnostics_timer = node->createWallTimer(
+        ros::WallDuration(client_node_config.diagnostics_period),
+        &ClientNode::diagnostics_timer_fn, this);
+  }
+
   ROS_INFO("Client: starting update thread.");
   update_thread = std::thread(std::bind(&ClientNode::update_thread_fn, this));
 
@@ -126,30 +192,63 @@ void ClientNode::print_config()
 void ClientNode::battery_state_callback_fn(
     const sensor_msgs::BatteryState& _msg)
 {
-  WriteLock battery_state_lock(battery_state_mutex);
-  current_battery_state = _msg;
+  /// RMF expects battery to have a percentage in the range for 0-100.
+  /// sensor_msgs/BatteryInfo on the other hand returns a value in
+  /// the range of 0-1
+  const float battery_percent = 100*_msg.percentage;
+  const bool charging =
+      _msg.power_supply_status == _msg.POWER_SUPPLY_STATUS_CHARGING;
+  update_observed_status(
+      [battery_percent, charging](ObservedStatus& _state)
+      {
+        _state.battery_percent = battery_percent;
+        _state.charging = charging;
+      });
 }
 
-bool ClientNode::get_robot_transform()
+bool ClientNode::update_robot_transform()
 {
+  // Lookups of the latest transform never wait, a robot frame that is not
+  // available yet only skips this update
+  geometry_msgs::TransformStamped transform;
   try {
-    geometry_msgs::TransformStamped tmp_transform_stamped = 
-        tf2_buffer.lookupTransform(
-            client_node_config.map_frame,
-            client_node_config.robot_frame,
-            ros::Time(0));
-    WriteLock robot_transform_lock(robot_transform_mutex);
-    previous_robot_transform = current_robot_transform;
-    current_robot_transform = tmp_transform_stamped;
+    if (!tf2_buffer.canTransform(
+        client_node_config.map_frame,
+        client_node_config.robot_frame,
+        ros::Time(0)))
+    {
+      ROS_WARN_THROTTLE(5.0, "Unable to get robot transform.");
+      return false;
+    }
+    transform = tf2_buffer.lookupTransform(
+        client_node_config.map_frame,
+        client_node_config.robot_frame,
+        ros::Time(0));
   }
-  catch (tf2::TransformException &ex) {
-    ROS_WARN("%s", ex.what());
+  catch (tf2::TransformException&) {
+    ROS_WARN_THROTTLE(5.0, "Unable to get robot transform.");
     return false;
   }
+
+  // An unchanged transform means the robot did not move since the last
+  // update, as far as we can tell
+  const bool moving = !is_transform_close(transform, previous_robot_transform);
+  update_observed_status(
+      [&transform, moving](ObservedStatus& _state)
+      {
+        _state.sec = transform.header.stamp.sec;
+        _state.nanosec = transform.header.stamp.nsec;
+        _state.x = transform.transform.translation.x;
+        _state.y = transform.transform.translation.y;
+        _state.yaw = get_yaw_from_transform(transform);
+        _state.moving = moving;
+      });
+  previous_robot_transform = std::move(transform);
   return true;
 }
 
-messages::RobotMode ClientNode::get_robot_mode()
+messages::RobotMode ClientNode::get_robot_mode(
+    const ObservedStatus& _observed_status) const
 {
   /// Checks if robot has just received a request that causes an adapter error
   if (request_error)
@@ -160,22 +259,12 @@ messages::RobotMode ClientNode::get_robot_mode()
     return messages::RobotMode{messages::RobotMode::MODE_EMERGENCY};
 
   /// Checks if robot is charging
-  {
-    ReadLock battery_state_lock(battery_state_mutex);
-
-    if (current_battery_state.power_supply_status ==
-        current_battery_state.POWER_SUPPLY_STATUS_CHARGING)
-      return messages::RobotMode{messages::RobotMode::MODE_CHARGING};
-  }
+  if (_observed_status.charging)
+    return messages::RobotMode{messages::RobotMode::MODE_CHARGING};
 
   /// Checks if robot is moving
-  {
-    ReadLock robot_transform_lock(robot_transform_mutex);
-
-    if (!is_transform_close(
-        current_robot_transform, previous_robot_transform))
-      return messages::RobotMode{messages::RobotMode::MODE_MOVING};
-  }
+  if (_observed_status.moving)
+    return messages::RobotMode{messages::RobotMode::MODE_MOVING};
   
   /// Otherwise, robot is neither charging nor moving,
   /// Checks if the robot is paused
@@ -189,60 +278,130 @@ messages::RobotMode ClientNode::get_robot_mode()
 
 void ClientNode::publish_robot_state()
 {
-  messages::RobotState new_robot_state;
-  new_robot_state.name = client_node_config.robot_name;
-  new_robot_state.model = client_node_config.robot_model;
+  // Consistent copies of the status and the task, without taking any of the
+  // writers' locks
+  const ObservedStatus status = observed_status.load();
+  const auto task = observed_task.load();
+
+  // Assigning into the same state every time reuses its string and path
+  // capacity, so once warmed up publishing does not allocate
+  messages::RobotState& new_robot_state = outgoing_robot_state;
+  new_robot_state.task_id = task->task_id;
+  new_robot_state.mode = get_robot_mode(status);
+  new_robot_state.battery_percent = status.battery_percent;
+
+  new_robot_state.location.sec = status.sec;
+  new_robot_state.location.nanosec = status.nanosec;
+  new_robot_state.location.x = status.x;
+  new_robot_state.location.y = status.y;
+  new_robot_state.location.yaw = status.yaw;
+  new_robot_state.location.level_name = client_node_config.level_name;
+
+  new_robot_state.path = task->path;
+  new_robot_state.path_version = task->path_version;
+  new_robot_state.path_index = task->path_index;
+
+  if (client_node_config.adaptive_publishing &&
+      !should_publish_robot_state(new_robot_state))
+    return;
 
+  if (!fields.client->send_robot_state(new_robot_state))
   {
-    ReadLock task_id_lock(task_id_mutex);
-    new_robot_state.task_id = current_task_id;    
+    ROS_WARN("failed to send robot state: msg sec %u", new_robot_state.location.sec);
+    return;
   }
 
-  new_robot_state.mode = get_robot_mode();
-
+  if (client_node_config.adaptive_publishing)
   {
-    ReadLock battery_state_lock(battery_state_mutex);
-    /// RMF expects battery to have a percentage in the range for 0-100.
-    /// sensor_msgs/BatteryInfo on the other hand returns a value in 
-    /// the range of 0-1
-    new_robot_state.battery_percent = 100*current_battery_state.percentage;
+    published_robot_state = true;
+    last_published_robot_state = new_robot_state;
+    last_published_time = ros::WallTime::now();
   }
+}
 
-  {
-    ReadLock robot_transform_lock(robot_transform_mutex);
-    new_robot_state.location.sec = current_robot_transform.header.stamp.sec;
-    new_robot_state.location.nanosec = 
-        current_robot_transform.header.stamp.nsec;
-    new_robot_state.location.x = 
-        current_robot_transform.transform.translation.x;
-    new_robot_state.location.y = 
-        current_robot_transform.transform.translation.y;
-    new_robot_state.location.yaw = 
-        get_yaw_from_transform(current_robot_transform);
-    new_robot_state.location.level_name = client_node_config.level_name;
-  }
+bool ClientNode::should_publish_robot_state(
+    const messages::RobotState& _robot_state) const
+{
+  if (!published_robot_state)
+    return true;
 
-  new_robot_state.path.clear();
-  {
-    ReadLock goal_path_lock(goal_path_mutex);
+  const messages::RobotState& last = last_published_robot_state;
+  if (_robot_state.mode.mode != last.mode.mode ||
+      _robot_state.task_id != last.task_id ||
+      _robot_state.path_version != last.path_version ||
+      _robot_state.path_index != last.path_index ||
+      _robot_state.path.size() != last.path.size())
+    return true;
 
-    for (size_t i = 0; i < goal_path.size(); ++i)
-    {
-      new_robot_state.path.push_back(
-          messages::Location{
-              (int32_t)goal_path[i].goal.target_pose.header.stamp.sec,
-              goal_path[i].goal.target_pose.header.stamp.nsec,
-              (float)goal_path[i].goal.target_pose.pose.position.x,
-              (float)goal_path[i].goal.target_pose.pose.position.y,
-              (float)(get_yaw_from_quat(
-                  goal_path[i].goal.target_pose.pose.orientation)),
-              goal_path[i].level_name
-          });
-    }
+  // Traffic negotiation needs up to date poses while moving
+  if (_robot_state.mode.mode == messages::RobotMode::MODE_MOVING)
+    return true;
+
+  const double dx = _robot_state.location.x - last.location.x;
+  const double dy = _robot_state.location.y - last.location.y;
+  const double dyaw =
+      std::remainder(_robot_state.location.yaw - last.location.yaw, 2.0 * M_PI);
+  if (std::sqrt(dx * dx + dy * dy) >
+      client_node_config.publish_distance_threshold ||
+      std::abs(dyaw) > client_node_config.publish_yaw_threshold)
+    return true;
+
+  // Otherwise only a heartbeat, so the server knows the robot is still there
+  return (ros::WallTime::now() - last_published_time).toSec() >=
+      client_node_config.heartbeat_period;
+}
+
+void ClientNode::update_observed_status(
+    const std::function<void(ObservedStatus&)>& _update)
+{
+  std::lock_guard<std::mutex> lock(observed_status_mutex);
+  ObservedStatus status = observed_status.load();
+  _update(status);
+  observed_status.store(status);
+}
+
+void ClientNode::update_observed_path()
+{
+  const uint32_t path_version = current_path_version;
+  const uint32_t path_index =
+      static_cast<uint32_t>(current_path_length - goal_path.size());
+
+  // The server already holds the path it sent, it only needs to know how
+  // far along it the robot is
+  std::vector<messages::Location> path;
+  const bool compact =
+      client_node_config.compact_path_progress && current_path_version != 0;
+  for (size_t i = 0; !compact && i < goal_path.size(); ++i)
+  {
+    path.push_back(
+        messages::Location{
+            (int32_t)goal_path[i].goal.target_pose.header.stamp.sec,
+            goal_path[i].goal.target_pose.header.stamp.nsec,
+            (float)goal_path[i].goal.target_pose.pose.position.x,
+            (float)goal_path[i].goal.target_pose.pose.position.y,
+            (float)(get_yaw_from_quat(
+                goal_path[i].goal.target_pose.pose.orientation)),
+            goal_path[i].level_name
+        });
   }
 
-  if (!fields.client->send_robot_state(new_robot_state))
-    ROS_WARN("failed to send robot state: msg sec %u", new_robot_state.location.sec);
+  // Only the task id is carried over, the previous path is not copied just
+  // to be replaced
+  std::lock_guard<std::mutex> lock(observed_task_mutex);
+  auto task = std::make_shared<ObservedTask>();
+  task->task_id = observed_task.load()->task_id;
+  task->path = std::move(path);
+  task->path_version = path_version;
+  task->path_index = path_index;
+  observed_task.store(std::move(task));
+}
+
+void ClientNode::update_observed_task_id(const std::string& _task_id)
+{
+  std::lock_guard<std::mutex> lock(observed_task_mutex);
+  auto task = std::make_shared<ObservedTask>(*observed_task.load());
+  task->task_id = _task_id;
+  observed_task.store(std::move(task));
 }
 
 bool ClientNode::is_valid_request(
@@ -272,88 +431,135 @@ move_base_msgs::MoveBaseGoal ClientNode::location_to_move_base_goal(
   return goal;
 }
 
-bool ClientNode::read_mode_request()
+bool ClientNode::handle_mode_request(
+    const messages::ModeRequest& _mode_request)
 {
-  messages::ModeRequest mode_request;
-  if (fields.client->read_mode_request(mode_request) && 
-      is_valid_request(
-          mode_request.fleet_name, mode_request.robot_name, 
-          mode_request.task_id))
+  if (is_valid_request(
+          _mode_request.fleet_name, _mode_request.robot_name, 
+          _mode_request.task_id))
   {
-    if (mode_request.mode.mode == messages::RobotMode::MODE_PAUSED)
+    FREE_FLEET_TRACEPOINT(client_request_accepted, tracing::RequestKind::Mode,
+        _mode_request.robot_name.c_str(), _mode_request.task_id.c_str());
+
+    if (_mode_request.mode.mode == messages::RobotMode::MODE_PAUSED)
     {
       ROS_INFO("received a PAUSE command.");
 
-      fields.move_base_client->cancelAllGoals();
-      WriteLock goal_path_lock(goal_path_mutex);
-      if (!goal_path.empty())
-        goal_path[0].sent = false;
-
+      // The goal is put on hold before it gets cancelled, so that its
+      // callback does not take the cancellation for a failure
       paused = true;
       emergency = false;
+      {
+        WriteLock goal_path_lock(goal_path_mutex);
+        if (!goal_path.empty())
+          goal_path[0].sent = false;
+      }
+      fields.move_base_client->cancelAllGoals();
     }
-    else if (mode_request.mode.mode == messages::RobotMode::MODE_MOVING)
+    else if (_mode_request.mode.mode == messages::RobotMode::MODE_MOVING)
     {
       ROS_INFO("received an explicit RESUME command.");
       paused = false;
       emergency = false;
     }
-    else if (mode_request.mode.mode == messages::RobotMode::MODE_EMERGENCY)
+    else if (_mode_request.mode.mode == messages::RobotMode::MODE_EMERGENCY)
     {
       ROS_INFO("received an EMERGENCY command.");
       paused = false;
       emergency = true;
     }
-    else if (mode_request.mode.mode == messages::RobotMode::MODE_DOCKING)
+    else if (_mode_request.mode.mode == messages::RobotMode::MODE_DOCKING)
     {
       ROS_INFO("received a DOCKING command.");
-      if (fields.docking_trigger_client &&
-        fields.docking_trigger_client->isValid())
-      {
-        std_srvs::Trigger trigger_srv;
-        fields.docking_trigger_client->call(trigger_srv);
-        if (!trigger_srv.response.success)
-        {
-          ROS_ERROR("Failed to trigger docking sequence, message: %s.",
-            trigger_srv.response.message.c_str());
-          request_error = true;
-          return false;
-        }
-      }
     }
 
-    WriteLock task_id_lock(task_id_mutex);
-    current_task_id = mode_request.task_id;
+    {
+      WriteLock task_id_lock(task_id_mutex);
+      current_task_id = _mode_request.task_id;
+    }
+    update_observed_task_id(_mode_request.task_id);
 
     request_error = false;
+
+    // Triggered once the task is current, so that a failure is not taken
+    // for one of an earlier request
+    if (_mode_request.mode.mode == messages::RobotMode::MODE_DOCKING &&
+        fields.docking_trigger_client &&
+        fields.docking_trigger_client->isValid())
+      trigger_docking(_mode_request.task_id);
     return true;
   }
   return false;
 }
 
-bool ClientNode::read_path_request()
+void ClientNode::trigger_docking(const std::string& _task_id)
 {
-  messages::PathRequest path_request;
-  if (fields.client->read_path_request(path_request) &&
-      is_valid_request(
-          path_request.fleet_name, path_request.robot_name,
-          path_request.task_id))
+  // The call blocks until the docking server responds, which only holds up
+  // the callback spinner
+  ros::getGlobalCallbackQueue()->addCallback(
+      boost::make_shared<FunctionCallback>(
+          [this, _task_id]()
+          {
+            std_srvs::Trigger trigger_srv;
+            if (fields.docking_trigger_client->call(trigger_srv) &&
+                trigger_srv.response.success)
+              return;
+
+            ROS_ERROR("Failed to trigger docking sequence, message: %s.",
+                trigger_srv.response.message.c_str());
+            ReadLock task_id_lock(task_id_mutex);
+            if (current_task_id == _task_id)
+              request_error = true;
+          }),
+      reinterpret_cast<uint64_t>(this));
+}
+
+bool ClientNode::handle_path_request(
+    const messages::PathRequest& _path_request)
+{
+  if (_path_request.operation != messages::PathRequest::PATH_REPLACE)
+    return handle_path_update(_path_request);
+
+  if (is_valid_request(
+          _path_request.fleet_name, _path_request.robot_name,
+          _path_request.task_id))
   {
-    ROS_INFO("received a Path command of size %lu.", path_request.path.size());
+    FREE_FLEET_TRACEPOINT(client_request_accepted, tracing::RequestKind::Path,
+        _path_request.robot_name.c_str(), _path_request.task_id.c_str());
 
-    if (path_request.path.size() <= 0)
+    ROS_INFO("received a Path command of size %lu.", _path_request.path.size());
+
+    if (_path_request.path.size() <= 0)
       return false;
 
+    std::deque<Goal> goals;
+    for (size_t i = 0; i < _path_request.path.size(); ++i)
+    {
+      goals.push_back(
+          Goal {
+              _path_request.path[i].level_name,
+              location_to_move_base_goal(_path_request.path[i]),
+              false,
+              0,
+              ros::Time(
+                  _path_request.path[i].sec, _path_request.path[i].nanosec)});
+    }
+
+    // Queued paths start from wherever the task before them ends
+    if (!_path_request.after_task_id.empty())
+      return queue_task(
+          QueuedTask {
+              _path_request.after_task_id,
+              _path_request.task_id,
+              std::move(goals),
+              _path_request.version});
+
     // Sanity check: the first waypoint of the Path must be within N meters of
     // our current position. Otherwise, ignore the request.
     {
-      ReadLock robot_transform_lock(robot_transform_mutex);
-      const double dx =
-          path_request.path[0].x - 
-          current_robot_transform.transform.translation.x;
-      const double dy =
-          path_request.path[0].y -
-          current_robot_transform.transform.translation.y;
+      const ObservedStatus status = observed_status.load();
+      const double dx = _path_request.path[0].x - status.x;
+      const double dy = _path_request.path[0].y - status.y;
       const double dist_to_first_waypoint = sqrt(dx*dx + dy*dy);
 
       ROS_INFO("distance to first waypoint: %.2f\n", dist_to_first_waypoint);
@@ -365,9 +571,15 @@ bool ClientNode::read_path_request()
             "waiting for next valid request.\n",
             client_node_config.max_dist_to_first_waypoint);
         
+        {
+          WriteLock goal_path_lock(goal_path_mutex);
+          goal_path.clear();
+          queued_tasks.clear();
+          current_path_version = 0;
+          current_path_length = 0;
+          update_observed_path();
+        }
         fields.move_base_client->cancelAllGoals();
-        WriteLock goal_path_lock(goal_path_mutex);
-        goal_path.clear();
 
         request_error = true;
         emergency = false;
@@ -377,21 +589,17 @@ bool ClientNode::read_path_request()
     }
 
     WriteLock goal_path_lock(goal_path_mutex);
-    goal_path.clear();
-    for (size_t i = 0; i < path_request.path.size(); ++i)
+    goal_path = std::move(goals);
+    queued_tasks.clear();
+    current_path_version = _path_request.version;
+    current_path_length = goal_path.size();
+    update_observed_path();
+
     {
-      goal_path.push_back(
-          Goal {
-              path_request.path[i].level_name,
-              location_to_move_base_goal(path_request.path[i]),
-              false,
-              0,
-              ros::Time(
-                  path_request.path[i].sec, path_request.path[i].nanosec)});
+      WriteLock task_id_lock(task_id_mutex);
+      current_task_id = _path_request.task_id;
     }
-
-    WriteLock task_id_lock(task_id_mutex);
-    current_task_id = path_request.task_id;
+    update_observed_task_id(_path_request.task_id);
 
     if (paused)
       paused = false;
@@ -402,32 +610,129 @@ bool ClientNode::read_path_request()
   return false;
 }
 
-bool ClientNode::read_destination_request()
+bool ClientNode::handle_path_update(
+    const messages::PathRequest& _path_update)
 {
-  messages::DestinationRequest destination_request;
-  if (fields.client->read_destination_request(destination_request) &&
-      is_valid_request(
-          destination_request.fleet_name, destination_request.robot_name,
-          destination_request.task_id))
+  // Updates usually carry on with the same task, duplicates are told apart
+  // by the path version they apply to instead of by their task id
+  if (client_node_config.robot_name != _path_update.robot_name ||
+      client_node_config.fleet_name != _path_update.fleet_name)
+    return false;
+
+  bool cancel_goal = false;
+  bool started_queued_task = false;
   {
-    ROS_INFO("received a Destination command, x: %.2f, y: %.2f, yaw: %.2f",
-        destination_request.destination.x, destination_request.destination.y,
-        destination_request.destination.yaw);
-    
     WriteLock goal_path_lock(goal_path_mutex);
-    goal_path.clear();
-    goal_path.push_back(
+    if (current_path_version == 0 ||
+        _path_update.base_version != current_path_version)
+    {
+      ROS_WARN("received an update of path version %u while following path "
+          "version %u, ignoring it.",
+          _path_update.base_version, current_path_version);
+      return false;
+    }
+
+    const size_t passed = current_path_length - goal_path.size();
+    const size_t kept = _path_update.kept_waypoints(current_path_length);
+    ROS_INFO("received a Path update keeping %lu waypoints, followed by %lu "
+        "new ones.", kept, _path_update.path.size());
+
+    // Only the waypoints after the current goal are replaced when they are
+    // all that changes, otherwise the current goal gets replaced too
+    if (kept > passed)
+      goal_path.resize(kept - passed);
+    else
+      goal_path.clear();
+
+    for (const messages::Location& location : _path_update.path)
+    {
+      goal_path.push_back(
+          Goal {
+              location.level_name,
+              location_to_move_base_goal(location),
+              false,
+              0,
+              ros::Time(location.sec, location.nanosec)});
+    }
+    cancel_goal = goal_path.empty();
+
+    current_path_version = _path_update.version;
+    current_path_length = kept + _path_update.path.size();
+    update_observed_path();
+
+    // A path cut down to nothing ends the task, the task queued behind it
+    // takes over
+    if (cancel_goal)
+      started_queued_task = start_queued_task();
+  }
+  if (cancel_goal)
+    fields.move_base_client->cancelAllGoals();
+  if (started_queued_task)
+    return true;
+
+  FREE_FLEET_TRACEPOINT(client_request_accepted, tracing::RequestKind::Path,
+      _path_update.robot_name.c_str(), _path_update.task_id.c_str());
+
+  {
+    WriteLock task_id_lock(task_id_mutex);
+    current_task_id = _path_update.task_id;
+  }
+  update_observed_task_id(_path_update.task_id);
+
+  if (paused)
+    paused = false;
+
+  request_error = false;
+  return true;
+}
+
+bool ClientNode::handle_destination_request(
+    const messages::DestinationRequest& _destination_request)
+{
+  if (is_valid_request(
+          _destination_request.fleet_name, _destination_request.robot_name,
+          _destination_request.task_id))
+  {
+    FREE_FLEET_TRACEPOINT(
+        client_request_accepted, tracing::RequestKind::Destination,
+        _destination_request.robot_name.c_str(),
+        _destination_request.task_id.c_str());
+
+    ROS_INFO("received a Destination command, x: %.2f, y: %.2f, yaw: %.2f",
+        _destination_request.destination.x, _destination_request.destination.y,
+        _destination_request.destination.yaw);
+
+    std::deque<Goal> goals;
+    goals.push_back(
         Goal {
-            destination_request.destination.level_name,
-            location_to_move_base_goal(destination_request.destination),
+            _destination_request.destination.level_name,
+            location_to_move_base_goal(_destination_request.destination),
             false,
             0,
             ros::Time(
-                destination_request.destination.sec, 
-                destination_request.destination.nanosec)});
+                _destination_request.destination.sec, 
+                _destination_request.destination.nanosec)});
 
-    WriteLock task_id_lock(task_id_mutex);
-    current_task_id = destination_request.task_id;
+    if (!_destination_request.after_task_id.empty())
+      return queue_task(
+          QueuedTask {
+              _destination_request.after_task_id,
+              _destination_request.task_id,
+              std::move(goals),
+              0});
+
+    WriteLock goal_path_lock(goal_path_mutex);
+    goal_path = std::move(goals);
+    queued_tasks.clear();
+    current_path_version = 0;
+    current_path_length = goal_path.size();
+    update_observed_path();
+
+    {
+      WriteLock task_id_lock(task_id_mutex);
+      current_task_id = _destination_request.task_id;
+    }
+    update_observed_task_id(_destination_request.task_id);
 
     if (paused)
       paused = false;
@@ -438,73 +743,198 @@ bool ClientNode::read_destination_request()
   return false;
 }
 
-void ClientNode::read_requests()
+bool ClientNode::queue_task(QueuedTask _task)
 {
-  if (read_mode_request() || 
-      read_path_request() || 
-      read_destination_request())
-    return;
+  WriteLock goal_path_lock(goal_path_mutex);
+  std::string last_task_id;
+  {
+    ReadLock task_id_lock(task_id_mutex);
+    last_task_id = current_task_id;
+  }
+  for (const QueuedTask& queued_task : queued_tasks)
+  {
+    // Requests are resent until the robot reports their task
+    if (queued_task.task_id == _task.task_id)
+      return false;
+    last_task_id = queued_task.task_id;
+  }
+
+  if (_task.after_task_id != last_task_id)
+  {
+    ROS_WARN("received task %s queued after task %s, while the last task of "
+        "the robot is %s, ignoring it.", _task.task_id.c_str(),
+        _task.after_task_id.c_str(), last_task_id.c_str());
+    return false;
+  }
+
+  ROS_INFO("queued task %s of %lu goals after task %s.",
+      _task.task_id.c_str(), _task.goals.size(), _task.after_task_id.c_str());
+  queued_tasks.push_back(std::move(_task));
+
+  // The task it follows may already be done
+  return goal_path.empty() && start_queued_task();
 }
 
-void ClientNode::handle_requests()
+bool ClientNode::start_queued_task()
 {
-  // there is an emergency or the robot is paused
-  if (emergency || request_error || paused)
-    return;
+  if (queued_tasks.empty())
+    return false;
+
+  QueuedTask& task = queued_tasks.front();
+  ROS_INFO("task %s is done, moving on to queued task %s.",
+      task.after_task_id.c_str(), task.task_id.c_str());
+  goal_path = std::move(task.goals);
+  current_path_version = task.path_version;
+  current_path_length = goal_path.size();
+  update_observed_path();
 
-  // ooooh we have goals
-  WriteLock goal_path_lock(goal_path_mutex);
-  if (!goal_path.empty())
   {
-    // Goals must have been updated since last handling, execute them now
-    if (!goal_path.front().sent)
+    WriteLock task_id_lock(task_id_mutex);
+    current_task_id = task.task_id;
+  }
+  update_observed_task_id(task.task_id);
+  queued_tasks.pop_front();
+  return true;
+}
+
+void ClientNode::start_request_callbacks()
+{
+  // Requests are handled on the DDS reader thread as soon as they arrive,
+  // instead of waiting for the next update
+  fields.client->on_mode_request(
+      [this](const messages::ModeRequest& _mode_request)
+      {
+        // Mode requests only touch the flags and the goal path under its own
+        // lock, they never wait for the path handling behind request_mutex
+        if (handle_mode_request(_mode_request))
+          send_next_goal();
+      });
+  fields.client->on_path_request(
+      [this](const messages::PathRequest& _path_request)
+      {
+        std::lock_guard<std::mutex> lock(request_mutex);
+        if (handle_path_request(_path_request))
+          send_next_goal();
+      });
+  fields.client->on_destination_request(
+      [this](const messages::DestinationRequest& _destination_request)
+      {
+        std::lock_guard<std::mutex> lock(request_mutex);
+        if (handle_destination_request(_destination_request))
+          send_next_goal();
+      });
+}
+
+void ClientNode::send_next_goal()
+{
+  goal_send_pending = true;
+  while (goal_send_pending)
+  {
+    std::unique_lock<std::mutex> send_lock(goal_send_mutex, std::try_to_lock);
+    if (!send_lock.owns_lock())
+      return;
+    goal_send_pending = false;
+
+    move_base_msgs::MoveBaseGoal goal;
+    uint64_t send_id = 0;
+#ifdef FREE_FLEET_TRACING
+    tracing::RequestKind request_kind = tracing::RequestKind::Destination;
+#endif
     {
-      ROS_INFO("sending next goal.");
-      fields.move_base_client->sendGoal(goal_path.front().goal);
+      // there is an emergency or the robot is paused
+      WriteLock goal_path_lock(goal_path_mutex);
+      if (emergency || request_error || paused ||
+          goal_path.empty() || goal_path.front().sent)
+        continue;
+
       goal_path.front().sent = true;
-      return;
+      goal_path.front().send_id = ++last_goal_send_id;
+      goal = goal_path.front().goal;
+      send_id = goal_path.front().send_id;
+#ifdef FREE_FLEET_TRACING
+      if (current_path_version)
+        request_kind = tracing::RequestKind::Path;
+#endif
+    }
+
+    ROS_INFO("sending next goal.");
+    fields.move_base_client->sendGoal(
+        goal,
+        [this, send_id](
+            const GoalState& _state,
+            const move_base_msgs::MoveBaseResultConstPtr&)
+        {
+          handle_goal_done(send_id, _state);
+        },
+        [this, send_id]()
+        {
+          handle_goal_active(send_id);
+        });
+#ifdef FREE_FLEET_TRACING
+    {
+      ReadLock task_id_lock(task_id_mutex);
+      FREE_FLEET_TRACEPOINT(client_goal_sent, request_kind,
+          client_node_config.robot_name.c_str(), current_task_id.c_str());
     }
+#endif
+  }
+}
+
+void ClientNode::handle_goal_active(uint64_t _send_id)
+{
+  ROS_DEBUG("goal %lu is active.", static_cast<unsigned long>(_send_id));
+}
+
+void ClientNode::handle_goal_done(uint64_t _send_id, const GoalState& _state)
+{
+  bool goal_done = false;
+  ros::Duration wait_time_remaining(0.0);
+  {
+    // Goals that were cancelled, replaced or put on hold since they were
+    // sent are already taken care of
+    WriteLock goal_path_lock(goal_path_mutex);
+    if (goal_path.empty() ||
+        !goal_path.front().sent ||
+        goal_path.front().send_id != _send_id)
+      return;
 
-    // Goals have been sent, check the goal states now
-    GoalState current_goal_state = fields.move_base_client->getState();
-    if (current_goal_state == GoalState::SUCCEEDED)
+    Goal& current_goal = goal_path.front();
+    if (_state == GoalState::SUCCEEDED)
     {
       ROS_INFO("current goal state: SUCCEEEDED.");
 
       // By some stroke of good fortune, we may have arrived at our goal
       // earlier than we were scheduled to reach it. If that is the case,
       // we need to wait here until it's time to proceed.
-      if (ros::Time::now() >= goal_path.front().goal_end_time)
+      const ros::Time now = ros::Time::now();
+      if (now >= current_goal.goal_end_time)
       {
         goal_path.pop_front();
+        update_observed_path();
+        if (goal_path.empty())
+          start_queued_task();
+        goal_done = true;
       }
       else
       {
-        ros::Duration wait_time_remaining =
-            goal_path.front().goal_end_time - ros::Time::now();
+        wait_time_remaining = current_goal.goal_end_time - now;
         ROS_INFO(
             "we reached our goal early! Waiting %.1f more seconds",
             wait_time_remaining.toSec());
       }
-      return;
-    }
-    else if (current_goal_state == GoalState::ACTIVE)
-    {
-      return;
     }
-    else if (current_goal_state == GoalState::ABORTED)
+    else if (_state == GoalState::ABORTED)
     {
-      goal_path.front().aborted_count++;
+      current_goal.aborted_count++;
 
       // TODO: parameterize the maximum number of retries.
-      if (goal_path.front().aborted_count < 5)
+      if (current_goal.aborted_count < 5)
       {
         ROS_INFO("robot's navigation stack has aborted the current goal %d "
             "times, client will trying again...",
-            goal_path.front().aborted_count);
-        fields.move_base_client->cancelGoal();
-        goal_path.front().sent = false;
-        return;
+            current_goal.aborted_count);
+        current_goal.sent = false;
+        goal_done = true;
       }
       else
       {
@@ -512,44 +942,92 @@ void ClientNode::handle_requests()
             "times, please check that there is nothing in the way of the "
             "robot, client will abort the current path request, and await "
             "further requests.",
-            goal_path.front().aborted_count);
-        fields.move_base_client->cancelGoal();
+            current_goal.aborted_count);
         goal_path.clear();
-        return;
+        queued_tasks.clear();
+        update_observed_path();
       }
     }
     else
     {
-      ROS_INFO("Undesirable goal state: %s",
-          current_goal_state.toString().c_str());
+      ROS_INFO("Undesirable goal state: %s", _state.toString().c_str());
       ROS_INFO("Client will abort the current path request, and await further "
           "requests or manual intervention.");
-      fields.move_base_client->cancelGoal();
       goal_path.clear();
-      return;
+      queued_tasks.clear();
+      update_observed_path();
     }
   }
-  
-  // otherwise, mode is correct, nothing in queue, nothing else to do then
+
+  // The next goal goes out straight from the callback of the previous one
+  if (goal_done)
+    send_next_goal();
+  else if (wait_time_remaining > ros::Duration(0.0))
+    start_goal_wait(_send_id, wait_time_remaining);
 }
 
-void ClientNode::update_thread_fn()
+void ClientNode::start_goal_wait(
+    uint64_t _send_id, const ros::Duration& _wait_time)
+{
+  // Replacing the timer waits for its callback if it is running, which
+  // locks goal_path_mutex, so that is never locked here
+  std::lock_guard<std::mutex> timer_lock(goal_wait_timer_mutex);
+  goal_wait_timer = node->createTimer(
+      _wait_time,
+      [this, _send_id](const ros::TimerEvent&)
+      {
+        handle_goal_wait_done(_send_id);
+      },
+      true);
+}
+
+void ClientNode::handle_goal_wait_done(uint64_t _send_id)
 {
-  while (node->ok())
   {
-    update_rate->sleep();
-    ros::spinOnce();
+    WriteLock goal_path_lock(goal_path_mutex);
+    if (goal_path.empty() ||
+        !goal_path.front().sent ||
+        goal_path.front().send_id != _send_id)
+      return;
 
-    get_robot_transform();
+    goal_path.pop_front();
+    update_observed_path();
+    if (goal_path.empty())
+      start_queued_task();
+  }
+  send_next_goal();
+}
 
-    read_requests();
+void ClientNode::update_thread_fn()
+{
+  client_node_config.update_thread.apply("update");
+
+  using Clock = std::chrono::steady_clock;
+  const Clock::duration update_period =
+      std::chrono::duration_cast<Clock::duration>(
+          std::chrono::duration<double>(
+              1.0 / client_node_config.update_frequency));
+
+  // Goals are followed up on from their own callbacks, this only samples
+  // the transform once every period, so that moving gets detected between
+  // samples that are far enough apart
+  Clock::time_point next_update = Clock::now();
+  while (node->ok())
+  {
+    std::this_thread::sleep_until(next_update);
+    update_robot_transform();
 
-    handle_requests();
+    const Clock::time_point now = Clock::now();
+    next_update += update_period;
+    if (next_update < now)
+      next_update = now + update_period;
   }
 }
 
 void ClientNode::publish_thread_fn()
 {
+  client_node_config.publish_thread.apply("publish");
+
   while (node->ok())
   {
     publish_rate->sleep();
@@ -558,5 +1036,23 @@ void ClientNode::publish_thread_fn()
   }
 }
 
+void ClientNode::diagnostics_timer_fn(const ros::WallTimerEvent&)
+{
+  const auto now = std::chrono::steady_clock::now();
+  Stats stats = fields.client->get_stats();
+
+  diagnostic_msgs::DiagnosticArray diagnostics;
+  diagnostics.header.stamp = ros::Time::now();
+  to_diagnostic_statuses(
+      stats, published_stats,
+      std::chrono::duration<double>(now - published_stats_time).count(),
+      ros::this_node::getName(), client_node_config.robot_name,
+      diagnostics.status);
+  diagnostics_pub.publish(diagnostics);
+
+  published_stats = std::move(stats);
+  published_stats_time = now;
+}
+
 } // namespace ros1
 } // namespace free_fleet
@@ -20,15 +20,19 @@
 
 #include <deque>
 #include <mutex>
+#include <chrono>
 #include <atomic>
 #include <memory>
 #include <thread>
 #include <vector>
+#include <functional>
 
 #include <ros/ros.h>
+#include <ros/callback_queue.h>
 #include <std_msgs/String.h>
 #include <std_srvs/Trigger.h>
 #include <sensor_msgs/BatteryState.h>
+#include <diagnostic_msgs/DiagnosticArray.h>
 #include <tf2_ros/transform_listener.h>
 #include <geometry_msgs/TransformStamped.h>
 
@@ -36,7 +40,10 @@
 #include <move_base_msgs/MoveBaseAction.h>
 #include <actionlib/client/simple_action_client.h>
 
+#include <free_fleet/Stats.hpp>
 #include <free_fleet/Client.hpp>
+#include <free_fleet/SeqLock.hpp>
+#include <free_fleet/AtomicSnapshot.hpp>
 #include <free_fleet/messages/Location.hpp>
 
 #include "ClientNodeConfig.hpp"
@@ -84,7 +91,8 @@ private:
 
   std::unique_ptr<ros::NodeHandle> node;
 
-  std::unique_ptr<ros::Rate> update_rate;
+  /// Spins the global callback queue
+  std::unique_ptr<ros::AsyncSpinner> spinner;
 
   std::unique_ptr<ros::Rate> publish_rate;
 
@@ -93,10 +101,6 @@ private:
 
   ros::Subscriber battery_percent_sub;
 
-  std::mutex battery_state_mutex;
-
-  sensor_msgs::BatteryState current_battery_state;
-
   void battery_state_callback_fn(const sensor_msgs::BatteryState& msg);
 
   // --------------------------------------------------------------------------
@@ -106,13 +110,13 @@ private:
 
   tf2_ros::TransformListener tf2_listener;
 
-  std::mutex robot_transform_mutex;
-
-  geometry_msgs::TransformStamped current_robot_transform;
-
+  /// Transform of the previous update, only used by the update thread to
+  /// tell whether the robot moved. Everything else reads the pose from
+  /// observed_status.
   geometry_msgs::TransformStamped previous_robot_transform;
 
-  bool get_robot_transform();
+  /// Looks up the latest transform of the robot without waiting on TF
+  bool update_robot_transform();
 
   // --------------------------------------------------------------------------
   // Mode handling
@@ -124,19 +128,34 @@ private:
   std::atomic<bool> emergency;
   std::atomic<bool> paused;
 
-  messages::RobotMode get_robot_mode();
+  struct ObservedStatus;
 
-  bool read_mode_request();
+  messages::RobotMode get_robot_mode(
+      const ObservedStatus& observed_status) const;
+
+  /// Called without request_mutex, so that the robot gets stopped without
+  /// waiting for path handling in progress
+  bool handle_mode_request(const messages::ModeRequest& mode_request);
+
+  /// Calls the docking trigger from the global callback queue, so that the
+  /// mode request never waits on the docking server. A failure is only
+  /// reported when no other request came in since this one.
+  void trigger_docking(const std::string& task_id);
 
   // --------------------------------------------------------------------------
   // Path request handling
 
-  bool read_path_request();
+  bool handle_path_request(const messages::PathRequest& path_request);
+
+  /// Applies a request that only changes the tail of the current path, the
+  /// goal that is being followed is left alone unless the update changes it
+  bool handle_path_update(const messages::PathRequest& path_update);
 
   // --------------------------------------------------------------------------
   // Destination request handling
 
-  bool read_destination_request();
+  bool handle_destination_request(
+      const messages::DestinationRequest& destination_request);
 
   // --------------------------------------------------------------------------
   // Task handling
@@ -160,18 +179,149 @@ private:
     bool sent = false;
     uint32_t aborted_count = 0;
     ros::Time goal_end_time;
+
+    /// Set when the goal is sent, callbacks of goals that are no longer the
+    /// one being followed are told apart by it
+    uint64_t send_id = 0;
   };
 
   std::mutex goal_path_mutex;
 
   std::deque<Goal> goal_path;
 
-  void read_requests();
+  // Version and length of the path request that goal_path was filled from,
+  // the version stays 0 for destination requests
+  uint32_t current_path_version = 0;
+
+  size_t current_path_length = 0;
+
+  /// Requests that are queued to start once the task before them completes,
+  /// so that the robot moves on without waiting for the server, in the order
+  /// they follow each other. Guarded by goal_path_mutex.
+  struct QueuedTask
+  {
+    std::string after_task_id;
+    std::string task_id;
+    std::deque<Goal> goals;
+    uint32_t path_version;
+  };
+
+  std::deque<QueuedTask> queued_tasks;
+
+  /// Queues the task behind the last task of the robot, and starts it right
+  /// away if the current task is already done. Tasks that follow any other
+  /// task are ignored. Returns true if the task was started.
+  bool queue_task(QueuedTask task);
+
+  /// Moves on to the next queued task, returns false if there is none. Needs
+  /// to be called with goal_path_mutex locked and the goals of the current
+  /// task done.
+  bool start_queued_task();
+
+  /// Serializes the handling of incoming path and destination requests,
+  /// which arrive on the DDS reader threads, mode requests do not take it
+  std::mutex request_mutex;
+
+  void start_request_callbacks();
+
+  // --------------------------------------------------------------------------
+  // Goal progression, driven by the move base action callbacks
+
+  /// Only one thread sends goals at a time, a thread that finds another one
+  /// sending leaves the pending goal for that thread to send
+  std::mutex goal_send_mutex;
+
+  std::atomic<bool> goal_send_pending{false};
+
+  uint64_t last_goal_send_id = 0;
+
+  /// Sends the first goal of the path unless it was already sent, or goals
+  /// are on hold. Never called with goal_path_mutex locked, as actionlib
+  /// calls the goal callbacks with its own lock held, and those lock
+  /// goal_path_mutex.
+  void send_next_goal();
+
+  void handle_goal_active(uint64_t send_id);
+
+  void handle_goal_done(uint64_t send_id, const GoalState& state);
+
+  /// Robots that reach a goal ahead of its time wait for it on this timer
+  /// before moving on to the next goal
+  std::mutex goal_wait_timer_mutex;
+
+  ros::Timer goal_wait_timer;
+
+  void start_goal_wait(uint64_t send_id, const ros::Duration& wait_time);
 
-  void handle_requests();
+  void handle_goal_wait_done(uint64_t send_id);
+
+  // --------------------------------------------------------------------------
+  // Published state
+
+  /// Everything the published robot state is made of, split by how often it
+  /// changes, so that publishing gets a consistent state of each without
+  /// taking any of the writers' locks. The transform, battery and motion
+  /// change on every update and are overwritten in place.
+  struct ObservedStatus
+  {
+    int32_t sec = 0;
+    uint32_t nanosec = 0;
+    double x = 0.0;
+    double y = 0.0;
+    double yaw = 0.0;
+    float battery_percent = 0.f;
+    bool charging = false;
+    bool moving = false;
+  };
+
+  /// The task and its path only change with requests and goals, they are
+  /// replaced as a whole
+  struct ObservedTask
+  {
+    std::string task_id;
+    uint32_t path_version = 0;
+    uint32_t path_index = 0;
+    std::vector<messages::Location> path;
+  };
+
+  /// Each only serializes the writers of its state, publishing never takes
+  /// either of them
+  std::mutex observed_status_mutex;
+
+  SeqLock<ObservedStatus> observed_status;
+
+  std::mutex observed_task_mutex;
+
+  AtomicSnapshot<ObservedTask> observed_task;
+
+  void update_observed_status(
+      const std::function<void(ObservedStatus&)>& update);
+
+  /// Needs to be called with goal_path_mutex locked
+  void update_observed_path();
+
+  void update_observed_task_id(const std::string& task_id);
+
+  /// State that gets filled in and sent on every publish, only used from the
+  /// publish thread. Its path starts out with room for this many waypoints,
+  /// and keeps whatever capacity longer paths needed.
+  static constexpr size_t OutgoingPathCapacity = 32;
+
+  messages::RobotState outgoing_robot_state;
 
   void publish_robot_state();
 
+  /// Last state that was published along with when, only used from the
+  /// publish thread
+  bool published_robot_state = false;
+
+  messages::RobotState last_published_robot_state;
+
+  ros::WallTime last_published_time;
+
+  bool should_publish_robot_state(
+      const messages::RobotState& robot_state) const;
+
   // --------------------------------------------------------------------------
   // Threads and thread functions
 
@@ -185,6 +335,19 @@ private:
 
   // --------------------------------------------------------------------------
 
+  ros::WallTimer diagnostics_timer;
+
+  ros::Publisher diagnostics_pub;
+
+  /// Stats that were last published, which the rates are computed from
+  Stats published_stats;
+
+  std::chrono::steady_clock::time_point published_stats_time;
+
+  void diagnostics_timer_fn(const ros::WallTimerEvent& event);
+
+  // --------------------------------------------------------------------------
+
   ClientNodeConfig client_node_config;
 
   Fields fields;
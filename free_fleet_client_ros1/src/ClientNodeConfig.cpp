@@ -16,6 +16,7 @@
  */
 
 #include <cstdio>
+#include <algorithm>
 
 #include "ClientNodeConfig.hpp"
 
@@ -63,6 +64,72 @@ void ClientNodeConfig::get_param_if_available(
   }
 }
 
+void ClientNodeConfig::get_param_if_available(
+    const ros::NodeHandle& _node, const std::string& _key,
+    bool& _param_out)
+{
+  bool tmp_param;
+  if (_node.getParam(_key, tmp_param))
+  {
+    ROS_INFO("Found %s on the parameter server. Setting %s to %s.",
+        _key.c_str(), _key.c_str(), tmp_param ? "true" : "false");
+    _param_out = tmp_param;
+  }
+}
+
+void ClientNodeConfig::get_param_if_available(
+    const ros::NodeHandle& _node, const std::string& _key,
+    std::vector<std::string>& _param_out)
+{
+  std::vector<std::string> tmp_param;
+  if (_node.getParam(_key, tmp_param))
+  {
+    ROS_INFO("Found %s on the parameter server. Setting %s to %zu values.",
+        _key.c_str(), _key.c_str(), tmp_param.size());
+    _param_out = tmp_param;
+  }
+}
+
+void ClientNodeConfig::get_param_if_available(
+    const ros::NodeHandle& _node, const std::string& _key,
+    std::vector<int>& _param_out)
+{
+  std::vector<int> tmp_param;
+  if (_node.getParam(_key, tmp_param))
+  {
+    ROS_INFO("Found %s on the parameter server. Setting %s to %zu values.",
+        _key.c_str(), _key.c_str(), tmp_param.size());
+    _param_out = tmp_param;
+  }
+}
+
+void ClientNodeConfig::get_qos_params_if_available(
+    const ros::NodeHandle& _node, const std::string& _prefix,
+    TopicQoS& _qos_out)
+{
+  get_param_if_available(_node, _prefix + "/reliable", _qos_out.reliable);
+  get_param_if_available(
+      _node, _prefix + "/history_depth", _qos_out.history_depth);
+  get_param_if_available(
+      _node, _prefix + "/transient_local", _qos_out.transient_local);
+  get_param_if_available(_node, _prefix + "/deadline", _qos_out.deadline);
+  get_param_if_available(
+      _node, _prefix + "/latency_budget", _qos_out.latency_budget);
+  get_param_if_available(
+      _node, _prefix + "/liveliness_lease", _qos_out.liveliness_lease);
+  get_param_if_available(
+      _node, _prefix + "/transport_priority", _qos_out.transport_priority);
+}
+
+void ClientNodeConfig::get_thread_params_if_available(
+    const ros::NodeHandle& _node, const std::string& _prefix,
+    ThreadConfig& _thread_out)
+{
+  get_param_if_available(_node, _prefix + "/cpus", _thread_out.cpus);
+  get_param_if_available(
+      _node, _prefix + "/fifo_priority", _thread_out.fifo_priority);
+}
+
 void ClientNodeConfig::print_config() const
 {
   printf("ROS 1 CLIENT CONFIGURATION\n");
@@ -73,10 +140,23 @@ void ClientNodeConfig::print_config() const
   printf("  wait timeout: %.1f\n", wait_timeout);
   printf("  update request frequency: %.1f\n", update_frequency);
   printf("  publish state frequency: %.1f\n", publish_frequency);
+  printf("  adaptive publishing: %s\n",
+      adaptive_publishing ? "enabled" : "disabled");
+  printf("    maximum publish frequency: %.1f\n", max_publish_frequency);
+  printf("    heartbeat period: %.1f\n", heartbeat_period);
+  printf("    distance threshold: %.2f\n", publish_distance_threshold);
+  printf("    yaw threshold: %.2f\n", publish_yaw_threshold);
   printf("  maximum distance to first waypoint: %.1f\n", 
       max_dist_to_first_waypoint);
+  printf("  compact path progress: %s\n",
+      compact_path_progress ? "enabled" : "disabled");
+  printf("  path simplification tolerance: %.3f m, %.3f rad\n",
+      path_simplification_tolerance, path_simplification_yaw_tolerance);
+  printf("  path packing threshold: %d\n", path_packing_threshold);
+  printf("  diagnostics period (seconds): %.1f\n", diagnostics_period);
   printf("  TOPICS\n");
   printf("    battery state: %s\n", battery_state_topic.c_str());
+  printf("    diagnostics: %s\n", diagnostics_topic.c_str());
   printf("    move base server: %s\n", move_base_server_name.c_str());
   printf("    docking trigger server: %s\n", docking_trigger_server_name.c_str());
   printf("  ROBOT FRAMES\n");
@@ -84,22 +164,75 @@ void ClientNodeConfig::print_config() const
   printf("    robot frame: %s\n", robot_frame.c_str());
   printf("CLIENT-SERVER DDS CONFIGURATION\n");
   printf("  dds domain: %d\n", dds_domain);
+  printf("  dds partition: %s\n",
+      dds_partition.empty() ? "default" : dds_partition.c_str());
+  printf("  per-robot request partitions: %s\n",
+      dds_request_partitions ? "enabled" : "disabled");
+  printf("  shared memory: %s\n",
+      dds_shared_memory ? "enabled" : "disabled");
+  printf("  discovery: mode %s, %zu peers, interface %s, "
+      "spdp interval %.3fs\n",
+      dds_discovery_mode.c_str(), dds_discovery_peers.size(),
+      dds_network_interface.empty() ? "auto" : dds_network_interface.c_str(),
+      dds_spdp_interval);
+  printf("  robot registration: %s\n",
+      robot_registration ? "enabled" : "disabled");
+  printf("  time sync: %s\n", time_sync ? "enabled" : "disabled");
+  printf("  request acks: %s\n", request_acks ? "enabled" : "disabled");
+  printf("  split robot state: %s\n",
+      split_robot_state ? "enabled" : "disabled");
   printf("  TOPICS\n");
   printf("    robot state: %s\n", dds_state_topic.c_str());
   printf("    mode request: %s\n", dds_mode_request_topic.c_str());
   printf("    path request: %s\n", dds_path_request_topic.c_str());
   printf("    destination request: %s\n", 
       dds_destination_request_topic.c_str());
+  printf("  QOS\n");
+  printf("    robot state: %s\n", dds_state_qos.to_string().c_str());
+  printf("    mode request: %s\n", dds_mode_request_qos.to_string().c_str());
+  printf("    path request: %s\n", dds_path_request_qos.to_string().c_str());
+  printf("    destination request: %s\n",
+      dds_destination_request_qos.to_string().c_str());
+  printf("  THREADS\n");
+  printf("    update: %s\n", update_thread.to_string().c_str());
+  printf("    publish: %s\n", publish_thread.to_string().c_str());
+  printf("    client: %s\n", client_threads.to_string().c_str());
+  printf("    dds: %s\n", dds_threads.to_string().c_str());
 }
   
 ClientConfig ClientNodeConfig::get_client_config() const
 {
   ClientConfig client_config;
+  client_config.fleet_name = fleet_name;
+  client_config.robot_name = robot_name;
   client_config.dds_domain = dds_domain;
   client_config.dds_state_topic = dds_state_topic;
   client_config.dds_mode_request_topic = dds_mode_request_topic;
   client_config.dds_path_request_topic = dds_path_request_topic;
   client_config.dds_destination_request_topic = dds_destination_request_topic;
+  client_config.dds_request_partitions = dds_request_partitions;
+  client_config.dds_partition = dds_partition;
+  client_config.dds_shared_memory = dds_shared_memory;
+  DiscoveryConfig::parse_mode(
+      dds_discovery_mode, client_config.dds_discovery.mode);
+  client_config.dds_discovery.peers = dds_discovery_peers;
+  client_config.dds_discovery.network_interface = dds_network_interface;
+  client_config.dds_discovery.spdp_interval = dds_spdp_interval;
+  client_config.robot_registration = robot_registration;
+  client_config.time_sync = time_sync;
+  client_config.request_acks = request_acks;
+  client_config.split_robot_state = split_robot_state;
+  client_config.dds_state_qos = dds_state_qos;
+  client_config.dds_mode_request_qos = dds_mode_request_qos;
+  client_config.dds_path_request_qos = dds_path_request_qos;
+  client_config.dds_destination_request_qos = dds_destination_request_qos;
+  client_config.path_simplification_tolerance = path_simplification_tolerance;
+  client_config.path_simplification_yaw_tolerance =
+      path_simplification_yaw_tolerance;
+  client_config.path_packing_threshold =
+      static_cast<size_t>(std::max(path_packing_threshold, 0));
+  client_config.threads = client_threads;
+  client_config.dds_threads = dds_threads;
   return client_config;
 }
 
@@ -133,15 +266,81 @@ ClientNodeConfig ClientNodeConfig::make()
   config.get_param_if_available(
       node_private_ns, "dds_destination_request_topic", 
       config.dds_destination_request_topic);
+  config.get_param_if_available(
+      node_private_ns, "dds_request_partitions", 
+      config.dds_request_partitions);
+  config.get_param_if_available(
+      node_private_ns, "dds_partition", config.dds_partition);
+  config.get_param_if_available(
+      node_private_ns, "dds_shared_memory", config.dds_shared_memory);
+  config.get_param_if_available(
+      node_private_ns, "dds_discovery_mode", config.dds_discovery_mode);
+  config.get_param_if_available(
+      node_private_ns, "dds_discovery_peers", config.dds_discovery_peers);
+  config.get_param_if_available(
+      node_private_ns, "dds_network_interface", config.dds_network_interface);
+  config.get_param_if_available(
+      node_private_ns, "dds_spdp_interval", config.dds_spdp_interval);
+  config.get_param_if_available(
+      node_private_ns, "robot_registration", config.robot_registration);
+  config.get_param_if_available(node_private_ns, "time_sync", config.time_sync);
+  config.get_param_if_available(
+      node_private_ns, "request_acks", config.request_acks);
+  config.get_param_if_available(
+      node_private_ns, "split_robot_state", config.split_robot_state);
+  config.get_qos_params_if_available(
+      node_private_ns, "dds_state_qos", config.dds_state_qos);
+  config.get_qos_params_if_available(
+      node_private_ns, "dds_mode_request_qos", config.dds_mode_request_qos);
+  config.get_qos_params_if_available(
+      node_private_ns, "dds_path_request_qos", config.dds_path_request_qos);
+  config.get_qos_params_if_available(
+      node_private_ns, "dds_destination_request_qos",
+      config.dds_destination_request_qos);
   config.get_param_if_available(
       node_private_ns, "wait_timeout", config.wait_timeout);
   config.get_param_if_available(
       node_private_ns, "update_frequency", config.update_frequency);
   config.get_param_if_available(
       node_private_ns, "publish_frequency", config.publish_frequency);
+  config.get_param_if_available(
+      node_private_ns, "adaptive_publishing", config.adaptive_publishing);
+  config.get_param_if_available(
+      node_private_ns, "max_publish_frequency", config.max_publish_frequency);
+  config.get_param_if_available(
+      node_private_ns, "heartbeat_period", config.heartbeat_period);
+  config.get_param_if_available(
+      node_private_ns, "publish_distance_threshold",
+      config.publish_distance_threshold);
+  config.get_param_if_available(
+      node_private_ns, "publish_yaw_threshold", config.publish_yaw_threshold);
   config.get_param_if_available(
       node_private_ns, "max_dist_to_first_waypoint", 
       config.max_dist_to_first_waypoint);
+  config.get_param_if_available(
+      node_private_ns, "compact_path_progress",
+      config.compact_path_progress);
+  config.get_param_if_available(
+      node_private_ns, "path_simplification_tolerance",
+      config.path_simplification_tolerance);
+  config.get_param_if_available(
+      node_private_ns, "path_simplification_yaw_tolerance",
+      config.path_simplification_yaw_tolerance);
+  config.get_param_if_available(
+      node_private_ns, "path_packing_threshold",
+      config.path_packing_threshold);
+  config.get_param_if_available(
+      node_private_ns, "diagnostics_topic", config.diagnostics_topic);
+  config.get_param_if_available(
+      node_private_ns, "diagnostics_period", config.diagnostics_period);
+  config.get_thread_params_if_available(
+      node_private_ns, "update_thread", config.update_thread);
+  config.get_thread_params_if_available(
+      node_private_ns, "publish_thread", config.publish_thread);
+  config.get_thread_params_if_available(
+      node_private_ns, "client_threads", config.client_threads);
+  config.get_thread_params_if_available(
+      node_private_ns, "dds_threads", config.dds_threads);
   return config;
 }
 
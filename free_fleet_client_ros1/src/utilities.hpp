@@ -20,6 +20,12 @@
 
 #include <geometry_msgs/Quaternion.h>
 #include <geometry_msgs/TransformStamped.h>
+#include <diagnostic_msgs/DiagnosticStatus.h>
+
+#include <string>
+#include <vector>
+
+#include <free_fleet/Stats.hpp>
 
 namespace free_fleet
 {
@@ -37,6 +43,19 @@ bool is_transform_close(
     const geometry_msgs::TransformStamped& transform_1,
     const geometry_msgs::TransformStamped& transform_2);
 
+
+/// Fills in a diagnostic status for the traffic through each topic, along
+/// with its rates since the previous stats, and one for each latency
+/// histogram. Topics warn whenever samples were lost, rejected or failed to
+/// be written since the previous stats.
+void to_diagnostic_statuses(
+    const Stats& stats,
+    const Stats& previous_stats,
+    double elapsed_seconds,
+    const std::string& name,
+    const std::string& hardware_id,
+    std::vector<diagnostic_msgs::DiagnosticStatus>& statuses);
+
 } // namespace ros1
 } // namespace free_fleet
 
@@ -19,6 +19,9 @@
 #define FREE_FLEET__ROS2__CLIENTNODE_HPP
 
 #include <deque>
+#include <chrono>
+#include <functional>
+#include <mutex>
 #include <shared_mutex>
 #include <atomic>
 #include <memory>
@@ -33,16 +36,19 @@
 #include <tf2/impl/utils.h>
 #include <std_srvs/srv/trigger.hpp>
 #include <sensor_msgs/msg/battery_state.hpp>
+#include <diagnostic_msgs/msg/diagnostic_array.hpp>
 #include <nav2_msgs/action/navigate_to_pose.hpp>
+#include <nav2_msgs/action/navigate_through_poses.hpp>
 
 #include <geometry_msgs/msg/transform_stamped.hpp>
 
-#include <nav2_util/robot_utils.hpp>
-
 #include <geometry_msgs/msg/pose_stamped.hpp>
 
+#include <free_fleet/Stats.hpp>
 #include <free_fleet/Client.hpp>
 #include <free_fleet/ClientConfig.hpp>
+#include <free_fleet/SeqLock.hpp>
+#include <free_fleet/AtomicSnapshot.hpp>
 #include <free_fleet/messages/RobotState.hpp>
 #include <free_fleet/messages/ModeRequest.hpp>
 #include <free_fleet/messages/PathRequest.hpp>
@@ -68,6 +74,9 @@ public:
 
   using NavigateToPose = nav2_msgs::action::NavigateToPose;
   using GoalHandleNavigateToPose = rclcpp_action::ClientGoalHandle<NavigateToPose>;
+  using NavigateThroughPoses = nav2_msgs::action::NavigateThroughPoses;
+  using GoalHandleNavigateThroughPoses =
+    rclcpp_action::ClientGoalHandle<NavigateThroughPoses>;
 
   explicit ClientNode(const rclcpp::NodeOptions & options = rclcpp::NodeOptions());
   ~ClientNode() override;
@@ -80,6 +89,9 @@ public:
     // navigation2 action client
     rclcpp_action::Client<NavigateToPose>::SharedPtr move_base_client;
 
+    // navigation2 action client for whole paths, nullptr if not used
+    rclcpp_action::Client<NavigateThroughPoses>::SharedPtr through_poses_client;
+
     // Docker server client
     rclcpp::Client<std_srvs::srv::Trigger>::SharedPtr docking_trigger_client;
   };
@@ -91,8 +103,6 @@ private:
   // Battery handling
 
   rclcpp::Subscription<sensor_msgs::msg::BatteryState>::SharedPtr  battery_percent_sub;
-  Mutex battery_state_mutex;
-  sensor_msgs::msg::BatteryState current_battery_state;
   void battery_state_callback_fn(const sensor_msgs::msg::BatteryState::SharedPtr msg);
 
   // --------------------------------------------------------------------------
@@ -100,11 +110,13 @@ private:
 
   std::shared_ptr<tf2_ros::Buffer> tf2_buffer;
   std::shared_ptr<tf2_ros::TransformListener> tf2_listener;
-  Mutex robot_pose_mutex;
-  geometry_msgs::msg::PoseStamped current_robot_pose;
+
+  /// Pose of the previous update, only used by the update to tell whether
+  /// the robot moved. Everything else reads the pose from observed_status.
   geometry_msgs::msg::PoseStamped previous_robot_pose;
 
-  bool get_robot_pose();
+  /// Looks up the latest pose of the robot without waiting on TF
+  bool update_robot_pose();
 
   // --------------------------------------------------------------------------
   // Mode handling
@@ -116,18 +128,26 @@ private:
   std::atomic<bool> emergency;
   std::atomic<bool> paused;
 
-  messages::RobotMode get_robot_mode();
-  bool read_mode_request();
+  struct ObservedStatus;
+  messages::RobotMode get_robot_mode(const ObservedStatus & observed_status) const;
+  /// Called without request_mutex, which is only taken once the robot has
+  /// been stopped
+  bool handle_mode_request(const messages::ModeRequest & mode_request);
 
   // --------------------------------------------------------------------------
   // Path request handling
 
-  bool read_path_request();
+  bool handle_path_request(const messages::PathRequest & path_request);
+
+  /// Applies a request that only changes the tail of the current path, the
+  /// goal that is being followed is left alone unless the update changes it
+  bool handle_path_update(const messages::PathRequest & path_update);
 
   // --------------------------------------------------------------------------
   // Destination request handling
 
-  bool read_destination_request();
+  bool handle_destination_request(
+    const messages::DestinationRequest & destination_request);
 
   // --------------------------------------------------------------------------
   // Task handling
@@ -155,10 +175,132 @@ private:
   Mutex goal_path_mutex;
   std::deque<Goal> goal_path;
 
-  void read_requests();
+  // Version and length of the path request that goal_path was filled from,
+  // the version stays 0 for destination requests
+  uint32_t current_path_version = 0;
+  size_t current_path_length = 0;
+
+  /// Requests that are queued to start once the task before them completes,
+  /// so that the robot moves on without waiting for the server, in the order
+  /// they follow each other. Guarded by goal_path_mutex.
+  struct QueuedTask
+  {
+    std::string after_task_id;
+    std::string task_id;
+    std::deque<Goal> goals;
+    uint32_t path_version;
+  };
+  std::deque<QueuedTask> queued_tasks;
+
+  /// Queues the task behind the last task of the robot, and starts it right
+  /// away if the current task is already done. Tasks that follow any other
+  /// task are ignored. Returns true if the task was started.
+  bool queue_task(QueuedTask task);
+
+  /// Moves on to the next queued task, returns false if there is none. Needs
+  /// to be called with goal_path_mutex locked and the goals of the current
+  /// task done.
+  bool start_queued_task();
+
+  /// One shot timer that completes the current goal once its scheduled end
+  /// time is reached, when the robot got there early. Guarded by
+  /// goal_path_mutex along with the generation, bumped every time the wait
+  /// gets scheduled or cancelled.
+  rclcpp::TimerBase::SharedPtr early_arrival_timer;
+  uint64_t early_arrival_generation = 0;
+
+  void schedule_early_arrival(const rclcpp::Duration & wait_time);
+  void cancel_early_arrival();
+
+  /// Bumped every time the goals get replaced or paused, so that results and
+  /// feedback of goals sent before that are ignored. Guarded by
+  /// goal_path_mutex.
+  uint64_t goal_generation = 0;
+
+  /// Cancels any early arrival wait and disowns the goals that were sent,
+  /// needs to be called with goal_path_mutex locked
+  void discard_sent_goals();
+
+  /// Cancels the goals of both action clients, without waiting
+  void cancel_all_goals();
+
+  void send_next_goal();
+  void send_remaining_path();
+
+  /// Follows up on the result of a sent goal, whole_path is true if it was a
+  /// NavigateThroughPoses goal of everything left in goal_path. Returns true
+  /// if the next goal can be sent right away.
+  bool handle_goal_result(
+    rclcpp_action::ResultCode code, bool whole_path, uint64_t generation);
+
+  /// Serializes the handling of incoming requests, which arrive on the DDS
+  /// reader threads, with following up on the goals from the update timer.
+  /// Mode requests only take it after stopping the robot.
+  std::mutex request_mutex;
+
+  void start_request_callbacks();
   void handle_requests();
+
+  // --------------------------------------------------------------------------
+  // Published state
+
+  /// Everything the published robot state is made of, split by how often it
+  /// changes, so that publishing gets a consistent state of each without
+  /// taking any of the writers' locks. The pose, battery and motion change
+  /// on every update and are overwritten in place.
+  struct ObservedStatus
+  {
+    int32_t sec = 0;
+    uint32_t nanosec = 0;
+    double x = 0.0;
+    double y = 0.0;
+    double yaw = 0.0;
+    float battery_percent = 0.f;
+    bool charging = false;
+    bool moving = false;
+  };
+
+  /// The task and its path only change with requests and goals, they are
+  /// replaced as a whole
+  struct ObservedTask
+  {
+    std::string task_id;
+    uint32_t path_version = 0;
+    uint32_t path_index = 0;
+    std::vector<messages::Location> path;
+  };
+
+  /// Each only serializes the writers of its state, publishing never takes
+  /// either of them
+  std::mutex observed_status_mutex;
+  SeqLock<ObservedStatus> observed_status;
+
+  std::mutex observed_task_mutex;
+  AtomicSnapshot<ObservedTask> observed_task;
+
+  void update_observed_status(const std::function<void(ObservedStatus &)> & update);
+
+  /// Needs to be called with goal_path_mutex locked
+  void update_observed_path();
+
+  void update_observed_task_id(const std::string & task_id);
+
+  /// State that gets filled in and sent on every publish, only used from the
+  /// publish timer. Its path starts out with room for this many waypoints,
+  /// and keeps whatever capacity longer paths needed.
+  static constexpr size_t OutgoingPathCapacity = 32;
+  messages::RobotState outgoing_robot_state;
+
   void publish_robot_state();
 
+  /// Last state that was published along with when, only used from the
+  /// publish timer
+  bool published_robot_state = false;
+  messages::RobotState last_published_robot_state;
+  std::chrono::steady_clock::time_point last_published_time;
+
+  bool should_publish_robot_state(const messages::RobotState & robot_state) const;
+
   // --------------------------------------------------------------------------
   // publish and update functions and timers
 
@@ -167,11 +309,26 @@ private:
   void update_fn();
   void publish_fn();
 
+  // --------------------------------------------------------------------------
+  // diagnostics, published from their own timer as stats are collected
+  // without locking
+
+  rclcpp::TimerBase::SharedPtr diagnostics_timer;
+  rclcpp::Publisher<diagnostic_msgs::msg::DiagnosticArray>::SharedPtr diagnostics_pub;
+
+  /// Stats that were last published, which the rates are computed from
+  Stats published_stats;
+  std::chrono::steady_clock::time_point published_stats_time;
+
+  void publish_diagnostics();
+
   // --------------------------------------------------------------------------
 
   ClientNodeConfig client_node_config;
   Fields fields;
 
+  void declare_and_get_qos_parameters(const std::string & prefix, TopicQoS & qos);
+
   void start(Fields fields);
 };
 
@@ -19,9 +19,11 @@
 #define FREE_FLEET__ROS2__CLIENTNODECONFIG_HPP
 
 #include <string>
+#include <vector>
 
 #include <rclcpp/rclcpp.hpp>
 
+#include <free_fleet/TopicQoS.hpp>
 #include <free_fleet/ClientConfig.hpp>
 
 namespace free_fleet
@@ -45,18 +47,69 @@ struct ClientNodeConfig
   std::string move_base_server_name = "move_base";
   std::string docking_trigger_server_name = "";
 
+  /// Send the remaining path as a single NavigateThroughPoses goal, so the
+  /// robot does not stop at every waypoint, only single waypoints are still
+  /// sent as NavigateToPose goals
+  bool use_navigate_through_poses = false;
+  std::string navigate_through_poses_server_name = "navigate_through_poses";
+
   int dds_domain = 42;
   std::string dds_state_topic = "robot_state";
   std::string dds_mode_request_topic = "mode_request";
   std::string dds_path_request_topic = "path_request";
   std::string dds_destination_request_topic = "destination_request";
+  bool dds_request_partitions = false;
+  std::string dds_partition = "";
+  bool dds_shared_memory = false;
+  std::string dds_discovery_mode = "default";
+  std::vector<std::string> dds_discovery_peers;
+  std::string dds_network_interface = "";
+  double dds_spdp_interval = 0.0;
+  bool robot_registration = false;
+  bool time_sync = false;
+  bool request_acks = false;
+  bool split_robot_state = false;
+
+  TopicQoS dds_state_qos = TopicQoS::best_effort();
+  TopicQoS dds_mode_request_qos = TopicQoS::urgent_requests();
+  TopicQoS dds_path_request_qos = TopicQoS::reliable_requests();
+  TopicQoS dds_destination_request_qos = TopicQoS::reliable_requests();
 
   double wait_timeout = 10.0;
   double update_frequency = 10.0;
   double publish_frequency = 1.0;
 
+  /// Publish the state on the next tick after it changes, on every tick at
+  /// max_publish_frequency while the robot is moving, and only every
+  /// heartbeat_period seconds otherwise, instead of at publish_frequency
+  bool adaptive_publishing = false;
+  double max_publish_frequency = 10.0;
+  double heartbeat_period = 5.0;
+
+  /// Movement since the last published state that counts as a change
+  double publish_distance_threshold = 0.1;
+  double publish_yaw_threshold = 0.1;
+
   double max_dist_to_first_waypoint = 10.0;
 
+  /// Only report the version of the current path request and the index of
+  /// the next waypoint, instead of the whole remaining path
+  bool compact_path_progress = false;
+
+  /// Reported paths are simplified within these tolerances in meters and
+  /// radians before they are sent, disabled if the distance tolerance is 0
+  double path_simplification_tolerance = 0.0;
+  double path_simplification_yaw_tolerance = 0.1;
+
+  /// Paths of at least this many waypoints are sent packed, see
+  /// ClientConfig::path_packing_threshold, disabled if 0
+  int path_packing_threshold = 0;
+
+  /// Statistics of the client are published as diagnostics every this many
+  /// seconds, disabled if 0
+  std::string diagnostics_topic = "diagnostics";
+  double diagnostics_period = 1.0;
+
   void print_config() const;
 
   ClientConfig get_client_config() const;
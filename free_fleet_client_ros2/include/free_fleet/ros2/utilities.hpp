@@ -18,7 +18,13 @@
 #ifndef FREE_FLEET__ROS2__UTILITIES_HPP
 #define FREE_FLEET__ROS2__UTILITIES_HPP
 
+#include <string>
+#include <vector>
+
 #include <geometry_msgs/msg/pose_stamped.hpp>
+#include <diagnostic_msgs/msg/diagnostic_status.hpp>
+
+#include <free_fleet/Stats.hpp>
 
 namespace free_fleet
 {
@@ -34,6 +40,18 @@ bool is_pose_close(
     const geometry_msgs::msg::PoseStamped& pose_1,
     const geometry_msgs::msg::PoseStamped& pose_2);
 
+/// Fills in a diagnostic status for the traffic through each topic, along
+/// with its rates since the previous stats, and one for each latency
+/// histogram. Topics warn whenever samples were lost, rejected or failed to
+/// be written since the previous stats.
+void to_diagnostic_statuses(
+    const Stats& stats,
+    const Stats& previous_stats,
+    double elapsed_seconds,
+    const std::string& name,
+    const std::string& hardware_id,
+    std::vector<diagnostic_msgs::msg::DiagnosticStatus>& statuses);
+
 } // namespace ros2
 } // namespace free_fleet
 
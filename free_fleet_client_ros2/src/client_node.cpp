@@ -15,9 +15,10 @@
  *
  */
 
+#include <cmath>
+#include <algorithm>
 #include <iostream>
 #include <exception>
-#include <thread>
 
 #include <rcl/time.h>
 #include <rclcpp/rclcpp.hpp>
@@ -25,6 +26,9 @@
 
 #include <rclcpp_action/rclcpp_action.hpp>
 #include <nav2_msgs/action/navigate_to_pose.hpp>
+#include <nav2_msgs/action/navigate_through_poses.hpp>
+
+#include <free_fleet/Tracing.hpp>
 
 #include "free_fleet/ros2/utilities.hpp"
 #include "free_fleet/ros2/client_node.hpp"
@@ -51,16 +55,51 @@ ClientNode::ClientNode(const rclcpp::NodeOptions & options)
   declare_parameter("robot_frame", client_node_config.robot_frame);
   declare_parameter("nav2_server_name", client_node_config.move_base_server_name);
   declare_parameter("docking_trigger_server_name", client_node_config.docking_trigger_server_name);
+  declare_parameter(
+    "use_navigate_through_poses", client_node_config.use_navigate_through_poses);
+  declare_parameter(
+    "nav2_through_poses_server_name",
+    client_node_config.navigate_through_poses_server_name);
   declare_parameter("dds_domain", client_node_config.dds_domain);
   declare_parameter("dds_mode_request_topic", client_node_config.dds_mode_request_topic);
   declare_parameter("dds_path_request_topic", client_node_config.dds_path_request_topic);
   declare_parameter(
     "dds_destination_request_topic",
     client_node_config.dds_destination_request_topic);
+  declare_parameter("dds_request_partitions", client_node_config.dds_request_partitions);
+  declare_parameter("dds_partition", client_node_config.dds_partition);
+  declare_parameter("dds_shared_memory", client_node_config.dds_shared_memory);
+  declare_parameter("dds_discovery_mode", client_node_config.dds_discovery_mode);
+  declare_parameter(
+    "dds_discovery_peers", client_node_config.dds_discovery_peers);
+  declare_parameter(
+    "dds_network_interface", client_node_config.dds_network_interface);
+  declare_parameter("dds_spdp_interval", client_node_config.dds_spdp_interval);
+  declare_parameter("robot_registration", client_node_config.robot_registration);
+  declare_parameter("time_sync", client_node_config.time_sync);
+  declare_parameter("request_acks", client_node_config.request_acks);
+  declare_parameter(
+    "split_robot_state", client_node_config.split_robot_state);
   declare_parameter("wait_timeout", client_node_config.wait_timeout);
   declare_parameter("update_frequency", client_node_config.update_frequency);
   declare_parameter("publish_frequency", client_node_config.publish_frequency);
+  declare_parameter("adaptive_publishing", client_node_config.adaptive_publishing);
+  declare_parameter("max_publish_frequency", client_node_config.max_publish_frequency);
+  declare_parameter("heartbeat_period", client_node_config.heartbeat_period);
+  declare_parameter(
+    "publish_distance_threshold", client_node_config.publish_distance_threshold);
+  declare_parameter("publish_yaw_threshold", client_node_config.publish_yaw_threshold);
   declare_parameter("max_dist_to_first_waypoint", client_node_config.max_dist_to_first_waypoint);
+  declare_parameter("compact_path_progress", client_node_config.compact_path_progress);
+  declare_parameter(
+    "path_simplification_tolerance", client_node_config.path_simplification_tolerance);
+  declare_parameter(
+    "path_simplification_yaw_tolerance",
+    client_node_config.path_simplification_yaw_tolerance);
+  declare_parameter(
+    "path_packing_threshold", client_node_config.path_packing_threshold);
+  declare_parameter("diagnostics_topic", client_node_config.diagnostics_topic);
+  declare_parameter("diagnostics_period", client_node_config.diagnostics_period);
 
   // getting new values for parameters or keep defaults
   get_parameter("fleet_name", client_node_config.fleet_name);
@@ -72,16 +111,55 @@ ClientNode::ClientNode(const rclcpp::NodeOptions & options)
   get_parameter("robot_frame", client_node_config.robot_frame);
   get_parameter("nav2_server_name", client_node_config.move_base_server_name);
   get_parameter("docking_trigger_server_name", client_node_config.docking_trigger_server_name);
+  get_parameter(
+    "use_navigate_through_poses", client_node_config.use_navigate_through_poses);
+  get_parameter(
+    "nav2_through_poses_server_name",
+    client_node_config.navigate_through_poses_server_name);
   get_parameter("dds_domain", client_node_config.dds_domain);
   get_parameter("dds_mode_request_topic", client_node_config.dds_mode_request_topic);
   get_parameter("dds_path_request_topic", client_node_config.dds_path_request_topic);
   get_parameter(
     "dds_destination_request_topic",
     client_node_config.dds_destination_request_topic);
+  get_parameter("dds_request_partitions", client_node_config.dds_request_partitions);
+  get_parameter("dds_partition", client_node_config.dds_partition);
+  get_parameter("dds_shared_memory", client_node_config.dds_shared_memory);
+  get_parameter("dds_discovery_mode", client_node_config.dds_discovery_mode);
+  get_parameter("dds_discovery_peers", client_node_config.dds_discovery_peers);
+  get_parameter(
+    "dds_network_interface", client_node_config.dds_network_interface);
+  get_parameter("dds_spdp_interval", client_node_config.dds_spdp_interval);
+  get_parameter("robot_registration", client_node_config.robot_registration);
+  get_parameter("time_sync", client_node_config.time_sync);
+  get_parameter("request_acks", client_node_config.request_acks);
+  get_parameter("split_robot_state", client_node_config.split_robot_state);
+  declare_and_get_qos_parameters("dds_state_qos", client_node_config.dds_state_qos);
+  declare_and_get_qos_parameters("dds_mode_request_qos", client_node_config.dds_mode_request_qos);
+  declare_and_get_qos_parameters("dds_path_request_qos", client_node_config.dds_path_request_qos);
+  declare_and_get_qos_parameters(
+    "dds_destination_request_qos",
+    client_node_config.dds_destination_request_qos);
   get_parameter("wait_timeout", client_node_config.wait_timeout);
   get_parameter("update_frequency", client_node_config.update_frequency);
   get_parameter("publish_frequency", client_node_config.publish_frequency);
+  get_parameter("adaptive_publishing", client_node_config.adaptive_publishing);
+  get_parameter("max_publish_frequency", client_node_config.max_publish_frequency);
+  get_parameter("heartbeat_period", client_node_config.heartbeat_period);
+  get_parameter(
+    "publish_distance_threshold", client_node_config.publish_distance_threshold);
+  get_parameter("publish_yaw_threshold", client_node_config.publish_yaw_threshold);
   get_parameter("max_dist_to_first_waypoint", client_node_config.max_dist_to_first_waypoint);
+  get_parameter("compact_path_progress", client_node_config.compact_path_progress);
+  get_parameter(
+    "path_simplification_tolerance", client_node_config.path_simplification_tolerance);
+  get_parameter(
+    "path_simplification_yaw_tolerance",
+    client_node_config.path_simplification_yaw_tolerance);
+  get_parameter(
+    "path_packing_threshold", client_node_config.path_packing_threshold);
+  get_parameter("diagnostics_topic", client_node_config.diagnostics_topic);
+  get_parameter("diagnostics_period", client_node_config.diagnostics_period);
   print_config();
 
   ClientConfig client_config = client_node_config.get_client_config();
@@ -107,6 +185,27 @@ ClientNode::ClientNode(const rclcpp::NodeOptions & options)
     get_logger(), "connected with move base action server: %s",
     client_node_config.move_base_server_name.c_str());
 
+  /// Setting up the navigation2 action client for whole paths, if required
+  rclcpp_action::Client<NavigateThroughPoses>::SharedPtr through_poses_client =
+    nullptr;
+  if (client_node_config.use_navigate_through_poses) {
+    through_poses_client = rclcpp_action::create_client<NavigateThroughPoses>(
+      this, client_node_config.navigate_through_poses_server_name);
+    RCLCPP_INFO(
+      get_logger(), "waiting for connection with navigate through poses server: %s",
+      client_node_config.navigate_through_poses_server_name.c_str());
+    while (!through_poses_client->wait_for_action_server(
+        std::chrono::duration<double>(client_node_config.wait_timeout)))
+    {
+      RCLCPP_ERROR(
+        get_logger(), "timed out waiting for navigate through poses server: %s",
+        client_node_config.navigate_through_poses_server_name.c_str());
+      if (!rclcpp::ok()) {
+        throw std::runtime_error("exited rclcpp while constructing client_node");
+      }
+    }
+  }
+
   /// Setting up the docking server client, if required, wait for server
   rclcpp::Client<std_srvs::srv::Trigger>::SharedPtr docking_trigger_client = nullptr;
   if (client_node_config.docking_trigger_server_name != "") {
@@ -133,12 +232,16 @@ ClientNode::ClientNode(const rclcpp::NodeOptions & options)
     get_node_base_interface(), get_node_timers_interface());
   tf2_buffer->setCreateTimerInterface(timer_interface);
   tf2_buffer->setUsingDedicatedThread(true);
-  tf2_listener = std::make_shared<tf2_ros::TransformListener>(*tf2_buffer);
+  // The listener subscribes through this node, instead of a node and thread
+  // of its own, so that transforms published within the same container use
+  // intra-process communication when it is enabled
+  tf2_listener = std::make_shared<tf2_ros::TransformListener>(*tf2_buffer, this, false);
 
   start(
     Fields{
         std::move(client),
         std::move(move_base_client),
+        std::move(through_poses_client),
         std::move(docking_trigger_client)
       });
 }
@@ -159,15 +262,57 @@ void ClientNode::start(Fields _fields)
   emergency = false;
   paused = false;
 
+  start_request_callbacks();
+
+  outgoing_robot_state.name = client_node_config.robot_name;
+  outgoing_robot_state.model = client_node_config.robot_model;
+  outgoing_robot_state.path.reserve(OutgoingPathCapacity);
+  last_published_robot_state.path.reserve(OutgoingPathCapacity);
+
   RCLCPP_INFO(get_logger(), "starting update timer.");
   std::chrono::duration<double> update_period =
     std::chrono::duration<double>(1.0 / client_node_config.update_frequency);
   update_timer = create_wall_timer(update_period, std::bind(&ClientNode::update_fn, this));
 
   RCLCPP_INFO(get_logger(), "starting publish timer.");
+  // With adaptive publishing the timer only checks for changes at the
+  // maximum rate, and most ticks publish nothing
+  const double publish_frequency = client_node_config.adaptive_publishing ?
+    client_node_config.max_publish_frequency : client_node_config.publish_frequency;
   std::chrono::duration<double> publish_period =
-    std::chrono::duration<double>(1.0 / client_node_config.publish_frequency);
+    std::chrono::duration<double>(1.0 / publish_frequency);
   publish_timer = create_wall_timer(publish_period, std::bind(&ClientNode::publish_fn, this));
+
+  if (client_node_config.diagnostics_period > 0.0) {
+    diagnostics_pub = create_publisher<diagnostic_msgs::msg::DiagnosticArray>(
+      client_node_config.diagnostics_topic, 10);
+
+    published_stats_time = std::chrono::steady_clock::now();
+    diagnostics_timer = create_wall_timer(
+      std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::duration<double>(client_node_config.diagnostics_period)),
+      std::bind(&ClientNode::publish_diagnostics, this));
+  }
+}
+
+void ClientNode::declare_and_get_qos_parameters(
+  const std::string & _prefix, TopicQoS & _qos)
+{
+  declare_parameter(_prefix + ".reliable", _qos.reliable);
+  declare_parameter(_prefix + ".history_depth", _qos.history_depth);
+  declare_parameter(_prefix + ".transient_local", _qos.transient_local);
+  declare_parameter(_prefix + ".deadline", _qos.deadline);
+  declare_parameter(_prefix + ".latency_budget", _qos.latency_budget);
+  declare_parameter(_prefix + ".liveliness_lease", _qos.liveliness_lease);
+  declare_parameter(_prefix + ".transport_priority", _qos.transport_priority);
+
+  get_parameter(_prefix + ".reliable", _qos.reliable);
+  get_parameter(_prefix + ".history_depth", _qos.history_depth);
+  get_parameter(_prefix + ".transient_local", _qos.transient_local);
+  get_parameter(_prefix + ".deadline", _qos.deadline);
+  get_parameter(_prefix + ".latency_budget", _qos.latency_budget);
+  get_parameter(_prefix + ".liveliness_lease", _qos.liveliness_lease);
+  get_parameter(_prefix + ".transport_priority", _qos.transport_priority);
 }
 
 void ClientNode::print_config()
@@ -178,29 +323,69 @@ void ClientNode::print_config()
 void ClientNode::battery_state_callback_fn(
   const sensor_msgs::msg::BatteryState::SharedPtr _msg)
 {
-  WriteLock battery_state_lock(battery_state_mutex);
-  current_battery_state = *_msg;
+  /// RMF expects battery to have a percentage in the range for 0-100.
+  /// sensor_msgs/BatteryInfo on the other hand returns a value in
+  /// the range of 0-1
+  const float battery_percent = 100 * _msg->percentage;
+  const bool charging =
+    _msg->power_supply_status == _msg->POWER_SUPPLY_STATUS_CHARGING;
+  update_observed_status(
+    [battery_percent, charging](ObservedStatus & _state)
+    {
+      _state.battery_percent = battery_percent;
+      _state.charging = charging;
+    });
 }
 
-bool ClientNode::get_robot_pose()
+bool ClientNode::update_robot_pose()
 {
-  geometry_msgs::msg::PoseStamped tmp_pose_stamped;
-  if (nav2_util::getCurrentPose(
-      tmp_pose_stamped, *tf2_buffer,
+  // Lookups of the latest transform never wait, a robot frame that is not
+  // available yet only skips this update
+  geometry_msgs::msg::TransformStamped transform;
+  try {
+    if (!tf2_buffer->canTransform(
+        client_node_config.map_frame,
+        client_node_config.robot_frame,
+        tf2::TimePointZero))
+    {
+      RCLCPP_WARN_THROTTLE(get_logger(), *get_clock(), 5000, "Unable to get robot pose.");
+      return false;
+    }
+    transform = tf2_buffer->lookupTransform(
       client_node_config.map_frame,
       client_node_config.robot_frame,
-      client_node_config.wait_timeout)) {
-    WriteLock robot_transform_lock(robot_pose_mutex);
-    previous_robot_pose = current_robot_pose;
-    current_robot_pose = tmp_pose_stamped;
-    return true;
-  } else {
-    RCLCPP_WARN(get_logger(), "Unable to get robot pose.");
+      tf2::TimePointZero);
+  } catch (const tf2::TransformException &) {
+    RCLCPP_WARN_THROTTLE(get_logger(), *get_clock(), 5000, "Unable to get robot pose.");
     return false;
   }
+
+  geometry_msgs::msg::PoseStamped pose;
+  pose.header = transform.header;
+  pose.pose.position.x = transform.transform.translation.x;
+  pose.pose.position.y = transform.transform.translation.y;
+  pose.pose.position.z = transform.transform.translation.z;
+  pose.pose.orientation = transform.transform.rotation;
+
+  // An unchanged pose means the robot did not move since the last update,
+  // as far as we can tell
+  const bool moving = !is_pose_close(pose, previous_robot_pose);
+  update_observed_status(
+    [&pose, moving](ObservedStatus & _state)
+    {
+      _state.sec = pose.header.stamp.sec;
+      _state.nanosec = pose.header.stamp.nanosec;
+      _state.x = pose.pose.position.x;
+      _state.y = pose.pose.position.y;
+      _state.yaw = get_yaw_from_pose(pose);
+      _state.moving = moving;
+    });
+  previous_robot_pose = std::move(pose);
+  return true;
 }
 
-messages::RobotMode ClientNode::get_robot_mode()
+messages::RobotMode ClientNode::get_robot_mode(
+  const ObservedStatus & _observed_status) const
 {
   /// Checks if robot has just received a request that causes an adapter error
   if (request_error) {
@@ -213,25 +398,13 @@ messages::RobotMode ClientNode::get_robot_mode()
   }
 
   /// Checks if robot is charging
-  {
-    ReadLock battery_state_lock(battery_state_mutex);
-
-    if (current_battery_state.power_supply_status ==
-      current_battery_state.POWER_SUPPLY_STATUS_CHARGING)
-    {
-      return messages::RobotMode{messages::RobotMode::MODE_CHARGING};
-    }
+  if (_observed_status.charging) {
+    return messages::RobotMode{messages::RobotMode::MODE_CHARGING};
   }
 
   /// Checks if robot is moving
-  {
-    ReadLock robot_transform_lock(robot_pose_mutex);
-
-    if (!is_pose_close(
-        current_robot_pose, previous_robot_pose))
-    {
-      return messages::RobotMode{messages::RobotMode::MODE_MOVING};
-    }
+  if (_observed_status.moving) {
+    return messages::RobotMode{messages::RobotMode::MODE_MOVING};
   }
 
   /// Otherwise, robot is neither charging nor moving,
@@ -247,60 +420,137 @@ messages::RobotMode ClientNode::get_robot_mode()
 
 void ClientNode::publish_robot_state()
 {
-  messages::RobotState new_robot_state;
-  new_robot_state.name = client_node_config.robot_name;
-  new_robot_state.model = client_node_config.robot_model;
-
+  // Consistent copies of the status and the task, without taking any of the
+  // writers' locks
+  const ObservedStatus status = observed_status.load();
+  const auto task = observed_task.load();
+
+  // Assigning into the same state every time reuses its string and path
+  // capacity, so once warmed up publishing does not allocate
+  messages::RobotState & new_robot_state = outgoing_robot_state;
+  new_robot_state.task_id = task->task_id;
+  new_robot_state.mode = get_robot_mode(status);
+  new_robot_state.battery_percent = status.battery_percent;
+
+  new_robot_state.location.sec = status.sec;
+  new_robot_state.location.nanosec = status.nanosec;
+  new_robot_state.location.x = status.x;
+  new_robot_state.location.y = status.y;
+  new_robot_state.location.yaw = status.yaw;
+  new_robot_state.location.level_name = client_node_config.level_name;
+
+  new_robot_state.path = task->path;
+  new_robot_state.path_version = task->path_version;
+  new_robot_state.path_index = task->path_index;
+
+  if (client_node_config.adaptive_publishing &&
+    !should_publish_robot_state(new_robot_state))
   {
-    ReadLock task_id_lock(task_id_mutex);
-    new_robot_state.task_id = current_task_id;
+    return;
   }
 
-  new_robot_state.mode = get_robot_mode();
+  if (!fields.client->send_robot_state(new_robot_state)) {
+    RCLCPP_WARN(
+      get_logger(), "failed to send robot state: msg sec %u",
+      new_robot_state.location.sec);
+    return;
+  }
 
-  {
-    ReadLock battery_state_lock(battery_state_mutex);
-    /// RMF expects battery to have a percentage in the range for 0-100.
-    /// sensor_msgs/BatteryInfo on the other hand returns a value in
-    /// the range of 0-1
-    new_robot_state.battery_percent = 100 * current_battery_state.percentage;
+  if (client_node_config.adaptive_publishing) {
+    published_robot_state = true;
+    last_published_robot_state = new_robot_state;
+    last_published_time = std::chrono::steady_clock::now();
   }
+}
 
+bool ClientNode::should_publish_robot_state(
+  const messages::RobotState & _robot_state) const
+{
+  if (!published_robot_state) {
+    return true;
+  }
+
+  const messages::RobotState & last = last_published_robot_state;
+  if (_robot_state.mode.mode != last.mode.mode ||
+    _robot_state.task_id != last.task_id ||
+    _robot_state.path_version != last.path_version ||
+    _robot_state.path_index != last.path_index ||
+    _robot_state.path.size() != last.path.size())
   {
-    ReadLock robot_transform_lock(robot_pose_mutex);
-    new_robot_state.location.sec = current_robot_pose.header.stamp.sec;
-    new_robot_state.location.nanosec =
-      current_robot_pose.header.stamp.nanosec;
-    new_robot_state.location.x =
-      current_robot_pose.pose.position.x;
-    new_robot_state.location.y =
-      current_robot_pose.pose.position.y;
-    new_robot_state.location.yaw = get_yaw_from_pose(current_robot_pose);
-    new_robot_state.location.level_name = client_node_config.level_name;
-  }
-
-  new_robot_state.path.clear();
+    return true;
+  }
+
+  // Traffic negotiation needs up to date poses while moving
+  if (_robot_state.mode.mode == messages::RobotMode::MODE_MOVING) {
+    return true;
+  }
+
+  const double dx = _robot_state.location.x - last.location.x;
+  const double dy = _robot_state.location.y - last.location.y;
+  const double dyaw =
+    std::remainder(_robot_state.location.yaw - last.location.yaw, 2.0 * M_PI);
+  if (std::sqrt(dx * dx + dy * dy) > client_node_config.publish_distance_threshold ||
+    std::abs(dyaw) > client_node_config.publish_yaw_threshold)
   {
-    ReadLock goal_path_lock(goal_path_mutex);
-    for (size_t i = 0; i < goal_path.size(); ++i)
-    {
-      new_robot_state.path.push_back(
-          messages::Location{
-              (int32_t)goal_path[i].goal.pose.header.stamp.sec,
-              goal_path[i].goal.pose.header.stamp.nanosec,
-              (float)goal_path[i].goal.pose.pose.position.x,
-              (float)goal_path[i].goal.pose.pose.position.y,
-              (float)get_yaw_from_pose(goal_path[i].goal.pose),
-              goal_path[i].level_name
-          });
-    }
+    return true;
   }
 
-  if (!fields.client->send_robot_state(new_robot_state)) {
-    RCLCPP_WARN(
-      get_logger(), "failed to send robot state: msg sec %u",
-      new_robot_state.location.sec);
+  // Otherwise only a heartbeat, so the server knows the robot is still there
+  const std::chrono::duration<double> since_published =
+    std::chrono::steady_clock::now() - last_published_time;
+  return since_published.count() >= client_node_config.heartbeat_period;
+}
+
+void ClientNode::update_observed_status(
+  const std::function<void(ObservedStatus &)> & _update)
+{
+  std::lock_guard<std::mutex> lock(observed_status_mutex);
+  ObservedStatus status = observed_status.load();
+  _update(status);
+  observed_status.store(status);
+}
+
+void ClientNode::update_observed_path()
+{
+  const uint32_t path_version = current_path_version;
+  const uint32_t path_index =
+    static_cast<uint32_t>(current_path_length - goal_path.size());
+
+  // The server already holds the path it sent, it only needs to know how
+  // far along it the robot is
+  std::vector<messages::Location> path;
+  const bool compact =
+    client_node_config.compact_path_progress && current_path_version != 0;
+  for (size_t i = 0; !compact && i < goal_path.size(); ++i)
+  {
+    path.push_back(
+        messages::Location{
+            (int32_t)goal_path[i].goal.pose.header.stamp.sec,
+            goal_path[i].goal.pose.header.stamp.nanosec,
+            (float)goal_path[i].goal.pose.pose.position.x,
+            (float)goal_path[i].goal.pose.pose.position.y,
+            (float)get_yaw_from_pose(goal_path[i].goal.pose),
+            goal_path[i].level_name
+        });
   }
+
+  // Only the task id is carried over, the previous path is not copied just
+  // to be replaced
+  std::lock_guard<std::mutex> lock(observed_task_mutex);
+  auto task = std::make_shared<ObservedTask>();
+  task->task_id = observed_task.load()->task_id;
+  task->path = std::move(path);
+  task->path_version = path_version;
+  task->path_index = path_index;
+  observed_task.store(std::move(task));
+}
+
+void ClientNode::update_observed_task_id(const std::string & _task_id)
+{
+  std::lock_guard<std::mutex> lock(observed_task_mutex);
+  auto task = std::make_shared<ObservedTask>(*observed_task.load());
+  task->task_id = _task_id;
+  observed_task.store(std::move(task));
 }
 
 bool ClientNode::is_valid_request(
@@ -333,42 +583,52 @@ nav2_msgs::action::NavigateToPose::Goal ClientNode::location_to_nav_goal(
   return goal;
 }
 
-bool ClientNode::read_mode_request()
+bool ClientNode::handle_mode_request(
+    const messages::ModeRequest& _mode_request)
 {
-  messages::ModeRequest mode_request;
-  if (fields.client->read_mode_request(mode_request) && 
-      is_valid_request(
-          mode_request.fleet_name, mode_request.robot_name, 
-          mode_request.task_id))
+  if (is_valid_request(
+          _mode_request.fleet_name, _mode_request.robot_name, 
+          _mode_request.task_id))
   {
-    if (mode_request.mode.mode == messages::RobotMode::MODE_PAUSED)
+    FREE_FLEET_TRACEPOINT(client_request_accepted, tracing::RequestKind::Mode,
+        _mode_request.robot_name.c_str(), _mode_request.task_id.c_str());
+
+    if (_mode_request.mode.mode == messages::RobotMode::MODE_PAUSED)
     {
       RCLCPP_INFO(get_logger(), "received a PAUSE command.");
 
-      fields.move_base_client->async_cancel_all_goals();
-      WriteLock goal_path_lock(goal_path_mutex);
-      if (!goal_path.empty())
-        goal_path[0].sent = false;
-
+      // The robot is held and stopped right away, the goals are only put on
+      // hold once path handling in progress is done with them, and cancelled
+      // again in case one was sent in the meantime
       paused = true;
       emergency = false;
       request_error = false;
+      cancel_all_goals();
+
+      std::lock_guard<std::mutex> lock(request_mutex);
+      {
+        WriteLock goal_path_lock(goal_path_mutex);
+        discard_sent_goals();
+        for (Goal & goal : goal_path)
+          goal.sent = false;
+      }
+      cancel_all_goals();
     }
-    else if (mode_request.mode.mode == messages::RobotMode::MODE_MOVING)
+    else if (_mode_request.mode.mode == messages::RobotMode::MODE_MOVING)
     {
       RCLCPP_INFO(get_logger(), "received an explicit RESUME command.");
       paused = false;
       emergency = false;
       request_error = false;
     }
-    else if (mode_request.mode.mode == messages::RobotMode::MODE_EMERGENCY)
+    else if (_mode_request.mode.mode == messages::RobotMode::MODE_EMERGENCY)
     {
       RCLCPP_INFO(get_logger(), "received an EMERGENCY command.");
       paused = false;
       emergency = true;
       request_error = false;
     }
-    else if (mode_request.mode.mode == messages::RobotMode::MODE_DOCKING)
+    else if (_mode_request.mode.mode == messages::RobotMode::MODE_DOCKING)
     {
       RCLCPP_INFO(get_logger(), "received a DOCKING command.");
       if (fields.docking_trigger_client &&
@@ -394,41 +654,70 @@ bool ClientNode::read_mode_request()
     }
     else {
       RCLCPP_ERROR(get_logger(), "received an INVALID/UNSUPPORTED command: %d.",
-              mode_request.mode.mode);
+              _mode_request.mode.mode);
       request_error = true;
     }
 
-    WriteLock task_id_lock(task_id_mutex);
-    current_task_id = mode_request.task_id;
+    {
+      WriteLock task_id_lock(task_id_mutex);
+      current_task_id = _mode_request.task_id;
+    }
+    update_observed_task_id(_mode_request.task_id);
 
     return true;
   }
   return false;
 }
 
-bool ClientNode::read_path_request()
+bool ClientNode::handle_path_request(
+    const messages::PathRequest& _path_request)
 {
-  messages::PathRequest path_request;
-  if (fields.client->read_path_request(path_request) &&
-      is_valid_request(
-          path_request.fleet_name, path_request.robot_name,
-          path_request.task_id))
+  if (_path_request.operation != messages::PathRequest::PATH_REPLACE)
+    return handle_path_update(_path_request);
+
+  if (is_valid_request(
+          _path_request.fleet_name, _path_request.robot_name,
+          _path_request.task_id))
   {
-    RCLCPP_INFO(get_logger(), "received a Path command of size %lu.", path_request.path.size());
+    FREE_FLEET_TRACEPOINT(client_request_accepted, tracing::RequestKind::Path,
+        _path_request.robot_name.c_str(), _path_request.task_id.c_str());
+
+    RCLCPP_INFO(get_logger(), "received a Path command of size %lu.", _path_request.path.size());
 
-    if (path_request.path.size() <= 0)
+    if (_path_request.path.size() <= 0)
       return false;
 
+    std::deque<Goal> goals;
+    for (size_t i = 0; i < _path_request.path.size(); ++i)
+    {
+      goals.push_back(
+          Goal {
+              _path_request.path[i].level_name,
+              location_to_nav_goal(_path_request.path[i]),
+              false,
+              0,
+              rclcpp::Time(
+                  _path_request.path[i].sec,
+                  _path_request.path[i].nanosec,
+                  RCL_ROS_TIME)}); // messages use RCL_ROS_TIME instead of default RCL_SYSTEM_TIME
+    }
+
+    // Queued paths start from wherever the task before them ends
+    if (!_path_request.after_task_id.empty()) {
+      return queue_task(
+        QueuedTask {
+          _path_request.after_task_id,
+          _path_request.task_id,
+          std::move(goals),
+          _path_request.version});
+    }
+
     // Sanity check: the first waypoint of the Path must be within N meters of
     // our current position. Otherwise, ignore the request.
     {
-      ReadLock robot_transform_lock(robot_pose_mutex);
-      const double dx =
-          path_request.path[0].x - 
-          current_robot_pose.pose.position.x;
-      const double dy =
-          path_request.path[0].y -
-          current_robot_pose.pose.position.y;
+      const ObservedStatus status = observed_status.load();
+      const double dx = _path_request.path[0].x - status.x;
+      const double dy = _path_request.path[0].y - status.y;
       const double dist_to_first_waypoint = sqrt(dx*dx + dy*dy);
 
       RCLCPP_INFO(get_logger(), "distance to first waypoint: %.2f\n", dist_to_first_waypoint);
@@ -441,9 +730,17 @@ bool ClientNode::read_path_request()
             client_node_config.max_dist_to_first_waypoint);
         
         fields.move_base_client->async_cancel_all_goals();
+        if (fields.through_poses_client) {
+          fields.through_poses_client->async_cancel_all_goals();
+        }
         {
           WriteLock goal_path_lock(goal_path_mutex);
+          discard_sent_goals();
           goal_path.clear();
+          queued_tasks.clear();
+          current_path_version = 0;
+          current_path_length = 0;
+          update_observed_path();
         }
 
         request_error = true;
@@ -454,28 +751,24 @@ bool ClientNode::read_path_request()
     }
 
     fields.move_base_client->async_cancel_all_goals();
+    if (fields.through_poses_client) {
+      fields.through_poses_client->async_cancel_all_goals();
+    }
     {
       WriteLock goal_path_lock(goal_path_mutex);
-      goal_path.clear();
-      for (size_t i = 0; i < path_request.path.size(); ++i)
-      {
-        goal_path.push_back(
-            Goal {
-                path_request.path[i].level_name,
-                location_to_nav_goal(path_request.path[i]),
-                false,
-                0,
-                rclcpp::Time(
-                    path_request.path[i].sec,
-                    path_request.path[i].nanosec,
-                    RCL_ROS_TIME)}); // messages use RCL_ROS_TIME instead of default RCL_SYSTEM_TIME
-      }
+      discard_sent_goals();
+      goal_path = std::move(goals);
+      queued_tasks.clear();
+      current_path_version = _path_request.version;
+      current_path_length = goal_path.size();
+      update_observed_path();
     }
     
     {
       WriteLock task_id_lock(task_id_mutex);
-      current_task_id = path_request.task_id;
+      current_task_id = _path_request.task_id;
     }
+    update_observed_task_id(_path_request.task_id);
 
     if (paused)
       paused = false;
@@ -486,38 +779,156 @@ bool ClientNode::read_path_request()
   return false;
 }
 
-bool ClientNode::read_destination_request()
+bool ClientNode::handle_path_update(
+    const messages::PathRequest& _path_update)
+{
+  // Updates usually carry on with the same task, duplicates are told apart
+  // by the path version they apply to instead of by their task id
+  if (client_node_config.robot_name != _path_update.robot_name ||
+      client_node_config.fleet_name != _path_update.fleet_name)
+    return false;
+
+  {
+    WriteLock goal_path_lock(goal_path_mutex);
+    if (current_path_version == 0 ||
+        _path_update.base_version != current_path_version)
+    {
+      RCLCPP_WARN(get_logger(), "received an update of path version %u while "
+          "following path version %u, ignoring it.",
+          _path_update.base_version, current_path_version);
+      return false;
+    }
+
+    const size_t passed = current_path_length - goal_path.size();
+    const size_t kept = _path_update.kept_waypoints(current_path_length);
+    RCLCPP_INFO(get_logger(), "received a Path update keeping %lu waypoints, "
+        "followed by %lu new ones.", kept, _path_update.path.size());
+
+    auto to_goal = [this](const messages::Location & _location)
+    {
+      return Goal {
+          _location.level_name,
+          location_to_nav_goal(_location),
+          false,
+          0,
+          rclcpp::Time(_location.sec, _location.nanosec, RCL_ROS_TIME)};
+    };
+
+    if (kept > passed)
+    {
+      // Only the waypoints after the current goal change. Goals that were
+      // sent one at a time carry on, a path that was sent as a whole gets
+      // sent again, the new path takes over from the one being followed
+      // without stopping the robot.
+      const bool sent_as_path = goal_path.size() > 1 && goal_path[1].sent;
+      goal_path.resize(kept - passed);
+      for (const messages::Location & location : _path_update.path)
+        goal_path.push_back(to_goal(location));
+
+      if (sent_as_path)
+      {
+        if (goal_path.size() == 1)
+          fields.through_poses_client->async_cancel_all_goals();
+        discard_sent_goals();
+        for (Goal & goal : goal_path)
+          goal.sent = false;
+      }
+    }
+    else
+    {
+      // The current goal changes as well, just like for a whole new path
+      fields.move_base_client->async_cancel_all_goals();
+      if (fields.through_poses_client) {
+        fields.through_poses_client->async_cancel_all_goals();
+      }
+      discard_sent_goals();
+      goal_path.clear();
+      for (const messages::Location & location : _path_update.path)
+        goal_path.push_back(to_goal(location));
+    }
+
+    current_path_version = _path_update.version;
+    current_path_length = kept + _path_update.path.size();
+    update_observed_path();
+
+    // A path cut down to nothing ends the task, the task queued behind it
+    // takes over
+    if (goal_path.empty() && start_queued_task()) {
+      return true;
+    }
+  }
+
+  FREE_FLEET_TRACEPOINT(client_request_accepted, tracing::RequestKind::Path,
+      _path_update.robot_name.c_str(), _path_update.task_id.c_str());
+
+  {
+    WriteLock task_id_lock(task_id_mutex);
+    current_task_id = _path_update.task_id;
+  }
+  update_observed_task_id(_path_update.task_id);
+
+  if (paused)
+    paused = false;
+
+  request_error = false;
+  return true;
+}
+
+bool ClientNode::handle_destination_request(
+    const messages::DestinationRequest& _destination_request)
 {
-  messages::DestinationRequest destination_request;
-  if (fields.client->read_destination_request(destination_request) &&
-      is_valid_request(
-          destination_request.fleet_name, destination_request.robot_name,
-          destination_request.task_id))
+  if (is_valid_request(
+          _destination_request.fleet_name, _destination_request.robot_name,
+          _destination_request.task_id))
   {
+    FREE_FLEET_TRACEPOINT(
+        client_request_accepted, tracing::RequestKind::Destination,
+        _destination_request.robot_name.c_str(),
+        _destination_request.task_id.c_str());
+
     RCLCPP_INFO(get_logger(), "received a Destination command, x: %.2f, y: %.2f, yaw: %.2f",
-        destination_request.destination.x, destination_request.destination.y,
-        destination_request.destination.yaw);
-    
+        _destination_request.destination.x, _destination_request.destination.y,
+        _destination_request.destination.yaw);
+
+    Goal goal {
+        _destination_request.destination.level_name,
+        location_to_nav_goal(_destination_request.destination),
+        false,
+        0,
+        rclcpp::Time(
+            _destination_request.destination.sec,
+            _destination_request.destination.nanosec,
+            RCL_ROS_TIME)}; // messages use RCL_ROS_TIME instead of default RCL_SYSTEM_TIME
+
+    if (!_destination_request.after_task_id.empty()) {
+      return queue_task(
+        QueuedTask {
+          _destination_request.after_task_id,
+          _destination_request.task_id,
+          std::deque<Goal>{std::move(goal)},
+          0});
+    }
+
     fields.move_base_client->async_cancel_all_goals();
+    if (fields.through_poses_client) {
+      fields.through_poses_client->async_cancel_all_goals();
+    }
     {
       WriteLock goal_path_lock(goal_path_mutex);
+      discard_sent_goals();
       goal_path.clear();
-      goal_path.push_back(
-          Goal {
-              destination_request.destination.level_name,
-              location_to_nav_goal(destination_request.destination),
-              false,
-              0,
-              rclcpp::Time(
-                  destination_request.destination.sec,
-                  destination_request.destination.nanosec,
-                  RCL_ROS_TIME)}); // messages use RCL_ROS_TIME instead of default RCL_SYSTEM_TIME
+      goal_path.push_back(std::move(goal));
+      queued_tasks.clear();
+      current_path_version = 0;
+      current_path_length = goal_path.size();
+      update_observed_path();
     }
 
     {
       WriteLock task_id_lock(task_id_mutex);
-      current_task_id = destination_request.task_id;
+      current_task_id = _destination_request.task_id;
     }
+    update_observed_task_id(_destination_request.task_id);
 
     if (paused)
       paused = false;
@@ -528,14 +939,99 @@ bool ClientNode::read_destination_request()
   return false;
 }
 
-void ClientNode::read_requests()
+bool ClientNode::queue_task(QueuedTask _task)
 {
-  if (read_mode_request() ||
-    read_path_request() ||
-    read_destination_request())
+  WriteLock goal_path_lock(goal_path_mutex);
+  std::string last_task_id;
   {
-    return;
+    ReadLock task_id_lock(task_id_mutex);
+    last_task_id = current_task_id;
+  }
+  for (const QueuedTask & queued_task : queued_tasks) {
+    // Requests are resent until the robot reports their task
+    if (queued_task.task_id == _task.task_id) {
+      return false;
+    }
+    last_task_id = queued_task.task_id;
   }
+
+  if (_task.after_task_id != last_task_id) {
+    RCLCPP_WARN(get_logger(), "received task %s queued after task %s, while "
+        "the last task of the robot is %s, ignoring it.",
+        _task.task_id.c_str(), _task.after_task_id.c_str(),
+        last_task_id.c_str());
+    return false;
+  }
+
+  RCLCPP_INFO(get_logger(), "queued task %s of %lu goals after task %s.",
+      _task.task_id.c_str(), _task.goals.size(), _task.after_task_id.c_str());
+  queued_tasks.push_back(std::move(_task));
+
+  // The task it follows may already be done
+  return goal_path.empty() && start_queued_task();
+}
+
+bool ClientNode::start_queued_task()
+{
+  if (queued_tasks.empty()) {
+    return false;
+  }
+
+  QueuedTask & task = queued_tasks.front();
+  RCLCPP_INFO(get_logger(), "task %s is done, moving on to queued task %s.",
+      task.after_task_id.c_str(), task.task_id.c_str());
+  goal_path = std::move(task.goals);
+  current_path_version = task.path_version;
+  current_path_length = goal_path.size();
+  update_observed_path();
+
+  {
+    WriteLock task_id_lock(task_id_mutex);
+    current_task_id = task.task_id;
+  }
+  update_observed_task_id(task.task_id);
+  queued_tasks.pop_front();
+  return true;
+}
+
+void ClientNode::cancel_all_goals()
+{
+  fields.move_base_client->async_cancel_all_goals();
+  if (fields.through_poses_client) {
+    fields.through_poses_client->async_cancel_all_goals();
+  }
+}
+
+void ClientNode::start_request_callbacks()
+{
+  // Requests are handled on the DDS reader thread as soon as they arrive,
+  // instead of waiting for the next update
+  fields.client->on_mode_request(
+    [this](const messages::ModeRequest & _mode_request)
+    {
+      // Mode requests only take the request mutex once they have stopped
+      // the robot, so that they are never held up behind path handling
+      if (handle_mode_request(_mode_request)) {
+        std::lock_guard<std::mutex> lock(request_mutex);
+        handle_requests();
+      }
+    });
+  fields.client->on_path_request(
+    [this](const messages::PathRequest & _path_request)
+    {
+      std::lock_guard<std::mutex> lock(request_mutex);
+      if (handle_path_request(_path_request)) {
+        handle_requests();
+      }
+    });
+  fields.client->on_destination_request(
+    [this](const messages::DestinationRequest & _destination_request)
+    {
+      std::lock_guard<std::mutex> lock(request_mutex);
+      if (handle_destination_request(_destination_request)) {
+        handle_requests();
+      }
+    });
 }
 
 void ClientNode::handle_requests()
@@ -546,111 +1042,239 @@ void ClientNode::handle_requests()
 
   // ooooh we have goals
   ReadLock goal_path_lock(goal_path_mutex);
-  if (!goal_path.empty())
+  if (!goal_path.empty() && !goal_path.front().sent)
   {
-    auto send_goal_options = rclcpp_action::Client<NavigateToPose>::SendGoalOptions();
-    send_goal_options.goal_response_callback = [&](std::shared_future<GoalHandleNavigateToPose::SharedPtr> future) {
-      auto goal_handle = future.get();
-      if (!goal_handle) {
-        RCLCPP_ERROR(get_logger(), "Goal was rejected by server");
-      } else {
-        RCLCPP_INFO(get_logger(), "Goal accepted by server, waiting for result");
-      }
-    };
-    send_goal_options.feedback_callback = [&](GoalHandleNavigateToPose::SharedPtr, const std::shared_ptr<const NavigateToPose::Feedback> feedback) {
-      RCLCPP_INFO_THROTTLE(this->get_logger(), *get_clock(), 5000, "Distance remaining: %f", feedback->distance_remaining);
-    };
-    send_goal_options.result_callback = [&](const GoalHandleNavigateToPose::WrappedResult & result) {
-      WriteLock goal_path_lock(goal_path_mutex);
-      switch (result.code) {
-        case rclcpp_action::ResultCode::SUCCEEDED:
-          RCLCPP_INFO(get_logger(), "current goal state: SUCCEEEDED.");
-          // By some stroke of good fortune, we may have arrived at our goal
-          // earlier than we were scheduled to reach it. If that is the case,
-          // we need to wait here until it's time to proceed.
-          if (now() >= goal_path.front().goal_end_time)
-          {
-            if (!goal_path.empty()) // TODO: fix race condition instead
-              goal_path.pop_front();
-          }
-          else
-          { 
-            std::thread{
-              [&]() {
-                {
-                  ReadLock goal_path_lock(goal_path_mutex);
-                  while (now() < goal_path.front().goal_end_time) {
-                    rclcpp::Duration wait_time_remaining =
-                        goal_path.front().goal_end_time - now();
-                    RCLCPP_INFO(get_logger(), 
-                        "we reached our goal early! Waiting %.2f more seconds",
-                        wait_time_remaining.seconds());
-                    std::this_thread::sleep_for(
-                      std::chrono::nanoseconds(wait_time_remaining.nanoseconds()));
-                  }
-                }
-                WriteLock goal_path_lock(goal_path_mutex);
-                if (!goal_path.empty()) // TODO: fix race condition instead
-                  goal_path.pop_front();
-              }
-            }.detach();
-          }
-          return;
-        case rclcpp_action::ResultCode::ABORTED:
-          RCLCPP_ERROR(this->get_logger(), "Goal was aborted");
-          goal_path.front().aborted_count++;
-
-          // TODO: parameterize the maximum number of retries.
-          if (goal_path.front().aborted_count < 5)
-          {
-            RCLCPP_INFO(get_logger(), "robot's navigation stack has aborted the current goal %d "
-                "times, client will try again...",
-                goal_path.front().aborted_count);
-            goal_path.front().sent = false;
-            return;
-          }
-          else
-          {
-            RCLCPP_INFO(get_logger(), "robot's navigation stack has aborted the current goal %d "
-                "times, please check that there is nothing in the way of the "
-                "robot, client will abort the current path request, and await "
-                "further requests.",
-                goal_path.front().aborted_count);
-            goal_path.clear();
-            return;
-          }
-          return;
-        case rclcpp_action::ResultCode::CANCELED: // for example when paused.
-          RCLCPP_ERROR(this->get_logger(), "Goal was canceled");
-          // do not clear goal_path as we want to reuse it on resume
-          goal_path.front().sent = false;
-          return;
-        default:
-          RCLCPP_ERROR(this->get_logger(), "Unknown result code: %d", (int)result.code);
-          RCLCPP_INFO(get_logger(), "Client will abort the current path request, and await further "
-              "requests or manual intervention.");
-          goal_path.clear();
-          return;
-      }
-    };
-
     // Goals must have been updated since last handling, execute them now
-    if (!goal_path.front().sent)
+    if (fields.through_poses_client && goal_path.size() > 1)
+      send_remaining_path();
+    else
+      send_next_goal();
+#ifdef FREE_FLEET_TRACING
     {
-      RCLCPP_INFO(get_logger(), "sending next goal.");
-      fields.move_base_client->async_send_goal(goal_path.front().goal, send_goal_options);
-      goal_path.front().sent = true;
-      return;
+      ReadLock task_id_lock(task_id_mutex);
+      FREE_FLEET_TRACEPOINT(client_goal_sent,
+          current_path_version ?
+              tracing::RequestKind::Path :
+              tracing::RequestKind::Destination,
+          client_node_config.robot_name.c_str(), current_task_id.c_str());
     }
+#endif
+    return;
   }
   
   // otherwise, mode is correct, nothing in queue, nothing else to do then
 }
 
+void ClientNode::send_next_goal()
+{
+  const uint64_t generation = goal_generation;
+  auto send_goal_options = rclcpp_action::Client<NavigateToPose>::SendGoalOptions();
+  send_goal_options.goal_response_callback = [this](std::shared_future<GoalHandleNavigateToPose::SharedPtr> future) {
+    auto goal_handle = future.get();
+    if (!goal_handle) {
+      RCLCPP_ERROR(get_logger(), "Goal was rejected by server");
+    } else {
+      RCLCPP_INFO(get_logger(), "Goal accepted by server, waiting for result");
+    }
+  };
+  send_goal_options.feedback_callback = [this](GoalHandleNavigateToPose::SharedPtr, const std::shared_ptr<const NavigateToPose::Feedback> feedback) {
+    RCLCPP_INFO_THROTTLE(this->get_logger(), *get_clock(), 5000, "Distance remaining: %f", feedback->distance_remaining);
+  };
+  send_goal_options.result_callback = [this, generation](const GoalHandleNavigateToPose::WrappedResult & result) {
+    // The next goal goes out as soon as this one is done, instead of on the
+    // next update
+    std::lock_guard<std::mutex> lock(request_mutex);
+    if (handle_goal_result(result.code, false, generation)) {
+      handle_requests();
+    }
+  };
+
+  RCLCPP_INFO(get_logger(), "sending next goal.");
+  fields.move_base_client->async_send_goal(goal_path.front().goal, send_goal_options);
+  goal_path.front().sent = true;
+}
+
+void ClientNode::send_remaining_path()
+{
+  const uint64_t generation = goal_generation;
+  NavigateThroughPoses::Goal through_poses_goal;
+  through_poses_goal.poses.reserve(goal_path.size());
+  for (Goal & goal : goal_path)
+  {
+    through_poses_goal.poses.push_back(goal.goal.pose);
+    goal.sent = true;
+  }
+
+  auto send_goal_options =
+    rclcpp_action::Client<NavigateThroughPoses>::SendGoalOptions();
+  send_goal_options.goal_response_callback = [this](std::shared_future<GoalHandleNavigateThroughPoses::SharedPtr> future) {
+    auto goal_handle = future.get();
+    if (!goal_handle) {
+      RCLCPP_ERROR(get_logger(), "Path was rejected by server");
+    } else {
+      RCLCPP_INFO(get_logger(), "Path accepted by server, waiting for result");
+    }
+  };
+  send_goal_options.feedback_callback = [this, generation](GoalHandleNavigateThroughPoses::SharedPtr, const std::shared_ptr<const NavigateThroughPoses::Feedback> feedback) {
+    RCLCPP_INFO_THROTTLE(
+      this->get_logger(), *get_clock(), 5000, "Distance remaining: %f, poses remaining: %d",
+      feedback->distance_remaining, feedback->number_of_poses_remaining);
+
+    // Waypoints that were passed through get dropped right away so the
+    // reported path stays current, the last one waits for the result
+    WriteLock goal_path_lock(goal_path_mutex);
+    if (generation != goal_generation) {
+      return;
+    }
+    const size_t poses_remaining =
+      static_cast<size_t>(std::max<int>(1, feedback->number_of_poses_remaining));
+    if (goal_path.size() > poses_remaining) {
+      while (goal_path.size() > poses_remaining)
+        goal_path.pop_front();
+      update_observed_path();
+    }
+  };
+  send_goal_options.result_callback = [this, generation](const GoalHandleNavigateThroughPoses::WrappedResult & result) {
+    std::lock_guard<std::mutex> lock(request_mutex);
+    if (handle_goal_result(result.code, true, generation)) {
+      handle_requests();
+    }
+  };
+
+  RCLCPP_INFO(get_logger(), "sending remaining path of %lu goals.", goal_path.size());
+  fields.through_poses_client->async_send_goal(through_poses_goal, send_goal_options);
+}
+
+bool ClientNode::handle_goal_result(
+  rclcpp_action::ResultCode _code, bool _whole_path, uint64_t _generation)
+{
+  WriteLock goal_path_lock(goal_path_mutex);
+
+  // The goals were replaced or paused since this goal was sent
+  if (_generation != goal_generation || goal_path.empty()) {
+    return false;
+  }
+
+  switch (_code) {
+    case rclcpp_action::ResultCode::SUCCEEDED:
+      RCLCPP_INFO(get_logger(), "current goal state: SUCCEEEDED.");
+      // Every waypoint before the last one has been passed through
+      if (_whole_path) {
+        while (goal_path.size() > 1)
+          goal_path.pop_front();
+      }
+      // By some stroke of good fortune, we may have arrived at our goal
+      // earlier than we were scheduled to reach it. If that is the case,
+      // we need to wait here until it's time to proceed, without holding
+      // on to the goals in the meantime.
+      if (now() >= goal_path.front().goal_end_time) {
+        goal_path.pop_front();
+        update_observed_path();
+        if (goal_path.empty()) {
+          start_queued_task();
+        }
+        return true;
+      }
+      update_observed_path();
+      schedule_early_arrival(goal_path.front().goal_end_time - now());
+      return false;
+    case rclcpp_action::ResultCode::ABORTED:
+      RCLCPP_ERROR(this->get_logger(), "Goal was aborted");
+      goal_path.front().aborted_count++;
+
+      // TODO: parameterize the maximum number of retries.
+      if (goal_path.front().aborted_count < 5)
+      {
+        RCLCPP_INFO(get_logger(), "robot's navigation stack has aborted the current goal %d "
+            "times, client will try again...",
+            goal_path.front().aborted_count);
+        for (Goal & goal : goal_path)
+          goal.sent = false;
+        return false;
+      }
+      else
+      {
+        RCLCPP_INFO(get_logger(), "robot's navigation stack has aborted the current goal %d "
+            "times, please check that there is nothing in the way of the "
+            "robot, client will abort the current path request, and await "
+            "further requests.",
+            goal_path.front().aborted_count);
+        goal_path.clear();
+        queued_tasks.clear();
+        update_observed_path();
+        return false;
+      }
+    case rclcpp_action::ResultCode::CANCELED: // for example when paused.
+      RCLCPP_ERROR(this->get_logger(), "Goal was canceled");
+      // do not clear goal_path as we want to reuse it on resume
+      for (Goal & goal : goal_path)
+        goal.sent = false;
+      return false;
+    default:
+      RCLCPP_ERROR(this->get_logger(), "Unknown result code: %d", (int)_code);
+      RCLCPP_INFO(get_logger(), "Client will abort the current path request, and await further "
+          "requests or manual intervention.");
+      goal_path.clear();
+      queued_tasks.clear();
+      update_observed_path();
+      return false;
+  }
+}
+
+void ClientNode::schedule_early_arrival(const rclcpp::Duration & _wait_time)
+{
+  RCLCPP_INFO(
+    get_logger(), "we reached our goal early! Waiting %.2f more seconds",
+    _wait_time.seconds());
+
+  // The timer only fires once, requests that replace the goals in the
+  // meantime cancel it, and a newer generation means it fired too late
+  const uint64_t generation = ++early_arrival_generation;
+  early_arrival_timer = create_wall_timer(
+    std::chrono::nanoseconds(_wait_time.nanoseconds()),
+    [this, generation]()
+    {
+      std::lock_guard<std::mutex> lock(request_mutex);
+      {
+        WriteLock goal_path_lock(goal_path_mutex);
+        if (generation != early_arrival_generation || !early_arrival_timer) {
+          return;
+        }
+        early_arrival_timer->cancel();
+        early_arrival_timer.reset();
+        if (!goal_path.empty()) {
+          goal_path.pop_front();
+          update_observed_path();
+          if (goal_path.empty()) {
+            start_queued_task();
+          }
+        }
+      }
+      handle_requests();
+    });
+}
+
+void ClientNode::discard_sent_goals()
+{
+  cancel_early_arrival();
+  ++goal_generation;
+}
+
+void ClientNode::cancel_early_arrival()
+{
+  ++early_arrival_generation;
+  if (early_arrival_timer) {
+    early_arrival_timer->cancel();
+    early_arrival_timer.reset();
+  }
+}
+
 void ClientNode::update_fn()
 {
-  get_robot_pose();
-  read_requests();
+  update_robot_pose();
+
+  // Goals still need to be followed up on, once the previous goal is done
+  std::lock_guard<std::mutex> lock(request_mutex);
   handle_requests();
 }
 
@@ -659,5 +1283,26 @@ void ClientNode::publish_fn()
   publish_robot_state();
 }
 
+void ClientNode::publish_diagnostics()
+{
+  const auto now = std::chrono::steady_clock::now();
+  Stats stats = fields.client->get_stats();
+
+  diagnostic_msgs::msg::DiagnosticArray diagnostics;
+  diagnostics.header.stamp = get_clock()->now();
+  to_diagnostic_statuses(
+    stats, published_stats,
+    std::chrono::duration<double>(now - published_stats_time).count(),
+    get_name(), client_node_config.robot_name, diagnostics.status);
+  diagnostics_pub->publish(diagnostics);
+
+  published_stats = std::move(stats);
+  published_stats_time = now;
+}
+
 } // namespace ros2
 } // namespace free_fleet
+
+#include <rclcpp_components/register_node_macro.hpp>
+
+RCLCPP_COMPONENTS_REGISTER_NODE(free_fleet::ros2::ClientNode)
@@ -16,6 +16,7 @@
  */
 
 #include <cstdio>
+#include <algorithm>
 
 #include "free_fleet/ros2/client_node_config.hpp"
 
@@ -34,34 +35,101 @@ void ClientNodeConfig::print_config() const
   printf("  wait timeout: %.1f\n", wait_timeout);
   printf("  update request frequency: %.1f\n", update_frequency);
   printf("  publish state frequency: %.1f\n", publish_frequency);
+  printf("  adaptive publishing: %s\n",
+    adaptive_publishing ? "enabled" : "disabled");
+  printf("    maximum publish frequency: %.1f\n", max_publish_frequency);
+  printf("    heartbeat period: %.1f\n", heartbeat_period);
+  printf("    distance threshold: %.2f\n", publish_distance_threshold);
+  printf("    yaw threshold: %.2f\n", publish_yaw_threshold);
   printf("  maximum distance to first waypoint: %.1f\n", 
       max_dist_to_first_waypoint);
+  printf("  compact path progress: %s\n",
+    compact_path_progress ? "enabled" : "disabled");
+  printf(
+    "  path simplification tolerance: %.3f m, %.3f rad\n",
+    path_simplification_tolerance, path_simplification_yaw_tolerance);
+  printf("  path packing threshold: %d\n", path_packing_threshold);
+  printf("  diagnostics period (seconds): %.1f\n", diagnostics_period);
   printf("  TOPICS\n");
   printf("    battery state: %s\n", battery_state_topic.c_str());
+  printf("    diagnostics: %s\n", diagnostics_topic.c_str());
   printf("    move base server: %s\n", move_base_server_name.c_str());
   printf("    docking trigger server: %s\n", docking_trigger_server_name.c_str());
+  printf("    navigate through poses server: %s (%s)\n",
+    navigate_through_poses_server_name.c_str(),
+    use_navigate_through_poses ? "enabled" : "disabled");
   printf("  ROBOT FRAMES\n");
   printf("    map frame: %s\n", map_frame.c_str());
   printf("    robot frame: %s\n", robot_frame.c_str());
   printf("CLIENT-SERVER DDS CONFIGURATION\n");
   printf("  dds domain: %d\n", dds_domain);
+  printf(
+    "  dds partition: %s\n",
+    dds_partition.empty() ? "default" : dds_partition.c_str());
+  printf("  per-robot request partitions: %s\n",
+    dds_request_partitions ? "enabled" : "disabled");
+  printf(
+    "  shared memory: %s\n",
+    dds_shared_memory ? "enabled" : "disabled");
+  printf(
+    "  discovery: mode %s, %zu peers, interface %s, spdp interval %.3fs\n",
+    dds_discovery_mode.c_str(), dds_discovery_peers.size(),
+    dds_network_interface.empty() ? "auto" : dds_network_interface.c_str(),
+    dds_spdp_interval);
+  printf(
+    "  robot registration: %s\n",
+    robot_registration ? "enabled" : "disabled");
+  printf("  time sync: %s\n", time_sync ? "enabled" : "disabled");
+  printf("  request acks: %s\n", request_acks ? "enabled" : "disabled");
+  printf(
+    "  split robot state: %s\n",
+    split_robot_state ? "enabled" : "disabled");
   printf("  TOPICS\n");
   printf("    robot state: %s\n", dds_state_topic.c_str());
   printf("    mode request: %s\n", dds_mode_request_topic.c_str());
   printf("    path request: %s\n", dds_path_request_topic.c_str());
   printf("    destination request: %s\n", 
       dds_destination_request_topic.c_str());
+  printf("  QOS\n");
+  printf("    robot state: %s\n", dds_state_qos.to_string().c_str());
+  printf("    mode request: %s\n", dds_mode_request_qos.to_string().c_str());
+  printf("    path request: %s\n", dds_path_request_qos.to_string().c_str());
+  printf("    destination request: %s\n",
+    dds_destination_request_qos.to_string().c_str());
   fflush(stdout);
 }
   
 ClientConfig ClientNodeConfig::get_client_config() const
 {
   ClientConfig client_config;
+  client_config.fleet_name = fleet_name;
+  client_config.robot_name = robot_name;
   client_config.dds_domain = dds_domain;
   client_config.dds_state_topic = dds_state_topic;
   client_config.dds_mode_request_topic = dds_mode_request_topic;
   client_config.dds_path_request_topic = dds_path_request_topic;
   client_config.dds_destination_request_topic = dds_destination_request_topic;
+  client_config.dds_request_partitions = dds_request_partitions;
+  client_config.dds_partition = dds_partition;
+  client_config.dds_shared_memory = dds_shared_memory;
+  DiscoveryConfig::parse_mode(
+    dds_discovery_mode, client_config.dds_discovery.mode);
+  client_config.dds_discovery.peers = dds_discovery_peers;
+  client_config.dds_discovery.network_interface = dds_network_interface;
+  client_config.dds_discovery.spdp_interval = dds_spdp_interval;
+  client_config.robot_registration = robot_registration;
+  client_config.time_sync = time_sync;
+  client_config.request_acks = request_acks;
+  client_config.split_robot_state = split_robot_state;
+  client_config.dds_state_qos = dds_state_qos;
+  client_config.dds_mode_request_qos = dds_mode_request_qos;
+  client_config.dds_path_request_qos = dds_path_request_qos;
+  client_config.dds_destination_request_qos = dds_destination_request_qos;
+  client_config.path_simplification_tolerance = path_simplification_tolerance;
+  client_config.path_simplification_yaw_tolerance =
+    path_simplification_yaw_tolerance;
+  client_config.path_packing_threshold =
+    static_cast<size_t>(std::max(path_packing_threshold, 0));
   return client_config;
 }
 
@@ -16,6 +16,7 @@
  */
 
 #include <cmath>
+#include <cstdio>
 #include <tf2/impl/utils.h>
 
 #include "free_fleet/ros2/utilities.hpp"
@@ -23,6 +24,7 @@
 #include <tf2/LinearMath/Matrix3x3.h>
 #include <tf2_geometry_msgs/tf2_geometry_msgs.h>
 #include <geometry_msgs/msg/quaternion.hpp>
+#include <diagnostic_msgs/msg/key_value.hpp>
 
 namespace free_fleet
 {
@@ -71,5 +73,122 @@ bool is_pose_close(
   return true;
 }
 
+namespace {
+
+diagnostic_msgs::msg::KeyValue key_value(
+    const std::string& _key, const std::string& _value)
+{
+  diagnostic_msgs::msg::KeyValue entry;
+  entry.key = _key;
+  entry.value = _value;
+  return entry;
+}
+
+diagnostic_msgs::msg::KeyValue key_value(
+    const std::string& _key, uint64_t _value)
+{
+  return key_value(_key, std::to_string(_value));
+}
+
+diagnostic_msgs::msg::KeyValue key_value(
+    const std::string& _key, double _value)
+{
+  char buffer[32];
+  snprintf(buffer, sizeof(buffer), "%.1f", _value);
+  return key_value(_key, std::string(buffer));
+}
+
+double rate(uint64_t _current, uint64_t _previous, double _elapsed_seconds)
+{
+  if (_elapsed_seconds <= 0.0 || _current < _previous)
+    return 0.0;
+  return (_current - _previous) / _elapsed_seconds;
+}
+
+diagnostic_msgs::msg::DiagnosticStatus to_diagnostic_status(
+    const LatencyHistogram& _histogram,
+    const std::string& _name,
+    const std::string& _hardware_id)
+{
+  diagnostic_msgs::msg::DiagnosticStatus status;
+  status.level = diagnostic_msgs::msg::DiagnosticStatus::OK;
+  status.name = _name;
+  status.hardware_id = _hardware_id;
+  status.message = "ok";
+  status.values.push_back(key_value("count", _histogram.count));
+  status.values.push_back(key_value("mean (us)", _histogram.mean() / 1e3));
+  status.values.push_back(
+      key_value("p50 (us)", _histogram.percentile(50.0) / 1e3));
+  status.values.push_back(
+      key_value("p90 (us)", _histogram.percentile(90.0) / 1e3));
+  status.values.push_back(
+      key_value("p99 (us)", _histogram.percentile(99.0) / 1e3));
+  status.values.push_back(key_value("max (us)", _histogram.max / 1e3));
+  return status;
+}
+
+} // namespace anonymous
+
+void to_diagnostic_statuses(
+    const Stats& _stats,
+    const Stats& _previous_stats,
+    double _elapsed_seconds,
+    const std::string& _name,
+    const std::string& _hardware_id,
+    std::vector<diagnostic_msgs::msg::DiagnosticStatus>& _statuses)
+{
+  // Topics are always listed in the same order, previous stats without them
+  // are the stats from before anything was counted
+  const TopicStats empty_topic;
+  for (size_t i = 0; i < _stats.topics.size(); ++i)
+  {
+    const TopicStats& topic = _stats.topics[i];
+    const TopicStats& previous =
+        i < _previous_stats.topics.size() ?
+            _previous_stats.topics[i] : empty_topic;
+
+    diagnostic_msgs::msg::DiagnosticStatus status;
+    status.name = _name + ": " + topic.topic;
+    status.hardware_id = _hardware_id;
+    status.level = diagnostic_msgs::msg::DiagnosticStatus::OK;
+    status.message = "ok";
+    if (topic.write_failures > previous.write_failures)
+    {
+      status.level = diagnostic_msgs::msg::DiagnosticStatus::WARN;
+      status.message = "writes failed";
+    }
+    else if (topic.samples_lost > previous.samples_lost ||
+        topic.samples_rejected > previous.samples_rejected)
+    {
+      status.level = diagnostic_msgs::msg::DiagnosticStatus::WARN;
+      status.message = "samples lost";
+    }
+
+    status.values.push_back(key_value("messages sent", topic.messages_sent));
+    status.values.push_back(
+        key_value("messages received", topic.messages_received));
+    status.values.push_back(key_value(
+        "messages sent per second",
+        rate(topic.messages_sent, previous.messages_sent, _elapsed_seconds)));
+    status.values.push_back(key_value(
+        "messages received per second",
+        rate(
+            topic.messages_received, previous.messages_received,
+            _elapsed_seconds)));
+    status.values.push_back(key_value("bytes sent", topic.bytes_sent));
+    status.values.push_back(key_value("bytes received", topic.bytes_received));
+    status.values.push_back(key_value("write failures", topic.write_failures));
+    status.values.push_back(key_value("samples lost", topic.samples_lost));
+    status.values.push_back(
+        key_value("samples rejected", topic.samples_rejected));
+    _statuses.push_back(std::move(status));
+  }
+
+  _statuses.push_back(to_diagnostic_status(
+      _stats.conversion_time, _name + ": conversion time", _hardware_id));
+  _statuses.push_back(to_diagnostic_status(
+      _stats.receipt_age, _name + ": receipt age", _hardware_id));
+}
+
 } // namespace ros2
 } // namespace free_fleet
\ No newline at end of file
@@ -16,10 +16,16 @@
  */
 
 #include <chrono>
+#include <future>
+#include <utility>
+#include <limits>
+#include <stdexcept>
+#include <algorithm>
 
-#include <Eigen/Geometry>
+#include <rclcpp_components/register_node_macro.hpp>
 
 #include <free_fleet/Server.hpp>
+#include <free_fleet/Tracing.hpp>
 #include <free_fleet/ServerConfig.hpp>
 
 #include <free_fleet/messages/ModeRequest.hpp>
@@ -34,55 +40,99 @@ namespace free_fleet
 namespace ros2
 {
 
+namespace {
+
+/// Components serve a single fleet, named after the executable's default
+/// fleet until the fleet_name parameter says otherwise
+ServerNodeConfig component_config()
+{
+  ServerNodeConfig config = ServerNodeConfig::make();
+  config.fleet_name = "free_fleet_server_ros2";
+  return config;
+}
+
+/// Rough size of a robot state once serialized, from its fixed size fields,
+/// its strings and its path, used to bound the size of fleet states
+std::size_t serialized_size(const rmf_fleet_msgs::msg::RobotState& _state)
+{
+  const std::size_t location_size = 40;
+  std::size_t size = 80 + _state.name.size() + _state.model.size() +
+      _state.task_id.size() + _state.location.level_name.size();
+  for (const auto& location : _state.path)
+    size += location_size + location.level_name.size();
+  return size;
+}
+
+} // namespace anonymous
+
 ServerNode::SharedPtr ServerNode::make(
     const ServerNodeConfig& _config, const rclcpp::NodeOptions& _node_options)
 {
   // Starting the free fleet server node
   SharedPtr server_node(new ServerNode(_config, _node_options));
 
-  auto start_time = std::chrono::steady_clock::now();
-  auto end_time = std::chrono::steady_clock::now();
-  while (
-      std::chrono::duration_cast<std::chrono::seconds>(end_time - start_time)
-          .count() < 10)
+  // Parameters passed in at launch are already declared from the overrides
+  // once the node is constructed, only wait if they have not been provided
+  server_node->setup_config();
+  if (!server_node->is_ready())
   {
-    rclcpp::spin_some(server_node);
-
-    server_node->setup_config();
-    if (server_node->is_ready())
-      break;
     RCLCPP_INFO(
         server_node->get_logger(), "waiting for configuration parameters.");
-
-    end_time = std::chrono::steady_clock::now();
-    std::this_thread::sleep_for(std::chrono::milliseconds(1000));
+    if (!server_node->wait_for_parameters(std::chrono::seconds(10)))
+    {
+      RCLCPP_ERROR(
+          server_node->get_logger(), "unable to initialize parameters.");
+      return nullptr;
+    }
   }
-
-  if (!server_node->is_ready())
-  {
-    RCLCPP_ERROR(
-        server_node->get_logger(), "unable to initialize parameters.");
+  if (!server_node->initialize())
     return nullptr;
-  }
-  server_node->print_config();
+  return server_node;
+}
 
-  // Starting the free fleet server
-  ServerConfig server_config =
-      server_node->server_node_config.get_server_config();
-  Server::SharedPtr server = Server::make(server_config);
+ServerNode::ServerNode(const rclcpp::NodeOptions& _node_options) :
+  ServerNode(
+      component_config(),
+      rclcpp::NodeOptions(_node_options)
+          .allow_undeclared_parameters(true)
+          .automatically_declare_parameters_from_overrides(true)
+          .use_intra_process_comms(true))
+{
+  // The container spins the node only once it is constructed, so the
+  // parameters have to be provided when the component is loaded
+  setup_config();
+  if (!is_ready())
+    throw std::runtime_error("fleet_name parameter is not set");
+  if (!initialize())
+    throw std::runtime_error("unable to start the free fleet server");
+}
+
+ServerNode::~ServerNode()
+{}
+
+bool ServerNode::initialize()
+{
+  print_config();
+
+  // Starting the free fleet server, the DDS participant gets brought up
+  // while the ROS interfaces are being created
+  ServerConfig server_config = server_node_config.get_server_config();
+  std::future<Server::SharedPtr> server_future = std::async(
+      std::launch::async,
+      [server_config]() { return Server::make(server_config); });
+
+  create_ros_interfaces();
+
+  Server::SharedPtr server = server_future.get();
   if (!server)
-    return nullptr;
+    return false;
 
-  server_node->start(Fields{
+  start(Fields{
     std::move(server)
   });
-
-  return server_node;
+  return true;
 }
 
-ServerNode::~ServerNode()
-{}
-
 ServerNode::ServerNode(
     const ServerNodeConfig& _config,
     const rclcpp::NodeOptions& _node_options) :
@@ -114,10 +164,89 @@ void ServerNode::setup_config()
   get_parameter(
       "dds_destination_request_topic",
       server_node_config.dds_destination_request_topic);
+  get_parameter("dds_fleet_state_topic",
+      server_node_config.dds_fleet_state_topic);
+  get_parameter(
+      "dds_fleet_state_period", server_node_config.dds_fleet_state_period);
+  get_parameter(
+      "dds_request_partitions", server_node_config.dds_request_partitions);
+  get_parameter("dds_partition", server_node_config.dds_partition);
+  get_parameter("dds_shard_domains", server_node_config.dds_shard_domains);
+  get_parameter(
+      "dds_shard_partitions", server_node_config.dds_shard_partitions);
+  get_parameter(
+      "incremental_path_requests",
+      server_node_config.incremental_path_requests);
+  get_parameter(
+      "path_packing_threshold", server_node_config.path_packing_threshold);
+  get_parameter(
+      "split_robot_states", server_node_config.split_robot_states);
+  get_parameter(
+      "dds_time_sync_period", server_node_config.dds_time_sync_period);
+  get_parameter(
+      "dds_request_retry_timeout",
+      server_node_config.dds_request_retry_timeout);
+  get_parameter(
+      "dds_request_retry_max_timeout",
+      server_node_config.dds_request_retry_max_timeout);
+  get_parameter(
+      "dds_request_max_retries", server_node_config.dds_request_max_retries);
+  get_parameter(
+      "dds_write_batching", server_node_config.dds_write_batching);
+  get_parameter(
+      "dds_shared_memory", server_node_config.dds_shared_memory);
+  get_parameter(
+      "dds_discovery_mode", server_node_config.dds_discovery_mode);
+  get_parameter(
+      "dds_discovery_peers", server_node_config.dds_discovery_peers);
+  get_parameter(
+      "dds_network_interface", server_node_config.dds_network_interface);
+  get_parameter(
+      "dds_spdp_interval", server_node_config.dds_spdp_interval);
+  get_parameter("dds_thread_cpus", server_node_config.dds_thread_cpus);
+  get_parameter(
+      "dds_thread_priority", server_node_config.dds_thread_priority);
+  get_parameter("server_thread_cpus", server_node_config.server_thread_cpus);
+  get_parameter(
+      "server_thread_priority", server_node_config.server_thread_priority);
+  get_parameter(
+      "send_queue_capacity", server_node_config.send_queue_capacity);
+  get_parameter("send_queue_policy", server_node_config.send_queue_policy);
+  get_parameter(
+      "robot_state_take_window", server_node_config.robot_state_take_window);
+  get_parameter("max_take_window", server_node_config.max_take_window);
+  get_qos_parameters(
+      "dds_robot_state_qos", server_node_config.dds_robot_state_qos);
+  get_qos_parameters(
+      "dds_mode_request_qos", server_node_config.dds_mode_request_qos);
+  get_qos_parameters(
+      "dds_path_request_qos", server_node_config.dds_path_request_qos);
+  get_qos_parameters(
+      "dds_destination_request_qos",
+      server_node_config.dds_destination_request_qos);
+  get_qos_parameters(
+      "dds_fleet_state_qos", server_node_config.dds_fleet_state_qos);
   get_parameter("update_state_frequency",
       server_node_config.update_state_frequency);
   get_parameter(
       "publish_state_frequency", server_node_config.publish_state_frequency);
+  get_parameter(
+      "fleet_state_max_message_size",
+      server_node_config.fleet_state_max_message_size);
+  get_parameter(
+      "fleet_state_round_robin", server_node_config.fleet_state_round_robin);
+  get_parameter(
+      "request_dedup_window", server_node_config.request_dedup_window);
+  get_parameter("ingest_threads", server_node_config.ingest_threads);
+  get_parameter(
+      "robot_expiry_timeout", server_node_config.robot_expiry_timeout);
+  get_parameter("diagnostics_topic", server_node_config.diagnostics_topic);
+  get_parameter("diagnostics_period", server_node_config.diagnostics_period);
+  get_parameter(
+      "spatial_index_cell_size", server_node_config.spatial_index_cell_size);
+  get_parameter(
+      "query_radius_service", server_node_config.query_radius_service);
+  get_parameter("query_box_service", server_node_config.query_box_service);
 
   get_parameter("translation_x", server_node_config.translation_x);
   get_parameter("translation_y", server_node_config.translation_y);
@@ -125,6 +254,18 @@ void ServerNode::setup_config()
   get_parameter("scale", server_node_config.scale);
 }
 
+void ServerNode::get_qos_parameters(
+    const std::string& _prefix, TopicQoS& _qos)
+{
+  get_parameter(_prefix + ".reliable", _qos.reliable);
+  get_parameter(_prefix + ".history_depth", _qos.history_depth);
+  get_parameter(_prefix + ".transient_local", _qos.transient_local);
+  get_parameter(_prefix + ".deadline", _qos.deadline);
+  get_parameter(_prefix + ".latency_budget", _qos.latency_budget);
+  get_parameter(_prefix + ".liveliness_lease", _qos.liveliness_lease);
+  get_parameter(_prefix + ".transport_priority", _qos.transport_priority);
+}
+
 bool ServerNode::is_ready()
 {
   if (server_node_config.fleet_name == "fleet_name")
@@ -132,15 +273,83 @@ bool ServerNode::is_ready()
   return true;
 }
 
+bool ServerNode::wait_for_parameters(std::chrono::nanoseconds _timeout)
+{
+  // Woken up as soon as a usable fleet name gets set, instead of polling
+  std::promise<void> fleet_name_promise;
+  std::future<void> fleet_name_future = fleet_name_promise.get_future();
+  bool fleet_name_set = false;
+
+  auto callback_handle = add_on_set_parameters_callback(
+      [&](const std::vector<rclcpp::Parameter>& _parameters)
+      {
+        for (const auto& parameter : _parameters)
+        {
+          if (!fleet_name_set &&
+              parameter.get_name() == "fleet_name" &&
+              parameter.get_type() == rclcpp::ParameterType::PARAMETER_STRING &&
+              parameter.as_string() != "fleet_name")
+          {
+            fleet_name_set = true;
+            fleet_name_promise.set_value();
+          }
+        }
+        rcl_interfaces::msg::SetParametersResult result;
+        result.successful = true;
+        return result;
+      });
+
+  auto return_code = rclcpp::spin_until_future_complete(
+      shared_from_this(), fleet_name_future, _timeout);
+  remove_on_set_parameters_callback(callback_handle.get());
+  if (return_code != rclcpp::FutureReturnCode::SUCCESS)
+    return false;
+
+  setup_config();
+  return is_ready();
+}
+
 void ServerNode::start(Fields _fields)
 {
   fields = std::move(_fields);
 
-  {
-    WriteLock robot_states_lock(robot_states_mutex);
-    robot_states.clear();
-  }
+  // The configured transform takes locations from the RMF frame into the
+  // fleet frame
+  rmf_to_fleet_transform = FrameTransform(
+      server_node_config.translation_x,
+      server_node_config.translation_y,
+      server_node_config.rotation,
+      server_node_config.scale);
+  fleet_to_rmf_transform = rmf_to_fleet_transform.inverse();
+
+  robot_states.store(std::make_shared<const RobotStateTable>());
+
+  ingest_pool = std::make_shared<WorkerPool>(
+      static_cast<size_t>(std::max(server_node_config.ingest_threads, 1)));
+
+  fleet_state_chunks.assign(1, rmf_fleet_msgs::msg::FleetState());
+  fleet_state_chunks.front().name = server_node_config.fleet_name;
+  fleet_state_chunk_count = 1;
+  fleet_state_version = 0;
+  next_fleet_state_chunk = 0;
+
+  fields.server->on_robot_lost(
+      [this](const std::string& _robot_name)
+      {
+        RCLCPP_INFO(get_logger(), "lost robot: [%s]", _robot_name.c_str());
+        std::lock_guard<std::mutex> lock(lost_robots_mutex);
+        lost_robots.push_back(_robot_name);
+      });
+  fields.server->on_robot_rejoined(
+      [this](const std::string& _robot_name)
+      {
+        RCLCPP_INFO(
+            get_logger(), "robot rejoined: [%s]", _robot_name.c_str());
+      });
+}
 
+void ServerNode::create_ros_interfaces()
+{
   using namespace std::chrono_literals;
 
   // --------------------------------------------------------------------------
@@ -150,8 +359,11 @@ void ServerNode::start(Fields _fields)
   update_state_callback_group = create_callback_group(
       rclcpp::CallbackGroupType::MutuallyExclusive);
 
+  // Each fleet ingests its robot states at its own configured rate, on its
+  // own callback group
   update_state_timer = create_wall_timer(
-      100ms, std::bind(&ServerNode::update_state_callback, this),
+      std::chrono::seconds(1) / server_node_config.update_state_frequency,
+      std::bind(&ServerNode::update_state_callback, this),
       update_state_callback_group);
 
   // --------------------------------------------------------------------------
@@ -170,6 +382,24 @@ void ServerNode::start(Fields _fields)
       std::bind(&ServerNode::publish_fleet_state, this),
       fleet_state_pub_callback_group);
 
+  // --------------------------------------------------------------------------
+  // Diagnostics, published from the default callback group, as stats are
+  // collected without locking
+
+  if (server_node_config.diagnostics_period > 0.0)
+  {
+    diagnostics_pub =
+        create_publisher<diagnostic_msgs::msg::DiagnosticArray>(
+            server_node_config.diagnostics_topic, 10);
+
+    published_stats_time = std::chrono::steady_clock::now();
+    diagnostics_timer = create_wall_timer(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::duration<double>(
+                server_node_config.diagnostics_period)),
+        std::bind(&ServerNode::publish_diagnostics, this));
+  }
+
   // --------------------------------------------------------------------------
   // Mode request handling
 
@@ -215,6 +445,28 @@ void ServerNode::start(Fields _fields)
             handle_destination_request(std::move(msg));
           },
           destination_request_sub_opt);
+
+  // --------------------------------------------------------------------------
+  // Proximity queries, served from the default callback group, as the server
+  // and the robot state table can both be read from any thread
+
+  query_radius_service = create_service<QueryRadius>(
+      server_node_config.query_radius_service,
+      [this](
+          const std::shared_ptr<QueryRadius::Request> _request,
+          std::shared_ptr<QueryRadius::Response> _response)
+      {
+        handle_query_radius(*_request, *_response);
+      });
+
+  query_box_service = create_service<QueryBox>(
+      server_node_config.query_box_service,
+      [this](
+          const std::shared_ptr<QueryBox::Request> _request,
+          std::shared_ptr<QueryBox::Response> _response)
+      {
+        handle_query_box(*_request, *_response);
+      });
 }
 
 bool ServerNode::is_request_valid(
@@ -223,9 +475,9 @@ bool ServerNode::is_request_valid(
   if (_fleet_name != server_node_config.fleet_name)
     return false;
 
-  ReadLock robot_states_lock(robot_states_mutex);
-  auto it = robot_states.find(_robot_name);
-  if (it == robot_states.end())
+  auto robot_state_table = robot_states.load();
+  auto it = robot_state_table->indices.find(_robot_name);
+  if (it == robot_state_table->indices.end())
     return false;
   return true;
 }
@@ -234,179 +486,369 @@ void ServerNode::transform_fleet_to_rmf(
     const rmf_fleet_msgs::msg::Location& _fleet_frame_location,
     rmf_fleet_msgs::msg::Location& _rmf_frame_location) const
 {
-  // It feels easier to read if each operation is a separate statement.
-  // The compiler will be super smart and elide all these operations.
-  const Eigen::Vector2d translated =
-      Eigen::Vector2d(_fleet_frame_location.x, _fleet_frame_location.y)
-      - Eigen::Vector2d(
-          server_node_config.translation_x, server_node_config.translation_y);
-
-  // RCLCPP_INFO(
-  //     get_logger(), "    fleet->rmf translated: (%.3f, %.3f)",
-  //     translated[0], translated[1]);
-
-  const Eigen::Vector2d rotated =
-      Eigen::Rotation2D<double>(-server_node_config.rotation) * translated;
-
-  // RCLCPP_INFO(
-  //     get_logger(), "    fleet->rmf rotated: (%.3f, %.3f)",
-  //     rotated[0], rotated[1]);
-
-  const Eigen::Vector2d scaled = 1.0 / server_node_config.scale * rotated;
+  _rmf_frame_location = _fleet_frame_location;
+  fleet_to_rmf_transform.apply(_rmf_frame_location);
+}
 
-  // RCLCPP_INFO(
-  //     get_logger(), "    fleet->rmf scaled: (%.3f, %.3f)",
-  //     scaled[0], scaled[1]);
+void ServerNode::transform_fleet_to_rmf(
+    const rmf_fleet_msgs::msg::RobotState& _fleet_frame_rs,
+    rmf_fleet_msgs::msg::RobotState& _rmf_frame_rs) const
+{
+  transform_fleet_to_rmf(_fleet_frame_rs.location, _rmf_frame_rs.location);
 
-  _rmf_frame_location.x = scaled[0];
-  _rmf_frame_location.y = scaled[1];
-  _rmf_frame_location.yaw =
-      _fleet_frame_location.yaw - server_node_config.rotation;
+  _rmf_frame_rs.name = _fleet_frame_rs.name;
+  _rmf_frame_rs.model = _fleet_frame_rs.model;
+  _rmf_frame_rs.task_id = _fleet_frame_rs.task_id;
+  _rmf_frame_rs.mode = _fleet_frame_rs.mode;
+  _rmf_frame_rs.battery_percent = _fleet_frame_rs.battery_percent;
 
-  _rmf_frame_location.t = _fleet_frame_location.t;
-  _rmf_frame_location.level_name = _fleet_frame_location.level_name;
+  _rmf_frame_rs.path = _fleet_frame_rs.path;
+  fleet_to_rmf_transform.apply(
+      _rmf_frame_rs.path.begin(), _rmf_frame_rs.path.end());
 }
 
-void ServerNode::transform_rmf_to_fleet(
-    const rmf_fleet_msgs::msg::Location& _rmf_frame_location,
-    rmf_fleet_msgs::msg::Location& _fleet_frame_location) const
+bool ServerNode::is_duplicate_request(
+    const std::string& _robot_name, RequestKind _kind, uint64_t _fingerprint)
 {
-  // It feels easier to read if each operation is a separate statement.
-  // The compiler will be super smart and elide all these operations.
-  const Eigen::Vector2d scaled =
-      server_node_config.scale *
-      Eigen::Vector2d(_rmf_frame_location.x, _rmf_frame_location.y);
-
-  // RCLCPP_INFO(
-  //     get_logger(), "    rmf->fleet scaled: (%.3f, %.3f)",
-  //     scaled[0], scaled[1]);
-
-  const Eigen::Vector2d rotated =
-      Eigen::Rotation2D<double>(server_node_config.rotation) * scaled;
-
-  // RCLCPP_INFO(
-  //     get_logger(), "    rmf->fleet rotated: (%.3f, %.3f)",
-  //     rotated[0], rotated[1]);
-
-  const Eigen::Vector2d translated =
-      rotated +
-      Eigen::Vector2d(
-          server_node_config.translation_x, server_node_config.translation_y);
-
-  // RCLCPP_INFO(
-  //     get_logger(), "    rmf->fleet translated: (%.3f, %.3f)",
-  //     translated[0], translated[1]);
-
-  _fleet_frame_location.x = translated[0];
-  _fleet_frame_location.y = translated[1];
-  _fleet_frame_location.yaw =
-      _rmf_frame_location.yaw + server_node_config.rotation;
-
-  _fleet_frame_location.t = _rmf_frame_location.t;
-  _fleet_frame_location.level_name = _rmf_frame_location.level_name;
+  if (server_node_config.request_dedup_window <= 0.0)
+    return false;
+
+  // Only a request that actually got sent starts a new window, so that
+  // requests RMF keeps repeating still go out once every window, in case the
+  // earlier one never made it to the robot
+  const auto now = std::chrono::steady_clock::now();
+  SentRequest& sent_request =
+      sent_requests[_robot_name][static_cast<size_t>(_kind)];
+  if (sent_request.fingerprint == _fingerprint &&
+      std::chrono::duration<double>(now - sent_request.time).count() <
+          server_node_config.request_dedup_window)
+    return true;
+
+  sent_request.fingerprint = _fingerprint;
+  sent_request.time = now;
+  return false;
 }
 
 void ServerNode::handle_mode_request(
     rmf_fleet_msgs::msg::ModeRequest::UniquePtr _msg)
 {
+  FREE_FLEET_TRACEPOINT(rmf_request_received, tracing::RequestKind::Mode,
+      _msg->robot_name.c_str(), _msg->task_id.c_str());
+
+  if (!is_request_valid(_msg->fleet_name, _msg->robot_name) ||
+      is_duplicate_request(
+          _msg->robot_name, RequestKind::Mode, fingerprint(*_msg)))
+    return;
+
   messages::ModeRequest ff_msg;
   to_ff_message(*(_msg.get()), ff_msg);
-  fields.server->send_mode_request(ff_msg);
+  FREE_FLEET_TRACEPOINT(server_request_queued, tracing::RequestKind::Mode,
+      ff_msg.robot_name.c_str(), ff_msg.task_id.c_str());
+  fields.server->send_mode_request_async(std::move(ff_msg));
 }
 
 void ServerNode::handle_path_request(
     rmf_fleet_msgs::msg::PathRequest::UniquePtr _msg)
 {
-  for (std::size_t i = 0; i < _msg->path.size(); ++i)
-  {
-    rmf_fleet_msgs::msg::Location fleet_frame_waypoint;
-    transform_rmf_to_fleet(_msg->path[i], fleet_frame_waypoint);
-    _msg->path[i] = fleet_frame_waypoint;
-  }
+  FREE_FLEET_TRACEPOINT(rmf_request_received, tracing::RequestKind::Path,
+      _msg->robot_name.c_str(), _msg->task_id.c_str());
+
+  if (!is_request_valid(_msg->fleet_name, _msg->robot_name) ||
+      is_duplicate_request(
+          _msg->robot_name, RequestKind::Path, fingerprint(*_msg)))
+    return;
 
+  rmf_to_fleet_transform.apply(_msg->path.begin(), _msg->path.end());
+
+  // The ROS message is not needed any longer, its strings are handed over
+  // along with the request
   messages::PathRequest ff_msg;
-  to_ff_message(*(_msg.get()), ff_msg);
-  fields.server->send_path_request(ff_msg);
+  to_ff_message(std::move(*_msg), ff_msg);
+  FREE_FLEET_TRACEPOINT(server_request_queued, tracing::RequestKind::Path,
+      ff_msg.robot_name.c_str(), ff_msg.task_id.c_str());
+  fields.server->send_path_request_async(std::move(ff_msg));
 }
 
 void ServerNode::handle_destination_request(
     rmf_fleet_msgs::msg::DestinationRequest::UniquePtr _msg)
 {
-  rmf_fleet_msgs::msg::Location fleet_frame_destination;
-  transform_rmf_to_fleet(_msg->destination, fleet_frame_destination);
-  _msg->destination = fleet_frame_destination;
+  FREE_FLEET_TRACEPOINT(
+      rmf_request_received, tracing::RequestKind::Destination,
+      _msg->robot_name.c_str(), _msg->task_id.c_str());
+
+  if (!is_request_valid(_msg->fleet_name, _msg->robot_name) ||
+      is_duplicate_request(
+          _msg->robot_name, RequestKind::Destination, fingerprint(*_msg)))
+    return;
+
+  rmf_to_fleet_transform.apply(_msg->destination);
 
   messages::DestinationRequest ff_msg;
   to_ff_message(*(_msg.get()), ff_msg);
-  fields.server->send_destination_request(ff_msg);
+  FREE_FLEET_TRACEPOINT(
+      server_request_queued, tracing::RequestKind::Destination,
+      ff_msg.robot_name.c_str(), ff_msg.task_id.c_str());
+  fields.server->send_destination_request_async(std::move(ff_msg));
+}
+
+void ServerNode::handle_query_radius(
+    const QueryRadius::Request& _request,
+    QueryRadius::Response& _response)
+{
+  // Distances scale along with the transform into the fleet frame
+  double x = _request.x;
+  double y = _request.y;
+  double yaw = 0.0;
+  rmf_to_fleet_transform.apply(x, y, yaw);
+  const auto robot_names = fields.server->query_radius(
+      _request.level_name, x, y,
+      _request.radius * rmf_to_fleet_transform.scale());
+
+  const double squared_radius = _request.radius * _request.radius;
+  add_robot_states(
+      _request.level_name, robot_names,
+      [&](const rmf_fleet_msgs::msg::Location& _location)
+      {
+        const double dx = _location.x - _request.x;
+        const double dy = _location.y - _request.y;
+        return dx * dx + dy * dy <= squared_radius;
+      },
+      _response.robots);
+}
+
+void ServerNode::handle_query_box(
+    const QueryBox::Request& _request,
+    QueryBox::Response& _response)
+{
+  if (!(_request.min_x <= _request.max_x && _request.min_y <= _request.max_y))
+    return;
+
+  // The box is no longer axis aligned in the fleet frame once rotated, the
+  // server is asked for the box around it instead
+  double min_x = std::numeric_limits<double>::infinity();
+  double min_y = min_x;
+  double max_x = -min_x;
+  double max_y = -min_x;
+  for (const double corner_x : {_request.min_x, _request.max_x})
+  {
+    for (const double corner_y : {_request.min_y, _request.max_y})
+    {
+      double x = corner_x;
+      double y = corner_y;
+      double yaw = 0.0;
+      rmf_to_fleet_transform.apply(x, y, yaw);
+      min_x = std::min(min_x, x);
+      min_y = std::min(min_y, y);
+      max_x = std::max(max_x, x);
+      max_y = std::max(max_y, y);
+    }
+  }
+  const auto robot_names = fields.server->query_box(
+      _request.level_name, min_x, min_y, max_x, max_y);
+
+  add_robot_states(
+      _request.level_name, robot_names,
+      [&](const rmf_fleet_msgs::msg::Location& _location)
+      {
+        return _location.x >= _request.min_x && _location.x <= _request.max_x &&
+            _location.y >= _request.min_y && _location.y <= _request.max_y;
+      },
+      _response.robots);
+}
+
+template <typename Predicate>
+void ServerNode::add_robot_states(
+    const std::string& _level_name,
+    const std::vector<std::string>& _robot_names,
+    const Predicate& _predicate,
+    std::vector<rmf_fleet_msgs::msg::RobotState>& _robots) const
+{
+  auto robot_state_table = robot_states.load();
+  for (const auto& robot_name : _robot_names)
+  {
+    auto it = robot_state_table->indices.find(robot_name);
+    if (it == robot_state_table->indices.end())
+      continue;
+    const auto& robot_state = robot_state_table->robots[it->second];
+    if (robot_state->location.level_name == _level_name &&
+        _predicate(robot_state->location))
+      _robots.push_back(*robot_state);
+  }
+}
+
+void ServerNode::publish_diagnostics()
+{
+  const auto now = std::chrono::steady_clock::now();
+  Stats stats = fields.server->get_stats();
+
+  diagnostic_msgs::msg::DiagnosticArray diagnostics;
+  diagnostics.header.stamp = get_clock()->now();
+  to_diagnostic_statuses(
+      stats, published_stats,
+      std::chrono::duration<double>(now - published_stats_time).count(),
+      get_name(), server_node_config.fleet_name, diagnostics.status);
+  if (server_node_config.dds_time_sync_period > 0.0)
+    diagnostics.status.push_back(to_diagnostic_status(
+        fields.server->get_clock_offsets(), get_name(),
+        server_node_config.fleet_name));
+  diagnostics_pub->publish(diagnostics);
+
+  published_stats = std::move(stats);
+  published_stats_time = now;
 }
 
 void ServerNode::update_state_callback()
 {
-  std::vector<messages::RobotState> new_robot_states;
   fields.server->read_robot_states(new_robot_states);
 
-  for (const messages::RobotState& ff_rs : new_robot_states)
+  std::vector<std::string> expired_robots;
   {
-    rmf_fleet_msgs::msg::RobotState ros_rs;
-    to_ros_message(ff_rs, ros_rs);
+    std::lock_guard<std::mutex> lock(lost_robots_mutex);
+    expired_robots.swap(lost_robots);
+  }
 
-    WriteLock robot_states_lock(robot_states_mutex);
-    auto it = robot_states.find(ros_rs.name);
-    if (it == robot_states.end())
+  if (new_robot_states.empty() && expired_robots.empty())
+    return;
+
+  // The whole batch is converted and transformed into the RMF frame before
+  // being published into a new table, the transform is done once here
+  // instead of on every published fleet state. Every state is converted into
+  // its own slot, keeping the batch in order when split between threads.
+  std::vector<RobotStateTable::RobotStatePtr> rmf_frame_robot_states(
+      new_robot_states.size());
+  ingest_pool->parallel_for(
+      new_robot_states.size(), IngestRangeSize,
+      [this, &rmf_frame_robot_states](
+          size_t _begin, size_t _end)
+      {
+        rmf_fleet_msgs::msg::RobotState fleet_frame_rs;
+        for (size_t i = _begin; i < _end; ++i)
+        {
+          to_ros_message(new_robot_states[i], fleet_frame_rs);
+          auto rmf_frame_rs =
+              std::make_shared<rmf_fleet_msgs::msg::RobotState>();
+          transform_fleet_to_rmf(fleet_frame_rs, *rmf_frame_rs);
+          rmf_frame_robot_states[i] = std::move(rmf_frame_rs);
+        }
+      });
+
+  // This callback is the only writer, copying the current table only copies
+  // the pointers to the states of each robot.
+  auto new_table =
+      std::make_shared<RobotStateTable>(*robot_states.load());
+  for (auto& rmf_frame_rs : rmf_frame_robot_states)
+  {
+    auto it = new_table->indices.find(rmf_frame_rs->name);
+    if (it == new_table->indices.end())
+    {
       RCLCPP_INFO(
           get_logger(),
           "registered a new robot: [%s]",
-          ros_rs.name.c_str());
-
-    robot_states[ros_rs.name] = ros_rs;
+          rmf_frame_rs->name.c_str());
+      new_table->indices[rmf_frame_rs->name] = new_table->robots.size();
+      new_table->robots.push_back(std::move(rmf_frame_rs));
+    }
+    else
+    {
+      new_table->robots[it->second] = std::move(rmf_frame_rs);
+    }
   }
+  remove_robots(*new_table, expired_robots);
+  ++new_table->version;
+  robot_states.store(std::move(new_table));
 }
 
 void ServerNode::publish_fleet_state()
 {
-  rmf_fleet_msgs::msg::FleetState fleet_state;
-  fleet_state.name = server_node_config.fleet_name;
-  fleet_state.robots.clear();
+  auto robot_state_table = robot_states.load();
+  if (robot_state_table->version != fleet_state_version)
+  {
+    assemble_fleet_state(*robot_state_table);
+    fleet_state_version = robot_state_table->version;
+  }
 
-  ReadLock robot_states_lock(robot_states_mutex);
-  for (const auto it : robot_states)
+  if (server_node_config.fleet_state_round_robin)
   {
-    const auto fleet_frame_rs = it.second;
-    rmf_fleet_msgs::msg::RobotState rmf_frame_rs;
-
-    transform_fleet_to_rmf(fleet_frame_rs.location, rmf_frame_rs.location);
-
-    // RCLCPP_INFO(
-    //     get_logger(),
-    //     "robot location: (%.1f, %.1f, %.1f) -> (%.1f, %.1f, %.1f)",
-    //     fleet_frame_rs.location.x,
-    //     fleet_frame_rs.location.y,
-    //     fleet_frame_rs.location.yaw,
-    //     rmf_frame_rs.location.x,
-    //     rmf_frame_rs.location.y,
-    //     rmf_frame_rs.location.yaw);
-
-    rmf_frame_rs.name = fleet_frame_rs.name;
-    rmf_frame_rs.model = fleet_frame_rs.model;
-    rmf_frame_rs.task_id = fleet_frame_rs.task_id;
-    rmf_frame_rs.mode = fleet_frame_rs.mode;
-    rmf_frame_rs.battery_percent = fleet_frame_rs.battery_percent;
-
-    rmf_frame_rs.path.clear();
-    for (const auto& fleet_frame_path_loc : fleet_frame_rs.path)
-    {
-      rmf_fleet_msgs::msg::Location rmf_frame_path_loc;
+    if (next_fleet_state_chunk >= fleet_state_chunk_count)
+      next_fleet_state_chunk = 0;
+    publish_fleet_state_message(fleet_state_chunks[next_fleet_state_chunk++]);
+    return;
+  }
+  for (std::size_t i = 0; i < fleet_state_chunk_count; ++i)
+    publish_fleet_state_message(fleet_state_chunks[i]);
+}
 
-      transform_fleet_to_rmf(fleet_frame_path_loc, rmf_frame_path_loc);
+void ServerNode::publish_fleet_state_message(
+    const rmf_fleet_msgs::msg::FleetState& _fleet_state)
+{
+  // The assembled fleet states are kept for the next ticks, each publish
+  // gets its own copy that is handed over to rclcpp, so that intra-process
+  // subscriptions take ownership of it instead of being given another copy,
+  // it is only serialized for the other processes
+  fleet_state_pub->publish(
+      std::make_unique<rmf_fleet_msgs::msg::FleetState>(_fleet_state));
+}
 
-      rmf_frame_rs.path.push_back(rmf_frame_path_loc);
+void ServerNode::assemble_fleet_state(const RobotStateTable& _table)
+{
+  const std::size_t max_size = static_cast<std::size_t>(
+      std::max(server_node_config.fleet_state_max_message_size, 0));
+
+  // Robots are assigned over the ones of the previous assembly, so that
+  // their strings and paths keep their capacity from one assembly to the
+  // next, only the robots past the end of a chunk are destroyed
+  std::size_t chunk = 0;
+  std::size_t chunk_robots = 0;
+  std::size_t chunk_size = 0;
+  for (const auto& rmf_frame_rs : _table.robots)
+  {
+    const std::size_t robot_size =
+        max_size > 0 ? serialized_size(*rmf_frame_rs) : 0;
+    if (max_size > 0 && chunk_size > 0 && chunk_size + robot_size > max_size)
+    {
+      fleet_state_chunks[chunk].robots.resize(chunk_robots);
+      if (++chunk == fleet_state_chunks.size())
+      {
+        fleet_state_chunks.emplace_back();
+        fleet_state_chunks.back().name = server_node_config.fleet_name;
+      }
+      chunk_robots = 0;
+      chunk_size = 0;
     }
 
-    fleet_state.robots.push_back(rmf_frame_rs);
+    auto& robots = fleet_state_chunks[chunk].robots;
+    if (chunk_robots < robots.size())
+      robots[chunk_robots] = *rmf_frame_rs;
+    else
+      robots.push_back(*rmf_frame_rs);
+    ++chunk_robots;
+    chunk_size += robot_size;
+  }
+  fleet_state_chunks[chunk].robots.resize(chunk_robots);
+  fleet_state_chunk_count = chunk + 1;
+}
+
+void ServerNode::remove_robots(
+    RobotStateTable& _table, const std::vector<std::string>& _robot_names)
+{
+  for (const std::string& robot_name : _robot_names)
+  {
+    auto it = _table.indices.find(robot_name);
+    if (it == _table.indices.end())
+      continue;
+
+    const std::size_t index = it->second;
+    _table.indices.erase(it);
+    if (index + 1 != _table.robots.size())
+    {
+      _table.robots[index] = std::move(_table.robots.back());
+      _table.indices[_table.robots[index]->name] = index;
+    }
+    _table.robots.pop_back();
   }
-  fleet_state_pub->publish(fleet_state);
 }
 
 } // namespace ros2
 } // namespace free_fleet
+
+RCLCPP_COMPONENTS_REGISTER_NODE(free_fleet::ros2::ServerNode)
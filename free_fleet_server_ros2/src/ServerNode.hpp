@@ -18,8 +18,12 @@
 #ifndef FREE_FLEET_SERVER_ROS2__SRC__SERVERNODE_HPP
 #define FREE_FLEET_SERVER_ROS2__SRC__SERVERNODE_HPP
 
+#include <array>
 #include <mutex>
+#include <chrono>
+#include <cstdint>
 #include <memory>
+#include <vector>
 #include <unordered_map>
 
 #include <rclcpp/rclcpp.hpp>
@@ -27,6 +31,8 @@
 
 #include <rcl_interfaces/msg/parameter_event.hpp>
 
+#include <diagnostic_msgs/msg/diagnostic_array.hpp>
+
 #include <rmf_fleet_msgs/msg/location.hpp>
 #include <rmf_fleet_msgs/msg/robot_state.hpp>
 #include <rmf_fleet_msgs/msg/fleet_state.hpp>
@@ -34,7 +40,15 @@
 #include <rmf_fleet_msgs/msg/path_request.hpp>
 #include <rmf_fleet_msgs/msg/destination_request.hpp>
 
+#include <free_fleet_server_ros2/srv/query_box.hpp>
+#include <free_fleet_server_ros2/srv/query_radius.hpp>
+
+#include <free_fleet/Stats.hpp>
 #include <free_fleet/Server.hpp>
+#include <free_fleet/FrameTransform.hpp>
+#include <free_fleet/AtomicSnapshot.hpp>
+#include <free_fleet/WorkerPool.hpp>
+#include <free_fleet/RobotStateBatch.hpp>
 #include <free_fleet/messages/Location.hpp>
 #include <free_fleet/messages/RobotState.hpp>
 
@@ -52,6 +66,8 @@ public:
   using SharedPtr = std::shared_ptr<ServerNode>;
   using ReadLock = std::unique_lock<std::mutex>;
   using WriteLock = std::unique_lock<std::mutex>;
+  using QueryRadius = free_fleet_server_ros2::srv::QueryRadius;
+  using QueryBox = free_fleet_server_ros2::srv::QueryBox;
 
   static SharedPtr make(
       const ServerNodeConfig& config,
@@ -60,6 +76,13 @@ public:
               .allow_undeclared_parameters(true)
               .automatically_declare_parameters_from_overrides(true));
 
+  /// Constructor used when the node is loaded as a component, which serves
+  /// the fleet named by the fleet_name parameter. Intra-process
+  /// communication is always enabled so that adapters composed into the
+  /// same process get the fleet state without it being serialized. Throws
+  /// if the free fleet server cannot be started.
+  explicit ServerNode(const rclcpp::NodeOptions& options);
+
   ~ServerNode();
 
   struct Fields
@@ -75,13 +98,44 @@ private:
   bool is_request_valid(
       const std::string& fleet_name, const std::string& robot_name);
 
+  enum class RequestKind : size_t
+  {
+    Mode = 0,
+    Path,
+    Destination,
+    Count
+  };
+
+  /// Fingerprint of the last request of each kind that was sent to a robot
+  struct SentRequest
+  {
+    uint64_t fingerprint = 0;
+    std::chrono::steady_clock::time_point time;
+  };
+
+  /// Only accessed from the request subscriptions, which all share the same
+  /// mutually exclusive callback group
+  std::unordered_map<
+      std::string,
+      std::array<SentRequest, static_cast<size_t>(RequestKind::Count)>>
+          sent_requests;
+
+  /// Checks the request against the last one of the same kind that was sent
+  /// to the robot, keeping track of it if it is not a duplicate.
+  bool is_duplicate_request(
+      const std::string& robot_name, RequestKind kind, uint64_t fingerprint);
+
+  FrameTransform rmf_to_fleet_transform;
+
+  FrameTransform fleet_to_rmf_transform;
+
   void transform_fleet_to_rmf(
       const rmf_fleet_msgs::msg::Location& fleet_frame_location,
       rmf_fleet_msgs::msg::Location& rmf_frame_location) const;
 
-  void transform_rmf_to_fleet(
-      const rmf_fleet_msgs::msg::Location& rmf_frame_location,
-      rmf_fleet_msgs::msg::Location& fleet_frame_location) const;
+  void transform_fleet_to_rmf(
+      const rmf_fleet_msgs::msg::RobotState& fleet_frame_robot_state,
+      rmf_fleet_msgs::msg::RobotState& rmf_frame_robot_state) const;
 
   // --------------------------------------------------------------------------
 
@@ -111,10 +165,46 @@ private:
 
   rclcpp::TimerBase::SharedPtr update_state_timer;
 
-  std::mutex robot_states_mutex;
+  /// Latest state of every robot, already transformed into the RMF frame
+  /// when it was received, ready to be published. A new table is built for
+  /// every batch of states and swapped in at once, so readers never wait on
+  /// the ingestion.
+  struct RobotStateTable
+  {
+    using RobotStatePtr =
+        std::shared_ptr<const rmf_fleet_msgs::msg::RobotState>;
+
+    /// Index of each robot within robots
+    std::unordered_map<std::string, std::size_t> indices;
+
+    /// States are shared between tables, unless they have been updated
+    std::vector<RobotStatePtr> robots;
+
+    /// Incremented for every new table
+    uint64_t version = 0;
+  };
+
+  AtomicSnapshot<RobotStateTable> robot_states;
+
+  /// Smallest number of robot states converted by each ingest thread
+  static constexpr size_t IngestRangeSize = 16;
+
+  WorkerPool::SharedPtr ingest_pool;
+
+  /// States read on every update, reused along with their strings and paths
+  /// so that a steady fleet is taken in without allocating, only used from
+  /// update_state_callback
+  RobotStateBatch new_robot_states;
+
+  /// Robots reported lost by the server since the last update, these are
+  /// reported from within read_robot_states
+  std::mutex lost_robots_mutex;
+  std::vector<std::string> lost_robots;
 
-  std::unordered_map<std::string, rmf_fleet_msgs::msg::RobotState>
-      robot_states;
+  /// Removes the robots from the table, moving the last robot into the slot
+  /// of each removed robot
+  void remove_robots(
+      RobotStateTable& table, const std::vector<std::string>& robot_names);
 
   void update_state_callback();
 
@@ -128,16 +218,88 @@ private:
   rclcpp::Publisher<rmf_fleet_msgs::msg::FleetState>::SharedPtr
       fleet_state_pub;
 
+  /// Fleet states that get published on every tick, only reassembled when
+  /// robot states have changed. A single message with the whole fleet,
+  /// unless it is bounded by fleet_state_max_message_size. Only the first
+  /// fleet_state_chunk_count are in use, the others are kept for when the
+  /// fleet grows again.
+  std::vector<rmf_fleet_msgs::msg::FleetState> fleet_state_chunks;
+
+  std::size_t fleet_state_chunk_count = 1;
+
+  /// Version of the robot state table that fleet_state_chunks were assembled
+  /// from
+  uint64_t fleet_state_version = 0;
+
+  /// Message that gets published on the next tick in round robin
+  std::size_t next_fleet_state_chunk = 0;
+
   void publish_fleet_state();
 
+  void publish_fleet_state_message(
+      const rmf_fleet_msgs::msg::FleetState& fleet_state);
+
+  void assemble_fleet_state(const RobotStateTable& table);
+
+  // --------------------------------------------------------------------------
+
+  rclcpp::TimerBase::SharedPtr diagnostics_timer;
+
+  rclcpp::Publisher<diagnostic_msgs::msg::DiagnosticArray>::SharedPtr
+      diagnostics_pub;
+
+  /// Stats that were last published, which the rates are computed from
+  Stats published_stats;
+
+  std::chrono::steady_clock::time_point published_stats_time;
+
+  void publish_diagnostics();
+
+  // --------------------------------------------------------------------------
+
+  rclcpp::Service<QueryRadius>::SharedPtr query_radius_service;
+
+  rclcpp::Service<QueryBox>::SharedPtr query_box_service;
+
+  void handle_query_radius(
+      const QueryRadius::Request& request,
+      QueryRadius::Response& response);
+
+  void handle_query_box(
+      const QueryBox::Request& request,
+      QueryBox::Response& response);
+
+  /// Adds the states of the robots that the server found, as they are in the
+  /// robot state table in the RMF frame, keeping those whose location falls
+  /// within the query in that frame.
+  template <typename Predicate>
+  void add_robot_states(
+      const std::string& level_name,
+      const std::vector<std::string>& robot_names,
+      const Predicate& predicate,
+      std::vector<rmf_fleet_msgs::msg::RobotState>& robots) const;
+
   // --------------------------------------------------------------------------
 
   ServerNodeConfig server_node_config;
 
   void setup_config();
 
+  void get_qos_parameters(const std::string& prefix, TopicQoS& qos);
+
   bool is_ready();
 
+  /// Spins the node until the parameters get set, or until the timeout.
+  bool wait_for_parameters(std::chrono::nanoseconds timeout);
+
+  /// Creates the timers, publishers and subscriptions, which only start
+  /// being serviced once the node is spun.
+  void create_ros_interfaces();
+
+  /// Starts the free fleet server and the ROS interfaces once the
+  /// configuration is set, false if the server could not be started.
+  bool initialize();
+
   Fields fields;
 
   ServerNode(
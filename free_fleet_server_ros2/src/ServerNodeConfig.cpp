@@ -16,6 +16,7 @@
  */
 
 #include <cstdio>
+#include <algorithm>
 
 #include <free_fleet/ServerConfig.hpp>
 
@@ -33,19 +34,73 @@ void ServerNodeConfig::print_config() const
   printf("  fleet name: %s\n", fleet_name.c_str());
   printf("  update state frequency: %.1f\n", update_state_frequency);
   printf("  publish state frequency: %.1f\n", publish_state_frequency);
+  printf("  fleet state max message size (bytes): %d, %s\n",
+      fleet_state_max_message_size,
+      fleet_state_round_robin ? "round robin" : "all on every tick");
+  printf("  request dedup window (seconds): %.1f\n", request_dedup_window);
+  printf("  ingest threads: %d\n", ingest_threads);
+  printf("  robot expiry timeout (seconds): %.1f\n", robot_expiry_timeout);
+  printf("  diagnostics period (seconds): %.1f\n", diagnostics_period);
+  printf("  spatial index cell size (meters): %.1f\n",
+      spatial_index_cell_size);
   printf("  TOPICS\n");
   printf("    fleet state: %s\n", fleet_state_topic.c_str());
   printf("    mode request: %s\n", mode_request_topic.c_str());
   printf("    path request: %s\n", path_request_topic.c_str());
   printf("    destination request: %s\n", destination_request_topic.c_str());
+  printf("    diagnostics: %s\n", diagnostics_topic.c_str());
+  printf("  SERVICES\n");
+  printf("    query radius: %s\n", query_radius_service.c_str());
+  printf("    query box: %s\n", query_box_service.c_str());
   printf("SERVER-CLIENT DDS CONFIGURATION\n");
   printf("  dds domain: %d\n", dds_domain);
+  printf("  dds partition: %s\n",
+      dds_partition.empty() ? "default" : dds_partition.c_str());
+  printf("  shards: %zu\n",
+      std::max(dds_shard_domains.size(), dds_shard_partitions.size()));
+  printf("  per-robot request partitions: %s\n",
+      dds_request_partitions ? "enabled" : "disabled");
+  printf("  writer batching: %s\n",
+      dds_write_batching ? "enabled" : "disabled");
+  printf("  shared memory: %s\n",
+      dds_shared_memory ? "enabled" : "disabled");
+  printf("  discovery: mode %s, %zu peers, interface %s, "
+      "spdp interval %.3fs\n",
+      dds_discovery_mode.c_str(), dds_discovery_peers.size(),
+      dds_network_interface.empty() ? "auto" : dds_network_interface.c_str(),
+      dds_spdp_interval);
+  printf("  dds threads: %zu cpus, priority %d\n",
+      dds_thread_cpus.size(), dds_thread_priority);
+  printf("  server threads: %zu cpus, priority %d\n",
+      server_thread_cpus.size(), server_thread_priority);
+  printf("  send queue: capacity %d, %s\n",
+      send_queue_capacity, send_queue_policy.c_str());
+  printf("  take window: %d, growing up to %d\n",
+      robot_state_take_window, max_take_window);
+  printf("  fleet state period (seconds): %.1f\n", dds_fleet_state_period);
+  printf("  incremental path requests: %s\n",
+      incremental_path_requests ? "enabled" : "disabled");
+  printf("  path packing threshold: %d\n", path_packing_threshold);
+  printf("  split robot states: %s\n",
+      split_robot_states ? "enabled" : "disabled");
+  printf("  time sync period (seconds): %.1f\n", dds_time_sync_period);
+  printf("  request retry timeout (seconds): %.1f, up to %.1f, %d retries\n",
+      dds_request_retry_timeout, dds_request_retry_max_timeout,
+      dds_request_max_retries);
   printf("  TOPICS\n");
   printf("    robot state: %s\n", dds_robot_state_topic.c_str());
   printf("    mode request: %s\n", dds_mode_request_topic.c_str());
   printf("    path request: %s\n", dds_path_request_topic.c_str());
   printf("    destination request: %s\n",
       dds_destination_request_topic.c_str());
+  printf("    fleet state: %s\n", dds_fleet_state_topic.c_str());
+  printf("  QOS\n");
+  printf("    robot state: %s\n", dds_robot_state_qos.to_string().c_str());
+  printf("    mode request: %s\n", dds_mode_request_qos.to_string().c_str());
+  printf("    path request: %s\n", dds_path_request_qos.to_string().c_str());
+  printf("    destination request: %s\n",
+      dds_destination_request_qos.to_string().c_str());
+  printf("    fleet state: %s\n", dds_fleet_state_qos.to_string().c_str());
   printf("COORDINATE TRANSFORMATION\n");
   printf("  translation x (meters): %.3f\n", translation_x);
   printf("  translation y (meters): %.3f\n", translation_y);
@@ -56,11 +111,68 @@ void ServerNodeConfig::print_config() const
 ServerConfig ServerNodeConfig::get_server_config() const
 {
   ServerConfig server_config;
+  server_config.fleet_name = fleet_name;
   server_config.dds_domain = dds_domain;
   server_config.dds_robot_state_topic = dds_robot_state_topic;
   server_config.dds_mode_request_topic = dds_mode_request_topic;
   server_config.dds_path_request_topic = dds_path_request_topic;
   server_config.dds_destination_request_topic = dds_destination_request_topic;
+  server_config.dds_fleet_state_topic = dds_fleet_state_topic;
+  server_config.dds_request_partitions = dds_request_partitions;
+  server_config.dds_partition = dds_partition;
+  const size_t shard_count =
+      std::max(dds_shard_domains.size(), dds_shard_partitions.size());
+  for (size_t i = 0; i < shard_count; ++i)
+  {
+    ServerConfig::Shard shard;
+    shard.dds_domain = i < dds_shard_domains.size() ?
+        static_cast<int>(dds_shard_domains[i]) : dds_domain;
+    shard.dds_partition =
+        i < dds_shard_partitions.size() ? dds_shard_partitions[i] : "";
+    server_config.shards.push_back(shard);
+  }
+  server_config.dds_write_batching = dds_write_batching;
+  server_config.dds_shared_memory = dds_shared_memory;
+  DiscoveryConfig::parse_mode(
+      dds_discovery_mode, server_config.dds_discovery.mode);
+  server_config.dds_discovery.peers = dds_discovery_peers;
+  server_config.dds_discovery.network_interface = dds_network_interface;
+  server_config.dds_discovery.spdp_interval = dds_spdp_interval;
+  server_config.dds_threads.cpus.assign(
+      dds_thread_cpus.begin(), dds_thread_cpus.end());
+  server_config.dds_threads.fifo_priority = dds_thread_priority;
+  server_config.threads.cpus.assign(
+      server_thread_cpus.begin(), server_thread_cpus.end());
+  server_config.threads.fifo_priority = server_thread_priority;
+  server_config.send_queue_capacity =
+      static_cast<size_t>(std::max(send_queue_capacity, 1));
+  server_config.robot_state_take_window =
+      static_cast<size_t>(std::max(robot_state_take_window, 1));
+  server_config.max_take_window = static_cast<size_t>(
+      std::max(max_take_window, robot_state_take_window));
+  server_config.ingest_threads =
+      static_cast<size_t>(std::max(ingest_threads, 1));
+  server_config.robot_expiry_timeout = robot_expiry_timeout;
+  server_config.send_queue_policy =
+      send_queue_policy == "coalesce_per_robot" ?
+          ServerConfig::SendQueuePolicy::CoalescePerRobot :
+          ServerConfig::SendQueuePolicy::DropOldest;
+  server_config.dds_robot_state_qos = dds_robot_state_qos;
+  server_config.dds_mode_request_qos = dds_mode_request_qos;
+  server_config.dds_path_request_qos = dds_path_request_qos;
+  server_config.dds_destination_request_qos = dds_destination_request_qos;
+  server_config.dds_fleet_state_qos = dds_fleet_state_qos;
+  server_config.fleet_state_period = dds_fleet_state_period;
+  server_config.incremental_path_requests = incremental_path_requests;
+  server_config.path_packing_threshold =
+      static_cast<size_t>(std::max(path_packing_threshold, 0));
+  server_config.split_robot_states = split_robot_states;
+  server_config.time_sync_period = dds_time_sync_period;
+  server_config.request_retry_timeout = dds_request_retry_timeout;
+  server_config.request_retry_max_timeout = dds_request_retry_max_timeout;
+  server_config.request_max_retries =
+      static_cast<size_t>(std::max(dds_request_max_retries, 0));
+  server_config.spatial_index_cell_size = spatial_index_cell_size;
   return server_config;
 }
 
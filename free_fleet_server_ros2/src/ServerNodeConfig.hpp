@@ -19,6 +19,11 @@
 #define FREE_FLEET_SERVER_ROS2__SRC__SERVERNODECONFIG_HPP
 
 #include <string>
+#include <vector>
+#include <cstdint>
+
+#include <free_fleet/TopicQoS.hpp>
+#include <free_fleet/ServerConfig.hpp>
 
 namespace free_fleet
 {
@@ -40,10 +45,122 @@ struct ServerNodeConfig
   std::string dds_mode_request_topic = "mode_request";
   std::string dds_path_request_topic = "path_request";
   std::string dds_destination_request_topic = "destination_request";
+  std::string dds_fleet_state_topic = "fleet_state";
+  bool dds_request_partitions = false;
+  bool dds_write_batching = false;
+  std::string dds_partition = "";
+  bool dds_shared_memory = false;
+
+  /// Discovery settings, see DiscoveryConfig, the mode is one of "default",
+  /// "multicast", "spdp_multicast" or "unicast"
+  std::string dds_discovery_mode = "default";
+  std::vector<std::string> dds_discovery_peers;
+  std::string dds_network_interface = "";
+  double dds_spdp_interval = 0.0;
+
+  /// CPUs and SCHED_FIFO priority of the threads that CycloneDDS starts for
+  /// the domain, and of the threads that the server starts itself, see
+  /// ServerConfig::dds_threads and ServerConfig::threads. Threads run on any
+  /// CPU with the default scheduling when left empty and at 0. The executor
+  /// threads are placed in the same way through the executor_cpus and
+  /// executor_priority parameters of the process.
+  std::vector<int64_t> dds_thread_cpus;
+  int dds_thread_priority = 0;
+  std::vector<int64_t> server_thread_cpus;
+  int server_thread_priority = 0;
+
+  /// Splits the fleet into shards, shard i is on the i-th domain and within
+  /// the i-th partition, falling back to dds_domain and the default partition
+  /// when either list is shorter. A single shard on dds_domain and
+  /// dds_partition if both are empty.
+  std::vector<int64_t> dds_shard_domains;
+  std::vector<std::string> dds_shard_partitions;
+
+  /// Requests from RMF are queued up and written by the server's send thread,
+  /// the policy is either "drop_oldest" or "coalesce_per_robot"
+  int send_queue_capacity = 128;
+  std::string send_queue_policy = "drop_oldest";
+
+  /// Robot states taken from the reader at a time, doubled whenever a take
+  /// fills it up to max_take_window
+  int robot_state_take_window = 16;
+  int max_take_window = 1024;
+
+  TopicQoS dds_robot_state_qos = TopicQoS::best_effort();
+  TopicQoS dds_mode_request_qos = TopicQoS::urgent_requests();
+  TopicQoS dds_path_request_qos = TopicQoS::reliable_requests();
+  TopicQoS dds_destination_request_qos = TopicQoS::reliable_requests();
+  TopicQoS dds_fleet_state_qos = TopicQoS::latest_state();
+
+  /// Publishes the whole fleet as a single DDS fleet state every this many
+  /// seconds, in the fleet's own coordinates, for observers outside of ROS 2.
+  /// Disabled if 0.
+  double dds_fleet_state_period = 0.0;
+
+  /// Path requests that only change the end of a robot's path are sent as
+  /// updates of its current path, all clients need to support path updates
+  bool incremental_path_requests = false;
+
+  /// Path requests of at least this many waypoints are sent packed, see
+  /// ServerConfig::path_packing_threshold, disabled if 0
+  int path_packing_threshold = 0;
+
+  /// Also takes in robot states that clients split into poses and metadata,
+  /// see ServerConfig::split_robot_states
+  bool split_robot_states = false;
+
+  /// Clients are pinged every this many seconds to estimate how far the
+  /// clock of each robot is off from the server's, robot state locations are
+  /// then moved onto the server's clock. Disabled if 0.
+  double dds_time_sync_period = 0.0;
+
+  /// Requests that their robots have not acknowledged within this many
+  /// seconds are sent again, backing off up to dds_request_retry_max_timeout
+  /// for at most dds_request_max_retries times, see
+  /// ServerConfig::request_retry_timeout. Disabled if 0.
+  double dds_request_retry_timeout = 0.0;
+
+  double dds_request_retry_max_timeout = 8.0;
+
+  int dds_request_max_retries = 5;
+
+  /// Identical requests for the same robot within this many seconds of each
+  /// other only get sent once, 0 sends every request
+  double request_dedup_window = 2.0;
+
+  /// Number of threads that each batch of incoming robot states is
+  /// converted on, 1 converts them on the ingesting executor thread
+  int ingest_threads = 1;
+
+  /// Robots that have not been heard from for this many seconds are removed
+  /// from the published fleet state, disabled if 0
+  double robot_expiry_timeout = 0.0;
+
+  /// Proximity queries through the services below look up robots in a grid
+  /// of cells this many meters wide in the fleet frame, instead of going
+  /// through every robot. Disabled if 0.
+  double spatial_index_cell_size = 0.0;
+  std::string query_radius_service = "query_radius";
+  std::string query_box_service = "query_box";
 
   double update_state_frequency = 10.0;
   double publish_state_frequency = 10.0;
 
+  /// Fleet states published to RMF are kept under about this many bytes,
+  /// estimated from the names and paths of their robots, by spreading the
+  /// fleet over as many messages as needed, each robot being in exactly one
+  /// of them. The whole fleet goes into a single message if 0.
+  int fleet_state_max_message_size = 0;
+
+  /// Only publishes one of those messages on every tick, going through them
+  /// in turn, instead of all of them on every tick
+  bool fleet_state_round_robin = false;
+
+  /// Statistics of the server are published as diagnostics every this many
+  /// seconds, disabled if 0
+  std::string diagnostics_topic = "diagnostics";
+  double diagnostics_period = 1.0;
+
   // the transformation order of operations from the server to the client is:
   // 1) scale
   // 2) rotate
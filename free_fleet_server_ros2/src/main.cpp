@@ -15,10 +15,17 @@
  *
  */
 
+#include <thread>
+#include <vector>
+#include <string>
+#include <cstdint>
 #include <iostream>
+#include <algorithm>
 
 #include <rclcpp/rclcpp.hpp>
 
+#include <free_fleet/ThreadConfig.hpp>
+
 #include "ServerNode.hpp"
 
 
@@ -27,17 +34,74 @@ int main(int argc, char** argv)
   rclcpp::init(argc, argv);
   std::cout << "Greetings from free_fleet_server_ros2" << std::endl;
 
-  free_fleet::ros2::ServerNodeConfig server_node_config =
-      free_fleet::ros2::ServerNodeConfig::make();
-  server_node_config.fleet_name = "free_fleet_server_ros2";
+  // A list of fleet names hosts every one of those fleets in this process,
+  // each fleet gets its own node named <fleet_name>_node which reads its
+  // parameters from that node's section of the parameter file
+  std::vector<std::string> fleet_names;
+  int executor_threads = 0;
+  std::vector<int64_t> executor_cpus;
+  int executor_priority = 0;
+  {
+    auto bootstrap_node = std::make_shared<rclcpp::Node>(
+        "free_fleet_server_ros2_bootstrap",
+        rclcpp::NodeOptions()
+            .allow_undeclared_parameters(true)
+            .automatically_declare_parameters_from_overrides(true));
+    bootstrap_node->get_parameter("fleet_names", fleet_names);
+    bootstrap_node->get_parameter("executor_threads", executor_threads);
+    bootstrap_node->get_parameter("executor_cpus", executor_cpus);
+    bootstrap_node->get_parameter("executor_priority", executor_priority);
+  }
+
+  std::vector<free_fleet::ros2::ServerNode::SharedPtr> server_nodes;
+  if (fleet_names.empty())
+  {
+    free_fleet::ros2::ServerNodeConfig server_node_config =
+        free_fleet::ros2::ServerNodeConfig::make();
+    server_node_config.fleet_name = "free_fleet_server_ros2";
+
+    auto server_node = free_fleet::ros2::ServerNode::make(server_node_config);
+    if (!server_node)
+      return 1;
+    server_nodes.push_back(std::move(server_node));
+  }
+  else
+  {
+    for (const std::string& fleet_name : fleet_names)
+    {
+      free_fleet::ros2::ServerNodeConfig server_node_config =
+          free_fleet::ros2::ServerNodeConfig::make();
+      server_node_config.fleet_name = fleet_name;
 
-  auto server_node = free_fleet::ros2::ServerNode::make(server_node_config);
-  if (!server_node)
-    return 1;
+      auto server_node =
+          free_fleet::ros2::ServerNode::make(server_node_config);
+      if (!server_node)
+        return 1;
+      server_nodes.push_back(std::move(server_node));
+    }
+  }
+
+  // Every fleet has its own state ingestion and request handling callback
+  // groups, so that fleets are scheduled independently on the shared threads
+  if (executor_threads <= 0)
+  {
+    executor_threads = static_cast<int>(std::min<size_t>(
+        2 * server_nodes.size(),
+        std::max(2u, std::thread::hardware_concurrency())));
+  }
 
   rclcpp::executors::MultiThreadedExecutor executor {
-      rclcpp::ExecutorOptions(), 2};
-  executor.add_node(server_node);
+      rclcpp::ExecutorOptions(), static_cast<size_t>(executor_threads)};
+  for (const auto& server_node : server_nodes)
+    executor.add_node(server_node);
+
+  // The executor starts its threads from this one as it spins, and they
+  // inherit its CPUs and scheduling
+  free_fleet::ThreadConfig executor_thread_config;
+  executor_thread_config.cpus.assign(
+      executor_cpus.begin(), executor_cpus.end());
+  executor_thread_config.fifo_priority = executor_priority;
+  executor_thread_config.apply("executor");
   executor.spin();
 
   rclcpp::shutdown();
@@ -0,0 +1,504 @@
+/*
+ * Copyright (C) 2019 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <algorithm>
+#include <unordered_map>
+
+#include <rclcpp/rclcpp.hpp>
+
+#include <rmf_fleet_msgs/msg/location.hpp>
+#include <rmf_fleet_msgs/msg/robot_mode.hpp>
+#include <rmf_fleet_msgs/msg/mode_request.hpp>
+#include <rmf_fleet_msgs/msg/path_request.hpp>
+#include <rmf_fleet_msgs/msg/destination_request.hpp>
+
+#include <free_fleet/Client.hpp>
+#include <free_fleet/ClientConfig.hpp>
+#include <free_fleet/messages/RobotState.hpp>
+
+using Clock = std::chrono::steady_clock;
+
+namespace {
+
+struct Options
+{
+  size_t robots = 20;
+
+  /// Requests per second of each kind, spread over all the robots
+  double mode_rate = 0.0;
+  double path_rate = 50.0;
+  double destination_rate = 0.0;
+
+  size_t path_length = 20;
+
+  /// The storm runs in steps, every step multiplies the rates of the one
+  /// before it by the ramp factor, so the point where the server node starts
+  /// to fall behind shows up as the step where deliveries stop keeping up
+  size_t steps = 1;
+  double ramp_factor = 2.0;
+  double step_duration = 10.0;
+
+  /// Robots publish their states for this long before the storm starts, so
+  /// that the server node knows about all of them
+  double warmup = 3.0;
+  double state_rate = 2.0;
+
+  std::string fleet_name = "fleet_name";
+  int domain = 42;
+
+  std::string mode_request_topic = "mode_request";
+  std::string path_request_topic = "path_request";
+  std::string destination_request_topic = "destination_request";
+};
+
+void print_usage(const char* _program)
+{
+  printf("Usage: %s [options]\n", _program);
+  printf("  --robots N               number of emulated robots (20)\n");
+  printf("  --mode-rate HZ           mode requests/s over all robots (0)\n");
+  printf("  --path-rate HZ           path requests/s over all robots (50)\n");
+  printf("  --destination-rate HZ    destination requests/s over all robots "
+      "(0)\n");
+  printf("  --path-length N          waypoints of each path request (20)\n");
+  printf("  --steps N                number of rate steps (1)\n");
+  printf("  --ramp-factor X          rate multiplier between steps (2.0)\n");
+  printf("  --step-duration S        length of each step in seconds (10.0)\n");
+  printf("  --warmup S               states published before the storm "
+      "(3.0)\n");
+  printf("  --state-rate HZ          robot state rate of each robot (2.0)\n");
+  printf("  --fleet-name NAME        fleet name of the server node "
+      "(fleet_name)\n");
+  printf("  --domain N               DDS domain of the server node (42)\n");
+  printf("  --mode-request-topic NAME\n");
+  printf("  --path-request-topic NAME\n");
+  printf("  --destination-request-topic NAME\n");
+}
+
+bool parse_options(const std::vector<std::string>& _args, Options& _options)
+{
+  for (size_t i = 1; i < _args.size(); ++i)
+  {
+    const bool has_value = i + 1 < _args.size();
+    const std::string& arg = _args[i];
+    if (arg == "--robots" && has_value)
+      _options.robots = std::strtoul(_args[++i].c_str(), NULL, 10);
+    else if (arg == "--mode-rate" && has_value)
+      _options.mode_rate = std::atof(_args[++i].c_str());
+    else if (arg == "--path-rate" && has_value)
+      _options.path_rate = std::atof(_args[++i].c_str());
+    else if (arg == "--destination-rate" && has_value)
+      _options.destination_rate = std::atof(_args[++i].c_str());
+    else if (arg == "--path-length" && has_value)
+      _options.path_length = std::strtoul(_args[++i].c_str(), NULL, 10);
+    else if (arg == "--steps" && has_value)
+      _options.steps = std::strtoul(_args[++i].c_str(), NULL, 10);
+    else if (arg == "--ramp-factor" && has_value)
+      _options.ramp_factor = std::atof(_args[++i].c_str());
+    else if (arg == "--step-duration" && has_value)
+      _options.step_duration = std::atof(_args[++i].c_str());
+    else if (arg == "--warmup" && has_value)
+      _options.warmup = std::atof(_args[++i].c_str());
+    else if (arg == "--state-rate" && has_value)
+      _options.state_rate = std::atof(_args[++i].c_str());
+    else if (arg == "--fleet-name" && has_value)
+      _options.fleet_name = _args[++i];
+    else if (arg == "--domain" && has_value)
+      _options.domain = std::atoi(_args[++i].c_str());
+    else if (arg == "--mode-request-topic" && has_value)
+      _options.mode_request_topic = _args[++i];
+    else if (arg == "--path-request-topic" && has_value)
+      _options.path_request_topic = _args[++i];
+    else if (arg == "--destination-request-topic" && has_value)
+      _options.destination_request_topic = _args[++i];
+    else
+      return false;
+  }
+  return _options.robots > 0 && _options.steps > 0 &&
+      _options.state_rate > 0.0 && _options.step_duration > 0.0 &&
+      _options.mode_rate >= 0.0 && _options.path_rate >= 0.0 &&
+      _options.destination_rate >= 0.0 &&
+      _options.mode_rate + _options.path_rate + _options.destination_rate >
+          0.0;
+}
+
+double elapsed_us(
+    const Clock::time_point& _start, const Clock::time_point& _end)
+{
+  return std::chrono::duration<double, std::micro>(_end - _start).count();
+}
+
+Clock::duration period_of(double _rate)
+{
+  return std::chrono::duration_cast<Clock::duration>(
+      std::chrono::duration<double>(1.0 / _rate));
+}
+
+double percentile(const std::vector<double>& _sorted, double _p)
+{
+  if (_sorted.empty())
+    return 0.0;
+  return _sorted[static_cast<size_t>(_p * (_sorted.size() - 1))];
+}
+
+/// Keeps track of every request that was published until it comes out of
+/// DDS on the robot it was addressed to. Task ids are unique over the whole
+/// run, so that the server node never drops any of them as a duplicate.
+class DeliveryTracker
+{
+public:
+
+  void record_published(const std::string& _task_id)
+  {
+    const auto now = Clock::now();
+    std::lock_guard<std::mutex> lock(mutex);
+    in_flight[_task_id] = now;
+    ++published;
+  }
+
+  void record_delivered(const std::string& _task_id)
+  {
+    const auto now = Clock::now();
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = in_flight.find(_task_id);
+    if (it == in_flight.end())
+      return;
+    latencies_us.push_back(elapsed_us(it->second, now));
+    in_flight.erase(it);
+  }
+
+  struct Step
+  {
+    size_t published;
+    size_t in_flight;
+    std::vector<double> latencies_us;
+  };
+
+  /// Gets what happened since the last step, requests that are still in
+  /// flight may yet be delivered during the next one
+  Step take_step()
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    Step step{published, in_flight.size(), std::move(latencies_us)};
+    published = 0;
+    latencies_us.clear();
+    std::sort(step.latencies_us.begin(), step.latencies_us.end());
+    return step;
+  }
+
+private:
+
+  std::mutex mutex;
+
+  std::unordered_map<std::string, Clock::time_point> in_flight;
+
+  size_t published = 0;
+
+  std::vector<double> latencies_us;
+};
+
+/// A robot that only exists as a free fleet client, which keeps itself known
+/// to the server node through its states and reports every request it takes.
+/// Clients only hand out the newest of the requests that piled up since
+/// their last take, the ones it superseded are never delivered.
+class StormRobot
+{
+public:
+
+  StormRobot(
+      const Options& _options,
+      const std::string& _robot_name,
+      DeliveryTracker& _tracker) :
+    tracker(_tracker)
+  {
+    free_fleet::ClientConfig client_config;
+    client_config.fleet_name = _options.fleet_name;
+    client_config.robot_name = _robot_name;
+    client_config.dds_domain = _options.domain;
+    client = free_fleet::Client::make(client_config);
+
+    robot_state.name = _robot_name;
+    robot_state.model = "request_storm";
+    robot_state.mode.mode = free_fleet::messages::RobotMode::MODE_IDLE;
+    robot_state.battery_percent = 100.f;
+    robot_state.location =
+        free_fleet::messages::Location{0, 0, 0.f, 0.f, 0.f, "L1"};
+  }
+
+  bool start()
+  {
+    if (!client)
+      return false;
+
+    return client->on_mode_request(
+        [this](const free_fleet::messages::ModeRequest& _request)
+        {
+          tracker.record_delivered(_request.task_id);
+        }) &&
+        client->on_path_request(
+            [this](const free_fleet::messages::PathRequest& _request)
+            {
+              tracker.record_delivered(_request.task_id);
+            }) &&
+        client->on_destination_request(
+            [this](const free_fleet::messages::DestinationRequest& _request)
+            {
+              tracker.record_delivered(_request.task_id);
+            });
+  }
+
+  void publish_state()
+  {
+    client->send_robot_state(robot_state);
+  }
+
+private:
+
+  DeliveryTracker& tracker;
+
+  free_fleet::Client::SharedPtr client;
+
+  free_fleet::messages::RobotState robot_state;
+};
+
+/// Publishes requests of one kind round robin over the robots at a fixed
+/// rate, reusing a single message between requests.
+template <typename Message>
+class RequestPublisher
+{
+public:
+
+  RequestPublisher(
+      rclcpp::Node& _node,
+      const std::string& _topic,
+      const std::string& _kind,
+      Message _message) :
+    kind(_kind),
+    message(std::move(_message))
+  {
+    // Same depth as the subscriptions of the server node, requests it does
+    // not get to in time are dropped there
+    pub = _node.create_publisher<Message>(_topic, rclcpp::QoS(10));
+  }
+
+  void set_rate(double _rate, const Clock::time_point& _start)
+  {
+    rate = _rate;
+    if (rate > 0.0)
+    {
+      period = period_of(rate);
+      next_publish = _start;
+    }
+  }
+
+  /// Publishes every request that is due, returns when the next one is
+  Clock::time_point publish_due(
+      const Clock::time_point& _now,
+      const std::vector<std::string>& _robot_names,
+      DeliveryTracker& _tracker)
+  {
+    if (rate <= 0.0)
+      return Clock::time_point::max();
+
+    while (next_publish <= _now)
+    {
+      message.robot_name = _robot_names[next_robot];
+      message.task_id = kind + "_" + std::to_string(next_task++);
+      _tracker.record_published(message.task_id);
+      pub->publish(message);
+      next_robot = (next_robot + 1) % _robot_names.size();
+      next_publish += period;
+    }
+    return next_publish;
+  }
+
+private:
+
+  std::string kind;
+
+  Message message;
+
+  typename rclcpp::Publisher<Message>::SharedPtr pub;
+
+  double rate = 0.0;
+
+  Clock::duration period{0};
+
+  Clock::time_point next_publish;
+
+  size_t next_robot = 0;
+
+  size_t next_task = 0;
+};
+
+rmf_fleet_msgs::msg::Location make_location(size_t _index)
+{
+  rmf_fleet_msgs::msg::Location location;
+  location.t.sec = static_cast<int32_t>(_index);
+  location.t.nanosec = 0;
+  location.x = static_cast<float>(_index);
+  location.y = 0.f;
+  location.yaw = 0.f;
+  location.level_name = "L1";
+  return location;
+}
+
+} // namespace anonymous
+
+int main(int argc, char** argv)
+{
+  rclcpp::init(argc, argv);
+
+  Options options;
+  if (!parse_options(rclcpp::remove_ros_arguments(argc, argv), options))
+  {
+    print_usage(argv[0]);
+    rclcpp::shutdown();
+    return 1;
+  }
+
+  DeliveryTracker tracker;
+  std::vector<std::string> robot_names;
+  std::vector<std::unique_ptr<StormRobot>> robots;
+  for (size_t i = 0; i < options.robots; ++i)
+  {
+    robot_names.push_back("storm_robot_" + std::to_string(i));
+    robots.emplace_back(new StormRobot(options, robot_names.back(), tracker));
+    if (!robots.back()->start())
+    {
+      printf("failed to start %s\n", robot_names.back().c_str());
+      rclcpp::shutdown();
+      return 1;
+    }
+  }
+
+  auto node = std::make_shared<rclcpp::Node>("free_fleet_request_storm");
+
+  rmf_fleet_msgs::msg::ModeRequest mode_request;
+  mode_request.fleet_name = options.fleet_name;
+  mode_request.mode.mode = rmf_fleet_msgs::msg::RobotMode::MODE_MOVING;
+  RequestPublisher<rmf_fleet_msgs::msg::ModeRequest> mode_requests(
+      *node, options.mode_request_topic, "storm_mode", mode_request);
+
+  rmf_fleet_msgs::msg::PathRequest path_request;
+  path_request.fleet_name = options.fleet_name;
+  for (size_t i = 0; i < options.path_length; ++i)
+    path_request.path.push_back(make_location(i));
+  RequestPublisher<rmf_fleet_msgs::msg::PathRequest> path_requests(
+      *node, options.path_request_topic, "storm_path", path_request);
+
+  rmf_fleet_msgs::msg::DestinationRequest destination_request;
+  destination_request.fleet_name = options.fleet_name;
+  destination_request.destination = make_location(1);
+  RequestPublisher<rmf_fleet_msgs::msg::DestinationRequest>
+      destination_requests(
+          *node, options.destination_request_topic, "storm_destination",
+          destination_request);
+
+  printf("emulating %zu robots, warming up for %.1f s\n",
+      options.robots, options.warmup);
+
+  // A single thread publishes the states of every robot, spread evenly over
+  // each publish period, along with all of the requests
+  const auto state_interval = period_of(options.state_rate * options.robots);
+  const auto step_interval = std::chrono::duration_cast<Clock::duration>(
+      std::chrono::duration<double>(options.step_duration));
+  auto next_state = Clock::now();
+  size_t next_robot = 0;
+  auto publish_states = [&](const Clock::time_point& _now)
+  {
+    while (next_state <= _now)
+    {
+      robots[next_robot]->publish_state();
+      next_robot = (next_robot + 1) % robots.size();
+      next_state += state_interval;
+    }
+  };
+
+  const auto warmup_end = Clock::now() +
+      std::chrono::duration_cast<Clock::duration>(
+          std::chrono::duration<double>(options.warmup));
+  while (rclcpp::ok() && Clock::now() < warmup_end)
+  {
+    publish_states(Clock::now());
+    std::this_thread::sleep_until(std::min(next_state, warmup_end));
+  }
+  tracker.take_step();
+
+  printf("%4s %10s %10s %10s %8s %10s %10s %10s\n", "step", "offered/s",
+      "published", "delivered", "percent", "p50 (us)", "p99 (us)",
+      "in flight");
+
+  double scale = 1.0;
+  for (size_t step = 0; step < options.steps && rclcpp::ok(); ++step)
+  {
+    const auto step_start = Clock::now();
+    const auto step_end = step_start + step_interval;
+    mode_requests.set_rate(options.mode_rate * scale, step_start);
+    path_requests.set_rate(options.path_rate * scale, step_start);
+    destination_requests.set_rate(
+        options.destination_rate * scale, step_start);
+
+    while (rclcpp::ok())
+    {
+      const auto now = Clock::now();
+      if (now >= step_end)
+        break;
+      publish_states(now);
+      const auto next = std::min({
+          next_state,
+          step_end,
+          mode_requests.publish_due(now, robot_names, tracker),
+          path_requests.publish_due(now, robot_names, tracker),
+          destination_requests.publish_due(now, robot_names, tracker)});
+      std::this_thread::sleep_until(next);
+    }
+
+    const DeliveryTracker::Step result = tracker.take_step();
+    const double offered = (options.mode_rate + options.path_rate +
+        options.destination_rate) * scale;
+    const size_t delivered = result.latencies_us.size();
+    printf("%4zu %10.1f %10zu %10zu %7.1f%% %10.1f %10.1f %10zu\n",
+        step, offered, result.published, delivered,
+        result.published > 0 ? 100.0 * delivered / result.published : 0.0,
+        percentile(result.latencies_us, 0.5),
+        percentile(result.latencies_us, 0.99),
+        result.in_flight);
+    scale *= options.ramp_factor;
+  }
+
+  // Requests that are still on their way get a moment to arrive before the
+  // final count of the ones that never made it
+  std::this_thread::sleep_for(std::chrono::seconds(1));
+  const DeliveryTracker::Step result = tracker.take_step();
+  printf("delivered %zu more requests after the last step, %zu were never "
+      "delivered\n", result.latencies_us.size(), result.in_flight);
+
+  robots.clear();
+  node.reset();
+  rclcpp::shutdown();
+  return 0;
+}
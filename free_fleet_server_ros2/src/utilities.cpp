@@ -15,6 +15,10 @@
  *
  */
 
+#include <cstdio>
+#include <string>
+#include <utility>
+
 #include "utilities.hpp"
 
 namespace free_fleet
@@ -50,15 +54,34 @@ void to_ff_message(
   _out_msg.fleet_name = _in_msg.fleet_name;
   _out_msg.robot_name = _in_msg.robot_name;
 
-  _out_msg.path.clear();
+  _out_msg.path.resize(_in_msg.path.size());
+  for (size_t i = 0; i < _in_msg.path.size(); ++i)
+    to_ff_message(_in_msg.path[i], _out_msg.path[i]);
+
+  _out_msg.task_id = _in_msg.task_id;
+}
+
+void to_ff_message(
+    rmf_fleet_msgs::msg::PathRequest&& _in_msg,
+    messages::PathRequest& _out_msg)
+{
+  _out_msg.fleet_name = std::move(_in_msg.fleet_name);
+  _out_msg.robot_name = std::move(_in_msg.robot_name);
+
+  _out_msg.path.resize(_in_msg.path.size());
   for (size_t i = 0; i < _in_msg.path.size(); ++i)
   {
-    messages::Location tmp_loc_msg;
-    to_ff_message(_in_msg.path[i], tmp_loc_msg);
-    _out_msg.path.push_back(tmp_loc_msg);
+    rmf_fleet_msgs::msg::Location& in_loc = _in_msg.path[i];
+    messages::Location& out_loc = _out_msg.path[i];
+    out_loc.sec = in_loc.t.sec;
+    out_loc.nanosec = in_loc.t.nanosec;
+    out_loc.x = in_loc.x;
+    out_loc.y = in_loc.y;
+    out_loc.yaw = in_loc.yaw;
+    out_loc.level_name = std::move(in_loc.level_name);
   }
 
-  _out_msg.task_id = _in_msg.task_id;
+  _out_msg.task_id = std::move(_in_msg.task_id);
 }
 
 void to_ff_message(
@@ -104,5 +127,216 @@ void to_ros_message(
   }
 }
 
+namespace {
+
+// FNV-1a, good enough for telling requests apart, not meant to be secure
+constexpr uint64_t FingerprintSeed = 14695981039346656037ULL;
+
+void hash_bytes(uint64_t& _hash, const void* _data, size_t _size)
+{
+  const unsigned char* bytes = static_cast<const unsigned char*>(_data);
+  for (size_t i = 0; i < _size; ++i)
+  {
+    _hash ^= bytes[i];
+    _hash *= 1099511628211ULL;
+  }
+}
+
+void hash_string(uint64_t& _hash, const std::string& _str)
+{
+  // The length separates neighbouring strings
+  const uint64_t length = _str.size();
+  hash_bytes(_hash, &length, sizeof(length));
+  hash_bytes(_hash, _str.data(), _str.size());
+}
+
+void hash_location(uint64_t& _hash, const rmf_fleet_msgs::msg::Location& _loc)
+{
+  const double values[3] = {_loc.x, _loc.y, _loc.yaw};
+  hash_bytes(_hash, values, sizeof(values));
+  hash_string(_hash, _loc.level_name);
+}
+
+} // namespace anonymous
+
+uint64_t fingerprint(const rmf_fleet_msgs::msg::ModeRequest& _msg)
+{
+  uint64_t hash = FingerprintSeed;
+  hash_string(hash, _msg.task_id);
+  hash_bytes(hash, &_msg.mode.mode, sizeof(_msg.mode.mode));
+  return hash;
+}
+
+uint64_t fingerprint(const rmf_fleet_msgs::msg::PathRequest& _msg)
+{
+  uint64_t hash = FingerprintSeed;
+  hash_string(hash, _msg.task_id);
+  for (const auto& location : _msg.path)
+    hash_location(hash, location);
+  return hash;
+}
+
+uint64_t fingerprint(const rmf_fleet_msgs::msg::DestinationRequest& _msg)
+{
+  uint64_t hash = FingerprintSeed;
+  hash_string(hash, _msg.task_id);
+  hash_location(hash, _msg.destination);
+  return hash;
+}
+
+//==============================================================================
+
+namespace {
+
+diagnostic_msgs::msg::KeyValue key_value(
+    const std::string& _key, const std::string& _value)
+{
+  diagnostic_msgs::msg::KeyValue entry;
+  entry.key = _key;
+  entry.value = _value;
+  return entry;
+}
+
+diagnostic_msgs::msg::KeyValue key_value(
+    const std::string& _key, uint64_t _value)
+{
+  return key_value(_key, std::to_string(_value));
+}
+
+diagnostic_msgs::msg::KeyValue key_value(
+    const std::string& _key, double _value)
+{
+  char buffer[32];
+  snprintf(buffer, sizeof(buffer), "%.1f", _value);
+  return key_value(_key, std::string(buffer));
+}
+
+double rate(uint64_t _current, uint64_t _previous, double _elapsed_seconds)
+{
+  if (_elapsed_seconds <= 0.0 || _current < _previous)
+    return 0.0;
+  return (_current - _previous) / _elapsed_seconds;
+}
+
+diagnostic_msgs::msg::DiagnosticStatus to_diagnostic_status(
+    const LatencyHistogram& _histogram,
+    const std::string& _name,
+    const std::string& _hardware_id)
+{
+  diagnostic_msgs::msg::DiagnosticStatus status;
+  status.level = diagnostic_msgs::msg::DiagnosticStatus::OK;
+  status.name = _name;
+  status.hardware_id = _hardware_id;
+  status.message = "ok";
+  status.values.push_back(key_value("count", _histogram.count));
+  status.values.push_back(key_value("mean (us)", _histogram.mean() / 1e3));
+  status.values.push_back(
+      key_value("p50 (us)", _histogram.percentile(50.0) / 1e3));
+  status.values.push_back(
+      key_value("p90 (us)", _histogram.percentile(90.0) / 1e3));
+  status.values.push_back(
+      key_value("p99 (us)", _histogram.percentile(99.0) / 1e3));
+  status.values.push_back(key_value("max (us)", _histogram.max / 1e3));
+  return status;
+}
+
+} // namespace anonymous
+
+void to_diagnostic_statuses(
+    const Stats& _stats,
+    const Stats& _previous_stats,
+    double _elapsed_seconds,
+    const std::string& _name,
+    const std::string& _hardware_id,
+    std::vector<diagnostic_msgs::msg::DiagnosticStatus>& _statuses)
+{
+  // Topics are always listed in the same order, previous stats without them
+  // are the stats from before anything was counted
+  const TopicStats empty_topic;
+  for (size_t i = 0; i < _stats.topics.size(); ++i)
+  {
+    const TopicStats& topic = _stats.topics[i];
+    const TopicStats& previous =
+        i < _previous_stats.topics.size() ?
+            _previous_stats.topics[i] : empty_topic;
+
+    diagnostic_msgs::msg::DiagnosticStatus status;
+    status.name = _name + ": " + topic.topic;
+    status.hardware_id = _hardware_id;
+    status.level = diagnostic_msgs::msg::DiagnosticStatus::OK;
+    status.message = "ok";
+    if (topic.write_failures > previous.write_failures)
+    {
+      status.level = diagnostic_msgs::msg::DiagnosticStatus::WARN;
+      status.message = "writes failed";
+    }
+    else if (topic.samples_lost > previous.samples_lost ||
+        topic.samples_rejected > previous.samples_rejected)
+    {
+      status.level = diagnostic_msgs::msg::DiagnosticStatus::WARN;
+      status.message = "samples lost";
+    }
+
+    status.values.push_back(key_value("messages sent", topic.messages_sent));
+    status.values.push_back(
+        key_value("messages received", topic.messages_received));
+    status.values.push_back(key_value(
+        "messages sent per second",
+        rate(topic.messages_sent, previous.messages_sent, _elapsed_seconds)));
+    status.values.push_back(key_value(
+        "messages received per second",
+        rate(
+            topic.messages_received, previous.messages_received,
+            _elapsed_seconds)));
+    status.values.push_back(key_value("bytes sent", topic.bytes_sent));
+    status.values.push_back(key_value("bytes received", topic.bytes_received));
+    status.values.push_back(key_value("write failures", topic.write_failures));
+    status.values.push_back(key_value("samples lost", topic.samples_lost));
+    status.values.push_back(
+        key_value("samples rejected", topic.samples_rejected));
+    _statuses.push_back(std::move(status));
+  }
+
+  _statuses.push_back(to_diagnostic_status(
+      _stats.conversion_time, _name + ": conversion time", _hardware_id));
+  _statuses.push_back(to_diagnostic_status(
+      _stats.receipt_age, _name + ": receipt age", _hardware_id));
+
+  diagnostic_msgs::msg::DiagnosticStatus ack_status = to_diagnostic_status(
+      _stats.request_ack_time, _name + ": request ack time", _hardware_id);
+  ack_status.values.push_back(
+      key_value("retries", _stats.request_retries));
+  ack_status.values.push_back(
+      key_value("unacknowledged", _stats.unacknowledged_requests));
+  if (_stats.unacknowledged_requests > _previous_stats.unacknowledged_requests)
+  {
+    ack_status.level = diagnostic_msgs::msg::DiagnosticStatus::WARN;
+    ack_status.message = "requests unacknowledged";
+  }
+  _statuses.push_back(std::move(ack_status));
+}
+
+diagnostic_msgs::msg::DiagnosticStatus to_diagnostic_status(
+    const std::vector<ClockOffset>& _clock_offsets,
+    const std::string& _name,
+    const std::string& _hardware_id)
+{
+  diagnostic_msgs::msg::DiagnosticStatus status;
+  status.level = diagnostic_msgs::msg::DiagnosticStatus::OK;
+  status.name = _name + ": clock offsets";
+  status.hardware_id = _hardware_id;
+  status.message = "ok";
+  for (const ClockOffset& clock_offset : _clock_offsets)
+  {
+    status.values.push_back(key_value(
+        clock_offset.robot_name + " offset (ms)",
+        clock_offset.offset / 1e6));
+    status.values.push_back(key_value(
+        clock_offset.robot_name + " round trip (ms)",
+        clock_offset.round_trip / 1e6));
+  }
+  return status;
+}
+
 } // namespace ros2
 } // namespace free_fleet
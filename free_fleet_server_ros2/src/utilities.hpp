@@ -18,12 +18,20 @@
 #ifndef FREE_FLEET_SERVER_ROS2__SRC__UTILITIES_HPP
 #define FREE_FLEET_SERVER_ROS2__SRC__UTILITIES_HPP
 
+#include <string>
+#include <vector>
+#include <cstdint>
+
+#include <diagnostic_msgs/msg/diagnostic_status.hpp>
+
 #include <rmf_fleet_msgs/msg/location.hpp>
 #include <rmf_fleet_msgs/msg/robot_state.hpp>
 #include <rmf_fleet_msgs/msg/mode_request.hpp>
 #include <rmf_fleet_msgs/msg/path_request.hpp>
 #include <rmf_fleet_msgs/msg/destination_request.hpp>
 
+#include <free_fleet/Stats.hpp>
+#include <free_fleet/ClockOffset.hpp>
 #include <free_fleet/messages/Location.hpp>
 #include <free_fleet/messages/RobotState.hpp>
 #include <free_fleet/messages/ModeRequest.hpp>
@@ -46,6 +54,12 @@ void to_ff_message(
     const rmf_fleet_msgs::msg::PathRequest& in_msg, 
     messages::PathRequest& out_msg);
 
+/// Moves the names and the level names of the waypoints out of the request,
+/// instead of copying them
+void to_ff_message(
+    rmf_fleet_msgs::msg::PathRequest&& in_msg,
+    messages::PathRequest& out_msg);
+
 void to_ff_message(
     const rmf_fleet_msgs::msg::DestinationRequest& in_msg, 
     messages::DestinationRequest& out_msg);
@@ -60,6 +74,39 @@ void to_ros_message(
     const messages::RobotState& in_msg,
     rmf_fleet_msgs::msg::RobotState& out_msg);
 
+// ----------------------------------------------------------------------------
+
+/// Cheap hashes over the task ID and the contents of each request, used for
+/// telling apart requests that RMF sends again unchanged. The timestamps of
+/// the waypoints are left out, along with the names which requests are
+/// already keyed by.
+uint64_t fingerprint(const rmf_fleet_msgs::msg::ModeRequest& msg);
+
+uint64_t fingerprint(const rmf_fleet_msgs::msg::PathRequest& msg);
+
+uint64_t fingerprint(const rmf_fleet_msgs::msg::DestinationRequest& msg);
+
+// ----------------------------------------------------------------------------
+
+/// Fills in a diagnostic status for the traffic through each topic, along
+/// with its rates since the previous stats, and one for each latency
+/// histogram. Topics warn whenever samples were lost, rejected or failed to
+/// be written since the previous stats.
+void to_diagnostic_statuses(
+    const Stats& stats,
+    const Stats& previous_stats,
+    double elapsed_seconds,
+    const std::string& name,
+    const std::string& hardware_id,
+    std::vector<diagnostic_msgs::msg::DiagnosticStatus>& statuses);
+
+/// Fills in a diagnostic status with the clock offset and round trip of
+/// each robot, in milliseconds.
+diagnostic_msgs::msg::DiagnosticStatus to_diagnostic_status(
+    const std::vector<ClockOffset>& clock_offsets,
+    const std::string& name,
+    const std::string& hardware_id);
+
 } // namespace ros2
 } // namespace free_fleet
 